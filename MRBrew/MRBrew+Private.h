@@ -25,10 +25,40 @@
 
 #import <Foundation/Foundation.h>
 
+@class MRBrewResultCache;
+@class MRBrewHelper;
+@class MRBrewLauncher;
+@class MRBrewOperationMetrics;
+@class MRBrewWorker;
+@class MRBrewOutdatedEngine;
+
 @interface MRBrew ()
 
 @property (strong) NSString *brewPath;
+@property (copy) NSString *cellarPath;
+@property (readonly) MRBrewOutdatedEngine *outdatedEngine;
 @property (strong) NSDictionary *environment;
 @property (strong) NSOperationQueue *backgroundQueue;
+@property (strong) NSOperationQueue *mutatingQueue;
+@property (strong) MRBrewResultCache *resultCache;
+@property (strong) MRBrewHelper *helper;
+@property (strong) MRBrewLauncher *launcher;
+@property (strong) NSMutableDictionary *durationHistograms;
+@property (strong) NSMutableArray *inFlightWorkers;
+@property (assign) BOOL cachesResults;
+@property (strong) NSMutableArray *operationBatches;
+@property (strong) NSMutableDictionary *pendingBatches;
+@property (assign) BOOL batchesOperations;
+@property (assign) NSTimeInterval batchInterval;
+@property (assign) NSTimeInterval interruptGracePeriod;
+@property (assign) NSTimeInterval terminationGracePeriod;
+@property (strong) NSOperationQueue *delegateQueue;
+@property (strong) NSMutableArray *operationCompletions;
+@property (strong) NSMutableArray *operationGraphs;
+
+- (void)performPendingBatches;
+- (void)configureWorker:(MRBrewWorker *)worker;
+- (void)deliverToDelegates:(void (^)(void))delivery;
+- (void)recordOperationMetrics:(MRBrewOperationMetrics *)metrics;
 
 @end
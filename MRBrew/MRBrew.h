@@ -23,7 +23,7 @@
 //  DEALINGS IN THE SOFTWARE.
 //
 
-#import <Cocoa/Cocoa.h>
+#import <Foundation/Foundation.h>
 #import "MRBrewOperation.h"
 
 /** These constants indicate the type of error that resulted in an operation's
@@ -46,6 +46,11 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
 
 @protocol MRBrewDelegate;
 @class MRBrewWorker;
+@class MRBrewResultCache;
+@class MRBrewHelper;
+@class MRBrewHistogram;
+@class MRBrewOperationResult;
+@class MRBrewOperationGraph;
 
 /** The `MRBrew` class manages the execution of Homebrew operations. Operation
  * objects (defined by the MRBrewOperation class) are added to a queue and
@@ -56,12 +61,24 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
  * thread. Multiple operations can be performed by making repeated
  * calls to performOperation:delegate:.
  *
- * By default, operations are executed concurrently, but this behaviour can be
- * controlled using setConcurrentOperations:.
+ * Operations are queued in one of two lanes. Read-only operations (see the
+ * isReadOnly method of the MRBrewOperation class) are executed concurrently,
+ * up to a limit that can be changed using
+ * setMaxConcurrentReadOnlyOperations: or setConcurrentOperations:. All other
+ * operations modify the Homebrew installation and are executed one at a time,
+ * in a lane of their own, so that a long running install never delays a
+ * read-only operation and two operations never modify the installation at the
+ * same time. Within each lane, queued operations are started in order of their
+ * priority (see the priority property of the MRBrewOperation class).
+ *
+ * The output of read-only operations can be cached, so that repeating an
+ * operation does not spawn another subprocess, by calling
+ * setCachesResults:.
  *
  * `MRBrew`'s delegate methods—defined by the MRBrewDelegate protocol—allow
  * an object to receive callbacks regarding the success or failure of an
- * operation and output from Homebrew as it occurs.
+ * operation and output from Homebrew as it occurs. Callbacks are delivered on
+ * the main queue unless another queue is set using setDelegateQueue:.
  *
  * @warning Attempting to perform two operations that reference the same formula
  * concurrently may result in the failure of one of those operations. This is
@@ -102,6 +119,23 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
  */
 - (void)setBrewPath:(NSString *)path;
 
+/** Returns the absolute path of the Homebrew Cellar, which is read to perform
+ * operations in-process (see the performsInProcess property of
+ * `MRBrewOperation`).
+ *
+ * @return The Cellar path. Unless it has been set, this is the `Cellar`
+ * directory of the prefix of the Homebrew executable (e.g. `/usr/local/Cellar`
+ * for `/usr/local/bin/brew`).
+ */
+- (NSString *)cellarPath;
+
+/** Sets the absolute path of the Homebrew Cellar.
+ *
+ * @param path The absolute path of the Homebrew Cellar. If `nil` the `Cellar`
+ * directory of the prefix of the Homebrew executable will be used.
+ */
+- (void)setCellarPath:(NSString *)path;
+
 /**-----------------------------------------------------------------------------
  * @name Performing an Operation
  * -----------------------------------------------------------------------------
@@ -110,8 +144,17 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
 /** Performs an operation.
  *
  * Operations are placed in a queue for execution and will always execute on
- * separate threads. Use setConcurrentOperations: to control how queued
- * operations are executed (i.e. concurrently, or serially).
+ * separate threads. Read-only operations are queued separately from operations
+ * that modify the Homebrew installation, which are always executed serially.
+ * Use setConcurrentOperations: or setMaxConcurrentReadOnlyOperations: to
+ * control how queued read-only operations are executed.
+ *
+ * If the operation is read-only (see the isReadOnly method of the
+ * MRBrewOperation class) and an equal operation is already queued or
+ * executing, the delegate is attached to that operation instead of a second
+ * subprocess being spawned. The delegate receives any output generated before
+ * it was attached, followed by the same output, completion and failure
+ * messages as every other delegate attached to the operation.
  *
  * @param operation The operation to perform.
  * @param delegate The delegate object for the operation. The delegate will
@@ -120,12 +163,71 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
  */
 - (void)performOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate;
 
+/** Performs an operation, and calls a block with its result once it has
+ * finished or failed.
+ *
+ * The operation is performed in the same way as by performOperation:delegate:.
+ * The output of list, search and options operations, and of operations
+ * performed with JSON output, is parsed on a background thread as it is
+ * generated, so the result holds the parsed objects without the output being
+ * collected and parsed again.
+ *
+ * The block is called on the delegate queue (see setDelegateQueue:). To cancel
+ * the operation use cancelOperation:; the result then holds an error with the
+ * `MRBrewErrorOperationCancelled` error code.
+ *
+ * @param operation The operation to perform.
+ * @param completion The block to call with the result of the operation.
+ */
+- (void)performOperation:(MRBrewOperation *)operation completion:(void (^)(MRBrewOperationResult *result))completion;
+
+/** Performs several operations, and calls a block with their results once all
+ * of them have finished or failed.
+ *
+ * Each operation is performed as by performOperation:completion:, so
+ * operations are queued and executed as they would be if they were performed
+ * one at a time. The block is called once, on the delegate queue.
+ *
+ * @param operations The operations to perform.
+ * @param completion The block to call with an array of `MRBrewOperationResult`
+ * objects, in the same order as the operations.
+ */
+- (void)performOperations:(NSArray *)operations completion:(void (^)(NSArray *results))completion;
+
+/** Performs the operations of an operation graph in the order of their
+ * dependencies, and calls a block once all of them have finished, failed or
+ * been cancelled.
+ *
+ * Every operation in the graph is queued at once, and is executed as soon as
+ * the operations it depends on have finished successfully; operations that
+ * depend on an operation that failed are cancelled. The operations are not
+ * answered from the result cache or batched, and equal read-only operations
+ * performed by other delegates do not attach to them.
+ *
+ * The state, result and metrics of each node of the graph are available once
+ * the block is called, on the delegate queue. A graph can be performed once;
+ * this method has no effect if the graph has already been performed.
+ *
+ * @param graph The operation graph to perform.
+ * @param completion The block to call with the graph once every operation in
+ * it has finished.
+ */
+- (void)performOperationGraph:(MRBrewOperationGraph *)graph completion:(void (^)(MRBrewOperationGraph *graph))completion;
+
 /**-----------------------------------------------------------------------------
  * @name Stopping an Operation
  * -----------------------------------------------------------------------------
  */
 
 /** Cancels all queued and executing operations.
+ *
+ * Cancelling an executing operation interrupts the `brew` process performing
+ * it, along with the processes it launched. If they are still running once
+ * the interrupt grace period has passed they are terminated, and if they are
+ * still running once the termination grace period has passed they are killed,
+ * so that every cancelled operation has failed within the sum of the grace
+ * periods, plus one second for its output to be read. Queued operations fail
+ * as soon as they are dequeued.
  *
  * This method has no effect if there are currently no queued operations.
  */
@@ -139,6 +241,23 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
  */
 - (void)cancelOperation:(MRBrewOperation *)operation;
 
+/** Cancels a queued or executing operation on behalf of a single delegate.
+ *
+ * If other delegates are attached to the operation (see
+ * performOperation:delegate:) the delegate is detached and receives a
+ * brewOperation:didFailWithError: message with the
+ * `MRBrewErrorOperationCancelled` error code, while the operation continues
+ * for the remaining delegates. Otherwise the operation is cancelled. Use
+ * cancelOperation: to cancel an operation for all of its delegates.
+ *
+ * This method has no effect if the operation has already finished executing,
+ * or if the delegate is not attached to the operation.
+ *
+ * @param operation The operation to cancel.
+ * @param delegate The delegate for which the operation should be cancelled.
+ */
+- (void)cancelOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate;
+
 /** Cancels all queued and executing operations of the specified type.
  *
  * This method has no effect if there are currently no queued or executing
@@ -148,30 +267,278 @@ typedef NS_ENUM(NSInteger, MRBrewError) {
  */
 - (void)cancelAllOperationsOfType:(MRBrewOperationType)type;
 
+/** Cancels the queued and executing operations of an operation graph.
+ *
+ * Each cancelled operation fails with the `MRBrewErrorOperationCancelled`
+ * error code, and the completion block of the graph is called once every
+ * operation in it has finished. This method has no effect if the graph has
+ * finished.
+ *
+ * @param graph The operation graph to cancel.
+ */
+- (void)cancelOperationGraph:(MRBrewOperationGraph *)graph;
+
+/** Returns the time allowed for an operation to stop after it is interrupted,
+ * before it is terminated.
+ *
+ * @return The interrupt grace period, in seconds.
+ */
+- (NSTimeInterval)interruptGracePeriod;
+
+/** Sets the time allowed for an operation to stop after it is interrupted,
+ * before it is terminated. The default grace period is 5 seconds.
+ *
+ * The grace period applies to operations performed after it is set.
+ *
+ * @param gracePeriod The interrupt grace period, in seconds.
+ */
+- (void)setInterruptGracePeriod:(NSTimeInterval)gracePeriod;
+
+/** Returns the time allowed for an operation to stop after it is terminated,
+ * before it is killed.
+ *
+ * @return The termination grace period, in seconds.
+ */
+- (NSTimeInterval)terminationGracePeriod;
+
+/** Sets the time allowed for an operation to stop after it is terminated,
+ * before it is killed. The default grace period is 5 seconds.
+ *
+ * The grace period applies to operations performed after it is set.
+ *
+ * @param gracePeriod The termination grace period, in seconds.
+ */
+- (void)setTerminationGracePeriod:(NSTimeInterval)gracePeriod;
+
+/**-----------------------------------------------------------------------------
+ * @name Delivering Callbacks
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the queue on which delegates are sent messages.
+ *
+ * @return The delegate queue, or `nil` if delegates are sent messages on
+ * background threads as output is read.
+ */
+- (NSOperationQueue *)delegateQueue;
+
+/** Sets the queue on which delegates are sent messages. The default queue is
+ * the main queue.
+ *
+ * The messages for an operation are sent in order, one at a time, even if the
+ * queue executes operations concurrently: output is always delivered before
+ * brewOperationDidFinish: or brewOperation:didFailWithError:. Messages for
+ * different operations may be sent concurrently by a concurrent queue.
+ *
+ * If the queue is `nil`, delegates are sent messages on the background threads
+ * that read Homebrew's output, as soon as it is read, which avoids the cost of
+ * delivering them to a queue (see the delegateDispatchLag property of the
+ * MRBrewOperationMetrics class). Delegates should then return promptly and
+ * must be thread-safe, as the output and error output of an operation are read
+ * by different threads.
+ *
+ * The queue applies to operations performed after it is set.
+ *
+ * @param queue The delegate queue, or `nil`.
+ */
+- (void)setDelegateQueue:(NSOperationQueue *)queue;
+
 /**-----------------------------------------------------------------------------
  * @name Managing Operations
  * -----------------------------------------------------------------------------
  */
 
-/** Sets the concurrent execution of operations.
+/** Sets the concurrent execution of read-only operations.
  *
- * By default, operations are executed concurrently. Changing concurrency type
- * does not affect operations that are currently executing. Operations are
- * always executed in separate threads.
+ * By default, read-only operations are executed concurrently. Changing
+ * concurrency type does not affect operations that are currently executing.
+ * Operations are always executed in separate threads, and operations that are
+ * not read-only are always executed serially.
  *
- * @param concurrency If `YES`, operations are executed concurrently. If `NO`,
- * operations are executed serially.
+ * @param concurrency If `YES`, read-only operations are executed concurrently,
+ * up to a limit determined by the system. If `NO`, read-only operations are
+ * executed serially.
  */
 - (void)setConcurrentOperations:(BOOL)concurrency;
 
+/** Returns the maximum number of read-only operations that can execute at the
+ * same time.
+ *
+ * @return The maximum number of concurrent read-only operations, or
+ * `NSOperationQueueDefaultMaxConcurrentOperationCount` if the limit is
+ * determined by the system.
+ */
+- (NSInteger)maxConcurrentReadOnlyOperations;
+
+/** Sets the maximum number of read-only operations that can execute at the
+ * same time.
+ *
+ * Changing the limit does not affect operations that are currently executing.
+ *
+ * @param count The maximum number of concurrent read-only operations, or
+ * `NSOperationQueueDefaultMaxConcurrentOperationCount` to let the system
+ * determine the limit.
+ */
+- (void)setMaxConcurrentReadOnlyOperations:(NSInteger)count;
+
 /** Returns the number of operations queued for execution.
  *
- * The value returned by this method will change as operations are completed.
+ * The value returned by this method will change as operations are completed,
+ * and includes the operations queued in both lanes.
  *
  * @return The number of operations currently queued for execution.
  */
 - (NSUInteger)operationCount;
 
+/**-----------------------------------------------------------------------------
+ * @name Caching Operation Results
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns whether the output of read-only operations is cached.
+ *
+ * @return `YES` if results are cached, otherwise `NO`.
+ */
+- (BOOL)cachesResults;
+
+/** Sets whether the output of read-only operations is cached.
+ *
+ * When caching is enabled, a read-only operation (see the isReadOnly method of
+ * the MRBrewOperation class) that is equal to one previously performed
+ * successfully is answered from the result cache without spawning a
+ * subprocess: the delegate receives the cached output in a single
+ * brewOperation:didGenerateOutput: message followed by
+ * brewOperationDidFinish:. A delegate that implements
+ * brewOperation:didParseObjects: also receives the objects parsed from the
+ * cached output, which is parsed on a background queue, before
+ * brewOperationDidFinish:. Performing an operation that is not read-only
+ * discards all cached output.
+ *
+ * Caching is disabled by default.
+ *
+ * @param cachesResults If `YES`, the output of read-only operations is cached.
+ */
+- (void)setCachesResults:(BOOL)cachesResults;
+
+/** Returns the result cache used when caching is enabled.
+ *
+ * The cache can be used to inspect hit and miss counts, to change its byte
+ * limit, or as the delegate of an `MRBrewWatcher` object so that cached
+ * output is discarded when the Homebrew installation changes.
+ *
+ * @return The result cache.
+ */
+- (MRBrewResultCache *)resultCache;
+
+/**-----------------------------------------------------------------------------
+ * @name Batching Operations
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns whether install and remove operations are batched.
+ *
+ * @return `YES` if operations are batched, otherwise `NO`.
+ */
+- (BOOL)batchesOperations;
+
+/** Sets whether install and remove operations are batched.
+ *
+ * When batching is enabled, install (or remove) operations with the same
+ * parameters that are performed within the batch interval of one another are
+ * combined into a single operation naming every formula, so that Homebrew is
+ * only started once. The delegate of each operation receives the output that
+ * Homebrew writes under the `==> ` headers naming its formula, and the
+ * completion of the combined operation, with the operation it performed.
+ * Output that names none of the formulae is delivered to each delegate with
+ * its completion.
+ *
+ * If the combined operation fails, operations whose formula was installed (or
+ * removed) before the failure finish, and each of the others is performed
+ * again on its own, so that its delegate receives the outcome of that
+ * operation. Whether a formula was installed is determined by reading the
+ * Cellar; if it cannot be read, every operation fails with the error of the
+ * combined operation.
+ *
+ * An operation waiting in a batch can be cancelled on its own. Once the
+ * combined operation has started it can only be cancelled along with the
+ * other operations in the batch, using cancelAllOperations or
+ * cancelAllOperationsOfType:, so cancelOperation: has no effect on it unless
+ * it is the only operation in the batch.
+ *
+ * Batching is disabled by default.
+ *
+ * @param batchesOperations If `YES`, install and remove operations are batched.
+ */
+- (void)setBatchesOperations:(BOOL)batchesOperations;
+
+/** Returns the interval for which an install or remove operation waits for
+ * others to be batched with it.
+ *
+ * @return The batch interval, in seconds.
+ */
+- (NSTimeInterval)batchInterval;
+
+/** Sets the interval for which an install or remove operation waits for others
+ * to be batched with it. The default interval is 0.1 seconds.
+ *
+ * @param interval The batch interval, in seconds.
+ */
+- (void)setBatchInterval:(NSTimeInterval)interval;
+
+/**-----------------------------------------------------------------------------
+ * @name Collecting Metrics
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns a histogram of the durations of the operations with the specified
+ * name that have been performed.
+ *
+ * The duration of an operation is measured from the time it is queued until
+ * its delegate is sent brewOperationDidFinish: or
+ * brewOperation:didFailWithError:. Delegates that implement
+ * brewOperation:didCollectMetrics: receive the duration of each phase of an
+ * operation, and the resources used by the brew process that performed it.
+ *
+ * @param name The name of the operation, e.g. `MRBrewOperationInstallIdentifier`.
+ * @return A copy of the histogram, or `nil` if no operations with the name have
+ * been performed.
+ */
+- (MRBrewHistogram *)durationHistogramForOperationName:(NSString *)name;
+
+/** Returns histograms of the durations of the operations that have been
+ * performed (see durationHistogramForOperationName:).
+ *
+ * @return A dictionary of histograms whose keys are operation names.
+ */
+- (NSDictionary *)operationDurationHistograms;
+
+/** Discards the durations of the operations that have been performed. */
+- (void)resetOperationDurationHistograms;
+
+/**-----------------------------------------------------------------------------
+ * @name Using a Helper Process
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the helper process that performs operations, if any.
+ *
+ * @return The helper, or `nil` if each operation launches brew.
+ */
+- (MRBrewHelper *)helper;
+
+/** Sets a helper process that performs operations in place of launching brew
+ * for each operation.
+ *
+ * The helper is kept running between operations, so that operations do not
+ * each pay the cost of starting Homebrew (see the MRBrewHelper class for the
+ * protocol it must implement). If the helper cannot be launched, or exits
+ * before an operation has generated any output, the operation is performed by
+ * launching brew instead.
+ *
+ * @param helper The helper, or `nil` to launch brew for each operation.
+ */
+- (void)setHelper:(MRBrewHelper *)helper;
+
 /**-----------------------------------------------------------------------------
  * @name Managing the Environment
  * -----------------------------------------------------------------------------
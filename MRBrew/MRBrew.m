@@ -29,6 +29,20 @@
 #import "MRBrewFormula.h"
 #import "MRBrewConstants.h"
 #import "MRBrewWorker.h"
+#import "MRBrewResultCache.h"
+#import "MRBrewOperationBatch.h"
+#import "MRBrewLauncher.h"
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewHistogram.h"
+#import "MRBrewOperationResult.h"
+#import "MRBrewOperationCompletion.h"
+#import "MRBrewOperationGraph.h"
+#import "MRBrewOperationGraph+Private.h"
+#import "MRBrewOutputParser.h"
+#import "MRBrewOutputParserSession.h"
+#import "MRBrewCellar.h"
+#import "MRBrewInProcessWorker.h"
+#import "MRBrewOutdatedEngine.h"
 
 #ifndef __has_feature
     #define __has_feature(x) 0 // for compatibility with non-clang compilers
@@ -39,11 +53,21 @@
 #endif
 
 static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
+static const NSTimeInterval MRBrewDefaultBatchInterval = 0.1;
+static const NSTimeInterval MRBrewDefaultCancellationGracePeriod = 5.0;
 
 @implementation MRBrew
 
 @synthesize brewPath = _brewPath;
+@synthesize cellarPath = _cellarPath;
+@synthesize outdatedEngine = _outdatedEngine;
 @synthesize environment = _environment;
+@synthesize cachesResults = _cachesResults;
+@synthesize batchesOperations = _batchesOperations;
+@synthesize batchInterval = _batchInterval;
+@synthesize interruptGracePeriod = _interruptGracePeriod;
+@synthesize terminationGracePeriod = _terminationGracePeriod;
+@synthesize delegateQueue = _delegateQueue;
 
 #pragma mark - Lifecycle
 
@@ -63,7 +87,21 @@ static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
 {
     if (self = [super init]) {
         _backgroundQueue = [[NSOperationQueue alloc] init];
+        _mutatingQueue = [[NSOperationQueue alloc] init];
+        [_mutatingQueue setMaxConcurrentOperationCount:1];
         _brewPath = MRDefaultBrewPath;
+        _launcher = [[MRBrewLauncher alloc] initWithLaunchPath:_brewPath environment:nil];
+        _resultCache = [[MRBrewResultCache alloc] init];
+        _inFlightWorkers = [NSMutableArray array];
+        _operationBatches = [NSMutableArray array];
+        _pendingBatches = [NSMutableDictionary dictionary];
+        _batchInterval = MRBrewDefaultBatchInterval;
+        _interruptGracePeriod = MRBrewDefaultCancellationGracePeriod;
+        _terminationGracePeriod = MRBrewDefaultCancellationGracePeriod;
+        _durationHistograms = [NSMutableDictionary dictionary];
+        _delegateQueue = [NSOperationQueue mainQueue];
+        _operationCompletions = [NSMutableArray array];
+        _operationGraphs = [NSMutableArray array];
     }
     
     return self;
@@ -82,46 +120,616 @@ static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
         _brewPath = [path copy];
     else
         _brewPath = @"/usr/local/bin/brew";
+    
+    // resolve the path once, rather than for each operation
+    [[self launcher] setLaunchPath:_brewPath];
+}
+
+/* Returns the prefix of the Homebrew installation, which holds the directory
+ * of the Homebrew executable (e.g. /usr/local for /usr/local/bin/brew).
+ */
+- (NSString *)brewPrefix
+{
+    return [[[self brewPath] stringByDeletingLastPathComponent] stringByDeletingLastPathComponent];
+}
+
+- (NSString *)cellarPath
+{
+    @synchronized(self) {
+        if (_cellarPath) {
+            return _cellarPath;
+        }
+    }
+    
+    return [[self brewPrefix] stringByAppendingPathComponent:@"Cellar"];
+}
+
+- (void)setCellarPath:(NSString *)path
+{
+    @synchronized(self) {
+        _cellarPath = [path copy];
+    }
 }
 
 #pragma mark - Operation Methods
 
 - (void)performOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    [self performOperation:operation delegate:delegate batching:[self batchesOperations]];
+}
+
+- (void)performOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate batching:(BOOL)batching
+{
+    // operations performed in-process are answered by reading the
+    // installation, which is quicker than answering them from the cache
+    if ([operation isInProcessOperation]) {
+        [self performInProcessOperation:operation delegate:delegate batching:batching];
+        return;
+    }
+    
+    [self launchOperation:operation delegate:delegate batching:batching];
+}
+
+/* Performs an operation with a brew process, unless it is answered from the
+ * result cache or attached to an equal operation.
+ */
+- (void)launchOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate batching:(BOOL)batching
+{
+    BOOL cachesResults = [self cachesResults];
+    
+    // answer read-only operations from the result cache where possible, and
+    // discard cached output before performing an operation that may change it
+    if (cachesResults) {
+        if ([MRBrewOperation isReadOnlyOperationName:[operation name]]) {
+            NSString *output = [[self resultCache] outputForOperation:operation];
+            if (output) {
+                [self deliverCachedOutput:output forOperation:operation delegate:delegate];
+                return;
+            }
+        }
+        else {
+            [[self resultCache] removeAllOutput];
+        }
+    }
+    
+    // install and remove operations arriving within the batch interval are
+    // performed together by a single brew process
+    if (batching && [MRBrewOperationBatch canBatchOperation:operation]) {
+        [self addOperationToBatch:operation delegate:delegate];
+        return;
+    }
+    
+    BOOL readOnly = [MRBrewOperation isReadOnlyOperationName:[operation name]];
+    
+    // attach the delegate to an equal read-only operation that is already
+    // queued or executing rather than performing the operation again
+    if (readOnly) {
+        @synchronized([self inFlightWorkers]) {
+            for (MRBrewWorker *worker in [self inFlightWorkers]) {
+                if ([operation isEqualToOperation:[worker operation]] && [worker attachDelegate:delegate operation:operation]) {
+                    // a queued worker is promoted to the highest priority of
+                    // the operations attached to it
+                    NSOperationQueuePriority priority = (NSOperationQueuePriority)[operation priority];
+                    if (priority > [worker queuePriority]) {
+                        [worker setQueuePriority:priority];
+                    }
+                    return;
+                }
+            }
+        }
+    }
+    
+    MRBrewWorker *worker = [self workerForOperation:operation delegate:delegate];
+    [self enqueueWorker:worker coalescing:YES];
+}
+
+/* Performs an operation by reading the installation on the background queue,
+ * or with a brew process if the installation cannot be read. The objects are
+ * delivered along with output in the format brew would have written.
+ */
+- (void)performInProcessOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate batching:(BOOL)batching
+{
+    NSArray *(^readFormulae)(void);
+    
+    if ([[operation name] isEqualToString:MRBrewOperationOutdatedIdentifier]) {
+        MRBrewOutdatedEngine *engine = [self outdatedEngine];
+        readFormulae = ^{
+            return [engine outdatedFormulaeWithError:NULL];
+        };
+    }
+    else {
+        MRBrewCellar *cellar = [MRBrewCellar cellarWithPath:[self cellarPath]];
+        readFormulae = ^{
+            return [cellar installedFormulaeWithError:NULL];
+        };
+    }
+    
+    // the worker is queued like those that launch brew, so that it is counted
+    // and cancelled along with them
+    __weak MRBrew *weakSelf = self;
+    MRBrewInProcessWorker *worker = [[MRBrewInProcessWorker alloc] init];
+    [worker setOperation:operation];
+    [worker setDelegate:delegate];
+    [worker setReader:readFormulae];
+    [worker setFallbackHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        [weakSelf launchOperation:operation delegate:delegate batching:batching];
+    }];
+    [worker setDelegateQueue:[self delegateQueue]];
+    [worker setQueuePriority:(NSOperationQueuePriority)[operation priority]];
+    
+    [[self backgroundQueue] addOperation:worker];
+}
+
+/* Returns the engine that performs outdated operations in-process. The engine
+ * caches the versions read from formula files, so it is kept until the paths
+ * of the installation change.
+ */
+- (MRBrewOutdatedEngine *)outdatedEngine
+{
+    NSString *cellarPath = [self cellarPath];
+    NSString *libraryPath = [[self brewPrefix] stringByAppendingPathComponent:@"Library"];
+    NSString *formulaPath = [libraryPath stringByAppendingPathComponent:@"Formula"];
+    NSString *tapsPath = [libraryPath stringByAppendingPathComponent:@"Taps"];
+    
+    @synchronized(self) {
+        MRBrewOutdatedEngine *engine = _outdatedEngine;
+        
+        if (![[engine cellarPath] isEqualToString:cellarPath] || ![[engine formulaPath] isEqualToString:formulaPath] || ![[engine tapsPath] isEqualToString:tapsPath]) {
+            engine = [MRBrewOutdatedEngine engineWithCellarPath:cellarPath formulaPath:formulaPath tapsPath:tapsPath];
+            _outdatedEngine = engine;
+        }
+        
+        return engine;
+    }
+}
+
+/* Returns a worker that performs an operation for a delegate, once it has been
+ * enqueued.
+ */
+- (MRBrewWorker *)workerForOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
 {
     // construct command-line arguments for brew command
     NSMutableArray *arguments = [NSMutableArray array];
-    if ([operation name])
-        [arguments addObject:[operation name]];
-    if ([operation parameters])
-        [arguments addObjectsFromArray:[operation parameters]];
-    if ([operation formula])
-        [arguments addObject:[[operation formula] name]];
+    if ([operation isJSONOperation]) {
+        [arguments addObjectsFromArray:[self JSONArgumentsForOperation:operation]];
+    }
+    else {
+        if ([operation name])
+            [arguments addObject:[operation name]];
+        if ([operation parameters])
+            [arguments addObjectsFromArray:[operation parameters]];
+        if ([operation formula])
+            [arguments addObject:[[operation formula] name]];
+    }
     
     MRBrewWorker *worker = [[MRBrewWorker alloc] init];
     [worker setArguments:arguments];
     [worker setOperation:operation];
     [worker setDelegate:delegate];
-    [[self backgroundQueue] addOperation:worker];
+    [worker setQueuePriority:(NSOperationQueuePriority)[operation priority]];
+    [self configureWorker:worker];
+    if ([self cachesResults]) {
+        [worker setResultCache:[self resultCache]];
+    }
+    
+    return worker;
+}
+
+/* Adds a worker to the queue of its lane. Equal read-only operations performed
+ * later attach to a coalescing worker rather than launching brew again.
+ */
+- (void)enqueueWorker:(MRBrewWorker *)worker coalescing:(BOOL)coalescing
+{
+    BOOL readOnly = [MRBrewOperation isReadOnlyOperationName:[[worker operation] name]];
+    
+    if (readOnly && coalescing) {
+        @synchronized([self inFlightWorkers]) {
+            [[self inFlightWorkers] addObject:worker];
+        }
+        
+        __weak MRBrew *weakSelf = self;
+        __weak MRBrewWorker *weakWorker = worker;
+        [worker setCompletionBlock:^{
+            [weakSelf removeInFlightWorker:weakWorker];
+        }];
+    }
+    
+    // operations that modify the installation are serialized in a lane of
+    // their own, so that they never delay read-only operations
+    if (readOnly) {
+        [[self backgroundQueue] addOperation:worker];
+    }
+    else {
+        [[self mutatingQueue] addOperation:worker];
+    }
+}
+
+- (void)performOperation:(MRBrewOperation *)operation completion:(void (^)(MRBrewOperationResult *result))completion
+{
+    MRBrewOperationCompletion *operationCompletion = [[MRBrewOperationCompletion alloc] initWithOperation:operation];
+    
+    // delegates are not retained, so the completion is retained until the
+    // operation has finished or failed
+    __weak MRBrew *weakSelf = self;
+    __weak MRBrewOperationCompletion *weakCompletion = operationCompletion;
+    [operationCompletion setHandler:^(MRBrewOperationResult *result) {
+        [weakSelf removeOperationCompletion:weakCompletion];
+        if (completion) {
+            completion(result);
+        }
+    }];
+    
+    @synchronized([self operationCompletions]) {
+        [[self operationCompletions] addObject:operationCompletion];
+    }
+    
+    [self performOperation:operation delegate:operationCompletion];
+}
+
+- (void)performOperations:(NSArray *)operations completion:(void (^)(NSArray *results))completion
+{
+    NSUInteger count = [operations count];
+    
+    if (count == 0) {
+        if (completion) {
+            [self deliverToDelegates:^{
+                completion(@[]);
+            }];
+        }
+        return;
+    }
+    
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger index = 0; index < count; index++) {
+        [results addObject:[NSNull null]];
+    }
+    
+    __block NSUInteger remainingCount = count;
+    [operations enumerateObjectsUsingBlock:^(MRBrewOperation *operation, NSUInteger index, BOOL *stop) {
+        [self performOperation:operation completion:^(MRBrewOperationResult *result) {
+            BOOL finished;
+            @synchronized(results) {
+                [results replaceObjectAtIndex:index withObject:result];
+                finished = --remainingCount == 0;
+            }
+            
+            if (finished && completion) {
+                completion([results copy]);
+            }
+        }];
+    }];
+}
+
+- (void)performOperationGraph:(MRBrewOperationGraph *)graph completion:(void (^)(MRBrewOperationGraph *graph))completion
+{
+    if (![graph beginPerforming]) {
+        return;
+    }
+    
+    NSArray *nodes = [graph nodes];
+    if ([nodes count] == 0) {
+        [graph setFinishDate:[graph startDate]];
+        if (completion) {
+            [self deliverToDelegates:^{
+                completion(graph);
+            }];
+        }
+        return;
+    }
+    
+    // the graph is retained until every operation in it has finished
+    [graph setCompletionHandler:completion];
+    @synchronized([self operationGraphs]) {
+        [[self operationGraphs] addObject:graph];
+    }
+    
+    __weak MRBrew *weakSelf = self;
+    __weak MRBrewOperationGraph *weakGraph = graph;
+    
+    // nodes only depend on nodes added before them, so the worker of each
+    // dependency already exists
+    for (MRBrewOperationGraphNode *node in nodes) {
+        MRBrewOperationCompletion *operationCompletion = [[MRBrewOperationCompletion alloc] initWithOperation:[node operation]];
+        __weak MRBrewOperationCompletion *weakCompletion = operationCompletion;
+        __weak MRBrewOperationGraphNode *weakNode = node;
+        
+        // the node finishes once its metrics have been delivered, which
+        // follows the outcome of the operation
+        [operationCompletion setWaitsForMetrics:YES];
+        [operationCompletion setHandler:^(MRBrewOperationResult *result) {
+            [weakSelf operationGraph:weakGraph node:weakNode didCompleteWithResult:result metrics:[weakCompletion metrics]];
+        }];
+        
+        MRBrewWorker *worker = [self workerForOperation:[node operation] delegate:operationCompletion];
+        for (MRBrewOperationGraphNode *dependency in [node dependencies]) {
+            [worker addDependency:[dependency worker]];
+        }
+        
+        [node setCompletion:operationCompletion];
+        [node setWorker:worker];
+    }
+    
+    // the worker of a node may wait for its dependencies, and is cancelled
+    // if one fails, so other operations are not attached to it
+    for (MRBrewOperationGraphNode *node in nodes) {
+        [self enqueueWorker:[node worker] coalescing:NO];
+    }
+}
+
+- (void)operationGraph:(MRBrewOperationGraph *)graph node:(MRBrewOperationGraphNode *)node didCompleteWithResult:(MRBrewOperationResult *)result metrics:(MRBrewOperationMetrics *)metrics
+{
+    if (!graph || !node || ![graph completeNode:node result:result metrics:metrics]) {
+        return;
+    }
+    
+    @synchronized([self operationGraphs]) {
+        [[self operationGraphs] removeObjectIdenticalTo:graph];
+    }
+    
+    void (^completion)(MRBrewOperationGraph *graph) = [graph completionHandler];
+    [graph setCompletionHandler:nil];
+    if (completion) {
+        completion(graph);
+    }
+}
+
+- (void)removeOperationCompletion:(MRBrewOperationCompletion *)operationCompletion
+{
+    if (!operationCompletion) {
+        return;
+    }
+    
+    @synchronized([self operationCompletions]) {
+        [[self operationCompletions] removeObjectIdenticalTo:operationCompletion];
+    }
+}
+
+- (void)addOperationToBatch:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    NSString *key = [MRBrewOperationBatch keyForOperation:operation];
+    MRBrewOperationBatch *batch = nil;
+    
+    @synchronized([self operationBatches]) {
+        batch = [[self pendingBatches] objectForKey:key];
+        if ([batch addOperation:operation delegate:delegate]) {
+            return;
+        }
+        
+        batch = [[MRBrewOperationBatch alloc] initWithOperation:operation delegate:delegate];
+        [[self pendingBatches] setObject:batch forKey:key];
+        [[self operationBatches] addObject:batch];
+    }
+    
+    // the batch is performed once the interval has elapsed since its first
+    // operation arrived
+    __weak MRBrew *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self batchInterval] * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [weakSelf performBatch:batch];
+    });
+}
+
+- (void)performPendingBatches
+{
+    NSArray *batches;
+    
+    @synchronized([self operationBatches]) {
+        batches = [[self pendingBatches] allValues];
+    }
+    
+    for (MRBrewOperationBatch *batch in batches) {
+        [self performBatch:batch];
+    }
+}
+
+- (void)performBatch:(MRBrewOperationBatch *)batch
+{
+    @synchronized([self operationBatches]) {
+        // the batch may already have been performed, or discarded
+        if ([[self pendingBatches] objectForKey:[batch key]] != batch) {
+            return;
+        }
+        
+        [[self pendingBatches] removeObjectForKey:[batch key]];
+        [batch seal];
+        
+        if ([batch operationCount] == 0) {
+            [[self operationBatches] removeObjectIdenticalTo:batch];
+            return;
+        }
+    }
+    
+    __weak MRBrew *weakSelf = self;
+    [batch setRetryHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        [weakSelf performOperation:operation delegate:delegate batching:NO];
+    }];
+    [batch setCellarPath:[self cellarPath]];
+    
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setArguments:[batch arguments]];
+    [worker setOperation:[batch combinedOperation]];
+    [worker setDelegate:batch];
+    
+    // the Cellar is read as the batch starts, so that a failure is retried
+    // only for the formulae it left unchanged
+    [worker setStartHandler:^{
+        [batch recordInstalledVersions];
+    }];
+    [worker setQueuePriority:[batch queuePriority]];
+    [self configureWorker:worker];
+    if ([self cachesResults]) {
+        [worker setResultCache:[self resultCache]];
+    }
+    [batch setWorker:worker];
+    
+    // the worker holds its delegate weakly, so the batch is retained until
+    // the messages it receives from the worker have been delivered
+    __weak MRBrewWorker *weakWorker = worker;
+    [worker setCompletionBlock:^{
+        [weakWorker deliverToDelegates:^{
+            [weakSelf removeOperationBatch:batch];
+        }];
+    }];
+    
+    [[self mutatingQueue] addOperation:worker];
+}
+
+- (void)removeOperationBatch:(MRBrewOperationBatch *)batch
+{
+    @synchronized([self operationBatches]) {
+        [[self operationBatches] removeObjectIdenticalTo:batch];
+    }
+}
+
+- (NSArray *)operationBatchesSnapshot
+{
+    @synchronized([self operationBatches]) {
+        return [[self operationBatches] copy];
+    }
+}
+
+/* Returns the command-line arguments for an operation performed with JSON
+ * output. Homebrew describes installed formulae as JSON using the info command,
+ * so list operations (and info operations with no formula) are performed as
+ * info operations for installed formulae.
+ */
+- (NSArray *)JSONArgumentsForOperation:(MRBrewOperation *)operation
+{
+    NSMutableArray *arguments = [NSMutableArray array];
+    
+    if ([[operation name] isEqualToString:MRBrewOperationOutdatedIdentifier]) {
+        [arguments addObject:MRBrewOperationOutdatedIdentifier];
+        [arguments addObject:@"--json=v1"];
+        if ([operation parameters])
+            [arguments addObjectsFromArray:[operation parameters]];
+        
+        return arguments;
+    }
+    
+    [arguments addObject:MRBrewOperationInfoIdentifier];
+    [arguments addObject:@"--json=v1"];
+    
+    if ([[operation name] isEqualToString:MRBrewOperationListIdentifier]) {
+        [arguments addObject:@"--installed"];
+        
+        return arguments;
+    }
+    
+    if ([operation parameters])
+        [arguments addObjectsFromArray:[operation parameters]];
+    if ([operation formula])
+        [arguments addObject:[[operation formula] name]];
+    else
+        [arguments addObject:@"--installed"];
+    
+    return arguments;
+}
+
+- (void)removeInFlightWorker:(MRBrewWorker *)worker
+{
+    if (!worker) {
+        return;
+    }
+    
+    @synchronized([self inFlightWorkers]) {
+        [[self inFlightWorkers] removeObjectIdenticalTo:worker];
+    }
+}
+
+- (void)deliverCachedOutput:(NSString *)output forOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    MRBrewOperation *cachedOperation = [operation copy];
+    
+    // parse the output on a background queue for delegates that receive
+    // parsed objects, as a worker would have
+    if ([delegate respondsToSelector:@selector(brewOperation:didParseObjects:)] && [MRBrewOutputParserSession supportsOperation:operation]) {
+        __weak id<MRBrewDelegate> weakDelegate = delegate;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:cachedOperation output:output error:NULL];
+            [self deliverCachedOutput:output objects:objects forOperation:cachedOperation delegate:weakDelegate];
+        });
+        return;
+    }
+    
+    [self deliverCachedOutput:output objects:nil forOperation:cachedOperation delegate:delegate];
+}
+
+- (void)deliverCachedOutput:(NSString *)output objects:(NSArray *)objects forOperation:(MRBrewOperation *)cachedOperation delegate:(id<MRBrewDelegate>)delegate
+{
+    __weak id<MRBrewDelegate> weakDelegate = delegate;
+    
+    [self deliverToDelegates:^{
+        id<MRBrewDelegate> delegate = weakDelegate;
+        
+        if ([output length] > 0 && [delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
+            [delegate brewOperation:cachedOperation didGenerateOutput:output];
+        }
+        
+        if ([objects count] > 0 && [delegate respondsToSelector:@selector(brewOperation:didParseObjects:)]) {
+            [delegate brewOperation:cachedOperation didParseObjects:objects];
+        }
+        
+        if ([delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
+            [delegate brewOperationDidFinish:cachedOperation];
+        }
+    }];
+}
+
+/* Returns the queues of both lanes. The queues hold MRBrewWorker and
+ * MRBrewInProcessWorker objects, which both respond to operation and
+ * cancelForDelegate:.
+ */
+- (NSArray *)operationQueues
+{
+    return @[[self backgroundQueue], [self mutatingQueue]];
 }
 
 - (void)cancelAllOperations
 {
-    [[self backgroundQueue] cancelAllOperations];
+    for (MRBrewOperationBatch *batch in [self operationBatchesSnapshot]) {
+        [batch cancelAllOperations];
+    }
+    
+    for (NSOperationQueue *queue in [self operationQueues]) {
+        [queue cancelAllOperations];
+    }
 }
 
 - (void)cancelOperation:(MRBrewOperation *)operation
 {
-    for (MRBrewWorker *worker in [[self backgroundQueue] operations]) {
-        if ([[worker operation] isEqualToOperation:operation]) {
-            [worker cancel];
-            break;
+    for (MRBrewOperationBatch *batch in [self operationBatchesSnapshot]) {
+        if ([batch cancelOperation:operation]) {
+            return;
+        }
+    }
+    
+    for (NSOperationQueue *queue in [self operationQueues]) {
+        for (MRBrewWorker *worker in [queue operations]) {
+            if ([[worker operation] isEqualToOperation:operation]) {
+                [worker cancel];
+                return;
+            }
+        }
+    }
+}
+
+- (void)cancelOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    for (MRBrewOperationBatch *batch in [self operationBatchesSnapshot]) {
+        [batch cancelOperation:operation delegate:delegate];
+    }
+    
+    for (NSOperationQueue *queue in [self operationQueues]) {
+        for (MRBrewWorker *worker in [queue operations]) {
+            if ([[worker operation] isEqualToOperation:operation]) {
+                [worker cancelForDelegate:delegate];
+            }
         }
     }
 }
 
 - (void)cancelAllOperationsOfType:(MRBrewOperationType)type
 {
-    if ([[self backgroundQueue] operationCount] > 0) {
+    if ([self operationCount] > 0) {
         NSString *operationName;
         switch (type) {
             case MRBrewOperationInfo:
@@ -150,11 +758,26 @@ static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
                 break;
         }
         
-        for (MRBrewWorker *worker in [[self backgroundQueue] operations]) {
-            if ([[[worker operation] name] isEqualToString:operationName]) {
-                [worker cancel];
+        for (MRBrewOperationBatch *batch in [self operationBatchesSnapshot]) {
+            if ([[[batch combinedOperation] name] isEqualToString:operationName]) {
+                [batch cancelAllOperations];
             }
         }
+        
+        for (NSOperationQueue *queue in [self operationQueues]) {
+            for (MRBrewWorker *worker in [queue operations]) {
+                if ([[[worker operation] name] isEqualToString:operationName]) {
+                    [worker cancel];
+                }
+            }
+        }
+    }
+}
+
+- (void)cancelOperationGraph:(MRBrewOperationGraph *)graph
+{
+    for (MRBrewOperationGraphNode *node in [graph nodes]) {
+        [[node worker] cancel];
     }
 }
 
@@ -168,11 +791,121 @@ static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
     }
 }
 
+- (NSInteger)maxConcurrentReadOnlyOperations
+{
+    return [[self backgroundQueue] maxConcurrentOperationCount];
+}
+
+- (void)setMaxConcurrentReadOnlyOperations:(NSInteger)count
+{
+    [[self backgroundQueue] setMaxConcurrentOperationCount:count];
+}
+
 - (NSUInteger)operationCount
 {
-    return [[self backgroundQueue] operationCount];
+    NSUInteger batchedOperationCount = 0;
+    for (MRBrewOperationBatch *batch in [self operationBatchesSnapshot]) {
+        if (![batch isSealed]) {
+            batchedOperationCount += [batch operationCount];
+        }
+    }
+    
+    return [[self backgroundQueue] operationCount] + [[self mutatingQueue] operationCount] + batchedOperationCount;
+}
+
+- (BOOL)cachesResults
+{
+    return _cachesResults;
+}
+
+- (void)setCachesResults:(BOOL)cachesResults
+{
+    _cachesResults = cachesResults;
+    
+    if (!cachesResults) {
+        [[self resultCache] removeAllOutput];
+    }
+}
+
+/* Applies the settings shared by every worker. */
+- (void)configureWorker:(MRBrewWorker *)worker
+{
+    [worker setHelper:[self helper]];
+    [worker setDelegateQueue:[self delegateQueue]];
+    [worker setInterruptGracePeriod:[self interruptGracePeriod]];
+    [worker setTerminationGracePeriod:[self terminationGracePeriod]];
+    
+    __weak MRBrew *weakSelf = self;
+    [worker setMetricsHandler:^(MRBrewOperationMetrics *metrics) {
+        [weakSelf recordOperationMetrics:metrics];
+    }];
+}
+
+/* Sends messages to delegates on the delegate queue, or on the current thread
+ * if there is none.
+ */
+- (void)deliverToDelegates:(void (^)(void))delivery
+{
+    NSOperationQueue *queue = [self delegateQueue];
+    
+    if (queue) {
+        [queue addOperationWithBlock:delivery];
+    }
+    else {
+        delivery();
+    }
+}
+
+#pragma mark - Metrics
+
+- (void)recordOperationMetrics:(MRBrewOperationMetrics *)metrics
+{
+    NSString *name = [[metrics operation] name];
+    if (!name) {
+        return;
+    }
+    
+    MRBrewHistogram *histogram;
+    @synchronized([self durationHistograms]) {
+        histogram = [[self durationHistograms] objectForKey:name];
+        if (!histogram) {
+            histogram = [[MRBrewHistogram alloc] init];
+            [[self durationHistograms] setObject:histogram forKey:name];
+        }
+    }
+    
+    [histogram recordDuration:[metrics totalDuration]];
+}
+
+- (MRBrewHistogram *)durationHistogramForOperationName:(NSString *)name
+{
+    @synchronized([self durationHistograms]) {
+        return [[[self durationHistograms] objectForKey:name] copy];
+    }
+}
+
+- (NSDictionary *)operationDurationHistograms
+{
+    NSMutableDictionary *histograms = [NSMutableDictionary dictionary];
+    
+    @synchronized([self durationHistograms]) {
+        [[self durationHistograms] enumerateKeysAndObjectsUsingBlock:^(NSString *name, MRBrewHistogram *histogram, BOOL *stop) {
+            [histograms setObject:[histogram copy] forKey:name];
+        }];
+    }
+    
+    return histograms;
 }
 
+- (void)resetOperationDurationHistograms
+{
+    @synchronized([self durationHistograms]) {
+        [[self durationHistograms] removeAllObjects];
+    }
+}
+
+#pragma mark - Environment
+
 - (NSDictionary *)environment
 {
     return _environment;
@@ -181,6 +914,9 @@ static NSString * MRDefaultBrewPath = @"/usr/local/bin/brew";
 - (void)setEnvironment:(NSDictionary *)environment;
 {
     _environment = environment;
+    
+    // flatten the environment once, rather than for each operation
+    [[self launcher] setEnvironment:environment];
 }
 
 @end
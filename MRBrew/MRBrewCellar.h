@@ -0,0 +1,88 @@
+//
+//  MRBrewCellar.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+/** An `MRBrewCellar` reads the formulae installed in a Homebrew Cellar
+ * in-process, without spawning a Homebrew subprocess.
+ *
+ * The Cellar holds a directory (a rack) for each installed formula, which
+ * holds a directory (a keg) for each installed version. The Cellar is read in
+ * a single walk of the racks and the directories in them; the contents of
+ * kegs are never read.
+ *
+ * `MRBrew` reads its Cellar to perform list operations whose
+ * performsInProcess property is set.
+ */
+@interface MRBrewCellar : NSObject
+
+/** The path of the Cellar. */
+@property (readonly, copy) NSString *path;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating a Cellar
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns an initialized `MRBrewCellar` object for the Cellar at the
+ * specified path.
+ *
+ * @param path The absolute path of the Cellar (e.g. `/usr/local/Cellar`).
+ * @return A Cellar with the specified path.
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/** Returns a Cellar with the specified path.
+ *
+ * @param path The absolute path of the Cellar (e.g. `/usr/local/Cellar`).
+ * @return A Cellar with the specified path.
+ */
++ (instancetype)cellarWithPath:(NSString *)path;
+
+/**-----------------------------------------------------------------------------
+ * @name Reading Installed Formulae
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the installed versions of each formula in the Cellar.
+ *
+ * @param error If the Cellar cannot be read, upon return contains an error in
+ * the `NSPOSIXErrorDomain` domain. You may specify `nil` for this parameter.
+ * @return A dictionary whose keys are the names of the installed formulae, and
+ * whose values are arrays of the installed versions of each, in ascending
+ * version order, or `nil` if the Cellar cannot be read. A formula whose rack
+ * holds no kegs has an empty array of versions.
+ */
+- (NSDictionary *)installedVersionsWithError:(NSError **)error;
+
+/** Returns the formulae installed in the Cellar, as a list operation would.
+ *
+ * @param error If the Cellar cannot be read, upon return contains an error in
+ * the `NSPOSIXErrorDomain` domain. You may specify `nil` for this parameter.
+ * @return An array of `MRBrewFormula` objects with isInstalled set and their
+ * installedVersions, sorted by name, or `nil` if the Cellar cannot be read.
+ */
+- (NSArray *)installedFormulaeWithError:(NSError **)error;
+
+@end
@@ -0,0 +1,170 @@
+//
+//  MRBrewCellar.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import "MRBrewCellar.h"
+#import "MRBrewFormula.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fts.h>
+#include <errno.h>
+
+/* The levels of the walk: the Cellar, its racks and their kegs. */
+static const short MRBrewCellarRackLevel = 1;
+static const short MRBrewCellarKegLevel = 2;
+
+@implementation MRBrewCellar
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithPath:nil];
+}
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (self = [super init]) {
+        _path = [path copy];
+    }
+    
+    return self;
+}
+
++ (instancetype)cellarWithPath:(NSString *)path
+{
+    return [[self alloc] initWithPath:path];
+}
+
+#pragma mark - Installed Formulae
+
+- (NSDictionary *)installedVersionsWithError:(NSError **)error
+{
+    if (![self path]) {
+        [[self class] errorWithCode:ENOENT usingPointer:error];
+        return nil;
+    }
+    
+    // the walk does not stat entries, as directories are told apart by the
+    // types returned when the racks are read
+    char * const paths[] = { (char *)[[self path] fileSystemRepresentation], NULL };
+    FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR | FTS_NOSTAT, NULL);
+    
+    if (!fts) {
+        [[self class] errorWithCode:errno usingPointer:error];
+        return nil;
+    }
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSMutableDictionary *installedVersions = [NSMutableDictionary dictionary];
+    NSMutableArray *versions = nil;
+    int errorCode = 0;
+    FTSENT *entry;
+    
+    while ((entry = fts_read(fts))) {
+        // the Cellar itself must be readable, unlike the racks in it
+        if (entry->fts_level == FTS_ROOTLEVEL) {
+            if (entry->fts_info == FTS_DNR || entry->fts_info == FTS_ERR || entry->fts_info == FTS_NS) {
+                errorCode = entry->fts_errno;
+                break;
+            }
+            if (entry->fts_info != FTS_D && entry->fts_info != FTS_DP) {
+                errorCode = ENOTDIR;
+                break;
+            }
+            continue;
+        }
+        
+        // hidden entries, such as .DS_Store, are neither racks nor kegs
+        if (entry->fts_info != FTS_D || entry->fts_name[0] == '.') {
+            if (entry->fts_info == FTS_D) {
+                fts_set(fts, entry, FTS_SKIP);
+            }
+            continue;
+        }
+        
+        NSString *name = [fileManager stringWithFileSystemRepresentation:entry->fts_name length:entry->fts_namelen];
+        
+        if (entry->fts_level == MRBrewCellarRackLevel) {
+            versions = [NSMutableArray array];
+            [installedVersions setObject:versions forKey:name];
+        }
+        else if (entry->fts_level == MRBrewCellarKegLevel) {
+            [versions addObject:name];
+            fts_set(fts, entry, FTS_SKIP);
+        }
+    }
+    
+    if (!entry && errno != 0) {
+        errorCode = errno;
+    }
+    
+    fts_close(fts);
+    
+    if (errorCode != 0) {
+        [[self class] errorWithCode:errorCode usingPointer:error];
+        return nil;
+    }
+    
+    for (NSMutableArray *rackVersions in [installedVersions allValues]) {
+        [rackVersions sortUsingComparator:^NSComparisonResult(NSString *version, NSString *otherVersion) {
+            return [version compare:otherVersion options:NSNumericSearch];
+        }];
+    }
+    
+    return installedVersions;
+}
+
+- (NSArray *)installedFormulaeWithError:(NSError **)error
+{
+    NSDictionary *installedVersions = [self installedVersionsWithError:error];
+    
+    if (!installedVersions) {
+        return nil;
+    }
+    
+    NSArray *names = [[installedVersions allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    NSMutableArray *formulae = [NSMutableArray arrayWithCapacity:[names count]];
+    
+    for (NSString *name in names) {
+        MRBrewFormula *formula = [MRBrewFormula formulaWithName:name isNew:NO isUpdated:NO isInstalled:YES];
+        [formula setInstalledVersions:[installedVersions objectForKey:name]];
+        [formulae addObject:formula];
+    }
+    
+    return formulae;
+}
+
+#pragma mark - Errors
+
+/* Sets the error pointer (if provided) to a newly instantiated error object
+ * with the POSIX error domain and the specified error number.
+ */
++ (void)errorWithCode:(int)code usingPointer:(NSError * __autoreleasing *)errorPtr
+{
+    if (errorPtr) {
+        *errorPtr = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
+    }
+}
+
+@end
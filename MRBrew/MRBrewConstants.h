@@ -34,3 +34,5 @@ extern NSString * const MRBrewOperationRemoveIdentifier;
 extern NSString * const MRBrewOperationOptionsIdentifier;
 extern NSString * const MRBrewOperationOutdatedIdentifier;
 
+extern NSString * const MRBrewErrorOutputKey;
+
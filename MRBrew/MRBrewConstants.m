@@ -34,3 +34,5 @@ NSString * const MRBrewOperationRemoveIdentifier = @"remove";
 NSString * const MRBrewOperationOptionsIdentifier = @"options";
 NSString * const MRBrewOperationOutdatedIdentifier = @"outdated";
 
+NSString * const MRBrewErrorOutputKey = @"MRBrewErrorOutput";
+
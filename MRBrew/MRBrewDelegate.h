@@ -26,21 +26,36 @@
 #import <Foundation/Foundation.h>
 #import "MRBrewOperation.h"
 
+@class MRBrewOperationMetrics;
+
 /** The `MRBrewDelegate` protocol defines the optional methods implemented by
  delegates of the MRBrew class.
  
  MRBrew operations that generate output call the delegate method
- brewOperation:didGenerateOutput: _after_ completing an operation and
- immediately before calling brewOperationDidFinish:. In the case of
- `MRBrewOperationInstall` operations brewOperation:didGenerateOutput: may be
- called several times during the lifetime of the operation as output is
- received from Homebrew one line at a time.
+ brewOperation:didGenerateOutput: one or more times during the lifetime of the
+ operation as output is received from Homebrew. Output is delivered in whole
+ lines, and lines that arrive in quick succession are combined into a single
+ call. All output is delivered before brewOperationDidFinish: or
+ brewOperation:didFailWithError: is called.
+ 
+ Output that Homebrew writes to its standard error stream is delivered
+ separately, using the brewOperation:didGenerateErrorOutput: method.
+ 
+ For list, search and options operations, a delegate that implements
+ brewOperation:didParseObjects: receives the objects parsed from the output as
+ it arrives, so there is no need to collect the output and parse it once the
+ operation has finished.
  
  The brewOperation:didFailWithError: method is called at most once, if an error
  occurs performing an operation. The NSError object's `code` will correspond
- to one of the `MRBrewError` constants.
+ to one of the `MRBrewError` constants. If Homebrew wrote to its standard error
+ stream, the most recent error output is available in the error object's
+ `userInfo` dictionary under the `MRBrewErrorOutputKey` key.
+ 
+ Delegate methods are called on the main thread by default. The setDelegateQueue:
+ method of the MRBrew class changes the queue on which they are called.
  
- In all three methods, the MRBrewOperation object's `name` property can be
+ In each of these methods, the MRBrewOperation object's `name` property can be
  compared to the constants defined in MRBrewConstants.h to determine the type
  of operation that initiated the method call.
  
@@ -66,14 +81,48 @@
  */
 - (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error;
 
-/** This method is called when output is received from Homebrew. For
- * `MRBrewOperationInstall` operations this method will be called when output
- * is made available. For other operations this method is called at most once,
- * after an operation has completed and only if output was generated.
+/** This method is called when output is received from Homebrew. The output
+ * string contains one or more complete lines, except when a single line is too
+ * long to be held in memory at once, in which case it is delivered in pieces.
  *
  * @param operation The type of operation that generated the output.
  * @param output The output string.
  */
 - (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output;
 
+/** This method is called when error output is received from Homebrew (i.e.
+ * output written to its standard error stream). Error output is delivered in
+ * the same way as output, in one or more complete lines.
+ *
+ * @param operation The type of operation that generated the error output.
+ * @param output The error output string.
+ */
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateErrorOutput:(NSString *)output;
+
+/** This method is called when objects have been parsed from the output of a
+ * list, search or options operation. It is called one or more times as output
+ * is received, and the objects passed in each call follow those passed in the
+ * previous call. All objects are delivered before brewOperationDidFinish: is
+ * called.
+ *
+ * The objects are those that the `MRBrewOutputParser` method
+ * objectsForOperation:output:error: returns for the operation's output:
+ * `MRBrewFormula` objects for list and search operations, and
+ * `MRBrewInstallOption` objects for options operations.
+ *
+ * @param operation The type of operation that generated the output.
+ * @param objects An array of one or more objects parsed from the output.
+ */
+- (void)brewOperation:(MRBrewOperation *)operation didParseObjects:(NSArray *)objects;
+
+/** This method is called once brewOperationDidFinish: or
+ * brewOperation:didFailWithError: has been called, with timings and resource
+ * usage recorded while the operation was performed. It is not called for
+ * operations answered from the result cache.
+ *
+ * @param operation The type of operation that was performed.
+ * @param metrics The metrics recorded for the operation.
+ */
+- (void)brewOperation:(MRBrewOperation *)operation didCollectMetrics:(MRBrewOperationMetrics *)metrics;
+
 @end
@@ -0,0 +1,40 @@
+//
+//  MRBrewFSEventsWatcherBackend.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "MRBrewWatcherBackend.h"
+
+#ifdef __APPLE__
+
+/* An MRBrewFSEventsWatcherBackend watches for events with an FSEvents stream
+ * that reports events for individual files, scheduled on the queue of the
+ * backend. FSEvents watches every level below a path without a cost for each
+ * directory, so events for items deeper than the maximum depth are dropped as
+ * they are reported.
+ */
+@interface MRBrewFSEventsWatcherBackend : NSObject <MRBrewWatcherBackend>
+
+@end
+
+#endif
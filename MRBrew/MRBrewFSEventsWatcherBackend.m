@@ -0,0 +1,255 @@
+//
+//  MRBrewFSEventsWatcherBackend.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import "MRBrewFSEventsWatcherBackend.h"
+
+#ifdef __APPLE__
+
+#import <CoreServices/CoreServices.h>
+#import <limits.h>
+#import <stdlib.h>
+
+/* The latency of the event stream. Events are coalesced by the watcher, so
+ * the stream only needs to batch bursts of events into fewer callbacks.
+ */
+static const CFTimeInterval MRBrewFSEventsWatcherBackendLatency = 0.1;
+
+static const FSEventStreamEventFlags MRBrewFSEventsModifiedFlags = kFSEventStreamEventFlagItemModified |
+                                                                   kFSEventStreamEventFlagItemInodeMetaMod |
+                                                                   kFSEventStreamEventFlagItemChangeOwner |
+                                                                   kFSEventStreamEventFlagItemXattrMod |
+                                                                   kFSEventStreamEventFlagItemFinderInfoMod;
+
+static const FSEventStreamEventFlags MRBrewFSEventsRescanFlags = kFSEventStreamEventFlagMustScanSubDirs |
+                                                                 kFSEventStreamEventFlagUserDropped |
+                                                                 kFSEventStreamEventFlagKernelDropped |
+                                                                 kFSEventStreamEventFlagRootChanged;
+
+/* Returns a path with its symbolic links resolved, as the paths of events are
+ * reported, or nil if it cannot be resolved.
+ */
+static NSString *MRBrewFSEventsResolvedPath(NSString *path)
+{
+    char resolvedPath[PATH_MAX];
+    
+    if (!realpath([path fileSystemRepresentation], resolvedPath)) {
+        return nil;
+    }
+    
+    return [[NSFileManager defaultManager] stringWithFileSystemRepresentation:resolvedPath length:strlen(resolvedPath)];
+}
+
+/* Returns the watcher events for the flags of an FSEvents event. */
+static MRBrewWatcherEvent MRBrewFSEventsWatcherEvents(NSString *path, FSEventStreamEventFlags flags)
+{
+    MRBrewWatcherEvent events = 0;
+    
+    if (flags & kFSEventStreamEventFlagItemCreated) {
+        events |= MRBrewWatcherCreatedEvent;
+    }
+    if (flags & kFSEventStreamEventFlagItemRemoved) {
+        events |= MRBrewWatcherRemovedEvent;
+    }
+    if (flags & MRBrewFSEventsModifiedFlags) {
+        events |= MRBrewWatcherModifiedEvent;
+    }
+    if (flags & MRBrewFSEventsRescanFlags) {
+        events |= MRBrewWatcherRescanEvent;
+    }
+    
+    // a rename is reported for both the old and new paths of an item, so
+    // whether the item arrived or left is told by whether it still exists
+    if (flags & kFSEventStreamEventFlagItemRenamed) {
+        events |= [[NSFileManager defaultManager] fileExistsAtPath:path] ? MRBrewWatcherCreatedEvent : MRBrewWatcherRemovedEvent;
+    }
+    
+    // events without item flags are reported for directories whose contents
+    // changed in some way
+    return events ?: MRBrewWatcherModifiedEvent;
+}
+
+@interface MRBrewFSEventsWatcherBackend ()
+{
+    @private
+    NSArray *_paths;
+    NSArray *_rootPaths;
+    dispatch_queue_t _queue;
+    MRBrewWatcherBackendHandler _handler;
+    FSEventStreamRef _eventStream;
+}
+
+- (NSUInteger)depthOfPath:(NSString *)path;
+- (void)handleEventAtPath:(NSString *)path flags:(FSEventStreamEventFlags)flags;
+
+@end
+
+static void fileSystemEventsCallback(ConstFSEventStreamRef streamRef, void *userData, size_t numEvents, void *eventPaths, const FSEventStreamEventFlags eventFlags[], const FSEventStreamEventId eventIds[])
+{
+    MRBrewFSEventsWatcherBackend *backend = (__bridge MRBrewFSEventsWatcherBackend *)userData;
+    NSArray *paths = (__bridge NSArray *)eventPaths;
+    
+    size_t i;
+    for (i = 0; i < numEvents; i++) {
+        [backend handleEventAtPath:[paths objectAtIndex:i] flags:eventFlags[i]];
+    }
+}
+
+@implementation MRBrewFSEventsWatcherBackend
+
+@synthesize maximumDepth = _maximumDepth;
+
+#pragma mark - Lifecycle
+
+- (instancetype)initWithPaths:(NSArray *)paths queue:(dispatch_queue_t)queue handler:(MRBrewWatcherBackendHandler)handler
+{
+    if (self = [super init]) {
+        _paths = [paths copy];
+        _queue = queue;
+#if !OS_OBJECT_USE_OBJC
+        dispatch_retain(_queue);
+#endif
+        _handler = [handler copy];
+        _maximumDepth = NSUIntegerMax;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self stopWatching];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_queue);
+#endif
+}
+
+#pragma mark - Control
+
+- (BOOL)startWatching
+{
+    if (_eventStream) {
+        return YES;
+    }
+    
+    // the depth of an event is measured from the path that contains it, in
+    // the form it was given or with its symbolic links resolved
+    NSMutableArray *rootPaths = [NSMutableArray arrayWithCapacity:[_paths count] * 2];
+    for (NSString *path in _paths) {
+        [rootPaths addObject:[path stringByStandardizingPath]];
+        NSString *resolvedPath = MRBrewFSEventsResolvedPath(path);
+        if (resolvedPath) {
+            [rootPaths addObject:resolvedPath];
+        }
+    }
+    _rootPaths = rootPaths;
+    
+    // the stream does not retain the backend, which stops the stream before
+    // it is deallocated
+    FSEventStreamContext eventStreamContext;
+    eventStreamContext.info = (__bridge void *)(self);
+    eventStreamContext.version = 0;
+    eventStreamContext.retain = NULL;
+    eventStreamContext.release = NULL;
+    eventStreamContext.copyDescription = NULL;
+    
+    _eventStream = FSEventStreamCreate(NULL,
+                                       &fileSystemEventsCallback,
+                                       &eventStreamContext,
+                                       (__bridge CFArrayRef)_paths,
+                                       kFSEventStreamEventIdSinceNow,
+                                       MRBrewFSEventsWatcherBackendLatency,
+                                       kFSEventStreamCreateFlagUseCFTypes | kFSEventStreamCreateFlagFileEvents);
+    
+    if (!_eventStream) {
+        return NO;
+    }
+    
+    FSEventStreamSetDispatchQueue(_eventStream, _queue);
+    if (!FSEventStreamStart(_eventStream)) {
+        [self stopWatching];
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)stopWatching
+{
+    if (!_eventStream) {
+        return;
+    }
+    
+    FSEventStreamStop(_eventStream);
+    FSEventStreamInvalidate(_eventStream);
+    FSEventStreamRelease(_eventStream);
+    _eventStream = NULL;
+}
+
+#pragma mark - Events
+
+- (void)handleEventAtPath:(NSString *)path flags:(FSEventStreamEventFlags)flags
+{
+    // the paths of directory events end with a separator
+    if ([path length] > 1 && [path hasSuffix:@"/"]) {
+        path = [path substringToIndex:[path length] - 1];
+    }
+    
+    // the stream reports every level below a path, so items in directories
+    // deeper than the maximum depth are dropped, as they are never reported by
+    // a backend that watches directories one by one
+    NSUInteger maximumDepth = [self maximumDepth];
+    if (maximumDepth != NSUIntegerMax) {
+        NSUInteger depth = [self depthOfPath:path];
+        if (depth != NSNotFound && depth > maximumDepth + 1) {
+            return;
+        }
+    }
+    
+    _handler(path, MRBrewFSEventsWatcherEvents(path, flags));
+}
+
+/* Returns the number of levels a path is below the watched path containing it,
+ * which is 0 for a watched path, or NSNotFound if it is below none of them.
+ */
+- (NSUInteger)depthOfPath:(NSString *)path
+{
+    NSUInteger depth = NSNotFound;
+    
+    for (NSString *rootPath in _rootPaths) {
+        if ([path isEqualToString:rootPath]) {
+            return 0;
+        }
+        
+        NSString *rootPrefix = [rootPath hasSuffix:@"/"] ? rootPath : [rootPath stringByAppendingString:@"/"];
+        if ([path hasPrefix:rootPrefix]) {
+            depth = MIN(depth, [[[path substringFromIndex:[rootPrefix length]] pathComponents] count]);
+        }
+    }
+    
+    return depth;
+}
+
+@end
+
+#endif
@@ -23,12 +23,24 @@
 //  DEALINGS IN THE SOFTWARE.
 //
 
-#import <Cocoa/Cocoa.h>
+#import <Foundation/Foundation.h>
 
 /** An `MRBrewFormula` object represents a formula in the Homebrew package
  * manager.
+ *
+ * Formulae created with the initializers and formulaWithName: methods are
+ * mutable. Formulae returned by the internedFormulaWithName: methods are
+ * immutable and shared: each name and status has a single instance, which is
+ * created the first time it is requested and kept for the lifetime of the
+ * process. The formulae parsed from the output of list and search operations
+ * are interned, so repeated results share their formulae rather than
+ * allocating new ones.
+ *
+ * Copying an immutable formula returns the formula itself; use mutableCopy to
+ * obtain a formula that can be changed. Formulae are equal (see isEqual:) if
+ * their properties are equal, whether or not they are mutable.
  */
-@interface MRBrewFormula : NSObject <NSCopying>
+@interface MRBrewFormula : NSObject <NSCopying, NSMutableCopying>
 
 /** The name of the formula. */
 @property (copy) NSString *name;
@@ -42,6 +54,29 @@
 /** A boolean value representing whether the formula is installed. */
 @property (assign) BOOL isInstalled;
 
+/** The current stable version of the formula, or `nil` if the version is not
+ * known. Set for formulae decoded from operations performed with JSON output.
+ */
+@property (copy) NSString *version;
+
+/** An array of NSStrings containing the installed versions of the formula, or
+ * `nil` if the installed versions are not known. Set for formulae decoded from
+ * operations performed with JSON output.
+ */
+@property (copy) NSArray *installedVersions;
+
+/** An array of NSStrings containing the names of the formulae that the formula
+ * depends on, or `nil` if the dependencies are not known. Set for formulae
+ * decoded from info and list operations performed with JSON output.
+ */
+@property (copy) NSArray *dependencies;
+
+/** A boolean value representing whether the formula is immutable, as interned
+ * formulae are. Setting a property of an immutable formula raises an
+ * `NSInternalInconsistencyException`.
+ */
+@property (readonly) BOOL isImmutable;
+
 /**-----------------------------------------------------------------------------
  * @name Initialising a Formula
  * -----------------------------------------------------------------------------
@@ -89,6 +124,40 @@
  */
 + (instancetype)formulaWithName:(NSString *)name isNew:(BOOL)isNew isUpdated:(BOOL)isUpdated isInstalled:(BOOL)isInstalled;
 
+/**-----------------------------------------------------------------------------
+ * @name Interning a Formula
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the shared, immutable formula with the specified name.
+ *
+ * This method is safe to call from any thread.
+ *
+ * @param name The name of the formula.
+ * @return An immutable formula with the specified name, which is the same
+ * object each time it is requested.
+ */
++ (MRBrewFormula *)internedFormulaWithName:(NSString *)name;
+
+/** Returns the shared, immutable formula with the specified name and status.
+ *
+ * This method is safe to call from any thread.
+ *
+ * @param name The name of the formula.
+ * @param isNew A boolean value representing whether the formula is new.
+ * @param isUpdated A boolean value representing whether the formula is updated.
+ * @param isInstalled A boolean value representing whether the formula is
+ * installed.
+ * @return An immutable formula with the specified properties, which is the
+ * same object each time it is requested.
+ */
++ (MRBrewFormula *)internedFormulaWithName:(NSString *)name isNew:(BOOL)isNew isUpdated:(BOOL)isUpdated isInstalled:(BOOL)isInstalled;
+
+/**-----------------------------------------------------------------------------
+ * @name Comparing Formulae
+ * -----------------------------------------------------------------------------
+ */
+
 /** Compares the receiver to another formula.
  *
  * @param formula The formula with which to compare the receiver.
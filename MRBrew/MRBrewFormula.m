@@ -25,6 +25,18 @@
 
 #import "MRBrewFormula.h"
 
+/* The number of combinations of the isNew, isUpdated and isInstalled flags,
+ * each of which has a table of interned formulae keyed by name.
+ */
+static const NSUInteger MRBrewFormulaInternTableCount = 8;
+
+/* An MRBrewInternedFormula is an immutable formula, of which there is a single
+ * instance for each name and status.
+ */
+@interface MRBrewInternedFormula : MRBrewFormula
+
+@end
+
 @implementation MRBrewFormula
 
 #pragma mark - Lifecycle
@@ -72,14 +84,81 @@
                           isInstalled:isInstalled];
 }
 
+#pragma mark - Interning
+
+/* Returns the tables of interned formulae, indexed by status. */
++ (NSArray *)internTables
+{
+    static NSArray *internTables = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableArray *tables = [NSMutableArray arrayWithCapacity:MRBrewFormulaInternTableCount];
+        for (NSUInteger index = 0; index < MRBrewFormulaInternTableCount; index++) {
+            [tables addObject:[NSMutableDictionary dictionary]];
+        }
+        internTables = [tables copy];
+    });
+    
+    return internTables;
+}
+
++ (MRBrewFormula *)internedFormulaWithName:(NSString *)name
+{
+    return [self internedFormulaWithName:name isNew:NO isUpdated:NO isInstalled:NO];
+}
+
++ (MRBrewFormula *)internedFormulaWithName:(NSString *)name isNew:(BOOL)isNew isUpdated:(BOOL)isUpdated isInstalled:(BOOL)isInstalled
+{
+    if (!name) {
+        return nil;
+    }
+    
+    NSArray *internTables = [MRBrewFormula internTables];
+    NSUInteger status = (isNew ? 1 : 0) | (isUpdated ? 2 : 0) | (isInstalled ? 4 : 0);
+    NSMutableDictionary *internTable = [internTables objectAtIndex:status];
+    
+    @synchronized(internTables) {
+        MRBrewFormula *formula = [internTable objectForKey:name];
+        
+        if (!formula) {
+            formula = [[MRBrewInternedFormula alloc] initWithName:name isNew:isNew isUpdated:isUpdated isInstalled:isInstalled];
+            [internTable setObject:formula forKey:[formula name]];
+        }
+        
+        return formula;
+    }
+}
+
+- (BOOL)isImmutable
+{
+    return NO;
+}
+
 #pragma mark - Equality
 
+- (BOOL)isEqual:(id)object
+{
+    if (self == object)
+        return YES;
+    
+    if (![object isKindOfClass:[MRBrewFormula class]])
+        return NO;
+    
+    return [self isEqualToFormula:object];
+}
+
+- (NSUInteger)hash
+{
+    return [[self name] hash];
+}
+
 - (BOOL)isEqualToFormula:(MRBrewFormula *)formula
 {
     if (self == formula)
         return YES;
     
-    if (!formula || ![formula isKindOfClass:[self class]])
+    // interned formulae are equal to mutable formulae with the same properties
+    if (!formula || ![formula isKindOfClass:[MRBrewFormula class]])
         return NO;
     
     if (![[self name] isEqualToString:[formula name]])
@@ -90,6 +169,12 @@
         return NO;
     if ([self isInstalled] != [formula isInstalled])
         return NO;
+    if (([self version] || [formula version]) && ![[self version] isEqualToString:[formula version]])
+        return NO;
+    if (([self installedVersions] || [formula installedVersions]) && ![[self installedVersions] isEqualToArray:[formula installedVersions]])
+        return NO;
+    if (([self dependencies] || [formula dependencies]) && ![[self dependencies] isEqualToArray:[formula dependencies]])
+        return NO;
     
     return YES;
 }
@@ -98,13 +183,88 @@
 
 - (id)copyWithZone:(NSZone *)zone
 {
-    MRBrewFormula *copy = [[[self class] allocWithZone:zone] init];
+    return [self copyOfClass:[self class] zone:zone];
+}
+
+#pragma mark - NSMutableCopying protocol
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+    return [self copyOfClass:([self isImmutable] ? [MRBrewFormula class] : [self class]) zone:zone];
+}
+
+/* Returns a mutable copy of the receiver that is an instance of the specified
+ * class.
+ */
+- (id)copyOfClass:(Class)copyClass zone:(NSZone *)zone
+{
+    MRBrewFormula *copy = [[copyClass allocWithZone:zone] init];
     [copy setName:[[self name] copy]];
     [copy setIsUpdated:[self isUpdated]];
     [copy setIsNew:[self isNew]];
     [copy setIsInstalled:[self isInstalled]];
+    [copy setVersion:[self version]];
+    [copy setInstalledVersions:[self installedVersions]];
+    [copy setDependencies:[self dependencies]];
     
     return copy;
 }
 
 @end
+
+@implementation MRBrewInternedFormula
+
+- (BOOL)isImmutable
+{
+    return YES;
+}
+
+/* Raises an exception for an attempt to change an interned formula. */
+- (void)raiseImmutableException
+{
+    [NSException raise:NSInternalInconsistencyException format:@"MRBrewFormula: Interned formula is immutable (%@)", [self name]];
+}
+
+- (void)setName:(NSString *)name
+{
+    [self raiseImmutableException];
+}
+
+- (void)setIsUpdated:(BOOL)isUpdated
+{
+    [self raiseImmutableException];
+}
+
+- (void)setIsNew:(BOOL)isNew
+{
+    [self raiseImmutableException];
+}
+
+- (void)setIsInstalled:(BOOL)isInstalled
+{
+    [self raiseImmutableException];
+}
+
+- (void)setVersion:(NSString *)version
+{
+    [self raiseImmutableException];
+}
+
+- (void)setInstalledVersions:(NSArray *)installedVersions
+{
+    [self raiseImmutableException];
+}
+
+- (void)setDependencies:(NSArray *)dependencies
+{
+    [self raiseImmutableException];
+}
+
+#pragma mark - NSCopying protocol
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+@end
@@ -0,0 +1,187 @@
+//
+//  MRBrewFormulaIndex.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewWatcherDelegate.h"
+
+extern NSString * const MRBrewFormulaIndexErrorDomain;
+
+/** These constants indicate the type of error that resulted in the failure to
+ * load or save a formula index.
+ */
+typedef NS_ENUM(NSInteger, MRBrewFormulaIndexError) {
+    /** The index file could not be read or written. */
+    MRBrewFormulaIndexErrorFileAccess,
+    /** The index file is not a formula index, or is corrupt. */
+    MRBrewFormulaIndexErrorInvalidFormat,
+    /** The index file was written by an incompatible version of `MRBrew`. */
+    MRBrewFormulaIndexErrorUnsupportedVersion
+};
+
+@class MRBrewFormula;
+
+/** An `MRBrewFormulaIndex` answers formula queries in-process, without
+ * spawning a Homebrew subprocess or parsing operation output.
+ *
+ * An index is built once from the output of a search operation (which lists
+ * every available formula) and, optionally, a list operation (which lists the
+ * installed formulae), and can then be saved to a compact binary file using
+ * writeToFile:error:. Loading the file with indexWithContentsOfFile:error:
+ * memory-maps it, so an index can be queried as soon as it is loaded.
+ *
+ * Queries return arrays whose `MRBrewFormula` objects are looked up only as
+ * they are accessed, and are interned (see the internedFormulaWithName:
+ * methods of the MRBrewFormula class). Names are compared byte for byte, so
+ * queries are case-sensitive.
+ *
+ * An index can be kept current by specifying it as the delegate of an
+ * `MRBrewWatcher` object watching the Homebrew `Formula` and `Taps`
+ * locations: when formula files are added to or removed from a directory only
+ * the entries for that directory are updated, and the index file is rewritten
+ * if the index was loaded from or saved to a file. The directories changed by
+ * each notification are updated together, so the index is rewritten at most
+ * once per notification. If the watcher also watches the Cellar (as one
+ * created with a Homebrew prefix does), the installed state of each formula is
+ * updated when formulae are installed or removed.
+ */
+@interface MRBrewFormulaIndex : NSObject <MRBrewWatcherDelegate>
+
+/** The number of formulae in the index. */
+@property (readonly) NSUInteger count;
+
+/** The path of the file from which the index was loaded or to which it was
+ * last saved, or `nil` if the index has not been saved.
+ */
+@property (readonly, copy) NSString *path;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating a Formula Index
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns an index built from the output of search and list operations.
+ *
+ * @param searchOutput The output of a search operation performed without a
+ * search term, with one formula name per line.
+ * @param listOutput The output of a list operation, with one installed formula
+ * name per line. This parameter is optional and can be passed `nil`.
+ * @return An index containing the formulae listed by _searchOutput_.
+ */
++ (instancetype)indexWithSearchOutput:(NSString *)searchOutput listOutput:(NSString *)listOutput;
+
+/** Returns an index loaded from a file previously written using
+ * writeToFile:error:.
+ *
+ * The file is memory-mapped rather than read, and is not parsed.
+ *
+ * @param path The path of the index file.
+ * @param error A pointer to an error object that is set to an NSError instance
+ * if the file could not be loaded. This parameter is optional and can be
+ * passed `nil`.
+ * @return The loaded index, or `nil` if the file could not be loaded.
+ */
++ (instancetype)indexWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+/** Returns an initialized index built from the output of search and list
+ * operations.
+ *
+ * @param searchOutput The output of a search operation performed without a
+ * search term, with one formula name per line.
+ * @param listOutput The output of a list operation, with one installed formula
+ * name per line. This parameter is optional and can be passed `nil`.
+ * @return An index containing the formulae listed by _searchOutput_.
+ */
+- (instancetype)initWithSearchOutput:(NSString *)searchOutput listOutput:(NSString *)listOutput;
+
+/** Returns an initialized index loaded from a file previously written using
+ * writeToFile:error:.
+ *
+ * @param path The path of the index file.
+ * @param error A pointer to an error object that is set to an NSError instance
+ * if the file could not be loaded. This parameter is optional and can be
+ * passed `nil`.
+ * @return The loaded index, or `nil` if the file could not be loaded.
+ */
+- (instancetype)initWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+/**-----------------------------------------------------------------------------
+ * @name Saving a Formula Index
+ * -----------------------------------------------------------------------------
+ */
+
+/** Writes the index to a file.
+ *
+ * @param path The path of the file to write.
+ * @param error A pointer to an error object that is set to an NSError instance
+ * if the file could not be written. This parameter is optional and can be
+ * passed `nil`.
+ * @return `YES` if the file was written, otherwise `NO`.
+ */
+- (BOOL)writeToFile:(NSString *)path error:(NSError **)error;
+
+/**-----------------------------------------------------------------------------
+ * @name Querying a Formula Index
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the formula with the specified name.
+ *
+ * @param name The name of the formula.
+ * @return The formula, or `nil` if the index contains no formula with the
+ * specified name.
+ */
+- (MRBrewFormula *)formulaWithName:(NSString *)name;
+
+/** Returns the formulae whose names begin with a string.
+ *
+ * @param prefix The prefix to match.
+ * @return An array of `MRBrewFormula` objects sorted by name.
+ */
+- (NSArray *)formulaeWithPrefix:(NSString *)prefix;
+
+/** Returns the formulae whose names contain a string.
+ *
+ * @param string The string to match.
+ * @return An array of `MRBrewFormula` objects sorted by name.
+ */
+- (NSArray *)formulaeContainingString:(NSString *)string;
+
+/**-----------------------------------------------------------------------------
+ * @name Updating a Formula Index
+ * -----------------------------------------------------------------------------
+ */
+
+/** Updates the index entries for the formula files in a directory.
+ *
+ * Formulae whose files have been added to the directory are added to the
+ * index, and formulae previously added from the directory whose files have
+ * been removed are removed from the index. Formulae in a tap directory are
+ * named using the tap's `user/repository/` prefix, as listed by Homebrew.
+ *
+ * @param directory The absolute path of a `Formula` or tap directory.
+ */
+- (void)updateFormulaeInDirectory:(NSString *)directory;
+
+@end
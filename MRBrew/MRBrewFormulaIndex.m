@@ -0,0 +1,870 @@
+//
+//  MRBrewFormulaIndex.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewFormulaIndex.h"
+#import "MRBrewFormula.h"
+#import "MRBrewCellar.h"
+#include <string.h>
+
+NSString * const MRBrewFormulaIndexErrorDomain = @"uk.co.fidgetbox.MRBrew";
+
+/* An index file contains a header, followed by a table of entries sorted by
+ * formula name, a table of source directories, and a string table. Names are
+ * stored in the string table in entry order, each followed by a newline, so
+ * that substring queries can scan the names in a single pass. All integers are
+ * little-endian.
+ */
+static const char MRBrewFormulaIndexMagic[4] = {'M', 'R', 'F', 'I'};
+static const uint32_t MRBrewFormulaIndexVersion = 1;
+static const uint32_t MRBrewFormulaIndexInstalledFlag = 1 << 0;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t sourceCount;
+    uint32_t stringsLength;
+} MRBrewFormulaIndexHeader;
+
+typedef struct {
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    uint16_t source;            // index of the source directory plus one, or zero
+    uint32_t flags;
+} MRBrewFormulaIndexEntry;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} MRBrewFormulaIndexSource;
+
+/* An entry of an index being built, whose name refers to bytes owned by the
+ * caller, such as those of the index it is updated from.
+ */
+typedef struct {
+    const char *name;           // NULL for an entry that has been removed
+    uint16_t nameLength;
+    uint16_t source;            // index of the source path plus one, or zero
+    uint32_t flags;
+} MRBrewFormulaIndexDraftEntry;
+
+#pragma mark - Index Data Access
+
+static const MRBrewFormulaIndexHeader *MRBrewFormulaIndexGetHeader(NSData *data)
+{
+    return (const MRBrewFormulaIndexHeader *)[data bytes];
+}
+
+static uint32_t MRBrewFormulaIndexGetEntryCount(NSData *data)
+{
+    return NSSwapLittleIntToHost(MRBrewFormulaIndexGetHeader(data)->entryCount);
+}
+
+static const MRBrewFormulaIndexEntry *MRBrewFormulaIndexGetEntries(NSData *data)
+{
+    return (const MRBrewFormulaIndexEntry *)((const char *)[data bytes] + sizeof(MRBrewFormulaIndexHeader));
+}
+
+static const MRBrewFormulaIndexSource *MRBrewFormulaIndexGetSources(NSData *data)
+{
+    return (const MRBrewFormulaIndexSource *)(MRBrewFormulaIndexGetEntries(data) + MRBrewFormulaIndexGetEntryCount(data));
+}
+
+static const char *MRBrewFormulaIndexGetStrings(NSData *data)
+{
+    uint32_t sourceCount = NSSwapLittleIntToHost(MRBrewFormulaIndexGetHeader(data)->sourceCount);
+    
+    return (const char *)(MRBrewFormulaIndexGetSources(data) + sourceCount);
+}
+
+static const char *MRBrewFormulaIndexGetName(NSData *data, uint32_t index, NSUInteger *length)
+{
+    const MRBrewFormulaIndexEntry *entry = MRBrewFormulaIndexGetEntries(data) + index;
+    *length = NSSwapLittleShortToHost(entry->nameLength);
+    
+    return MRBrewFormulaIndexGetStrings(data) + NSSwapLittleIntToHost(entry->nameOffset);
+}
+
+static NSString *MRBrewFormulaIndexGetSourcePath(NSData *data, uint32_t sourceIndex)
+{
+    const MRBrewFormulaIndexSource *sourceEntry = MRBrewFormulaIndexGetSources(data) + sourceIndex;
+    
+    return [[NSString alloc] initWithBytes:MRBrewFormulaIndexGetStrings(data) + NSSwapLittleIntToHost(sourceEntry->offset)
+                                    length:NSSwapLittleIntToHost(sourceEntry->length)
+                                  encoding:NSUTF8StringEncoding];
+}
+
+static MRBrewFormula *MRBrewFormulaIndexGetFormula(NSData *data, uint32_t index)
+{
+    NSUInteger length;
+    const char *bytes = MRBrewFormulaIndexGetName(data, index, &length);
+    NSString *name = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    BOOL isInstalled = (NSSwapLittleIntToHost(MRBrewFormulaIndexGetEntries(data)[index].flags) & MRBrewFormulaIndexInstalledFlag) != 0;
+    
+    return [MRBrewFormula internedFormulaWithName:name isNew:NO isUpdated:NO isInstalled:isInstalled];
+}
+
+/* Compares two names byte for byte, ordering a name before those it prefixes. */
+static int MRBrewFormulaIndexCompareBytes(const char *first, NSUInteger firstLength, const char *second, NSUInteger secondLength)
+{
+    int result = memcmp(first, second, MIN(firstLength, secondLength));
+    if (result != 0) {
+        return result;
+    }
+    
+    return (firstLength < secondLength) ? -1 : (firstLength > secondLength ? 1 : 0);
+}
+
+/* Compares the name of an entry with a string of bytes. If prefix is YES, only
+ * the first length bytes of the name are compared.
+ */
+static int MRBrewFormulaIndexCompareName(NSData *data, uint32_t index, const char *bytes, NSUInteger length, BOOL prefix)
+{
+    NSUInteger nameLength;
+    const char *name = MRBrewFormulaIndexGetName(data, index, &nameLength);
+    
+    int result = memcmp(name, bytes, MIN(nameLength, length));
+    if (result != 0) {
+        return result;
+    }
+    
+    if (nameLength < length) {
+        return -1;
+    }
+    
+    return (nameLength > length && !prefix) ? 1 : 0;
+}
+
+/* Returns the index of the first entry whose name is not ordered before the
+ * bytes (or, if after is YES, after them).
+ */
+static uint32_t MRBrewFormulaIndexSearch(NSData *data, const char *bytes, NSUInteger length, BOOL prefix, BOOL after)
+{
+    uint32_t low = 0;
+    uint32_t high = MRBrewFormulaIndexGetEntryCount(data);
+    
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int result = MRBrewFormulaIndexCompareName(data, middle, bytes, length, prefix);
+        
+        if (result < 0 || (after && result == 0)) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+#pragma mark - Query Results
+
+/* An array of the formulae for a set of index entries, created as they are
+ * accessed. The array retains the index data it was created from, so it is
+ * unaffected by subsequent updates to the index.
+ */
+@interface MRBrewFormulaIndexResults : NSArray
+{
+    @private
+    NSData *_data;
+    NSData *_entryIndexes;
+    NSRange _range;
+}
+
+- (instancetype)initWithData:(NSData *)data range:(NSRange)range;
+- (instancetype)initWithData:(NSData *)data entryIndexes:(NSData *)entryIndexes;
+
+@end
+
+@implementation MRBrewFormulaIndexResults
+
+- (instancetype)initWithData:(NSData *)data range:(NSRange)range
+{
+    if (self = [super init]) {
+        _data = data;
+        _range = range;
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithData:(NSData *)data entryIndexes:(NSData *)entryIndexes
+{
+    if (self = [super init]) {
+        _data = data;
+        _entryIndexes = [entryIndexes copy];
+        _range = NSMakeRange(0, [entryIndexes length] / sizeof(uint32_t));
+    }
+    
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return _range.length;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= _range.length) {
+        [NSException raise:NSRangeException format:@"Index %lu beyond bounds [0 .. %lu]", (unsigned long)index, (unsigned long)_range.length];
+    }
+    
+    uint32_t entryIndex = _entryIndexes ? ((const uint32_t *)[_entryIndexes bytes])[index] : (uint32_t)(_range.location + index);
+    
+    return MRBrewFormulaIndexGetFormula(_data, entryIndex);
+}
+
+@end
+
+#pragma mark -
+
+@interface MRBrewFormulaIndex ()
+{
+    @private
+    NSData *_data;
+    NSString *_path;
+}
+
+@end
+
+@implementation MRBrewFormulaIndex
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithSearchOutput:nil listOutput:nil];
+}
+
+- (instancetype)initWithSearchOutput:(NSString *)searchOutput listOutput:(NSString *)listOutput
+{
+    if (self = [super init]) {
+        NSMutableSet *names = [NSMutableSet set];
+        if (![searchOutput hasPrefix:@"No formula found"]) {
+            [names unionSet:[[self class] formulaNamesFromOutput:searchOutput]];
+        }
+        
+        NSSet *installedNames = [[self class] formulaNamesFromOutput:listOutput];
+        [names unionSet:installedNames];
+        
+        _data = [[self class] dataWithNames:names installedNames:installedNames];
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithContentsOfFile:(NSString *)path error:(NSError * __autoreleasing *)error
+{
+    NSError *underlyingError = nil;
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:&underlyingError];
+    
+    if (!data) {
+        [[self class] errorWithCode:MRBrewFormulaIndexErrorFileAccess description:@"The index file could not be read." underlyingError:underlyingError usingPointer:error];
+        return nil;
+    }
+    
+    if (![[self class] validateData:data error:error]) {
+        return nil;
+    }
+    
+    if (self = [super init]) {
+        _data = data;
+        _path = [path copy];
+    }
+    
+    return self;
+}
+
++ (instancetype)indexWithSearchOutput:(NSString *)searchOutput listOutput:(NSString *)listOutput
+{
+    return [[self alloc] initWithSearchOutput:searchOutput listOutput:listOutput];
+}
+
++ (instancetype)indexWithContentsOfFile:(NSString *)path error:(NSError * __autoreleasing *)error
+{
+    return [[self alloc] initWithContentsOfFile:path error:error];
+}
+
+#pragma mark - Properties
+
+- (NSUInteger)count
+{
+    return MRBrewFormulaIndexGetEntryCount([self data]);
+}
+
+- (NSString *)path
+{
+    @synchronized(self) {
+        return _path;
+    }
+}
+
+- (NSData *)data
+{
+    @synchronized(self) {
+        return _data;
+    }
+}
+
+#pragma mark - Saving
+
+- (BOOL)writeToFile:(NSString *)path error:(NSError * __autoreleasing *)error
+{
+    NSError *underlyingError = nil;
+    
+    @synchronized(self) {
+        if (![_data writeToFile:path options:NSDataWritingAtomic error:&underlyingError]) {
+            [[self class] errorWithCode:MRBrewFormulaIndexErrorFileAccess description:@"The index file could not be written." underlyingError:underlyingError usingPointer:error];
+            return NO;
+        }
+        
+        _path = [path copy];
+    }
+    
+    return YES;
+}
+
+#pragma mark - Queries
+
+- (MRBrewFormula *)formulaWithName:(NSString *)name
+{
+    NSData *data = [self data];
+    const char *bytes = [name UTF8String];
+    if (!bytes) {
+        return nil;
+    }
+    
+    NSUInteger length = strlen(bytes);
+    uint32_t index = MRBrewFormulaIndexSearch(data, bytes, length, NO, NO);
+    if (index < MRBrewFormulaIndexGetEntryCount(data) && MRBrewFormulaIndexCompareName(data, index, bytes, length, NO) == 0) {
+        return MRBrewFormulaIndexGetFormula(data, index);
+    }
+    
+    return nil;
+}
+
+- (NSArray *)formulaeWithPrefix:(NSString *)prefix
+{
+    NSData *data = [self data];
+    const char *bytes = [prefix UTF8String] ?: "";
+    NSUInteger length = strlen(bytes);
+    
+    uint32_t first = MRBrewFormulaIndexSearch(data, bytes, length, YES, NO);
+    uint32_t last = MRBrewFormulaIndexSearch(data, bytes, length, YES, YES);
+    
+    return [[MRBrewFormulaIndexResults alloc] initWithData:data range:NSMakeRange(first, last - first)];
+}
+
+- (NSArray *)formulaeContainingString:(NSString *)string
+{
+    NSData *data = [self data];
+    const char *bytes = [string UTF8String] ?: "";
+    NSUInteger length = strlen(bytes);
+    uint32_t entryCount = MRBrewFormulaIndexGetEntryCount(data);
+    
+    // every name contains the empty string, and no name contains a newline
+    if (length == 0 || entryCount == 0 || memchr(bytes, '\n', length)) {
+        return [[MRBrewFormulaIndexResults alloc] initWithData:data range:NSMakeRange(0, (length == 0 ? entryCount : 0))];
+    }
+    
+    // scan the names in the string table and map each match back to the
+    // entry containing it, then continue from the start of the next name
+    const MRBrewFormulaIndexEntry *entries = MRBrewFormulaIndexGetEntries(data);
+    const char *strings = MRBrewFormulaIndexGetStrings(data);
+    NSUInteger lastNameLength;
+    const char *namesEnd = MRBrewFormulaIndexGetName(data, entryCount - 1, &lastNameLength) + lastNameLength;
+    
+    NSMutableData *entryIndexes = [NSMutableData data];
+    const char *cursor = strings;
+    uint32_t index = 0;
+    
+    while (cursor < namesEnd) {
+        const char *match = memmem(cursor, namesEnd - cursor, bytes, length);
+        if (!match) {
+            break;
+        }
+        
+        uint32_t matchOffset = (uint32_t)(match - strings);
+        while (index + 1 < entryCount && NSSwapLittleIntToHost(entries[index + 1].nameOffset) <= matchOffset) {
+            index++;
+        }
+        
+        [entryIndexes appendBytes:&index length:sizeof(index)];
+        
+        NSUInteger nameLength;
+        cursor = MRBrewFormulaIndexGetName(data, index, &nameLength) + nameLength + 1;
+        index++;
+    }
+    
+    return [[MRBrewFormulaIndexResults alloc] initWithData:data entryIndexes:entryIndexes];
+}
+
+#pragma mark - Updating
+
+- (void)updateFormulaeInDirectory:(NSString *)directory
+{
+    [self updateFormulaeInDirectories:[NSSet setWithObject:directory] installedNames:nil];
+}
+
+/* Updates the entries for the formula files in a set of directories and, if
+ * installedNames is not nil, the installed state of every entry. Entries are
+ * read from the entry table of the index without creating formulae, and the
+ * index is rebuilt and rewritten at most once, if any entry changed.
+ */
+- (void)updateFormulaeInDirectories:(NSSet *)directories installedNames:(NSSet *)installedNames
+{
+    // the formula files are listed before the index is locked
+    NSMutableDictionary *namesByDirectory = [NSMutableDictionary dictionaryWithCapacity:[directories count]];
+    for (NSString *directory in directories) {
+        NSString *standardizedDirectory = [directory stringByStandardizingPath];
+        [namesByDirectory setObject:[[self class] formulaNamesInDirectory:standardizedDirectory] forKey:standardizedDirectory];
+    }
+    
+    @synchronized(self) {
+        NSData *data = _data;
+        uint32_t entryCount = MRBrewFormulaIndexGetEntryCount(data);
+        uint32_t sourceCount = NSSwapLittleIntToHost(MRBrewFormulaIndexGetHeader(data)->sourceCount);
+        const MRBrewFormulaIndexEntry *entries = MRBrewFormulaIndexGetEntries(data);
+        __block BOOL changed = NO;
+        
+        NSMutableArray *sourcePaths = [NSMutableArray arrayWithCapacity:sourceCount + [namesByDirectory count]];
+        for (uint32_t sourceIndex = 0; sourceIndex < sourceCount; sourceIndex++) {
+            [sourcePaths addObject:MRBrewFormulaIndexGetSourcePath(data, sourceIndex) ?: @""];
+        }
+        
+        // the names listed in each directory that are not yet in the index
+        // with that directory as their source, keyed by source
+        NSMutableDictionary *pendingNamesBySource = [NSMutableDictionary dictionaryWithCapacity:[namesByDirectory count]];
+        [namesByDirectory enumerateKeysAndObjectsUsingBlock:^(NSString *directory, NSSet *names, BOOL *stop) {
+            NSUInteger sourceIndex = [sourcePaths indexOfObject:directory];
+            if (sourceIndex == NSNotFound) {
+                // an entry refers to at most UINT16_MAX - 1 sources
+                if ([sourcePaths count] >= UINT16_MAX - 1) {
+                    return;
+                }
+                sourceIndex = [sourcePaths count];
+                [sourcePaths addObject:directory];
+            }
+            [pendingNamesBySource setObject:[names mutableCopy] forKey:@(sourceIndex + 1)];
+        }];
+        
+        NSMutableData *draftData = [NSMutableData dataWithLength:entryCount * sizeof(MRBrewFormulaIndexDraftEntry)];
+        MRBrewFormulaIndexDraftEntry *drafts = [draftData mutableBytes];
+        
+        for (uint32_t index = 0; index < entryCount; index++) {
+            NSUInteger nameLength;
+            drafts[index].name = MRBrewFormulaIndexGetName(data, index, &nameLength);
+            drafts[index].nameLength = (uint16_t)nameLength;
+            drafts[index].source = NSSwapLittleShortToHost(entries[index].source);
+            drafts[index].flags = NSSwapLittleIntToHost(entries[index].flags);
+            
+            // only the names of entries from an updated directory are decoded;
+            // those no longer having a formula file are dropped
+            NSMutableSet *pendingNames = drafts[index].source ? [pendingNamesBySource objectForKey:@(drafts[index].source)] : nil;
+            if (pendingNames) {
+                NSString *name = [[NSString alloc] initWithBytes:drafts[index].name length:nameLength encoding:NSUTF8StringEncoding];
+                if (name && [pendingNames containsObject:name]) {
+                    [pendingNames removeObject:name];
+                }
+                else {
+                    drafts[index].name = NULL;
+                    changed = YES;
+                }
+            }
+        }
+        
+        // formulae of an updated directory that are in the index with another
+        // source are moved to the directory, and the rest are added
+        NSMutableArray *addedNames = [NSMutableArray array];
+        NSMutableSet *addedNameSet = [NSMutableSet set];
+        [pendingNamesBySource enumerateKeysAndObjectsUsingBlock:^(NSNumber *source, NSSet *names, BOOL *stop) {
+            for (NSString *name in names) {
+                NSData *nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+                uint32_t index = MRBrewFormulaIndexSearch(data, [nameData bytes], [nameData length], NO, NO);
+                
+                if (index < entryCount && MRBrewFormulaIndexCompareName(data, index, [nameData bytes], [nameData length], NO) == 0) {
+                    NSUInteger nameLength;
+                    drafts[index].name = MRBrewFormulaIndexGetName(data, index, &nameLength);
+                    drafts[index].source = [source unsignedShortValue];
+                }
+                else if ([nameData length] > 0 && [nameData length] <= UINT16_MAX && ![addedNameSet containsObject:name]) {
+                    [addedNameSet addObject:name];
+                    [addedNames addObject:@[nameData, source, @([installedNames containsObject:name])]];
+                }
+            }
+            
+            changed = changed || [names count] > 0;
+        }];
+        
+        // the installed state of each entry is replaced by that read from the
+        // Cellar, looking up the entry of each installed formula by name
+        if (installedNames) {
+            for (uint32_t index = 0; index < entryCount; index++) {
+                drafts[index].flags &= ~MRBrewFormulaIndexInstalledFlag;
+            }
+            
+            for (NSString *name in installedNames) {
+                NSData *nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+                uint32_t index = MRBrewFormulaIndexSearch(data, [nameData bytes], [nameData length], NO, NO);
+                if (index < entryCount && MRBrewFormulaIndexCompareName(data, index, [nameData bytes], [nameData length], NO) == 0) {
+                    drafts[index].flags |= MRBrewFormulaIndexInstalledFlag;
+                }
+            }
+            
+            for (uint32_t index = 0; index < entryCount && !changed; index++) {
+                changed = drafts[index].flags != NSSwapLittleIntToHost(entries[index].flags);
+            }
+        }
+        
+        if (!changed) {
+            return;
+        }
+        
+        [addedNames sortUsingComparator:^NSComparisonResult(NSArray *first, NSArray *second) {
+            NSData *firstName = [first objectAtIndex:0];
+            NSData *secondName = [second objectAtIndex:0];
+            int result = MRBrewFormulaIndexCompareBytes([firstName bytes], [firstName length], [secondName bytes], [secondName length]);
+            
+            return result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame);
+        }];
+        
+        // merge the added entries into the remaining entries, both of which
+        // are sorted by name
+        NSUInteger addedCount = [addedNames count];
+        NSMutableData *mergedData = [NSMutableData dataWithCapacity:(entryCount + addedCount) * sizeof(MRBrewFormulaIndexDraftEntry)];
+        uint32_t index = 0;
+        NSUInteger addedIndex = 0;
+        
+        while (index < entryCount || addedIndex < addedCount) {
+            if (index < entryCount && !drafts[index].name) {
+                index++;
+                continue;
+            }
+            
+            MRBrewFormulaIndexDraftEntry added = { NULL, 0, 0, 0 };
+            if (addedIndex < addedCount) {
+                NSArray *addedName = [addedNames objectAtIndex:addedIndex];
+                added.name = [[addedName objectAtIndex:0] bytes];
+                added.nameLength = (uint16_t)[[addedName objectAtIndex:0] length];
+                added.source = [[addedName objectAtIndex:1] unsignedShortValue];
+                added.flags = [[addedName objectAtIndex:2] boolValue] ? MRBrewFormulaIndexInstalledFlag : 0;
+            }
+            
+            if (index < entryCount && (!added.name || MRBrewFormulaIndexCompareBytes(drafts[index].name, drafts[index].nameLength, added.name, added.nameLength) < 0)) {
+                [mergedData appendBytes:&drafts[index] length:sizeof(MRBrewFormulaIndexDraftEntry)];
+                index++;
+            }
+            else {
+                [mergedData appendBytes:&added length:sizeof(MRBrewFormulaIndexDraftEntry)];
+                addedIndex++;
+            }
+        }
+        
+        _data = [[self class] dataWithEntries:[mergedData bytes] count:[mergedData length] / sizeof(MRBrewFormulaIndexDraftEntry) sourcePaths:sourcePaths];
+        
+        if (_path) {
+            [_data writeToFile:_path options:NSDataWritingAtomic error:NULL];
+        }
+    }
+}
+
+#pragma mark - MRBrewWatcherDelegate
+
+- (void)brewChangeDidOccur:(NSArray *)paths
+{
+    // a change to a formula file updates its directory, which is updated once
+    // however many of its files changed, and a change in the Cellar updates
+    // the installed state of every formula
+    NSMutableSet *directories = [NSMutableSet setWithCapacity:[paths count]];
+    NSString *cellarPath = nil;
+    for (NSString *path in paths) {
+        NSString *pathCellar = [[self class] cellarPathForPath:path];
+        if (pathCellar) {
+            cellarPath = pathCellar;
+        }
+        else {
+            [directories addObject:([[path pathExtension] isEqualToString:@"rb"] ? [path stringByDeletingLastPathComponent] : path)];
+        }
+    }
+    
+    NSSet *installedNames = nil;
+    if (cellarPath) {
+        installedNames = [[self class] installedFormulaNamesInCellar:cellarPath];
+    }
+    
+    if ([directories count] > 0 || installedNames) {
+        [self updateFormulaeInDirectories:directories installedNames:installedNames];
+    }
+}
+
+#pragma mark - Encoding
+
+/* Returns the formula names listed in an operation's output, one per line. */
++ (NSSet *)formulaNamesFromOutput:(NSString *)output
+{
+    NSMutableSet *names = [NSMutableSet set];
+    
+    [output enumerateLinesUsingBlock:^(NSString *line, BOOL *stop) {
+        NSString *name = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([name length] > 0 && ![name hasPrefix:@"==>"]) {
+            [names addObject:name];
+        }
+    }];
+    
+    return names;
+}
+
+/* Returns the names of the formulae whose files are in a directory. */
++ (NSSet *)formulaNamesInDirectory:(NSString *)directory
+{
+    NSString *tapPrefix = [self tapPrefixForDirectory:directory];
+    NSMutableSet *names = [NSMutableSet set];
+    
+    for (NSString *file in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:NULL]) {
+        if ([[file pathExtension] isEqualToString:@"rb"]) {
+            [names addObject:[tapPrefix stringByAppendingString:[file stringByDeletingPathExtension]]];
+        }
+    }
+    
+    return names;
+}
+
+/* Returns the Cellar containing a path (e.g. /usr/local/Cellar for
+ * /usr/local/Cellar/wget/1.15), or nil if the path is not in a Cellar.
+ */
++ (NSString *)cellarPathForPath:(NSString *)path
+{
+    NSArray *components = [[path stringByStandardizingPath] pathComponents];
+    NSUInteger cellarIndex = [components indexOfObject:@"Cellar"];
+    
+    if (cellarIndex == NSNotFound) {
+        return nil;
+    }
+    
+    return [NSString pathWithComponents:[components subarrayWithRange:NSMakeRange(0, cellarIndex + 1)]];
+}
+
+/* Returns the names of the formulae with a keg in a Cellar, or nil if the
+ * Cellar cannot be read.
+ */
++ (NSSet *)installedFormulaNamesInCellar:(NSString *)cellarPath
+{
+    NSDictionary *installedVersions = [[MRBrewCellar cellarWithPath:cellarPath] installedVersionsWithError:NULL];
+    
+    if (!installedVersions) {
+        return nil;
+    }
+    
+    return [installedVersions keysOfEntriesPassingTest:^BOOL(NSString *name, NSArray *versions, BOOL *stop) {
+        return [versions count] > 0;
+    }];
+}
+
+/* Returns the user/repository/ prefix Homebrew uses to name formulae in a tap
+ * directory (e.g. .../Taps/user/homebrew-repository/Formula), or an empty
+ * string for any other directory.
+ */
++ (NSString *)tapPrefixForDirectory:(NSString *)directory
+{
+    NSArray *components = [directory pathComponents];
+    NSUInteger tapsIndex = [components indexOfObject:@"Taps"];
+    
+    if (tapsIndex == NSNotFound || tapsIndex + 2 >= [components count]) {
+        return @"";
+    }
+    
+    NSString *repository = [components objectAtIndex:tapsIndex + 2];
+    if ([repository hasPrefix:@"homebrew-"]) {
+        repository = [repository substringFromIndex:[@"homebrew-" length]];
+    }
+    
+    return [NSString stringWithFormat:@"%@/%@/", [components objectAtIndex:tapsIndex + 1], repository];
+}
+
++ (NSData *)dataWithNames:(NSSet *)names installedNames:(NSSet *)installedNames
+{
+    // sort names by their UTF-8 representation so that lookups can compare bytes
+    NSMutableArray *encodedNames = [NSMutableArray arrayWithCapacity:[names count]];
+    for (NSString *name in names) {
+        NSData *encodedName = [name dataUsingEncoding:NSUTF8StringEncoding];
+        if ([encodedName length] > 0 && [encodedName length] <= UINT16_MAX) {
+            [encodedNames addObject:@[encodedName, name]];
+        }
+    }
+    
+    [encodedNames sortUsingComparator:^NSComparisonResult(NSArray *first, NSArray *second) {
+        NSData *firstName = [first objectAtIndex:0];
+        NSData *secondName = [second objectAtIndex:0];
+        int result = MRBrewFormulaIndexCompareBytes([firstName bytes], [firstName length], [secondName bytes], [secondName length]);
+        
+        return result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame);
+    }];
+    
+    NSMutableData *draftData = [NSMutableData dataWithLength:[encodedNames count] * sizeof(MRBrewFormulaIndexDraftEntry)];
+    MRBrewFormulaIndexDraftEntry *drafts = [draftData mutableBytes];
+    
+    [encodedNames enumerateObjectsUsingBlock:^(NSArray *encodedName, NSUInteger index, BOOL *stop) {
+        NSData *nameData = [encodedName objectAtIndex:0];
+        drafts[index].name = [nameData bytes];
+        drafts[index].nameLength = (uint16_t)[nameData length];
+        drafts[index].source = 0;
+        drafts[index].flags = [installedNames containsObject:[encodedName objectAtIndex:1]] ? MRBrewFormulaIndexInstalledFlag : 0;
+    }];
+    
+    return [self dataWithEntries:drafts count:[encodedNames count] sourcePaths:nil];
+}
+
+/* Encodes entries sorted by name as index data. Only the source paths that
+ * entries refer to are written, unless there are too many to refer to, in
+ * which case none are.
+ */
++ (NSData *)dataWithEntries:(const MRBrewFormulaIndexDraftEntry *)drafts count:(NSUInteger)count sourcePaths:(NSArray *)sourcePaths
+{
+    NSMutableData *sourceNumbersData = [NSMutableData dataWithLength:([sourcePaths count] + 1) * sizeof(NSUInteger)];
+    NSUInteger *sourceNumbers = [sourceNumbersData mutableBytes];
+    NSMutableArray *writtenSourcePaths = [NSMutableArray array];
+    
+    for (NSUInteger index = 0; index < count; index++) {
+        uint16_t source = drafts[index].source;
+        if (source != 0 && source <= [sourcePaths count] && sourceNumbers[source] == 0) {
+            [writtenSourcePaths addObject:[sourcePaths objectAtIndex:source - 1]];
+            sourceNumbers[source] = [writtenSourcePaths count];
+        }
+    }
+    
+    if ([writtenSourcePaths count] >= UINT16_MAX) {
+        [writtenSourcePaths removeAllObjects];
+        memset(sourceNumbers, 0, [sourceNumbersData length]);
+    }
+    
+    NSMutableData *entries = [NSMutableData dataWithCapacity:count * sizeof(MRBrewFormulaIndexEntry)];
+    NSMutableData *sourceTable = [NSMutableData data];
+    NSMutableData *strings = [NSMutableData data];
+    
+    for (NSUInteger index = 0; index < count; index++) {
+        uint16_t source = drafts[index].source;
+        
+        MRBrewFormulaIndexEntry entry;
+        entry.nameOffset = NSSwapHostIntToLittle((uint32_t)[strings length]);
+        entry.nameLength = NSSwapHostShortToLittle(drafts[index].nameLength);
+        entry.source = NSSwapHostShortToLittle((source != 0 && source <= [sourcePaths count]) ? (uint16_t)sourceNumbers[source] : 0);
+        entry.flags = NSSwapHostIntToLittle(drafts[index].flags);
+        [entries appendBytes:&entry length:sizeof(entry)];
+        
+        [strings appendBytes:drafts[index].name length:drafts[index].nameLength];
+        [strings appendBytes:"\n" length:1];
+    }
+    
+    for (NSString *sourcePath in writtenSourcePaths) {
+        NSData *pathData = [sourcePath dataUsingEncoding:NSUTF8StringEncoding];
+        
+        MRBrewFormulaIndexSource source;
+        source.offset = NSSwapHostIntToLittle((uint32_t)[strings length]);
+        source.length = NSSwapHostIntToLittle((uint32_t)[pathData length]);
+        [sourceTable appendBytes:&source length:sizeof(source)];
+        
+        [strings appendData:pathData];
+    }
+    
+    MRBrewFormulaIndexHeader header;
+    memcpy(header.magic, MRBrewFormulaIndexMagic, sizeof(header.magic));
+    header.version = NSSwapHostIntToLittle(MRBrewFormulaIndexVersion);
+    header.entryCount = NSSwapHostIntToLittle((uint32_t)count);
+    header.sourceCount = NSSwapHostIntToLittle((uint32_t)[writtenSourcePaths count]);
+    header.stringsLength = NSSwapHostIntToLittle((uint32_t)[strings length]);
+    
+    NSMutableData *data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+    [data appendData:entries];
+    [data appendData:sourceTable];
+    [data appendData:strings];
+    
+    return data;
+}
+
+/* Checks that the data is an index of a supported version, that every offset
+ * it contains is in bounds, and that the names are laid out in entry order
+ * from the start of the string table, each followed by a newline, so that
+ * queries need no further checks.
+ */
++ (BOOL)validateData:(NSData *)data error:(NSError * __autoreleasing *)error
+{
+    if ([data length] < sizeof(MRBrewFormulaIndexHeader) || memcmp(MRBrewFormulaIndexGetHeader(data)->magic, MRBrewFormulaIndexMagic, sizeof(MRBrewFormulaIndexMagic)) != 0) {
+        [self errorWithCode:MRBrewFormulaIndexErrorInvalidFormat description:@"The file is not a formula index." underlyingError:nil usingPointer:error];
+        return NO;
+    }
+    
+    const MRBrewFormulaIndexHeader *header = MRBrewFormulaIndexGetHeader(data);
+    if (NSSwapLittleIntToHost(header->version) != MRBrewFormulaIndexVersion) {
+        [self errorWithCode:MRBrewFormulaIndexErrorUnsupportedVersion description:@"The formula index was written by an unsupported version of MRBrew." underlyingError:nil usingPointer:error];
+        return NO;
+    }
+    
+    uint64_t entryCount = NSSwapLittleIntToHost(header->entryCount);
+    uint64_t sourceCount = NSSwapLittleIntToHost(header->sourceCount);
+    uint64_t stringsLength = NSSwapLittleIntToHost(header->stringsLength);
+    uint64_t expectedLength = sizeof(MRBrewFormulaIndexHeader) + entryCount * sizeof(MRBrewFormulaIndexEntry) + sourceCount * sizeof(MRBrewFormulaIndexSource) + stringsLength;
+    BOOL valid = (expectedLength == [data length]);
+    
+    const MRBrewFormulaIndexEntry *entries = valid ? MRBrewFormulaIndexGetEntries(data) : NULL;
+    const char *strings = valid ? MRBrewFormulaIndexGetStrings(data) : NULL;
+    uint64_t expectedOffset = 0;
+    for (uint32_t index = 0; valid && index < entryCount; index++) {
+        uint64_t offset = NSSwapLittleIntToHost(entries[index].nameOffset);
+        uint64_t end = offset + NSSwapLittleShortToHost(entries[index].nameLength);
+        valid = offset == expectedOffset && end < stringsLength && strings[end] == '\n' && NSSwapLittleShortToHost(entries[index].source) <= sourceCount;
+        expectedOffset = end + 1;
+    }
+    
+    const MRBrewFormulaIndexSource *sources = valid ? MRBrewFormulaIndexGetSources(data) : NULL;
+    for (uint32_t index = 0; valid && index < sourceCount; index++) {
+        uint64_t end = (uint64_t)NSSwapLittleIntToHost(sources[index].offset) + NSSwapLittleIntToHost(sources[index].length);
+        valid = end <= stringsLength;
+    }
+    
+    if (!valid) {
+        [self errorWithCode:MRBrewFormulaIndexErrorInvalidFormat description:@"The formula index is corrupt." underlyingError:nil usingPointer:error];
+    }
+    
+    return valid;
+}
+
+/* Sets the error pointer (if provided) to a newly instantiated error object
+ * with the formula index error domain and the specified error code.
+ */
++ (void)errorWithCode:(MRBrewFormulaIndexError)code description:(NSString *)description underlyingError:(NSError *)underlyingError usingPointer:(NSError * __autoreleasing *)errorPtr
+{
+    if (errorPtr) {
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+        if (underlyingError) {
+            [userInfo setObject:underlyingError forKey:NSUnderlyingErrorKey];
+        }
+        
+        *errorPtr = [NSError errorWithDomain:MRBrewFormulaIndexErrorDomain code:code userInfo:userInfo];
+    }
+}
+
+@end
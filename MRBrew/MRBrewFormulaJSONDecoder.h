@@ -0,0 +1,89 @@
+//
+//  MRBrewFormulaJSONDecoder.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/** An `MRBrewFormulaJSONDecoder` decodes `MRBrewFormula` objects from the JSON
+ * output of info, list and outdated operations performed with JSON output (see
+ * the usesJSONOutput property of the MRBrewOperation class) as the output
+ * arrives.
+ *
+ * The decoder scans the JSON as a stream of tokens rather than building a tree
+ * of Foundation objects, and only decodes the values it uses: the formula's
+ * name, its current stable version, its installed versions and its
+ * dependencies. A formula with one or more installed versions has its
+ * isInstalled property set to `YES`.
+ *
+ * Output is appended in chunks of any size using appendData: or appendString:
+ * and the decoder's handler is called with the formulae completed by each
+ * chunk. Only the incomplete token at the end of the output received so far is
+ * held by the decoder.
+ */
+@interface MRBrewFormulaJSONDecoder : NSObject
+
+/** A boolean value indicating whether the output received so far is valid
+ * JSON. Once the output is found to be invalid, further output is ignored.
+ */
+@property (readonly, getter=isValid) BOOL valid;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating a Decoder
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns an initialized decoder.
+ *
+ * @param handler The block called with each non-empty array of formulae
+ * decoded. The block is called on the thread that appended the output, or that
+ * called finish.
+ * @return An initialized decoder.
+ */
+- (instancetype)initWithHandler:(void (^)(NSArray *formulae))handler;
+
+/**-----------------------------------------------------------------------------
+ * @name Decoding Output
+ * -----------------------------------------------------------------------------
+ */
+
+/** Decodes a chunk of UTF-8 encoded JSON output.
+ *
+ * @param data The output.
+ */
+- (void)appendData:(NSData *)data;
+
+/** Decodes a chunk of JSON output.
+ *
+ * @param string The output string.
+ */
+- (void)appendString:(NSString *)string;
+
+/** Decodes any output held by the receiver and checks that the output was a
+ * single complete JSON value.
+ *
+ * @return `YES` if the output was valid JSON, otherwise `NO`.
+ */
+- (BOOL)finish;
+
+@end
@@ -0,0 +1,547 @@
+//
+//  MRBrewFormulaJSONDecoder.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewFormulaJSONDecoder.h"
+#import "MRBrewFormula.h"
+
+/* The maximum nesting depth of JSON containers accepted by the decoder. */
+#define MRBrewFormulaJSONDecoderMaximumDepth 64
+
+/* The tokens expected next by the decoder. */
+typedef NS_ENUM(NSInteger, MRBrewFormulaJSONDecoderState) {
+    MRBrewFormulaJSONDecoderStateExpectingValue,
+    MRBrewFormulaJSONDecoderStateExpectingValueOrArrayEnd,
+    MRBrewFormulaJSONDecoderStateExpectingKey,
+    MRBrewFormulaJSONDecoderStateExpectingKeyOrObjectEnd,
+    MRBrewFormulaJSONDecoderStateExpectingColon,
+    MRBrewFormulaJSONDecoderStateExpectingSeparatorOrEnd,
+    MRBrewFormulaJSONDecoderStateComplete,
+    MRBrewFormulaJSONDecoderStateInvalid
+};
+
+/* The formula fields that a string value may be decoded into. */
+typedef NS_ENUM(NSInteger, MRBrewFormulaJSONDecoderField) {
+    MRBrewFormulaJSONDecoderFieldNone,
+    MRBrewFormulaJSONDecoderFieldName,
+    MRBrewFormulaJSONDecoderFieldVersion,
+    MRBrewFormulaJSONDecoderFieldInstalledVersion,
+    MRBrewFormulaJSONDecoderFieldDependency
+};
+
+/* Returns YES for the bytes that end a number or literal token. */
+static inline BOOL MRBrewFormulaJSONDecoderIsDelimiter(char byte)
+{
+    return byte == ',' || byte == ']' || byte == '}' || byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n';
+}
+
+/* Returns the value of a hexadecimal digit, or -1 if the byte is not one. */
+static inline int MRBrewFormulaJSONDecoderHexValue(char byte)
+{
+    if (byte >= '0' && byte <= '9') return byte - '0';
+    if (byte >= 'a' && byte <= 'f') return byte - 'a' + 10;
+    if (byte >= 'A' && byte <= 'F') return byte - 'A' + 10;
+    
+    return -1;
+}
+
+/* Returns YES if a number or literal token is valid JSON. Numbers are checked
+ * for the characters they may contain rather than their full grammar.
+ */
+static BOOL MRBrewFormulaJSONDecoderIsValidScalar(const char *bytes, NSUInteger length)
+{
+    if ((length == 4 && memcmp(bytes, "true", 4) == 0) || (length == 5 && memcmp(bytes, "false", 5) == 0) || (length == 4 && memcmp(bytes, "null", 4) == 0)) {
+        return YES;
+    }
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        char byte = bytes[i];
+        if (!((byte >= '0' && byte <= '9') || byte == '-' || byte == '+' || byte == '.' || byte == 'e' || byte == 'E')) {
+            return NO;
+        }
+    }
+    
+    return length > 0;
+}
+
+@interface MRBrewFormulaJSONDecoder ()
+{
+    @private
+    void (^_handler)(NSArray *formulae);
+    NSMutableData *_pendingData;
+    MRBrewFormulaJSONDecoderState _state;
+    NSUInteger _depth;
+    BOOL _objectContainers[MRBrewFormulaJSONDecoderMaximumDepth];
+    NSMutableArray *_keys;
+    NSMutableArray *_decodedFormulae;
+    NSString *_name;
+    NSString *_version;
+    NSMutableArray *_installedVersions;
+    NSMutableArray *_dependencies;
+}
+
+@end
+
+@implementation MRBrewFormulaJSONDecoder
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithHandler:nil];
+}
+
+- (instancetype)initWithHandler:(void (^)(NSArray *formulae))handler
+{
+    if (self = [super init]) {
+        _handler = [handler copy];
+        _pendingData = [NSMutableData data];
+        _keys = [NSMutableArray array];
+        _decodedFormulae = [NSMutableArray array];
+        _state = MRBrewFormulaJSONDecoderStateExpectingValue;
+    }
+    
+    return self;
+}
+
+- (BOOL)isValid
+{
+    @synchronized(self) {
+        return _state != MRBrewFormulaJSONDecoderStateInvalid;
+    }
+}
+
+#pragma mark - Decoding
+
+- (void)appendData:(NSData *)data
+{
+    @synchronized(self) {
+        if (_state == MRBrewFormulaJSONDecoderStateInvalid) {
+            return;
+        }
+        
+        [_pendingData appendData:data];
+        [self decodePendingDataAtEnd:NO];
+        [self deliverFormulae];
+    }
+}
+
+- (void)appendString:(NSString *)string
+{
+    [self appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (BOOL)finish
+{
+    @synchronized(self) {
+        if (_state != MRBrewFormulaJSONDecoderStateInvalid) {
+            [self decodePendingDataAtEnd:YES];
+            [self deliverFormulae];
+        }
+        
+        // the output must be a single complete value followed only by
+        // whitespace, which decodePendingDataAtEnd: consumes
+        if (_state != MRBrewFormulaJSONDecoderStateComplete || [_pendingData length] > 0) {
+            _state = MRBrewFormulaJSONDecoderStateInvalid;
+        }
+        
+        return _state != MRBrewFormulaJSONDecoderStateInvalid;
+    }
+}
+
+/* Decodes the complete tokens held by the receiver, leaving any incomplete token
+ * at the end of the data to be completed by further output. At the end of the
+ * output, an incomplete number or literal is decoded as it stands. Must be
+ * called while synchronized on the receiver.
+ */
+- (void)decodePendingDataAtEnd:(BOOL)atEnd
+{
+    const char *bytes = [_pendingData bytes];
+    NSUInteger length = [_pendingData length];
+    NSUInteger position = 0;
+    
+    while (position < length && _state != MRBrewFormulaJSONDecoderStateInvalid) {
+        char byte = bytes[position];
+        
+        if (byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n') {
+            position++;
+            continue;
+        }
+        
+        if (_state == MRBrewFormulaJSONDecoderStateComplete) {
+            _state = MRBrewFormulaJSONDecoderStateInvalid;
+            break;
+        }
+        
+        if (_state == MRBrewFormulaJSONDecoderStateExpectingColon) {
+            _state = (byte == ':') ? MRBrewFormulaJSONDecoderStateExpectingValue : MRBrewFormulaJSONDecoderStateInvalid;
+            position++;
+            continue;
+        }
+        
+        if (_state == MRBrewFormulaJSONDecoderStateExpectingSeparatorOrEnd) {
+            BOOL inObject = _objectContainers[_depth - 1];
+            
+            if (byte == ',') {
+                _state = inObject ? MRBrewFormulaJSONDecoderStateExpectingKey : MRBrewFormulaJSONDecoderStateExpectingValue;
+            }
+            else if ((byte == '}' && inObject) || (byte == ']' && !inObject)) {
+                [self closeContainer];
+            }
+            else {
+                _state = MRBrewFormulaJSONDecoderStateInvalid;
+            }
+            position++;
+            continue;
+        }
+        
+        if (_state == MRBrewFormulaJSONDecoderStateExpectingKey || _state == MRBrewFormulaJSONDecoderStateExpectingKeyOrObjectEnd) {
+            if (byte == '}' && _state == MRBrewFormulaJSONDecoderStateExpectingKeyOrObjectEnd) {
+                [self closeContainer];
+                position++;
+                continue;
+            }
+            
+            if (byte != '"') {
+                _state = MRBrewFormulaJSONDecoderStateInvalid;
+                break;
+            }
+            
+            NSUInteger end = [self endOfStringInBytes:bytes length:length start:position];
+            if (end == NSNotFound) {
+                break;
+            }
+            
+            NSString *key = [self stringFromBytes:bytes start:position end:end];
+            if (!key) {
+                _state = MRBrewFormulaJSONDecoderStateInvalid;
+                break;
+            }
+            
+            [_keys replaceObjectAtIndex:(_depth - 1) withObject:key];
+            _state = MRBrewFormulaJSONDecoderStateExpectingColon;
+            position = end + 1;
+            continue;
+        }
+        
+        // the decoder is expecting a value (or the end of an empty array)
+        if (byte == ']' && _state == MRBrewFormulaJSONDecoderStateExpectingValueOrArrayEnd) {
+            [self closeContainer];
+            position++;
+        }
+        else if (byte == '{' || byte == '[') {
+            [self openContainer:(byte == '{')];
+            position++;
+        }
+        else if (byte == '"') {
+            NSUInteger end = [self endOfStringInBytes:bytes length:length start:position];
+            if (end == NSNotFound) {
+                break;
+            }
+            
+            // only strings that are used by a formula are decoded
+            MRBrewFormulaJSONDecoderField field = [self fieldForCurrentValue];
+            if (field != MRBrewFormulaJSONDecoderFieldNone) {
+                NSString *value = [self stringFromBytes:bytes start:position end:end];
+                if (!value) {
+                    _state = MRBrewFormulaJSONDecoderStateInvalid;
+                    break;
+                }
+                [self decodeString:value forField:field];
+            }
+            
+            [self completeValue];
+            position = end + 1;
+        }
+        else {
+            NSUInteger end = position;
+            while (end < length && !MRBrewFormulaJSONDecoderIsDelimiter(bytes[end])) {
+                end++;
+            }
+            
+            if (end == length && !atEnd) {
+                break;
+            }
+            
+            if (!MRBrewFormulaJSONDecoderIsValidScalar(bytes + position, end - position)) {
+                _state = MRBrewFormulaJSONDecoderStateInvalid;
+                break;
+            }
+            
+            [self completeValue];
+            position = end;
+        }
+    }
+    
+    [_pendingData replaceBytesInRange:NSMakeRange(0, position) withBytes:NULL length:0];
+}
+
+/* Returns the index of the quotation mark that ends the string starting at the
+ * specified index, or NSNotFound if the string is incomplete.
+ */
+- (NSUInteger)endOfStringInBytes:(const char *)bytes length:(NSUInteger)length start:(NSUInteger)start
+{
+    for (NSUInteger i = start + 1; i < length; i++) {
+        if (bytes[i] == '\\') {
+            i++;
+        }
+        else if (bytes[i] == '"') {
+            return i;
+        }
+    }
+    
+    return NSNotFound;
+}
+
+/* Returns the decoded contents of the string token between the quotation marks
+ * at the specified indexes, or nil if the string is not valid.
+ */
+- (NSString *)stringFromBytes:(const char *)bytes start:(NSUInteger)start end:(NSUInteger)end
+{
+    const char *contents = bytes + start + 1;
+    NSUInteger length = end - start - 1;
+    
+    if (!memchr(contents, '\\', length)) {
+        return [[NSString alloc] initWithBytes:contents length:length encoding:NSUTF8StringEncoding];
+    }
+    
+    NSMutableData *unescaped = [NSMutableData dataWithCapacity:length];
+    NSUInteger runStart = 0;
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        if (contents[i] != '\\') {
+            continue;
+        }
+        
+        [unescaped appendBytes:(contents + runStart) length:(i - runStart)];
+        
+        char escaped = contents[++i];
+        char replacement = 0;
+        switch (escaped) {
+            case '"': replacement = '"'; break;
+            case '\\': replacement = '\\'; break;
+            case '/': replacement = '/'; break;
+            case 'b': replacement = '\b'; break;
+            case 'f': replacement = '\f'; break;
+            case 'n': replacement = '\n'; break;
+            case 'r': replacement = '\r'; break;
+            case 't': replacement = '\t'; break;
+            case 'u': {
+                if (i + 4 >= length) {
+                    return nil;
+                }
+                
+                uint32_t codePoint = 0;
+                for (NSUInteger j = 1; j <= 4; j++) {
+                    int value = MRBrewFormulaJSONDecoderHexValue(contents[i + j]);
+                    if (value < 0) {
+                        return nil;
+                    }
+                    codePoint = (codePoint << 4) | (uint32_t)value;
+                }
+                i += 4;
+                
+                // combine a surrogate pair into a single code point
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 6 < length && contents[i + 1] == '\\' && contents[i + 2] == 'u') {
+                    uint32_t lowSurrogate = 0;
+                    for (NSUInteger j = 3; j <= 6; j++) {
+                        int value = MRBrewFormulaJSONDecoderHexValue(contents[i + j]);
+                        if (value < 0) {
+                            return nil;
+                        }
+                        lowSurrogate = (lowSurrogate << 4) | (uint32_t)value;
+                    }
+                    
+                    if (lowSurrogate >= 0xDC00 && lowSurrogate <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                        i += 6;
+                    }
+                }
+                
+                if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                    codePoint = 0xFFFD;
+                }
+                
+                uint8_t encoded[4];
+                NSUInteger encodedLength;
+                if (codePoint < 0x80) {
+                    encoded[0] = (uint8_t)codePoint;
+                    encodedLength = 1;
+                }
+                else if (codePoint < 0x800) {
+                    encoded[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+                    encoded[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    encodedLength = 2;
+                }
+                else if (codePoint < 0x10000) {
+                    encoded[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+                    encoded[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+                    encoded[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    encodedLength = 3;
+                }
+                else {
+                    encoded[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+                    encoded[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+                    encoded[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+                    encoded[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    encodedLength = 4;
+                }
+                [unescaped appendBytes:encoded length:encodedLength];
+                runStart = i + 1;
+                continue;
+            }
+            default:
+                return nil;
+        }
+        
+        [unescaped appendBytes:&replacement length:1];
+        runStart = i + 1;
+    }
+    
+    [unescaped appendBytes:(contents + runStart) length:(length - runStart)];
+    
+    return [[NSString alloc] initWithData:unescaped encoding:NSUTF8StringEncoding];
+}
+
+/* Opens an object or array container. An object opened directly within the
+ * top-level array begins a new formula.
+ */
+- (void)openContainer:(BOOL)isObject
+{
+    if (_depth == MRBrewFormulaJSONDecoderMaximumDepth) {
+        _state = MRBrewFormulaJSONDecoderStateInvalid;
+        return;
+    }
+    
+    _objectContainers[_depth] = isObject;
+    [_keys addObject:@""];
+    _depth++;
+    
+    if (_depth == 2 && isObject && !_objectContainers[0]) {
+        _name = nil;
+        _version = nil;
+        _installedVersions = [NSMutableArray array];
+        _dependencies = [NSMutableArray array];
+    }
+    
+    _state = isObject ? MRBrewFormulaJSONDecoderStateExpectingKeyOrObjectEnd : MRBrewFormulaJSONDecoderStateExpectingValueOrArrayEnd;
+}
+
+/* Closes the innermost container, completing a formula if the container was
+ * an object directly within the top-level array.
+ */
+- (void)closeContainer
+{
+    if (_depth == 2 && _objectContainers[1] && !_objectContainers[0] && _name) {
+        MRBrewFormula *formula = [MRBrewFormula formulaWithName:_name isNew:NO isUpdated:NO isInstalled:([_installedVersions count] > 0)];
+        [formula setVersion:_version];
+        [formula setInstalledVersions:_installedVersions];
+        [formula setDependencies:_dependencies];
+        [_decodedFormulae addObject:formula];
+    }
+    
+    _depth--;
+    [_keys removeLastObject];
+    [self completeValue];
+}
+
+/* Updates the state of the receiver once a value has been decoded. */
+- (void)completeValue
+{
+    _state = (_depth == 0) ? MRBrewFormulaJSONDecoderStateComplete : MRBrewFormulaJSONDecoderStateExpectingSeparatorOrEnd;
+}
+
+/* Returns the formula field into which a string at the current position is
+ * decoded, based on the keys of the containers enclosing it.
+ *
+ * The output of an info operation describes each formula using the "name",
+ * "versions" (with a "stable" version), "installed" (an array of objects with
+ * a "version") and "dependencies" keys, and the output of an outdated
+ * operation using the "name", "installed_versions" and "current_version" keys.
+ */
+- (MRBrewFormulaJSONDecoderField)fieldForCurrentValue
+{
+    if (_depth < 2 || _objectContainers[0] || !_objectContainers[1]) {
+        return MRBrewFormulaJSONDecoderFieldNone;
+    }
+    
+    NSString *formulaKey = [_keys objectAtIndex:1];
+    
+    if (_depth == 2) {
+        if ([formulaKey isEqualToString:@"name"])
+            return MRBrewFormulaJSONDecoderFieldName;
+        if ([formulaKey isEqualToString:@"current_version"])
+            return MRBrewFormulaJSONDecoderFieldVersion;
+    }
+    else if (_depth == 3) {
+        if (_objectContainers[2] && [formulaKey isEqualToString:@"versions"] && [[_keys objectAtIndex:2] isEqualToString:@"stable"])
+            return MRBrewFormulaJSONDecoderFieldVersion;
+        if (!_objectContainers[2] && [formulaKey isEqualToString:@"dependencies"])
+            return MRBrewFormulaJSONDecoderFieldDependency;
+        if (!_objectContainers[2] && [formulaKey isEqualToString:@"installed_versions"])
+            return MRBrewFormulaJSONDecoderFieldInstalledVersion;
+    }
+    else if (_depth == 4) {
+        if (!_objectContainers[2] && _objectContainers[3] && [formulaKey isEqualToString:@"installed"] && [[_keys objectAtIndex:3] isEqualToString:@"version"])
+            return MRBrewFormulaJSONDecoderFieldInstalledVersion;
+    }
+    
+    return MRBrewFormulaJSONDecoderFieldNone;
+}
+
+- (void)decodeString:(NSString *)value forField:(MRBrewFormulaJSONDecoderField)field
+{
+    switch (field) {
+        case MRBrewFormulaJSONDecoderFieldName:
+            _name = value;
+            break;
+        case MRBrewFormulaJSONDecoderFieldVersion:
+            _version = value;
+            break;
+        case MRBrewFormulaJSONDecoderFieldInstalledVersion:
+            [_installedVersions addObject:value];
+            break;
+        case MRBrewFormulaJSONDecoderFieldDependency:
+            [_dependencies addObject:value];
+            break;
+        case MRBrewFormulaJSONDecoderFieldNone:
+            break;
+    }
+}
+
+- (void)deliverFormulae
+{
+    if ([_decodedFormulae count] == 0) {
+        return;
+    }
+    
+    NSArray *formulae = _decodedFormulae;
+    _decodedFormulae = [NSMutableArray array];
+    
+    if (_handler) {
+        _handler(formulae);
+    }
+}
+
+@end
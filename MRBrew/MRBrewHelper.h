@@ -0,0 +1,133 @@
+//
+//  MRBrewHelper.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/** The stream on which a helper request generated output. */
+typedef NS_ENUM(NSInteger, MRBrewHelperStream) {
+    MRBrewHelperStreamOutput,
+    MRBrewHelperStreamErrorOutput
+};
+
+/** An `MRBrewHelper` manages a long-lived helper process that performs brew
+ * commands on behalf of `MRBrew`, so that operations do not each pay the cost
+ * of starting Homebrew. The helper is launched when the first request is sent
+ * and kept running until it exits or is terminated; if it exits while
+ * requests are outstanding, those requests fail and the helper is launched
+ * again for the next request.
+ *
+ * Requests and responses are exchanged over the helper's standard input and
+ * standard output as frames, each consisting of a header line of the form
+ * `<type> <identifier> <length>` followed by `length` bytes of payload:
+ *
+ * - `R` (request): the brew arguments, each terminated by a NUL byte.
+ * - `C` (cancel): an empty payload; the helper should interrupt the request.
+ * - `O` (output) and `E` (error output): bytes written by the command to its
+ *   standard output or standard error stream.
+ * - `X` (exit): the exit status of the command, in decimal. This is the last
+ *   frame sent for a request.
+ *
+ * Requests may be pipelined, and the helper may answer them in any order.
+ * The helper should exit when its standard input is closed.
+ */
+@interface MRBrewHelper : NSObject
+
+/** The path of the helper executable. */
+@property (readonly, copy) NSString *launchPath;
+
+/** The arguments with which the helper is launched. */
+@property (readonly, copy) NSArray *arguments;
+
+/** The environment of the helper process, or `nil` to inherit the environment
+ * of the current process. Takes effect the next time the helper is launched.
+ */
+@property (copy) NSDictionary *environment;
+
+/** The number of times the helper process has been launched. */
+@property (readonly) NSUInteger launchCount;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating a Helper
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns a helper for the executable at the specified path.
+ *
+ * @param launchPath The path of the helper executable.
+ * @param arguments The arguments with which the helper is launched, or `nil`.
+ * @return A helper whose process has not yet been launched.
+ */
+- (instancetype)initWithLaunchPath:(NSString *)launchPath arguments:(NSArray *)arguments;
+
+/**-----------------------------------------------------------------------------
+ * @name Sending Requests
+ * -----------------------------------------------------------------------------
+ */
+
+/** Sends a request to the helper, launching the helper if it is not running.
+ *
+ * Handlers are called on a background thread, in the order in which the
+ * helper sent the corresponding frames.
+ *
+ * @param arguments The brew arguments of the command to perform.
+ * @param dataHandler A block called with the output of the command as it
+ * arrives.
+ * @param terminationHandler A block called once the command has exited, with
+ * `exited` set to `YES` and its exit status. If the helper exited before the
+ * command did, the block is called with `exited` set to `NO`.
+ * @return An identifier for the request, or `0` if the helper could not be
+ * launched or has stopped reading requests, in which case neither handler is
+ * called. A helper that has stopped reading requests is terminated, and its
+ * outstanding requests fail.
+ */
+- (NSUInteger)sendRequestWithArguments:(NSArray *)arguments
+                           dataHandler:(void (^)(MRBrewHelperStream stream, NSData *data))dataHandler
+                    terminationHandler:(void (^)(BOOL exited, int status))terminationHandler;
+
+/** Asks the helper to interrupt a request. The terminationHandler of the
+ * request is still called once the helper reports the exit of the command.
+ *
+ * @param identifier The identifier of the request.
+ */
+- (void)cancelRequest:(NSUInteger)identifier;
+
+/**-----------------------------------------------------------------------------
+ * @name Managing the Helper Process
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns whether the helper process is running.
+ *
+ * @return `YES` if the helper process is running, otherwise `NO`.
+ */
+- (BOOL)isRunning;
+
+/** Closes the helper's standard input and terminates the helper process.
+ * Outstanding requests fail, and the helper is launched again if another
+ * request is sent.
+ */
+- (void)terminate;
+
+@end
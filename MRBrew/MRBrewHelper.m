@@ -0,0 +1,470 @@
+//
+//  MRBrewHelper.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewHelper.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+
+static const NSUInteger MRBrewHelperMaximumHeaderLength = 64;
+
+/* A request sent to the helper, along with the handlers for its responses. */
+@interface MRBrewHelperRequest : NSObject
+
+@property (copy) void (^dataHandler)(MRBrewHelperStream stream, NSData *data);
+@property (copy) void (^terminationHandler)(BOOL exited, int status);
+
+@end
+
+@implementation MRBrewHelperRequest
+
+@end
+
+@interface MRBrewHelper ()
+{
+    @private
+    NSTask *_task;
+    NSFileHandle *_requestHandle;
+    NSMutableData *_responseData;
+    NSMutableDictionary *_requests;
+    NSUInteger _lastRequestIdentifier;
+    NSUInteger _launchCount;
+    NSObject *_writeLock;
+}
+
+@end
+
+@implementation MRBrewHelper
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithLaunchPath:nil arguments:nil];
+}
+
+- (instancetype)initWithLaunchPath:(NSString *)launchPath arguments:(NSArray *)arguments
+{
+    if (!launchPath) {
+        return nil;
+    }
+    
+    if (self = [super init]) {
+        _launchPath = [launchPath copy];
+        _arguments = [arguments copy] ?: @[];
+        _requests = [NSMutableDictionary dictionary];
+        _writeLock = [[NSObject alloc] init];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    // the helper exits once its standard input is closed
+    [_requestHandle closeFile];
+}
+
+#pragma mark - Helper Process
+
+- (NSUInteger)launchCount
+{
+    @synchronized(self) {
+        return _launchCount;
+    }
+}
+
+- (BOOL)isRunning
+{
+    @synchronized(self) {
+        return [_task isRunning];
+    }
+}
+
+/* Launches the helper process. Must be called while synchronized on the
+ * receiver.
+ */
+- (BOOL)launchTask
+{
+    NSTask *task = [[NSTask alloc] init];
+    NSPipe *requestPipe = [NSPipe pipe];
+    NSPipe *responsePipe = [NSPipe pipe];
+    
+    [task setLaunchPath:_launchPath];
+    [task setArguments:_arguments];
+    [task setStandardInput:requestPipe];
+    [task setStandardOutput:responsePipe];
+    
+    NSDictionary *environment = [self environment];
+    if (environment) {
+        [task setEnvironment:environment];
+    }
+    
+#ifdef F_SETNOSIGPIPE
+    // writing a request to a helper that has exited must not raise SIGPIPE;
+    // elsewhere the signal is blocked while writing
+    fcntl([[requestPipe fileHandleForWriting] fileDescriptor], F_SETNOSIGPIPE, 1);
+#endif
+    
+    // the end of the response stream, rather than the termination of the
+    // task, marks the exit of the helper so that every response sent before
+    // it exited is read first
+    __weak MRBrewHelper *weakSelf = self;
+    __weak NSTask *weakTask = task;
+    [[responsePipe fileHandleForReading] setReadabilityHandler:^(NSFileHandle *file) {
+        NSData *data = [file availableData];
+        if ([data length] > 0) {
+            [weakSelf receiveData:data fromTask:weakTask];
+        }
+        else {
+            [file setReadabilityHandler:nil];
+            [weakSelf taskExited:weakTask];
+        }
+    }];
+    
+    @try {
+        [task launch];
+    }
+    @catch (NSException *exception) {
+        NSLog(@"MRBrewHelper: An internal exception was raised (%@: %@)", [exception name], exception);
+        [[responsePipe fileHandleForReading] setReadabilityHandler:nil];
+        return NO;
+    }
+    
+    _task = task;
+    _requestHandle = [requestPipe fileHandleForWriting];
+    _responseData = [NSMutableData data];
+    _launchCount++;
+    
+    return YES;
+}
+
+/* Forgets the helper process, returning the requests that were outstanding
+ * in the order in which they were sent. Must be called while synchronized on
+ * the receiver.
+ */
+- (NSArray *)detachTask
+{
+    NSArray *identifiers = [[_requests allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    NSArray *requests = [_requests objectsForKeys:identifiers notFoundMarker:[NSNull null]];
+    
+    [_requests removeAllObjects];
+    _task = nil;
+    _requestHandle = nil;
+    _responseData = nil;
+    
+    return requests;
+}
+
+- (void)terminate
+{
+    [self terminateTaskWithRequestHandle:nil];
+}
+
+/* Terminates the helper process, unless a request handle is specified and
+ * requests are no longer written to it because the helper has since been
+ * launched again.
+ */
+- (void)terminateTaskWithRequestHandle:(NSFileHandle *)expectedRequestHandle
+{
+    NSTask *task;
+    NSFileHandle *requestHandle;
+    NSArray *requests;
+    
+    @synchronized(self) {
+        if (expectedRequestHandle && expectedRequestHandle != _requestHandle) {
+            return;
+        }
+        
+        task = _task;
+        requestHandle = _requestHandle;
+        requests = [self detachTask];
+    }
+    
+    @try {
+        [requestHandle closeFile];
+        if ([task isRunning]) {
+            [task terminate];
+        }
+    }
+    @catch (NSException *exception) {
+        NSLog(@"MRBrewHelper: An internal exception was raised (%@: %@)", [exception name], exception);
+    }
+    
+    [self failRequests:requests];
+}
+
+- (void)taskExited:(NSTask *)task
+{
+    NSArray *requests;
+    
+    @synchronized(self) {
+        if (!task || task != _task) {
+            return;
+        }
+        
+        requests = [self detachTask];
+    }
+    
+    [self failRequests:requests];
+}
+
+- (void)failRequests:(NSArray *)requests
+{
+    for (MRBrewHelperRequest *request in requests) {
+        if ([request terminationHandler]) {
+            [request terminationHandler](NO, 0);
+        }
+    }
+}
+
+#pragma mark - Requests
+
+- (NSUInteger)sendRequestWithArguments:(NSArray *)arguments
+                           dataHandler:(void (^)(MRBrewHelperStream stream, NSData *data))dataHandler
+                    terminationHandler:(void (^)(BOOL exited, int status))terminationHandler
+{
+    MRBrewHelperRequest *request = [[MRBrewHelperRequest alloc] init];
+    [request setDataHandler:dataHandler];
+    [request setTerminationHandler:terminationHandler];
+    
+    NSMutableData *payload = [NSMutableData data];
+    for (NSString *argument in arguments) {
+        [payload appendData:[argument dataUsingEncoding:NSUTF8StringEncoding]];
+        [payload appendBytes:"\0" length:1];
+    }
+    
+    NSUInteger identifier;
+    NSFileHandle *requestHandle;
+    
+    @synchronized(self) {
+        if (!_task && ![self launchTask]) {
+            return 0;
+        }
+        
+        identifier = ++_lastRequestIdentifier;
+        [_requests setObject:request forKey:@(identifier)];
+        requestHandle = _requestHandle;
+    }
+    
+    // a helper that no longer reads its requests is treated as having exited,
+    // and the request is not sent so that it can be performed by brew instead
+    if (![self writeFrameOfType:'R' identifier:identifier payload:payload toHandle:requestHandle]) {
+        @synchronized(self) {
+            [_requests removeObjectForKey:@(identifier)];
+        }
+        [self terminateTaskWithRequestHandle:requestHandle];
+        return 0;
+    }
+    
+    return identifier;
+}
+
+- (void)cancelRequest:(NSUInteger)identifier
+{
+    NSFileHandle *requestHandle;
+    
+    @synchronized(self) {
+        if (![_requests objectForKey:@(identifier)]) {
+            return;
+        }
+        
+        requestHandle = _requestHandle;
+    }
+    
+    if (![self writeFrameOfType:'C' identifier:identifier payload:nil toHandle:requestHandle]) {
+        [self terminateTaskWithRequestHandle:requestHandle];
+    }
+}
+
+/* Writes bytes to a descriptor, returning NO if they could not all be written,
+ * which means the helper has closed its standard input. Where the descriptor
+ * cannot be set not to raise SIGPIPE, the signal is blocked on the calling
+ * thread while writing, and a SIGPIPE raised by the write is discarded before
+ * it is unblocked, so that a helper that has exited never terminates the
+ * process.
+ */
+static BOOL MRBrewHelperWriteBytes(int descriptor, const char *bytes, size_t length)
+{
+#ifndef F_SETNOSIGPIPE
+    sigset_t pipeSignal;
+    sigset_t previousMask;
+    sigset_t pendingSignals;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previousMask);
+    
+    // a SIGPIPE that was already pending was not raised by this write
+    sigpending(&pendingSignals);
+    BOOL signalWasPending = sigismember(&pendingSignals, SIGPIPE);
+#endif
+    
+    int errorNumber = 0;
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = write(descriptor, bytes + written, length - written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            errorNumber = errno;
+            break;
+        }
+        written += (size_t)result;
+    }
+    
+#ifndef F_SETNOSIGPIPE
+    if (errorNumber == EPIPE && !signalWasPending) {
+        struct timespec timeout = {0, 0};
+        while (sigtimedwait(&pipeSignal, NULL, &timeout) == -1 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+#endif
+    
+    return errorNumber == 0;
+}
+
+/* Writes a frame to the helper, returning NO if the helper is no longer
+ * reading its requests. Writes are serialized separately from the receiver
+ * so that a helper that is slow to read its requests never blocks the
+ * delivery of its responses.
+ */
+- (BOOL)writeFrameOfType:(char)type identifier:(NSUInteger)identifier payload:(NSData *)payload toHandle:(NSFileHandle *)requestHandle
+{
+    NSMutableData *frame = [[[NSString stringWithFormat:@"%c %lu %lu\n", type, (unsigned long)identifier, (unsigned long)[payload length]] dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    if (payload) {
+        [frame appendData:payload];
+    }
+    
+    if (!requestHandle) {
+        return NO;
+    }
+    
+    @synchronized(_writeLock) {
+        return MRBrewHelperWriteBytes([requestHandle fileDescriptor], [frame bytes], [frame length]);
+    }
+}
+
+#pragma mark - Responses
+
+- (void)receiveData:(NSData *)data fromTask:(NSTask *)task
+{
+    NSMutableArray *events = [NSMutableArray array];
+    BOOL malformed = NO;
+    
+    @synchronized(self) {
+        if (!task || task != _task) {
+            return;
+        }
+        
+        [_responseData appendData:data];
+        
+        const char *bytes = [_responseData bytes];
+        NSUInteger length = [_responseData length];
+        NSUInteger offset = 0;
+        
+        while (offset < length) {
+            const char *newline = memchr(bytes + offset, '\n', length - offset);
+            if (!newline) {
+                malformed = length - offset > MRBrewHelperMaximumHeaderLength;
+                break;
+            }
+            
+            NSUInteger headerLength = (NSUInteger)(newline - (bytes + offset)) + 1;
+            char header[MRBrewHelperMaximumHeaderLength + 1];
+            char type;
+            unsigned long identifier;
+            unsigned long payloadLength;
+            
+            if (headerLength > MRBrewHelperMaximumHeaderLength) {
+                malformed = YES;
+                break;
+            }
+            
+            memcpy(header, bytes + offset, headerLength);
+            header[headerLength] = '\0';
+            if (sscanf(header, "%c %lu %lu\n", &type, &identifier, &payloadLength) != 3) {
+                malformed = YES;
+                break;
+            }
+            
+            // wait for the rest of the frame
+            if (length - offset - headerLength < payloadLength) {
+                break;
+            }
+            
+            NSData *payload = [NSData dataWithBytes:(bytes + offset + headerLength) length:payloadLength];
+            offset += headerLength + payloadLength;
+            
+            // responses to requests that are no longer outstanding are ignored
+            MRBrewHelperRequest *request = [_requests objectForKey:@(identifier)];
+            if (!request) {
+                continue;
+            }
+            
+            if (type == 'O' || type == 'E') {
+                MRBrewHelperStream stream = type == 'O' ? MRBrewHelperStreamOutput : MRBrewHelperStreamErrorOutput;
+                void (^dataHandler)(MRBrewHelperStream, NSData *) = [request dataHandler];
+                if (dataHandler) {
+                    [events addObject:[^{
+                        dataHandler(stream, payload);
+                    } copy]];
+                }
+            }
+            else if (type == 'X') {
+                int status = [[[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding] intValue];
+                void (^terminationHandler)(BOOL, int) = [request terminationHandler];
+                [_requests removeObjectForKey:@(identifier)];
+                if (terminationHandler) {
+                    [events addObject:[^{
+                        terminationHandler(YES, status);
+                    } copy]];
+                }
+            }
+            else {
+                malformed = YES;
+                break;
+            }
+        }
+        
+        [_responseData replaceBytesInRange:NSMakeRange(0, offset) withBytes:NULL length:0];
+    }
+    
+    for (void (^event)(void) in events) {
+        event();
+    }
+    
+    // a helper that does not follow the protocol cannot be relied upon, so it
+    // is stopped and its outstanding requests fail
+    if (malformed) {
+        NSLog(@"MRBrewHelper: The helper sent a malformed response and will be terminated");
+        [self terminate];
+    }
+}
+
+@end
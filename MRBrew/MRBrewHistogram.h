@@ -0,0 +1,78 @@
+//
+//  MRBrewHistogram.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/** An `MRBrewHistogram` aggregates durations into buckets whose upper bounds
+ * double from one millisecond, so that the distribution of a large number of
+ * durations can be kept in a fixed amount of memory. The final bucket holds
+ * every duration longer than the upper bound of the bucket before it.
+ */
+@interface MRBrewHistogram : NSObject <NSCopying>
+
+/** The number of durations recorded. */
+@property (readonly) NSUInteger count;
+
+/** The shortest duration recorded, or zero if none have been recorded. */
+@property (readonly) NSTimeInterval minimum;
+
+/** The longest duration recorded, or zero if none have been recorded. */
+@property (readonly) NSTimeInterval maximum;
+
+/** The mean of the durations recorded, or zero if none have been recorded. */
+@property (readonly) NSTimeInterval mean;
+
+/** Records a duration.
+ *
+ * @param duration The duration, in seconds.
+ */
+- (void)recordDuration:(NSTimeInterval)duration;
+
+/** Returns an upper bound for the duration below which the specified
+ * percentage of recorded durations fall.
+ *
+ * @param percentile The percentile, between 0 and 100.
+ * @return The upper bound of the bucket containing the percentile, limited to
+ * the maximum recorded duration, or zero if no durations have been recorded.
+ */
+- (NSTimeInterval)durationAtPercentile:(double)percentile;
+
+/** Returns the number of buckets. */
+- (NSUInteger)bucketCount;
+
+/** Returns the number of durations recorded in a bucket.
+ *
+ * @param index The index of the bucket.
+ */
+- (NSUInteger)countForBucketAtIndex:(NSUInteger)index;
+
+/** Returns the upper bound of the durations recorded in a bucket, or
+ * `DBL_MAX` for the final bucket.
+ *
+ * @param index The index of the bucket.
+ */
+- (NSTimeInterval)upperBoundForBucketAtIndex:(NSUInteger)index;
+
+@end
@@ -0,0 +1,171 @@
+//
+//  MRBrewHistogram.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewHistogram.h"
+#include <float.h>
+
+// buckets from 1ms up to 2^20ms (about 17 minutes), plus one for longer
+#define MRBrewHistogramBucketCount 22
+static const NSTimeInterval MRBrewHistogramFirstUpperBound = 0.001;
+
+@interface MRBrewHistogram ()
+{
+    @private
+    NSUInteger _bucketCounts[MRBrewHistogramBucketCount];
+    NSUInteger _count;
+    NSTimeInterval _minimum;
+    NSTimeInterval _maximum;
+    NSTimeInterval _sum;
+}
+
+@end
+
+@implementation MRBrewHistogram
+
+#pragma mark - Recording Durations
+
+- (void)recordDuration:(NSTimeInterval)duration
+{
+    duration = MAX(duration, 0);
+    
+    NSUInteger index = 0;
+    NSTimeInterval upperBound = MRBrewHistogramFirstUpperBound;
+    while (index < MRBrewHistogramBucketCount - 1 && duration > upperBound) {
+        upperBound *= 2;
+        index++;
+    }
+    
+    @synchronized(self) {
+        _bucketCounts[index]++;
+        _minimum = _count == 0 ? duration : MIN(_minimum, duration);
+        _maximum = MAX(_maximum, duration);
+        _sum += duration;
+        _count++;
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized(self) {
+        return _count;
+    }
+}
+
+- (NSTimeInterval)minimum
+{
+    @synchronized(self) {
+        return _minimum;
+    }
+}
+
+- (NSTimeInterval)maximum
+{
+    @synchronized(self) {
+        return _maximum;
+    }
+}
+
+- (NSTimeInterval)mean
+{
+    @synchronized(self) {
+        return _count > 0 ? _sum / _count : 0;
+    }
+}
+
+- (NSTimeInterval)durationAtPercentile:(double)percentile
+{
+    @synchronized(self) {
+        if (_count == 0) {
+            return 0;
+        }
+        
+        NSUInteger rank = (NSUInteger)ceil((MIN(MAX(percentile, 0), 100) / 100.0) * _count);
+        NSUInteger cumulativeCount = 0;
+        
+        for (NSUInteger index = 0; index < MRBrewHistogramBucketCount; index++) {
+            cumulativeCount += _bucketCounts[index];
+            if (cumulativeCount >= MAX(rank, 1)) {
+                return MIN([self upperBoundForBucketAtIndex:index], _maximum);
+            }
+        }
+        
+        return _maximum;
+    }
+}
+
+#pragma mark - Buckets
+
+- (NSUInteger)bucketCount
+{
+    return MRBrewHistogramBucketCount;
+}
+
+- (NSUInteger)countForBucketAtIndex:(NSUInteger)index
+{
+    if (index >= MRBrewHistogramBucketCount) {
+        return 0;
+    }
+    
+    @synchronized(self) {
+        return _bucketCounts[index];
+    }
+}
+
+- (NSTimeInterval)upperBoundForBucketAtIndex:(NSUInteger)index
+{
+    if (index >= MRBrewHistogramBucketCount - 1) {
+        return DBL_MAX;
+    }
+    
+    return ldexp(MRBrewHistogramFirstUpperBound, (int)index);
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    MRBrewHistogram *histogram = [[[self class] allocWithZone:zone] init];
+    
+    @synchronized(self) {
+        memcpy(histogram->_bucketCounts, _bucketCounts, sizeof(_bucketCounts));
+        histogram->_count = _count;
+        histogram->_minimum = _minimum;
+        histogram->_maximum = _maximum;
+        histogram->_sum = _sum;
+    }
+    
+    return histogram;
+}
+
+#pragma mark - NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, count: %lu, mean: %.1fms, p50: %.1fms, p99: %.1fms, maximum: %.1fms>",
+            [self class], self, (unsigned long)[self count], [self mean] * 1000.0,
+            [self durationAtPercentile:50] * 1000.0, [self durationAtPercentile:99] * 1000.0, [self maximum] * 1000.0];
+}
+
+@end
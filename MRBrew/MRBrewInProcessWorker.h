@@ -0,0 +1,57 @@
+//
+//  MRBrewInProcessWorker.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewDelegate.h"
+
+@class MRBrewOperation;
+
+/* An MRBrewInProcessWorker performs an in-process operation on one of the
+ * queues of MRBrew, so that the operation is counted and cancelled along with
+ * the workers that launch brew. Like an MRBrewWorker it has an operation and
+ * responds to cancelForDelegate:.
+ *
+ * The worker answers its operation by calling its reader. If the reader
+ * returns nil, the fallback handler is called to perform the operation with
+ * brew instead; otherwise the formulae are delivered to the delegate along
+ * with the output brew would have written. A worker that is cancelled before
+ * its outcome has been delivered fails with a cancellation error instead, so
+ * its delegate never receives brewOperationDidFinish: after a cancellation.
+ */
+@interface MRBrewInProcessWorker : NSOperation
+
+@property (copy) MRBrewOperation *operation;
+@property (weak) id<MRBrewDelegate> delegate;
+@property (copy) NSArray *(^reader)(void);
+@property (copy) void (^fallbackHandler)(MRBrewOperation *operation, id<MRBrewDelegate> delegate);
+
+/* The queue on which the delegate is sent messages; the main queue by
+ * default. If nil, the delegate is sent messages on the worker's thread.
+ */
+@property (strong) NSOperationQueue *delegateQueue;
+
+- (void)cancelForDelegate:(id<MRBrewDelegate>)delegate;
+
+@end
@@ -0,0 +1,149 @@
+//
+//  MRBrewInProcessWorker.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewInProcessWorker.h"
+#import "MRBrew.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+
+static NSString * const MRBrewErrorDomain = @"uk.co.fidgetbox.MRBrew";
+
+@interface MRBrewInProcessWorker ()
+{
+    @private
+    BOOL _outcomeEnqueued;
+}
+
+@end
+
+@implementation MRBrewInProcessWorker
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _delegateQueue = [NSOperationQueue mainQueue];
+    }
+    
+    return self;
+}
+
+#pragma mark - Performing the Operation
+
+- (void)start
+{
+    // a queued worker that was cancelled is not performed, but reports the
+    // cancellation so that every operation either finishes or fails
+    if ([self isCancelled]) {
+        [self deliverFormulae:nil];
+    }
+    
+    [super start];
+}
+
+- (void)main
+{
+    if ([self isCancelled]) {
+        [self deliverFormulae:nil];
+        return;
+    }
+    
+    NSArray *formulae = [self reader] ? [self reader]() : nil;
+    
+    if (!formulae && ![self isCancelled] && [self fallbackHandler]) {
+        [self fallbackHandler]([self operation], [self delegate]);
+        return;
+    }
+    
+    [self deliverFormulae:formulae];
+}
+
+/* Delivers the outcome of the operation once: the formulae, or a cancellation
+ * error if the worker has been cancelled by the time the outcome is delivered
+ * or there are no formulae.
+ */
+- (void)deliverFormulae:(NSArray *)formulae
+{
+    @synchronized(self) {
+        if (_outcomeEnqueued) {
+            return;
+        }
+        
+        _outcomeEnqueued = YES;
+    }
+    
+    // the output is that of brew list, which names one formula on each line
+    NSMutableString *output = [NSMutableString string];
+    for (MRBrewFormula *formula in formulae) {
+        [output appendString:[formula name]];
+        [output appendString:@"\n"];
+    }
+    
+    MRBrewOperation *operation = [self operation];
+    __weak id<MRBrewDelegate> weakDelegate = [self delegate];
+    
+    void (^delivery)(void) = ^{
+        id<MRBrewDelegate> delegate = weakDelegate;
+        
+        if (!formulae || [self isCancelled]) {
+            if ([delegate respondsToSelector:@selector(brewOperation:didFailWithError:)]) {
+                [delegate brewOperation:operation didFailWithError:[NSError errorWithDomain:MRBrewErrorDomain code:MRBrewErrorOperationCancelled userInfo:nil]];
+            }
+            return;
+        }
+        
+        if ([output length] > 0 && [delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
+            [delegate brewOperation:operation didGenerateOutput:output];
+        }
+        
+        if ([formulae count] > 0 && [delegate respondsToSelector:@selector(brewOperation:didParseObjects:)]) {
+            [delegate brewOperation:operation didParseObjects:formulae];
+        }
+        
+        if ([delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
+            [delegate brewOperationDidFinish:operation];
+        }
+    };
+    
+    NSOperationQueue *queue = [self delegateQueue];
+    if (queue) {
+        [queue addOperationWithBlock:delivery];
+    }
+    else {
+        delivery();
+    }
+}
+
+#pragma mark - Cancellation
+
+- (void)cancelForDelegate:(id<MRBrewDelegate>)delegate
+{
+    if (delegate == [self delegate]) {
+        [self cancel];
+    }
+}
+
+@end
@@ -0,0 +1,52 @@
+//
+//  MRBrewInotifyWatcherBackend.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "MRBrewWatcherBackend.h"
+
+#ifdef __linux__
+
+/* An MRBrewInotifyWatcherBackend watches for events with an inotify instance,
+ * which is read by a dispatch source on the queue of the backend.
+ *
+ * inotify does not watch directories recursively, so the backend adds a
+ * watch for every directory below the watched paths, and keeps a map of
+ * watch descriptors to the directories they watch in order to resolve the
+ * path of each event. Directories created or moved below a watched path are
+ * watched as they appear, and their contents are reported as created, since
+ * items may be created in them before they are watched. Watches for
+ * directories moved away are removed, as inotify keeps watching a directory
+ * wherever it is moved. Directories deeper than the maximum depth are not
+ * watched, although their creation is reported.
+ *
+ * If the inotify queue overflows then events are dropped, so the watches are
+ * added again and a rescan event is reported for each watched path.
+ *
+ * A backend watches at most once; stopping it closes its inotify instance.
+ */
+@interface MRBrewInotifyWatcherBackend : NSObject <MRBrewWatcherBackend>
+
+@end
+
+#endif
@@ -0,0 +1,378 @@
+//
+//  MRBrewInotifyWatcherBackend.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import "MRBrewInotifyWatcherBackend.h"
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fts.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const uint32_t MRBrewInotifyWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB |
+                                               IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+                                               IN_ONLYDIR | IN_DONT_FOLLOW;
+
+static const size_t MRBrewInotifyBufferSize = 64 * 1024;
+
+/* Returns the watcher events for the mask of an inotify event. */
+static MRBrewWatcherEvent MRBrewInotifyWatcherEvents(uint32_t mask)
+{
+    MRBrewWatcherEvent events = 0;
+    
+    if (mask & (IN_CREATE | IN_MOVED_TO)) {
+        events |= MRBrewWatcherCreatedEvent;
+    }
+    if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        events |= MRBrewWatcherRemovedEvent;
+    }
+    if (mask & (IN_MODIFY | IN_ATTRIB)) {
+        events |= MRBrewWatcherModifiedEvent;
+    }
+    
+    return events;
+}
+
+@interface MRBrewInotifyWatcherBackend ()
+{
+    @private
+    NSArray *_paths;
+    dispatch_queue_t _queue;
+    MRBrewWatcherBackendHandler _handler;
+    int _descriptor;
+    dispatch_source_t _source;
+    char *_buffer;
+    NSMutableDictionary *_pathsByWatch;
+    NSMutableDictionary *_watchesByPath;
+    NSMutableDictionary *_depthsByWatch;
+}
+
+@end
+
+@implementation MRBrewInotifyWatcherBackend
+
+@synthesize maximumDepth = _maximumDepth;
+
+#pragma mark - Lifecycle
+
+- (instancetype)initWithPaths:(NSArray *)paths queue:(dispatch_queue_t)queue handler:(MRBrewWatcherBackendHandler)handler
+{
+    if (self = [super init]) {
+        _paths = [paths copy];
+        _queue = queue;
+#if !OS_OBJECT_USE_OBJC
+        dispatch_retain(_queue);
+#endif
+        _handler = [handler copy];
+        _descriptor = -1;
+        _maximumDepth = NSUIntegerMax;
+        _pathsByWatch = [NSMutableDictionary dictionary];
+        _watchesByPath = [NSMutableDictionary dictionary];
+        _depthsByWatch = [NSMutableDictionary dictionary];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self stopWatching];
+    
+    free(_buffer);
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_queue);
+#endif
+}
+
+#pragma mark - Control
+
+- (BOOL)startWatching
+{
+    if (_descriptor >= 0) {
+        return _source != NULL;
+    }
+    
+    _descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_descriptor < 0) {
+        return NO;
+    }
+    
+    if (!_buffer) {
+        _buffer = malloc(MRBrewInotifyBufferSize);
+    }
+    
+    // watches are added before the source is resumed, so the map of watches
+    // is only used on the queue from then on
+    BOOL watching = NO;
+    for (NSString *path in _paths) {
+        watching |= [self addWatchesAtPath:path depth:_maximumDepth reportingContents:NO];
+    }
+    
+    if (watching && _buffer) {
+        _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)_descriptor, 0, _queue);
+    }
+    
+    if (!_source) {
+        close(_descriptor);
+        _descriptor = -1;
+        [_pathsByWatch removeAllObjects];
+        [_watchesByPath removeAllObjects];
+        [_depthsByWatch removeAllObjects];
+        return NO;
+    }
+    
+    __weak MRBrewInotifyWatcherBackend *weakBackend = self;
+    dispatch_source_t source = _source;
+    int descriptor = _descriptor;
+    
+    dispatch_source_set_event_handler(_source, ^{
+        [weakBackend readEvents];
+    });
+    dispatch_source_set_cancel_handler(_source, ^{
+        close(descriptor);
+#if !OS_OBJECT_USE_OBJC
+        dispatch_release(source);
+#endif
+    });
+    dispatch_resume(_source);
+    
+    return YES;
+}
+
+- (void)stopWatching
+{
+    if (!_source) {
+        return;
+    }
+    
+    // the descriptor is closed by the source once it has been cancelled, and
+    // events already being read are read from it until then
+    dispatch_source_cancel(_source);
+    _source = NULL;
+}
+
+#pragma mark - Watches
+
+/* Adds a watch for a directory and every directory up to a depth below it,
+ * reporting the items below the directory as created if required. Returns NO
+ * if the directory could not be watched.
+ */
+- (BOOL)addWatchesAtPath:(NSString *)path depth:(NSUInteger)depth reportingContents:(BOOL)reportsContents
+{
+    char * const paths[] = { (char *)[path fileSystemRepresentation], NULL };
+    FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR | FTS_NOSTAT, NULL);
+    
+    if (!fts) {
+        return NO;
+    }
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    BOOL watching = NO;
+    FTSENT *entry;
+    
+    while ((entry = fts_read(fts))) {
+        if (entry->fts_info == FTS_DP || entry->fts_info == FTS_DNR || entry->fts_info == FTS_ERR) {
+            continue;
+        }
+        
+        NSString *entryPath = [fileManager stringWithFileSystemRepresentation:entry->fts_path length:entry->fts_pathlen];
+        
+        // directories deeper than the depth are reported, but not watched
+        if (entry->fts_info == FTS_D && (NSUInteger)entry->fts_level > depth) {
+            fts_set(fts, entry, FTS_SKIP);
+        }
+        else if (entry->fts_info == FTS_D) {
+            int watch = inotify_add_watch(_descriptor, entry->fts_path, MRBrewInotifyWatchMask);
+            
+            // a directory that cannot be watched is not descended into
+            if (watch < 0) {
+                fts_set(fts, entry, FTS_SKIP);
+                continue;
+            }
+            
+            NSUInteger remainingDepth = (depth == NSUIntegerMax) ? NSUIntegerMax : depth - (NSUInteger)entry->fts_level;
+            [self recordWatch:watch forPath:entryPath depth:remainingDepth];
+            if (entry->fts_level == FTS_ROOTLEVEL) {
+                watching = YES;
+            }
+            
+            // the contents of the deepest directories are only read to be
+            // reported
+            if (!reportsContents && (NSUInteger)entry->fts_level == depth) {
+                fts_set(fts, entry, FTS_SKIP);
+            }
+        }
+        
+        if (reportsContents && entry->fts_level > FTS_ROOTLEVEL) {
+            _handler(entryPath, MRBrewWatcherCreatedEvent);
+        }
+    }
+    
+    fts_close(fts);
+    
+    return watching;
+}
+
+/* Records the directory watched by a watch descriptor, and the depth below
+ * it that is watched. inotify returns the existing descriptor when a
+ * directory is watched again, so a directory watched under another path is
+ * forgotten under that path.
+ */
+- (void)recordWatch:(int)watch forPath:(NSString *)path depth:(NSUInteger)depth
+{
+    NSNumber *key = @(watch);
+    NSString *previousPath = [_pathsByWatch objectForKey:key];
+    
+    if (previousPath) {
+        [_watchesByPath removeObjectForKey:previousPath];
+    }
+    
+    [_pathsByWatch setObject:path forKey:key];
+    [_watchesByPath setObject:key forKey:path];
+    [_depthsByWatch setObject:@(depth) forKey:key];
+}
+
+/* Removes the watches for a directory and every directory below it. */
+- (void)removeWatchesAtPath:(NSString *)path
+{
+    NSString *prefix = [path stringByAppendingString:@"/"];
+    
+    for (NSString *watchedPath in [_watchesByPath allKeys]) {
+        if (![watchedPath isEqualToString:path] && ![watchedPath hasPrefix:prefix]) {
+            continue;
+        }
+        
+        NSNumber *key = [_watchesByPath objectForKey:watchedPath];
+        inotify_rm_watch(_descriptor, [key intValue]);
+        [_pathsByWatch removeObjectForKey:key];
+        [_depthsByWatch removeObjectForKey:key];
+        [_watchesByPath removeObjectForKey:watchedPath];
+    }
+}
+
+/* Removes every watch. The events still queued for them are ignored, as
+ * inotify does not reuse watch descriptors while the instance is open.
+ */
+- (void)removeAllWatches
+{
+    for (NSNumber *key in [_pathsByWatch allKeys]) {
+        inotify_rm_watch(_descriptor, [key intValue]);
+    }
+    
+    [_pathsByWatch removeAllObjects];
+    [_watchesByPath removeAllObjects];
+    [_depthsByWatch removeAllObjects];
+}
+
+#pragma mark - Events
+
+- (void)readEvents
+{
+    for (;;) {
+        ssize_t length = read(_descriptor, _buffer, MRBrewInotifyBufferSize);
+        
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            break;
+        }
+        
+        char *position = _buffer;
+        while (position < _buffer + length) {
+            struct inotify_event *event = (struct inotify_event *)position;
+            [self handleEvent:event];
+            position += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+- (void)handleEvent:(const struct inotify_event *)event
+{
+    // the directories created or moved while events were dropped are not
+    // watched, so every watch is added again before the paths are rescanned
+    if (event->mask & IN_Q_OVERFLOW) {
+        [self removeAllWatches];
+        for (NSString *path in _paths) {
+            [self addWatchesAtPath:path depth:_maximumDepth reportingContents:NO];
+        }
+        for (NSString *path in _paths) {
+            _handler(path, MRBrewWatcherRescanEvent);
+        }
+        return;
+    }
+    
+    NSNumber *key = @(event->wd);
+    NSString *directory = [_pathsByWatch objectForKey:key];
+    
+    // events may still be queued for a watch that has been removed
+    if (!directory) {
+        return;
+    }
+    
+    // the directory may have been watched again by another descriptor
+    if (event->mask & IN_IGNORED) {
+        [_pathsByWatch removeObjectForKey:key];
+        [_depthsByWatch removeObjectForKey:key];
+        if ([[_watchesByPath objectForKey:directory] isEqualToNumber:key]) {
+            [_watchesByPath removeObjectForKey:directory];
+        }
+        return;
+    }
+    
+    NSString *path = directory;
+    if (event->len > 0) {
+        NSString *name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:event->name length:strlen(event->name)];
+        path = [directory stringByAppendingPathComponent:name];
+    }
+    
+    if ((event->mask & IN_ISDIR) && event->len > 0) {
+        if (event->mask & IN_MOVED_FROM) {
+            [self removeWatchesAtPath:path];
+        }
+        NSUInteger depth = [[_depthsByWatch objectForKey:key] unsignedIntegerValue];
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && depth > 0) {
+            [self addWatchesAtPath:path depth:(depth == NSUIntegerMax ? NSUIntegerMax : depth - 1) reportingContents:YES];
+        }
+    }
+    
+    // a watched path that is moved away is no longer below its parent
+    if (event->mask & IN_MOVE_SELF) {
+        [self removeWatchesAtPath:directory];
+    }
+    
+    MRBrewWatcherEvent events = MRBrewInotifyWatcherEvents(event->mask);
+    if (events) {
+        _handler(path, events);
+    }
+}
+
+@end
+
+#endif
@@ -0,0 +1,65 @@
+//
+//  MRBrewKegChanges.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+/** An `MRBrewKegChanges` object describes how the installed formulae (kegs)
+ * of a Homebrew installation changed between two snapshots taken by an
+ * `MRBrewWatcher` created with initWithPrefix:delegate:.
+ *
+ * Each array contains `MRBrewFormula` objects whose installedVersions are the
+ * versions installed after the change. Installed formulae have isNew set, and
+ * upgraded formulae have isUpdated set; removed formulae have neither
+ * isInstalled set nor any installed versions. A formula may appear in more
+ * than one array, for example when it is upgraded and then linked.
+ */
+@interface MRBrewKegChanges : NSObject
+
+/** The formulae that were installed. */
+@property (readonly, copy) NSArray *installedFormulae;
+
+/** The formulae that were removed. */
+@property (readonly, copy) NSArray *removedFormulae;
+
+/** The formulae for which a version was installed alongside those installed
+ * previously.
+ */
+@property (readonly, copy) NSArray *upgradedFormulae;
+
+/** The formulae that were linked, or linked to another version. */
+@property (readonly, copy) NSArray *linkedFormulae;
+
+/** The formulae that were unlinked. */
+@property (readonly, copy) NSArray *unlinkedFormulae;
+
+/** The formulae that were pinned, or pinned to another version. */
+@property (readonly, copy) NSArray *pinnedFormulae;
+
+/** The formulae that were unpinned. */
+@property (readonly, copy) NSArray *unpinnedFormulae;
+
+/** Whether no formulae changed. */
+- (BOOL)isEmpty;
+
+@end
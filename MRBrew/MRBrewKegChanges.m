@@ -0,0 +1,54 @@
+//
+//  MRBrewKegChanges.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import "MRBrewKegChanges.h"
+#import "MRBrewKegChanges+Private.h"
+
+@implementation MRBrewKegChanges
+
+- (BOOL)isEmpty
+{
+    return [[self installedFormulae] count] == 0 &&
+           [[self removedFormulae] count] == 0 &&
+           [[self upgradedFormulae] count] == 0 &&
+           [[self linkedFormulae] count] == 0 &&
+           [[self unlinkedFormulae] count] == 0 &&
+           [[self pinnedFormulae] count] == 0 &&
+           [[self unpinnedFormulae] count] == 0;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %lu installed, %lu removed, %lu upgraded, %lu linked, %lu unlinked, %lu pinned, %lu unpinned>",
+            [self class],
+            (unsigned long)[[self installedFormulae] count],
+            (unsigned long)[[self removedFormulae] count],
+            (unsigned long)[[self upgradedFormulae] count],
+            (unsigned long)[[self linkedFormulae] count],
+            (unsigned long)[[self unlinkedFormulae] count],
+            (unsigned long)[[self pinnedFormulae] count],
+            (unsigned long)[[self unpinnedFormulae] count]];
+}
+
+@end
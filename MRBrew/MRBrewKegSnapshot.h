@@ -0,0 +1,48 @@
+//
+//  MRBrewKegSnapshot.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+@class MRBrewKegChanges;
+
+/* An MRBrewKegSnapshot records the kegs of a Homebrew installation: the
+ * versions of each formula installed in the Cellar, and the versions that
+ * are linked and pinned, which are the targets of the symbolic links in the
+ * LinkedKegs and PinnedKegs directories. Only the directories themselves are
+ * read, so taking a snapshot does not depend on the contents of any keg.
+ *
+ * A path that is nil, or a directory that does not exist, is recorded as
+ * holding no kegs.
+ */
+@interface MRBrewKegSnapshot : NSObject
+
+@property (readonly) NSDictionary *installedVersions;
+@property (readonly) NSDictionary *linkedVersions;
+@property (readonly) NSDictionary *pinnedVersions;
+
+- (instancetype)initWithCellarPath:(NSString *)cellarPath linkedKegsPath:(NSString *)linkedKegsPath pinnedKegsPath:(NSString *)pinnedKegsPath;
+
+- (MRBrewKegChanges *)changesSinceSnapshot:(MRBrewKegSnapshot *)snapshot;
+
+@end
@@ -0,0 +1,171 @@
+//
+//  MRBrewKegSnapshot.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import "MRBrewKegSnapshot.h"
+#import "MRBrewKegChanges.h"
+#import "MRBrewKegChanges+Private.h"
+#import "MRBrewFormula.h"
+#import "MRBrewCellar.h"
+
+/* Returns the names of the visible items in a directory, or an empty array if
+ * the directory cannot be read.
+ */
+static NSArray * MRBrewKegSnapshotDirectoryContents(NSString *path)
+{
+    if (!path) {
+        return @[];
+    }
+    
+    NSArray *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:NULL];
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity:[contents count]];
+    
+    for (NSString *name in contents) {
+        if (![name hasPrefix:@"."]) {
+            [names addObject:name];
+        }
+    }
+    
+    return names;
+}
+
+/* Returns the version each symbolic link in a directory refers to, keyed by
+ * the name of the link. Links refer to a keg in the Cellar, whose last path
+ * component is its version.
+ */
+static NSDictionary * MRBrewKegSnapshotLinkedVersions(NSString *path)
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSMutableDictionary *versions = [NSMutableDictionary dictionary];
+    
+    for (NSString *name in MRBrewKegSnapshotDirectoryContents(path)) {
+        NSString *destination = [fileManager destinationOfSymbolicLinkAtPath:[path stringByAppendingPathComponent:name] error:NULL];
+        
+        if (destination) {
+            [versions setObject:[destination lastPathComponent] forKey:name];
+        }
+    }
+    
+    return versions;
+}
+
+@implementation MRBrewKegSnapshot
+
+#pragma mark - Lifecycle
+
+- (instancetype)initWithCellarPath:(NSString *)cellarPath linkedKegsPath:(NSString *)linkedKegsPath pinnedKegsPath:(NSString *)pinnedKegsPath
+{
+    if (self = [super init]) {
+        NSMutableDictionary *installedVersions = [NSMutableDictionary dictionary];
+        
+        // a rack without kegs is left behind when every version is removed
+        NSDictionary *rackVersions = cellarPath ? [[MRBrewCellar cellarWithPath:cellarPath] installedVersionsWithError:NULL] : nil;
+        [rackVersions enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSArray *versions, BOOL *stop) {
+            if ([versions count] > 0) {
+                [installedVersions setObject:versions forKey:name];
+            }
+        }];
+        
+        _installedVersions = installedVersions;
+        _linkedVersions = MRBrewKegSnapshotLinkedVersions(linkedKegsPath);
+        _pinnedVersions = MRBrewKegSnapshotLinkedVersions(pinnedKegsPath);
+    }
+    
+    return self;
+}
+
+#pragma mark - Changes
+
+- (MRBrewKegChanges *)changesSinceSnapshot:(MRBrewKegSnapshot *)snapshot
+{
+    NSDictionary *previousInstalledVersions = [snapshot installedVersions];
+    NSMutableArray *installedFormulae = [NSMutableArray array];
+    NSMutableArray *removedFormulae = [NSMutableArray array];
+    NSMutableArray *upgradedFormulae = [NSMutableArray array];
+    
+    [_installedVersions enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSArray *versions, BOOL *stop) {
+        NSArray *previousVersions = [previousInstalledVersions objectForKey:name];
+        
+        if (!previousVersions) {
+            [installedFormulae addObject:[self formulaWithName:name isNew:YES isUpdated:NO]];
+        }
+        else if (![[NSSet setWithArray:versions] isSubsetOfSet:[NSSet setWithArray:previousVersions]]) {
+            [upgradedFormulae addObject:[self formulaWithName:name isNew:NO isUpdated:YES]];
+        }
+    }];
+    
+    for (NSString *name in previousInstalledVersions) {
+        if (![_installedVersions objectForKey:name]) {
+            [removedFormulae addObject:[self formulaWithName:name isNew:NO isUpdated:NO]];
+        }
+    }
+    
+    NSMutableArray *linkedFormulae = [NSMutableArray array];
+    NSMutableArray *unlinkedFormulae = [NSMutableArray array];
+    [self compareVersions:_linkedVersions withPreviousVersions:[snapshot linkedVersions] added:linkedFormulae removed:unlinkedFormulae];
+    
+    NSMutableArray *pinnedFormulae = [NSMutableArray array];
+    NSMutableArray *unpinnedFormulae = [NSMutableArray array];
+    [self compareVersions:_pinnedVersions withPreviousVersions:[snapshot pinnedVersions] added:pinnedFormulae removed:unpinnedFormulae];
+    
+    MRBrewKegChanges *changes = [[MRBrewKegChanges alloc] init];
+    [changes setInstalledFormulae:installedFormulae];
+    [changes setRemovedFormulae:removedFormulae];
+    [changes setUpgradedFormulae:upgradedFormulae];
+    [changes setLinkedFormulae:linkedFormulae];
+    [changes setUnlinkedFormulae:unlinkedFormulae];
+    [changes setPinnedFormulae:pinnedFormulae];
+    [changes setUnpinnedFormulae:unpinnedFormulae];
+    
+    return changes;
+}
+
+/* Adds a formula for each name whose version was added or changed, and for
+ * each name whose version was removed.
+ */
+- (void)compareVersions:(NSDictionary *)versions withPreviousVersions:(NSDictionary *)previousVersions added:(NSMutableArray *)added removed:(NSMutableArray *)removed
+{
+    [versions enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSString *version, BOOL *stop) {
+        if (![[previousVersions objectForKey:name] isEqualToString:version]) {
+            [added addObject:[self formulaWithName:name isNew:NO isUpdated:NO]];
+        }
+    }];
+    
+    for (NSString *name in previousVersions) {
+        if (![versions objectForKey:name]) {
+            [removed addObject:[self formulaWithName:name isNew:NO isUpdated:NO]];
+        }
+    }
+}
+
+/* Returns a formula with the versions installed in the receiver. */
+- (MRBrewFormula *)formulaWithName:(NSString *)name isNew:(BOOL)isNew isUpdated:(BOOL)isUpdated
+{
+    NSArray *installedVersions = [_installedVersions objectForKey:name];
+    MRBrewFormula *formula = [MRBrewFormula formulaWithName:name isNew:isNew isUpdated:isUpdated isInstalled:(installedVersions != nil)];
+    [formula setInstalledVersions:(installedVersions ?: @[])];
+    
+    return formula;
+}
+
+@end
@@ -0,0 +1,60 @@
+//
+//  MRBrewLauncher.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/* An MRBrewLauncher spawns brew processes with posix_spawn. The launch path is
+ * standardized and the environment flattened into the NULL-terminated array
+ * passed to the new process when they are set, rather than for each launch,
+ * so that launching a process only builds its argument array.
+ *
+ * A process launched with a launch path or environment other than those of
+ * the launcher has them standardized and flattened for that launch only.
+ *
+ * Symbolic links in the launch path are not resolved: the process is run as
+ * the path it was given (which is also its first argument), as Homebrew finds
+ * its prefix from that path.
+ *
+ * A process launched in its own process group leads a group with the same ID
+ * as the process, which the processes it launches join, so that they can all
+ * be signalled at once.
+ */
+@interface MRBrewLauncher : NSObject
+
+@property (copy) NSString *launchPath;
+@property (copy) NSDictionary *environment;
+@property (readonly) NSUInteger environmentFlattenCount;
+
+- (instancetype)initWithLaunchPath:(NSString *)launchPath environment:(NSDictionary *)environment;
+
+- (pid_t)spawnProcessWithLaunchPath:(NSString *)launchPath
+                          arguments:(NSArray *)arguments
+                        environment:(NSDictionary *)environment
+                     standardOutput:(int)outputDescriptor
+                      standardError:(int)errorDescriptor
+                       processGroup:(BOOL)createsProcessGroup
+                              error:(int *)errorNumber;
+
+@end
@@ -0,0 +1,363 @@
+//
+//  MRBrewLauncher.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewLauncher.h"
+#include <spawn.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdlib.h>
+#ifdef __APPLE__
+#include <crt_externs.h>
+#else
+extern char **environ;
+#endif
+
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 34)
+#define MRBREW_LAUNCHER_HAS_CLOSEFROM 1
+#endif
+#endif
+
+#if !defined(POSIX_SPAWN_CLOEXEC_DEFAULT) && !defined(MRBREW_LAUNCHER_HAS_CLOSEFROM)
+/* Adds an action closing each descriptor above the standard streams that is
+ * open in this process. The descriptors are listed from /proc where it is
+ * mounted, and are otherwise found by testing each possible descriptor.
+ * Closing a descriptor that has since been closed is not an error, as the C
+ * libraries that lack closefrom ignore the failure of a close action.
+ */
+static void MRBrewLauncherAddCloseActions(posix_spawn_file_actions_t *fileActions)
+{
+    DIR *directory = opendir("/proc/self/fd");
+    if (directory) {
+        int directoryDescriptor = dirfd(directory);
+        struct dirent *entry;
+        
+        while ((entry = readdir(directory))) {
+            char *end;
+            long descriptor = strtol(entry->d_name, &end, 10);
+            if (end == entry->d_name || *end != '\0' || descriptor <= STDERR_FILENO || descriptor == directoryDescriptor) {
+                continue;
+            }
+            posix_spawn_file_actions_addclose(fileActions, (int)descriptor);
+        }
+        
+        closedir(directory);
+        return;
+    }
+    
+    int limit = getdtablesize();
+    for (int descriptor = STDERR_FILENO + 1; descriptor < limit; descriptor++) {
+        if (fcntl(descriptor, F_GETFD) != -1) {
+            posix_spawn_file_actions_addclose(fileActions, descriptor);
+        }
+    }
+}
+#endif
+
+/* A NULL-terminated array of C strings, stored in a single allocation that is
+ * freed along with the receiver.
+ */
+@interface MRBrewLauncherVector : NSObject
+{
+    @private
+    char **_strings;
+}
+
+- (instancetype)initWithStrings:(NSArray *)strings;
+- (char * const *)strings;
+
+@end
+
+@implementation MRBrewLauncherVector
+
+- (instancetype)initWithStrings:(NSArray *)strings
+{
+    if (self = [super init]) {
+        NSUInteger count = [strings count];
+        NSUInteger length = 0;
+        
+        for (NSString *string in strings) {
+            length += strlen([string UTF8String]) + 1;
+        }
+        
+        // the pointers are followed by the strings they point to
+        _strings = malloc(((count + 1) * sizeof(char *)) + length);
+        if (!_strings) {
+            return nil;
+        }
+        
+        char *buffer = (char *)(_strings + count + 1);
+        NSUInteger index = 0;
+        
+        for (NSString *string in strings) {
+            const char *representation = [string UTF8String];
+            size_t size = strlen(representation) + 1;
+            memcpy(buffer, representation, size);
+            _strings[index++] = buffer;
+            buffer += size;
+        }
+        _strings[count] = NULL;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_strings);
+}
+
+- (char * const *)strings
+{
+    return _strings;
+}
+
+@end
+
+@interface MRBrewLauncher ()
+{
+    @private
+    NSString *_standardizedLaunchPath;
+    MRBrewLauncherVector *_environmentVector;
+}
+
+@end
+
+@implementation MRBrewLauncher
+
+@synthesize launchPath = _launchPath;
+@synthesize environment = _environment;
+@synthesize environmentFlattenCount = _environmentFlattenCount;
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithLaunchPath:nil environment:nil];
+}
+
+- (instancetype)initWithLaunchPath:(NSString *)launchPath environment:(NSDictionary *)environment
+{
+    if (self = [super init]) {
+        [self setLaunchPath:launchPath];
+        [self setEnvironment:environment];
+    }
+    
+    return self;
+}
+
+#pragma mark - Launch Path and Environment
+
+- (NSString *)launchPath
+{
+    @synchronized(self) {
+        return _launchPath;
+    }
+}
+
+- (void)setLaunchPath:(NSString *)launchPath
+{
+    NSString *standardizedLaunchPath = [self standardizedLaunchPath:launchPath];
+    
+    @synchronized(self) {
+        _launchPath = [launchPath copy];
+        _standardizedLaunchPath = standardizedLaunchPath;
+    }
+}
+
+- (NSDictionary *)environment
+{
+    @synchronized(self) {
+        return _environment;
+    }
+}
+
+- (void)setEnvironment:(NSDictionary *)environment
+{
+    MRBrewLauncherVector *environmentVector = environment ? [self vectorForEnvironment:environment] : nil;
+    
+    @synchronized(self) {
+        _environment = [environment copy];
+        _environmentVector = environmentVector;
+    }
+}
+
+- (NSUInteger)environmentFlattenCount
+{
+    @synchronized(self) {
+        return _environmentFlattenCount;
+    }
+}
+
+/* Returns the standardized launch path. Symbolic links are not resolved, as
+ * Homebrew finds its prefix from the path it is run as (e.g. /usr/local for
+ * /usr/local/bin/brew, rather than the repository the link refers to).
+ */
+- (NSString *)standardizedLaunchPath:(NSString *)launchPath
+{
+    return [launchPath stringByStandardizingPath];
+}
+
+- (MRBrewLauncherVector *)vectorForEnvironment:(NSDictionary *)environment
+{
+    NSMutableArray *variables = [NSMutableArray arrayWithCapacity:[environment count]];
+    
+    [environment enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+        [variables addObject:[NSString stringWithFormat:@"%@=%@", key, value]];
+    }];
+    
+    @synchronized(self) {
+        _environmentFlattenCount++;
+    }
+    
+    return [[MRBrewLauncherVector alloc] initWithStrings:variables];
+}
+
+#pragma mark - Spawning Processes
+
+- (pid_t)spawnProcessWithLaunchPath:(NSString *)launchPath
+                          arguments:(NSArray *)arguments
+                        environment:(NSDictionary *)environment
+                     standardOutput:(int)outputDescriptor
+                      standardError:(int)errorDescriptor
+                       processGroup:(BOOL)createsProcessGroup
+                              error:(int *)errorNumber
+{
+    NSString *standardizedLaunchPath = nil;
+    MRBrewLauncherVector *environmentVector = nil;
+    
+    // use the standardized launch path and flattened environment where possible;
+    // these are retained so that they outlive a concurrent change
+    @synchronized(self) {
+        if (launchPath == _launchPath || [launchPath isEqualToString:_launchPath]) {
+            standardizedLaunchPath = _standardizedLaunchPath;
+        }
+        
+        if (environment && (environment == _environment || [environment isEqualToDictionary:_environment])) {
+            environmentVector = _environmentVector;
+        }
+    }
+    
+    if (!standardizedLaunchPath) {
+        standardizedLaunchPath = [self standardizedLaunchPath:launchPath];
+    }
+    
+    if ([standardizedLaunchPath length] == 0) {
+        if (errorNumber) {
+            *errorNumber = ENOENT;
+        }
+        return 0;
+    }
+    
+    // the path is checked rather than rewritten, so that the process is run
+    // as the path it was given
+    if (access([standardizedLaunchPath fileSystemRepresentation], X_OK) != 0) {
+        if (errorNumber) {
+            *errorNumber = errno;
+        }
+        return 0;
+    }
+    
+    if (environment && !environmentVector) {
+        environmentVector = [self vectorForEnvironment:environment];
+    }
+    
+#ifdef __APPLE__
+    char * const *environmentStrings = environmentVector ? [environmentVector strings] : *_NSGetEnviron();
+#else
+    char * const *environmentStrings = environmentVector ? [environmentVector strings] : environ;
+#endif
+    
+    MRBrewLauncherVector *argumentVector = [[MRBrewLauncherVector alloc] initWithStrings:[@[standardizedLaunchPath] arrayByAddingObjectsFromArray:(arguments ?: @[])]];
+    if (!argumentVector || (environment && !environmentVector)) {
+        if (errorNumber) {
+            *errorNumber = ENOMEM;
+        }
+        return 0;
+    }
+    
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, outputDescriptor, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&fileActions, errorDescriptor, STDERR_FILENO);
+    
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+    
+    // close every descriptor other than the standard streams in the new
+    // process, so that it cannot hold open the pipes of other processes
+#ifdef POSIX_SPAWN_CLOEXEC_DEFAULT
+    flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+    posix_spawn_file_actions_addinherit_np(&fileActions, STDIN_FILENO);
+#elif defined(MRBREW_LAUNCHER_HAS_CLOSEFROM)
+    posix_spawn_file_actions_addclosefrom_np(&fileActions, STDERR_FILENO + 1);
+#else
+    MRBrewLauncherAddCloseActions(&fileActions);
+#endif
+    
+    // the new process starts with no signals blocked and the default action
+    // for signals this process may ignore or handle
+    sigset_t signalMask;
+    sigemptyset(&signalMask);
+    posix_spawnattr_setsigmask(&attributes, &signalMask);
+    
+    sigset_t defaultSignals;
+    sigemptyset(&defaultSignals);
+    sigaddset(&defaultSignals, SIGPIPE);
+    sigaddset(&defaultSignals, SIGINT);
+    sigaddset(&defaultSignals, SIGTERM);
+    sigaddset(&defaultSignals, SIGHUP);
+    sigaddset(&defaultSignals, SIGQUIT);
+    sigaddset(&defaultSignals, SIGCHLD);
+    posix_spawnattr_setsigdefault(&attributes, &defaultSignals);
+    
+    if (createsProcessGroup) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup(&attributes, 0);
+    }
+    
+    posix_spawnattr_setflags(&attributes, flags);
+    
+    pid_t processIdentifier = 0;
+    int result = posix_spawn(&processIdentifier, [standardizedLaunchPath fileSystemRepresentation], &fileActions, &attributes, [argumentVector strings], environmentStrings);
+    
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&fileActions);
+    
+    if (result != 0) {
+        if (errorNumber) {
+            *errorNumber = result;
+        }
+        return 0;
+    }
+    
+    return processIdentifier;
+}
+
+@end
@@ -48,6 +48,20 @@ typedef NS_ENUM(NSInteger, MRBrewOperationType) {
     MRBrewOperationOutdated
 };
 
+/** The priority of an operation, which determines the order in which queued
+ * operations are started. The values match those of the corresponding
+ * `NSOperationQueuePriority` constants.
+ */
+typedef NS_ENUM(NSInteger, MRBrewOperationPriority) {
+    /** A low priority, for operations performed in the background. */
+    MRBrewOperationPriorityLow = -4,
+    /** The default priority. */
+    MRBrewOperationPriorityNormal = 0,
+    /** A high priority, for operations whose results are awaited by the
+     * user. */
+    MRBrewOperationPriorityHigh = 4
+};
+
 /** The `MRBrewOperation` class encapsulates the arguments associated with a
  single Homebrew operation.
  
@@ -89,6 +103,10 @@ typedef NS_ENUM(NSInteger, MRBrewOperationType) {
 
 /** A formula associated with the operation, where a formula is permitted
  * (see `man brew` for details).
+ *
+ * The formula is copied, so an interned formula (see the
+ * internedFormulaWithName: methods of the MRBrewFormula class) is shared by
+ * the operation and its copies rather than copied.
  */
 @property (copy) MRBrewFormula *formula;
 
@@ -97,6 +115,46 @@ typedef NS_ENUM(NSInteger, MRBrewOperationType) {
  */
 @property (copy) NSArray *parameters;
 
+/** A boolean value representing whether Homebrew is asked to describe formulae
+ * using JSON rather than text. Defaults to `NO`.
+ *
+ * JSON output is supported by info, list and outdated operations (see
+ * supportsJSONOutputForOperationName:), and is ignored for other operations.
+ * A list operation with JSON output is performed as an `info --installed`
+ * operation, as are info operations with no formula. The objects parsed from
+ * JSON output include the versions and dependencies of each formula (see the
+ * MRBrewFormula class).
+ */
+@property (assign) BOOL usesJSONOutput;
+
+/** Whether the operation is performed in-process, by reading the Homebrew
+ * installation rather than spawning a Homebrew subprocess. Defaults to `NO`.
+ *
+ * Performing an operation in-process is supported for list and outdated
+ * operations without a formula, parameters or JSON output (see
+ * isInProcessOperation). List operations are answered by reading the Cellar,
+ * and outdated operations by comparing the Cellar with the versions of the
+ * formula files (see the MRBrewOutdatedEngine class). The operation is
+ * performed by Homebrew if it is not supported, if the Cellar cannot be read,
+ * or if the current version of an installed formula cannot be determined. An
+ * operation performed in-process generates the same output as Homebrew would,
+ * and parses formulae whose installedVersions are set. It is queued, counted
+ * and cancelled like any other read-only operation.
+ *
+ * Whether an operation is performed in-process does not affect its output, so
+ * operations that differ only in this property are equal.
+ */
+@property (assign) BOOL performsInProcess;
+
+/** The priority of the operation. Of the operations waiting to be executed,
+ * those with a higher priority are started first. Defaults to
+ * `MRBrewOperationPriorityNormal`.
+ *
+ * The priority does not affect the output of an operation, so operations that
+ * differ only in priority are equal.
+ */
+@property (assign) MRBrewOperationPriority priority;
+
 /**-----------------------------------------------------------------------------
  * @name Initialising an Operation
  * -----------------------------------------------------------------------------
@@ -207,6 +265,63 @@ typedef NS_ENUM(NSInteger, MRBrewOperationType) {
 /** Returns an outdated operation. */
 + (instancetype)outdatedOperation;
 
+/**-----------------------------------------------------------------------------
+ * @name Classifying Operations
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns whether the named operation only reads information from Homebrew.
+ *
+ * The `list`, `search`, `info`, `options` and `outdated` operations are
+ * considered read-only. All other operations, including custom operations,
+ * are assumed to modify the Homebrew installation.
+ *
+ * @param name The operation name.
+ * @return YES if the named operation is read-only, otherwise NO.
+ */
++ (BOOL)isReadOnlyOperationName:(NSString *)name;
+
+/** Returns whether the receiver only reads information from Homebrew.
+ *
+ * @return YES if the receiver is a read-only operation, otherwise NO.
+ */
+- (BOOL)isReadOnly;
+
+/** Returns whether the named operation supports JSON output.
+ *
+ * The `info`, `list` and `outdated` operations support JSON output.
+ *
+ * @param name The operation name.
+ * @return YES if the named operation supports JSON output, otherwise NO.
+ */
++ (BOOL)supportsJSONOutputForOperationName:(NSString *)name;
+
+/** Returns whether the receiver is performed with JSON output, which requires
+ * both that the usesJSONOutput property is set and that the operation supports
+ * JSON output.
+ *
+ * @return YES if the receiver is performed with JSON output, otherwise NO.
+ */
+- (BOOL)isJSONOperation;
+
+/** Returns whether operations with the specified name can be performed
+ * in-process.
+ *
+ * @param name The operation name.
+ * @return YES if the named operation can be performed in-process, otherwise
+ * NO.
+ */
++ (BOOL)supportsInProcessForOperationName:(NSString *)name;
+
+/** Returns whether the receiver is performed in-process, which requires that
+ * the performsInProcess property is set, that the operation can be performed
+ * in-process, and that the operation has no formula, parameters or JSON
+ * output.
+ *
+ * @return YES if the receiver is performed in-process, otherwise NO.
+ */
+- (BOOL)isInProcessOperation;
+
 /**-----------------------------------------------------------------------------
 * @name Comparing Operations
 * -----------------------------------------------------------------------------
@@ -133,6 +133,53 @@
     return [[self alloc] initWithType:MRBrewOperationOutdated formula:nil parameters:nil];
 }
 
+#pragma mark - Classification
+
++ (BOOL)isReadOnlyOperationName:(NSString *)name
+{
+    static NSSet *readOnlyOperationNames = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        readOnlyOperationNames = [NSSet setWithObjects:MRBrewOperationListIdentifier,
+                                                       MRBrewOperationSearchIdentifier,
+                                                       MRBrewOperationInfoIdentifier,
+                                                       MRBrewOperationOptionsIdentifier,
+                                                       MRBrewOperationOutdatedIdentifier, nil];
+    });
+    
+    return name && [readOnlyOperationNames containsObject:name];
+}
+
+- (BOOL)isReadOnly
+{
+    return [[self class] isReadOnlyOperationName:[self name]];
+}
+
++ (BOOL)supportsJSONOutputForOperationName:(NSString *)name
+{
+    return [name isEqualToString:MRBrewOperationInfoIdentifier] || [name isEqualToString:MRBrewOperationListIdentifier] || [name isEqualToString:MRBrewOperationOutdatedIdentifier];
+}
+
+- (BOOL)isJSONOperation
+{
+    return [self usesJSONOutput] && [[self class] supportsJSONOutputForOperationName:[self name]];
+}
+
++ (BOOL)supportsInProcessForOperationName:(NSString *)name
+{
+    return [name isEqualToString:MRBrewOperationListIdentifier] || [name isEqualToString:MRBrewOperationOutdatedIdentifier];
+}
+
+- (BOOL)isInProcessOperation
+{
+    if (![self performsInProcess] || ![[self class] supportsInProcessForOperationName:[self name]]) {
+        return NO;
+    }
+    
+    return ![self formula] && [[self parameters] count] == 0 && ![self isJSONOperation];
+}
+
 #pragma mark - Equality
 
 - (BOOL)isEqualToOperation:(MRBrewOperation *)operation
@@ -164,6 +211,9 @@
         return NO;
     }
     
+    if ([self usesJSONOutput] != [operation usesJSONOutput])
+        return NO;
+    
     return YES;
 }
 
@@ -173,8 +223,11 @@
 {
     MRBrewOperation *copy = [[[self class] allocWithZone:zone] init];
     [copy setName:[[self name] copy]];
-    [copy setFormula:[[self formula] copy]];
+    [copy setFormula:[self formula]];
     [copy setParameters:[[self parameters] copy]];
+    [copy setUsesJSONOutput:[self usesJSONOutput]];
+    [copy setPerformsInProcess:[self performsInProcess]];
+    [copy setPriority:[self priority]];
     
     return copy;
 }
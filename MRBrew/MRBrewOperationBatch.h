@@ -0,0 +1,79 @@
+//
+//  MRBrewOperationBatch.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewDelegate.h"
+
+@class MRBrewOperation;
+@class MRBrewWorker;
+
+/* An MRBrewOperationBatch combines install or remove operations that share
+ * the same name and parameters into a single operation naming every formula,
+ * so that they are performed by a single brew process. The batch is the
+ * delegate of the worker performing the combined operation, and passes each
+ * message on to the delegate of every operation in the batch, substituting the
+ * operation that delegate performed.
+ *
+ * Output is divided between the operations by the "==> " headers brew writes
+ * as it begins each step, and is delivered to the delegate of the operation
+ * whose formula the most recent header names. Output that names none of the
+ * formulae is delivered with the outcome of the batch.
+ *
+ * If the combined operation fails, the formula responsible cannot be
+ * identified. The versions installed in the Cellar when the batch was started
+ * (recorded by recordInstalledVersions) are compared with those installed
+ * afterwards: operations whose formula changed finish, and each of the others
+ * is performed again on its own using the retry handler, its delegate
+ * receiving the outcome of that operation. If the installed versions cannot
+ * be determined (the Cellar cannot be read, or they were not recorded), every
+ * operation fails with the error of the combined operation.
+ */
+@interface MRBrewOperationBatch : NSObject <MRBrewDelegate>
+
+@property (readonly, copy) NSString *key;
+@property (readonly, getter=isSealed) BOOL sealed;
+@property (weak) MRBrewWorker *worker;
+@property (copy) void (^retryHandler)(MRBrewOperation *operation, id<MRBrewDelegate> delegate);
+@property (copy) NSString *cellarPath;
+
++ (BOOL)canBatchOperation:(MRBrewOperation *)operation;
++ (NSString *)keyForOperation:(MRBrewOperation *)operation;
+
+- (instancetype)initWithOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate;
+- (BOOL)addOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate;
+- (void)seal;
+- (void)recordInstalledVersions;
+
+- (NSUInteger)operationCount;
+- (NSArray *)operations;
+- (MRBrewOperation *)combinedOperation;
+- (NSArray *)arguments;
+- (NSOperationQueuePriority)queuePriority;
+
+- (BOOL)cancelOperation:(MRBrewOperation *)operation;
+- (BOOL)cancelOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate;
+- (void)cancelAllOperations;
+
+@end
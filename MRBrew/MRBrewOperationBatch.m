@@ -0,0 +1,617 @@
+//
+//  MRBrewOperationBatch.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOperationBatch.h"
+#import "MRBrew.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewConstants.h"
+#import "MRBrewWorker.h"
+#import "MRBrewCellar.h"
+
+/* The prefix of the headers that brew writes as it begins each step of an
+ * install or removal, such as "==> Pouring wget-1.15.mavericks.bottle.tar.gz".
+ */
+static NSString * const MRBrewOperationBatchHeaderPrefix = @"==> ";
+
+/* An operation in a batch, along with the delegate that performed it. */
+@interface MRBrewOperationBatchEntry : NSObject
+
+@property (strong) MRBrewOperation *operation;
+@property (weak) id<MRBrewDelegate> delegate;
+
+@end
+
+@implementation MRBrewOperationBatchEntry
+
+@end
+
+@interface MRBrewOperationBatch ()
+{
+    @private
+    NSString *_name;
+    NSArray *_parameters;
+    NSMutableArray *_entries;
+    BOOL _sealed;
+    BOOL _delivered;
+    NSDictionary *_startInstalledVersions;
+    NSString *_outputFormulaName;
+    NSMutableString *_unattributedOutput;
+    NSMutableString *_unattributedErrorOutput;
+}
+
+@end
+
+@implementation MRBrewOperationBatch
+
+#pragma mark - Lifecycle
+
++ (BOOL)canBatchOperation:(MRBrewOperation *)operation
+{
+    NSString *name = [operation name];
+    
+    return [operation formula] && ([name isEqualToString:MRBrewOperationInstallIdentifier] || [name isEqualToString:MRBrewOperationRemoveIdentifier]);
+}
+
++ (NSString *)keyForOperation:(MRBrewOperation *)operation
+{
+    NSMutableString *key = [NSMutableString stringWithString:([operation name] ?: @"")];
+    
+    [key appendString:@"\x1e"];
+    for (NSString *parameter in [operation parameters]) {
+        [key appendString:parameter];
+        [key appendString:@"\x1f"];
+    }
+    
+    return key;
+}
+
+- (instancetype)init
+{
+    return [self initWithOperation:nil delegate:nil];
+}
+
+- (instancetype)initWithOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    if (![[self class] canBatchOperation:operation]) {
+        return nil;
+    }
+    
+    if (self = [super init]) {
+        _key = [[[self class] keyForOperation:operation] copy];
+        _name = [[operation name] copy];
+        _parameters = [[operation parameters] copy] ?: @[];
+        _entries = [NSMutableArray array];
+        _unattributedOutput = [NSMutableString string];
+        _unattributedErrorOutput = [NSMutableString string];
+        [self addOperation:operation delegate:delegate];
+    }
+    
+    return self;
+}
+
+#pragma mark - Batched Operations
+
+- (BOOL)addOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    if (![[self class] canBatchOperation:operation] || ![[[self class] keyForOperation:operation] isEqualToString:_key]) {
+        return NO;
+    }
+    
+    MRBrewOperationBatchEntry *entry = [[MRBrewOperationBatchEntry alloc] init];
+    [entry setOperation:[operation copy]];
+    [entry setDelegate:delegate];
+    
+    @synchronized(self) {
+        if (_sealed) {
+            return NO;
+        }
+        
+        [_entries addObject:entry];
+    }
+    
+    return YES;
+}
+
+- (BOOL)isSealed
+{
+    @synchronized(self) {
+        return _sealed;
+    }
+}
+
+- (void)seal
+{
+    @synchronized(self) {
+        _sealed = YES;
+    }
+}
+
+- (NSArray *)entriesSnapshot
+{
+    @synchronized(self) {
+        return [_entries copy];
+    }
+}
+
+- (NSUInteger)operationCount
+{
+    @synchronized(self) {
+        return [_entries count];
+    }
+}
+
+- (NSArray *)operations
+{
+    return [[self entriesSnapshot] valueForKey:@"operation"];
+}
+
+/* Returns the name of each formula in the batch once, in the order in which
+ * the formulae were added.
+ */
+- (NSArray *)formulaNames
+{
+    NSMutableArray *names = [NSMutableArray array];
+    NSMutableSet *seenNames = [NSMutableSet set];
+    
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        NSString *name = [[[entry operation] formula] name];
+        if (name && ![seenNames containsObject:name]) {
+            [seenNames addObject:name];
+            [names addObject:name];
+        }
+    }
+    
+    return names;
+}
+
+- (MRBrewOperation *)combinedOperation
+{
+    return [MRBrewOperation operationWithName:_name formula:nil parameters:[_parameters arrayByAddingObjectsFromArray:[self formulaNames]]];
+}
+
+- (NSArray *)arguments
+{
+    return [[@[_name] arrayByAddingObjectsFromArray:_parameters] arrayByAddingObjectsFromArray:[self formulaNames]];
+}
+
+- (NSOperationQueuePriority)queuePriority
+{
+    MRBrewOperationPriority priority = MRBrewOperationPriorityLow;
+    
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        priority = MAX(priority, [[entry operation] priority]);
+    }
+    
+    return (NSOperationQueuePriority)priority;
+}
+
+#pragma mark - Cancellation
+
+- (BOOL)cancelOperation:(MRBrewOperation *)operation
+{
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        if ([[entry operation] isEqualToOperation:operation]) {
+            return [self cancelEntry:entry];
+        }
+    }
+    
+    return NO;
+}
+
+- (BOOL)cancelOperation:(MRBrewOperation *)operation delegate:(id<MRBrewDelegate>)delegate
+{
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        if ([entry delegate] == delegate && [[entry operation] isEqualToOperation:operation]) {
+            return [self cancelEntry:entry];
+        }
+    }
+    
+    return NO;
+}
+
+- (void)cancelAllOperations
+{
+    BOOL sealed;
+    
+    @synchronized(self) {
+        sealed = _sealed;
+        
+        // operations waiting for the batch to be performed are discarded, as
+        // a queued worker is when it is cancelled
+        if (!sealed) {
+            [_entries removeAllObjects];
+        }
+    }
+    
+    if (sealed) {
+        [[self worker] cancel];
+    }
+}
+
+/* Removes an operation from the batch. Once the batch is being performed, its
+ * formulae are installed (or removed) by a single brew process, so an
+ * operation can only be cancelled by cancelling the worker; this is done only
+ * for the last operation in the batch, whose delegate then receives the
+ * outcome of the worker.
+ */
+- (BOOL)cancelEntry:(MRBrewOperationBatchEntry *)entry
+{
+    @synchronized(self) {
+        if (_delivered || ![_entries containsObject:entry]) {
+            return NO;
+        }
+        
+        if (!_sealed) {
+            [_entries removeObjectIdenticalTo:entry];
+            return YES;
+        }
+        
+        // cancelling the worker would cancel the other operations too
+        if ([_entries count] > 1) {
+            return NO;
+        }
+    }
+    
+    [[self worker] cancel];
+    
+    return YES;
+}
+
+#pragma mark - Installed Versions
+
+/* Returns the versions installed of each formula in the Cellar, or nil if the
+ * Cellar cannot be read. A rack without kegs is left behind when every version
+ * is removed, so it is treated as holding no versions.
+ */
+static NSDictionary *MRBrewOperationBatchInstalledVersions(NSString *cellarPath)
+{
+    NSDictionary *rackVersions = cellarPath ? [[MRBrewCellar cellarWithPath:cellarPath] installedVersionsWithError:NULL] : nil;
+    if (!rackVersions) {
+        return nil;
+    }
+    
+    NSMutableDictionary *installedVersions = [NSMutableDictionary dictionary];
+    [rackVersions enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSArray *versions, BOOL *stop) {
+        if ([versions count] > 0) {
+            [installedVersions setObject:versions forKey:name];
+        }
+    }];
+    
+    return installedVersions;
+}
+
+- (void)recordInstalledVersions
+{
+    NSDictionary *installedVersions = MRBrewOperationBatchInstalledVersions([self cellarPath]);
+    
+    @synchronized(self) {
+        _startInstalledVersions = installedVersions;
+    }
+}
+
+/* Returns the names of the formulae whose installed versions changed while the
+ * batch was performed, or nil if that cannot be determined.
+ */
+- (NSSet *)changedFormulaNames
+{
+    NSDictionary *startInstalledVersions;
+    
+    @synchronized(self) {
+        startInstalledVersions = _startInstalledVersions;
+    }
+    
+    NSDictionary *installedVersions = startInstalledVersions ? MRBrewOperationBatchInstalledVersions([self cellarPath]) : nil;
+    if (!installedVersions) {
+        return nil;
+    }
+    
+    NSMutableSet *changedNames = [NSMutableSet set];
+    for (NSString *name in [self formulaNames]) {
+        NSArray *startVersions = [startInstalledVersions objectForKey:name];
+        NSArray *versions = [installedVersions objectForKey:name];
+        if (startVersions != versions && ![startVersions isEqualToArray:versions]) {
+            [changedNames addObject:name];
+        }
+    }
+    
+    return changedNames;
+}
+
+#pragma mark - Output Attribution
+
+static BOOL MRBrewOperationBatchIsNameCharacter(unichar character)
+{
+    return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || (character >= '0' && character <= '9') || character == '@' || character == '+' || character == '_';
+}
+
+static BOOL MRBrewOperationBatchIsDigit(unichar character)
+{
+    return character >= '0' && character <= '9';
+}
+
+/* Returns whether the name occurs in the line as a whole formula name: it may
+ * be followed by a version ("wget-1.15", "wget--1.15.bottle") or an extension
+ * ("wget.rb"), but not by more of another name ("wget-extras", "python@3.9" for
+ * "python@3").
+ */
+static NSUInteger MRBrewOperationBatchLocationOfName(NSString *line, NSString *name)
+{
+    NSUInteger length = [line length];
+    NSRange searchRange = NSMakeRange(0, length);
+    
+    while (searchRange.length > 0) {
+        NSRange range = [line rangeOfString:name options:NSLiteralSearch range:searchRange];
+        if (range.location == NSNotFound) {
+            break;
+        }
+        
+        NSUInteger end = NSMaxRange(range);
+        unichar previous = range.location > 0 ? [line characterAtIndex:range.location - 1] : ' ';
+        unichar next = end < length ? [line characterAtIndex:end] : ' ';
+        unichar following = end + 1 < length ? [line characterAtIndex:end + 1] : ' ';
+        
+        BOOL startsName = !MRBrewOperationBatchIsNameCharacter(previous) && previous != '-';
+        BOOL endsName;
+        if (next == '-') {
+            endsName = MRBrewOperationBatchIsDigit(following) || following == '-';
+        }
+        else if (next == '.') {
+            endsName = !MRBrewOperationBatchIsDigit(following);
+        }
+        else {
+            endsName = !MRBrewOperationBatchIsNameCharacter(next);
+        }
+        
+        if (startsName && endsName) {
+            return range.location;
+        }
+        
+        searchRange = NSMakeRange(range.location + 1, length - range.location - 1);
+    }
+    
+    return NSNotFound;
+}
+
+/* Returns the name of the formula in the batch that a line of output names
+ * first, or nil if it names none of them.
+ */
+- (NSString *)formulaNameInLine:(NSString *)line
+{
+    NSString *formulaName = nil;
+    NSUInteger formulaLocation = NSNotFound;
+    
+    for (NSString *name in [self formulaNames]) {
+        NSUInteger location = MRBrewOperationBatchLocationOfName(line, name);
+        if (location == NSNotFound) {
+            continue;
+        }
+        
+        if (!formulaName || location < formulaLocation || (location == formulaLocation && [name length] > [formulaName length])) {
+            formulaName = name;
+            formulaLocation = location;
+        }
+    }
+    
+    return formulaName;
+}
+
+/* Divides output into runs of whole lines, each paired with the name of the
+ * formula it belongs to. Output belongs to the formula named by the most
+ * recent header; a line of error output that names a formula belongs to that
+ * formula. Output that precedes the first header naming a formula is held,
+ * and belongs to that formula once it is named.
+ */
+- (NSArray *)attributeOutput:(NSString *)output isErrorOutput:(BOOL)isErrorOutput
+{
+    NSMutableArray *runs = [NSMutableArray array];
+    NSString *runName = nil;
+    NSMutableString *run = nil;
+    NSUInteger length = [output length];
+    NSUInteger index = 0;
+    
+    @synchronized(self) {
+        while (index < length) {
+            NSRange lineRange = [output lineRangeForRange:NSMakeRange(index, 0)];
+            NSString *line = [output substringWithRange:lineRange];
+            index = NSMaxRange(lineRange);
+            
+            NSString *name = _outputFormulaName;
+            if (!isErrorOutput && [line hasPrefix:MRBrewOperationBatchHeaderPrefix]) {
+                NSString *headerName = [self formulaNameInLine:line];
+                if (headerName) {
+                    // the output held until a formula was named belongs to it
+                    if (!_outputFormulaName) {
+                        if ([_unattributedOutput length] > 0) {
+                            [runs addObject:@[headerName, [_unattributedOutput copy], @NO]];
+                        }
+                        if ([_unattributedErrorOutput length] > 0) {
+                            [runs addObject:@[headerName, [_unattributedErrorOutput copy], @YES]];
+                        }
+                        [_unattributedOutput setString:@""];
+                        [_unattributedErrorOutput setString:@""];
+                    }
+                    
+                    _outputFormulaName = [headerName copy];
+                    name = headerName;
+                }
+            }
+            else if (isErrorOutput) {
+                name = [self formulaNameInLine:line] ?: name;
+            }
+            
+            if (!name) {
+                [(isErrorOutput ? _unattributedErrorOutput : _unattributedOutput) appendString:line];
+                continue;
+            }
+            
+            if (run && [name isEqualToString:runName]) {
+                [run appendString:line];
+                continue;
+            }
+            
+            if (run) {
+                [runs addObject:@[runName, run, @(isErrorOutput)]];
+            }
+            runName = name;
+            run = [NSMutableString stringWithString:line];
+        }
+    }
+    
+    if (run) {
+        [runs addObject:@[runName, run, @(isErrorOutput)]];
+    }
+    
+    return runs;
+}
+
+- (void)deliverOutput:(NSString *)output isErrorOutput:(BOOL)isErrorOutput toEntry:(MRBrewOperationBatchEntry *)entry
+{
+    id<MRBrewDelegate> delegate = [entry delegate];
+    
+    if (isErrorOutput) {
+        if ([delegate respondsToSelector:@selector(brewOperation:didGenerateErrorOutput:)]) {
+            [delegate brewOperation:[entry operation] didGenerateErrorOutput:output];
+        }
+    }
+    else if ([delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
+        [delegate brewOperation:[entry operation] didGenerateOutput:output];
+    }
+}
+
+- (void)deliverAttributedOutput:(NSArray *)runs
+{
+    NSArray *entries = [self entriesSnapshot];
+    
+    for (NSArray *run in runs) {
+        NSString *name = [run objectAtIndex:0];
+        for (MRBrewOperationBatchEntry *entry in entries) {
+            if ([[[[entry operation] formula] name] isEqualToString:name]) {
+                [self deliverOutput:[run objectAtIndex:1] isErrorOutput:[[run objectAtIndex:2] boolValue] toEntry:entry];
+            }
+        }
+    }
+}
+
+/* Delivers the output that named none of the formulae to the delegate of an
+ * operation whose outcome is the outcome of the batch, once it is known.
+ */
+- (void)deliverUnattributedOutputToEntry:(MRBrewOperationBatchEntry *)entry
+{
+    NSString *output;
+    NSString *errorOutput;
+    
+    @synchronized(self) {
+        output = [_unattributedOutput copy];
+        errorOutput = [_unattributedErrorOutput copy];
+    }
+    
+    if ([output length] > 0) {
+        [self deliverOutput:output isErrorOutput:NO toEntry:entry];
+    }
+    if ([errorOutput length] > 0) {
+        [self deliverOutput:errorOutput isErrorOutput:YES toEntry:entry];
+    }
+}
+
+#pragma mark - MRBrewDelegate protocol
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    @synchronized(self) {
+        _delivered = YES;
+    }
+    
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        [self deliverUnattributedOutputToEntry:entry];
+        
+        id<MRBrewDelegate> delegate = [entry delegate];
+        if ([delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
+            [delegate brewOperationDidFinish:[entry operation]];
+        }
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    @synchronized(self) {
+        _delivered = YES;
+    }
+    
+    NSArray *entries = [self entriesSnapshot];
+    
+    // a failure cannot be attributed to a single formula, so each operation is
+    // performed again on its own unless the batch was cancelled; operations
+    // whose formula was installed (or removed) before the failure finished.
+    // Without the installed versions an operation that succeeded cannot be
+    // told apart, so none is performed again and each receives the failure
+    BOOL retries = [entries count] > 1 && [error code] != MRBrewErrorOperationCancelled && [self retryHandler];
+    NSSet *changedNames = retries ? [self changedFormulaNames] : nil;
+    if (!changedNames) retries = NO;
+    
+    for (MRBrewOperationBatchEntry *entry in entries) {
+        id<MRBrewDelegate> delegate = [entry delegate];
+        
+        if ([changedNames containsObject:[[[entry operation] formula] name]]) {
+            [self deliverUnattributedOutputToEntry:entry];
+            if ([delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
+                [delegate brewOperationDidFinish:[entry operation]];
+            }
+            continue;
+        }
+        
+        if (retries) {
+            [self retryHandler]([entry operation], delegate);
+            continue;
+        }
+        
+        [self deliverUnattributedOutputToEntry:entry];
+        if ([delegate respondsToSelector:@selector(brewOperation:didFailWithError:)]) {
+            [delegate brewOperation:[entry operation] didFailWithError:error];
+        }
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
+{
+    [self deliverAttributedOutput:[self attributeOutput:output isErrorOutput:NO]];
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didCollectMetrics:(MRBrewOperationMetrics *)metrics
+{
+    for (MRBrewOperationBatchEntry *entry in [self entriesSnapshot]) {
+        id<MRBrewDelegate> delegate = [entry delegate];
+        if ([delegate respondsToSelector:@selector(brewOperation:didCollectMetrics:)]) {
+            [delegate brewOperation:[entry operation] didCollectMetrics:metrics];
+        }
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateErrorOutput:(NSString *)output
+{
+    [self deliverAttributedOutput:[self attributeOutput:output isErrorOutput:YES]];
+}
+
+@end
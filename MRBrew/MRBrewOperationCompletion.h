@@ -0,0 +1,52 @@
+//
+//  MRBrewOperationCompletion.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewDelegate.h"
+
+@class MRBrewOperation;
+@class MRBrewOperationResult;
+@class MRBrewOperationMetrics;
+
+/* An MRBrewOperationCompletion is the delegate of an operation performed using
+ * a completion block. It collects the objects parsed from the output of the
+ * operation, or the output itself if it is not parsed, and calls the handler
+ * with the result once the operation has finished or failed. The handler is
+ * called at most once.
+ *
+ * If waitsForMetrics is YES the handler is called once the metrics of the
+ * operation have been delivered instead, which workers do immediately after
+ * the outcome; cached output has no metrics.
+ */
+@interface MRBrewOperationCompletion : NSObject <MRBrewDelegate>
+
+@property (readonly, copy) MRBrewOperation *operation;
+@property (copy) void (^handler)(MRBrewOperationResult *result);
+@property (assign) BOOL waitsForMetrics;
+@property (readonly, strong) MRBrewOperationMetrics *metrics;
+
+- (instancetype)initWithOperation:(MRBrewOperation *)operation;
+
+@end
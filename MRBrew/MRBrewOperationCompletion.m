@@ -0,0 +1,135 @@
+//
+//  MRBrewOperationCompletion.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOperationCompletion.h"
+#import "MRBrewOperation.h"
+#import "MRBrewOperationResult.h"
+#import "MRBrewOperationResult+Private.h"
+#import "MRBrewOutputParserSession.h"
+
+@interface MRBrewOperationCompletion ()
+
+@property (strong) NSMutableArray *objects;
+@property (strong) NSMutableString *output;
+@property (strong) MRBrewOperationResult *result;
+@property (strong) MRBrewOperationMetrics *metrics;
+
+@end
+
+@implementation MRBrewOperationCompletion
+
+- (instancetype)initWithOperation:(MRBrewOperation *)operation
+{
+    if (self = [super init]) {
+        _operation = [operation copy];
+        
+        // parsed output is not collected, as the objects parsed from it are;
+        // operations performed in-process deliver objects with any output
+        if ([MRBrewOutputParserSession supportsOperation:operation] || [operation isInProcessOperation]) {
+            _objects = [NSMutableArray array];
+        }
+        if (![MRBrewOutputParserSession supportsOperation:operation]) {
+            _output = [NSMutableString string];
+        }
+    }
+    
+    return self;
+}
+
+- (void)completeWithResult:(MRBrewOperationResult *)result
+{
+    void (^handler)(MRBrewOperationResult *result);
+    @synchronized(self) {
+        [self setResult:result];
+        if ([self waitsForMetrics]) {
+            return;
+        }
+        handler = [self handler];
+        [self setHandler:nil];
+    }
+    
+    if (handler) {
+        handler(result);
+    }
+}
+
+#pragma mark - MRBrewDelegate protocol
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
+{
+    @synchronized(self) {
+        [[self output] appendString:output];
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didParseObjects:(NSArray *)objects
+{
+    @synchronized(self) {
+        [[self objects] addObjectsFromArray:objects];
+    }
+}
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    MRBrewOperationResult *result = [[MRBrewOperationResult alloc] init];
+    [result setOperation:[self operation]];
+    @synchronized(self) {
+        [result setObjects:[self objects]];
+        [result setOutput:[self output]];
+    }
+    
+    [self completeWithResult:result];
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    MRBrewOperationResult *result = [[MRBrewOperationResult alloc] init];
+    [result setOperation:[self operation]];
+    [result setError:error];
+    
+    [self completeWithResult:result];
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didCollectMetrics:(MRBrewOperationMetrics *)metrics
+{
+    void (^handler)(MRBrewOperationResult *result);
+    MRBrewOperationResult *result;
+    @synchronized(self) {
+        [self setMetrics:metrics];
+        if (![self waitsForMetrics] || ![self result]) {
+            return;
+        }
+        result = [self result];
+        handler = [self handler];
+        [self setHandler:nil];
+    }
+    
+    if (handler) {
+        handler(result);
+    }
+}
+
+@end
+
@@ -0,0 +1,57 @@
+//
+//  MRBrewOperationGraph+Private.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MRBrewWorker;
+@class MRBrewOperationCompletion;
+
+@interface MRBrewOperationGraphNode ()
+
+@property (copy) MRBrewOperation *operation;
+@property (copy) NSArray *dependencies;
+@property (assign) MRBrewOperationGraphNodeState state;
+@property (strong) MRBrewOperationResult *result;
+@property (strong) MRBrewOperationMetrics *metrics;
+@property (strong) MRBrewWorker *worker;
+@property (strong) MRBrewOperationCompletion *completion;
+
+@end
+
+@interface MRBrewOperationGraph ()
+
+@property (strong) NSDate *startDate;
+@property (strong) NSDate *finishDate;
+@property (copy) void (^completionHandler)(MRBrewOperationGraph *graph);
+
+/* Marks the graph as performed, returning NO if it already was. */
+- (BOOL)beginPerforming;
+
+/* Records the outcome of a node's operation, returning YES once every node in
+ * the graph has finished.
+ */
+- (BOOL)completeNode:(MRBrewOperationGraphNode *)node result:(MRBrewOperationResult *)result metrics:(MRBrewOperationMetrics *)metrics;
+
+@end
@@ -0,0 +1,157 @@
+//
+//  MRBrewOperationGraph.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MRBrewOperation;
+@class MRBrewOperationResult;
+@class MRBrewOperationMetrics;
+
+/** These constants indicate the state of a node in an operation graph. */
+typedef NS_ENUM(NSInteger, MRBrewOperationGraphNodeState) {
+    /** The operation has not finished. */
+    MRBrewOperationGraphNodeStatePending,
+    /** The operation finished successfully. */
+    MRBrewOperationGraphNodeStateSucceeded,
+    /** The operation failed. */
+    MRBrewOperationGraphNodeStateFailed,
+    /** The operation was cancelled, either explicitly or because an operation
+     * it depends on did not succeed.
+     */
+    MRBrewOperationGraphNodeStateCancelled
+};
+
+/** An `MRBrewOperationGraphNode` object represents an operation in an
+ * operation graph, along with the nodes of the operations it depends on.
+ * Nodes are created by the addOperation:dependencies: method of the
+ * MRBrewOperationGraph class.
+ */
+@interface MRBrewOperationGraphNode : NSObject
+
+/** The operation performed by the node. */
+@property (readonly, copy) MRBrewOperation *operation;
+
+/** The nodes whose operations must succeed before the operation is
+ * performed.
+ */
+@property (readonly, copy) NSArray *dependencies;
+
+/** The state of the node. */
+@property (readonly) MRBrewOperationGraphNodeState state;
+
+/** The result of the operation, or `nil` if it has not finished. */
+@property (readonly, strong) MRBrewOperationResult *result;
+
+/** The time spent queued for and performing the operation, or `nil` if it has
+ * not finished.
+ */
+@property (readonly, strong) MRBrewOperationMetrics *metrics;
+
+@end
+
+/** An `MRBrewOperationGraph` object describes a set of operations and the
+ * dependencies between them, to be performed using `MRBrew`'s
+ * performOperationGraph:completion: method.
+ *
+ * An operation is performed once every operation it depends on has finished
+ * successfully, and operations that do not depend on each other are performed
+ * as they would be if they were performed one at a time: read-only operations
+ * concurrently, up to the limit set by setMaxConcurrentReadOnlyOperations:, and
+ * operations that modify the Homebrew installation one at a time. If an
+ * operation fails, the operations that depend on it, directly or indirectly,
+ * are cancelled.
+ *
+ * For example, to update Homebrew, then install two formulae, then list the
+ * installed formulae:
+ *
+ *     MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+ *     MRBrewOperationGraphNode *update = [graph addOperation:[MRBrewOperation updateOperation] dependencies:nil];
+ *     MRBrewOperationGraphNode *wget = [graph addOperation:[MRBrewOperation installOperation:wget] dependencies:@[update]];
+ *     MRBrewOperationGraphNode *git = [graph addOperation:[MRBrewOperation installOperation:git] dependencies:@[update]];
+ *     [graph addOperation:[MRBrewOperation listOperation] dependencies:@[wget, git]];
+ *
+ * A graph can be performed once.
+ */
+@interface MRBrewOperationGraph : NSObject
+
+/**-----------------------------------------------------------------------------
+ * @name Creating an Operation Graph
+ * -----------------------------------------------------------------------------
+ */
+
+/** Creates and returns an empty operation graph.
+ *
+ * @return An initialised operation graph.
+ */
++ (instancetype)operationGraph;
+
+/**-----------------------------------------------------------------------------
+ * @name Adding Operations
+ * -----------------------------------------------------------------------------
+ */
+
+/** Adds an operation that depends on no other operations.
+ *
+ * @param operation The operation to add.
+ * @return The node of the operation.
+ */
+- (MRBrewOperationGraphNode *)addOperation:(MRBrewOperation *)operation;
+
+/** Adds an operation that is performed once the operations of other nodes have
+ * finished successfully.
+ *
+ * Dependencies must be nodes already added to the receiver, so a graph never
+ * contains a cycle. Operations cannot be added once the graph is performed.
+ *
+ * @param operation The operation to add.
+ * @param dependencies An array of `MRBrewOperationGraphNode` objects, or `nil`.
+ * @return The node of the operation, or `nil` if a dependency is not a node of
+ * the receiver or the graph has been performed.
+ */
+- (MRBrewOperationGraphNode *)addOperation:(MRBrewOperation *)operation dependencies:(NSArray *)dependencies;
+
+/**-----------------------------------------------------------------------------
+ * @name Inspecting the Graph
+ * -----------------------------------------------------------------------------
+ */
+
+/** The nodes of the graph, in the order they were added. */
+@property (readonly, copy) NSArray *nodes;
+
+/** Returns whether every operation in the graph finished successfully.
+ *
+ * @return `YES` if every operation succeeded, otherwise `NO`.
+ */
+- (BOOL)succeeded;
+
+/** The date on which the graph was performed, or `nil` if it has not been. */
+@property (readonly, strong) NSDate *startDate;
+
+/** The date on which the last operation in the graph finished, or `nil` if
+ * the graph has not finished.
+ */
+@property (readonly, strong) NSDate *finishDate;
+
+@end
@@ -0,0 +1,166 @@
+//
+//  MRBrewOperationGraph.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOperationGraph.h"
+#import "MRBrewOperationGraph+Private.h"
+#import "MRBrewOperation.h"
+#import "MRBrewOperationResult.h"
+#import "MRBrew.h"
+
+@implementation MRBrewOperationGraphNode
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %@ (%lu dependencies)>", [self class], [[self operation] name], (unsigned long)[[self dependencies] count]];
+}
+
+@end
+
+@interface MRBrewOperationGraph ()
+{
+    @private
+    NSMutableArray *_nodes;
+    NSUInteger _finishedNodeCount;
+    BOOL _performed;
+}
+
+@end
+
+@implementation MRBrewOperationGraph
+
+#pragma mark - Lifecycle
+
++ (instancetype)operationGraph
+{
+    return [[self alloc] init];
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _nodes = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+#pragma mark - Adding Operations
+
+- (MRBrewOperationGraphNode *)addOperation:(MRBrewOperation *)operation
+{
+    return [self addOperation:operation dependencies:nil];
+}
+
+- (MRBrewOperationGraphNode *)addOperation:(MRBrewOperation *)operation dependencies:(NSArray *)dependencies
+{
+    @synchronized(self) {
+        if (_performed) {
+            return nil;
+        }
+        
+        // only nodes already in the graph can be depended on, which rules out
+        // cycles
+        for (MRBrewOperationGraphNode *dependency in dependencies) {
+            if (![_nodes containsObject:dependency]) {
+                return nil;
+            }
+        }
+        
+        MRBrewOperationGraphNode *node = [[MRBrewOperationGraphNode alloc] init];
+        [node setOperation:operation];
+        [node setDependencies:(dependencies ?: @[])];
+        [_nodes addObject:node];
+        
+        return node;
+    }
+}
+
+#pragma mark - Inspecting the Graph
+
+- (NSArray *)nodes
+{
+    @synchronized(self) {
+        return [_nodes copy];
+    }
+}
+
+- (BOOL)succeeded
+{
+    for (MRBrewOperationGraphNode *node in [self nodes]) {
+        if ([node state] != MRBrewOperationGraphNodeStateSucceeded) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+#pragma mark - Performing the Graph
+
+- (BOOL)beginPerforming
+{
+    @synchronized(self) {
+        if (_performed) {
+            return NO;
+        }
+        _performed = YES;
+    }
+    
+    [self setStartDate:[NSDate date]];
+    
+    return YES;
+}
+
+- (BOOL)completeNode:(MRBrewOperationGraphNode *)node result:(MRBrewOperationResult *)result metrics:(MRBrewOperationMetrics *)metrics
+{
+    MRBrewOperationGraphNodeState state = MRBrewOperationGraphNodeStateSucceeded;
+    if ([[result error] code] == MRBrewErrorOperationCancelled) {
+        state = MRBrewOperationGraphNodeStateCancelled;
+    }
+    else if ([result error]) {
+        state = MRBrewOperationGraphNodeStateFailed;
+    }
+    
+    [node setResult:result];
+    [node setMetrics:metrics];
+    [node setState:state];
+    
+    // the worker and its delegate are no longer needed
+    [node setWorker:nil];
+    [node setCompletion:nil];
+    
+    @synchronized(self) {
+        _finishedNodeCount++;
+        if (_finishedNodeCount < [_nodes count]) {
+            return NO;
+        }
+    }
+    
+    [self setFinishDate:[NSDate date]];
+    
+    return YES;
+}
+
+@end
@@ -0,0 +1,108 @@
+//
+//  MRBrewOperationMetrics.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MRBrewOperation;
+
+/** An `MRBrewOperationMetrics` object records where the time went while an
+ * operation was performed, and the resources used by the brew process that
+ * performed it. It is delivered to delegates that implement
+ * brewOperation:didCollectMetrics: once the operation has finished or failed.
+ *
+ * Dates are `nil` for phases that did not occur; for example firstOutputDate
+ * is `nil` if the operation generated no output. Resource usage is only
+ * available when the operation was performed by launching brew, rather than
+ * by a helper process.
+ */
+@interface MRBrewOperationMetrics : NSObject
+
+/** The operation that was performed. */
+@property (readonly, copy) MRBrewOperation *operation;
+
+/** Whether the operation finished successfully. */
+@property (readonly) BOOL succeeded;
+
+/**-----------------------------------------------------------------------------
+ * @name Phases
+ * -----------------------------------------------------------------------------
+ */
+
+/** The date on which the operation was queued for execution. */
+@property (readonly, strong) NSDate *enqueueDate;
+
+/** The date on which brew was launched, or the request sent to the helper. */
+@property (readonly, strong) NSDate *launchDate;
+
+/** The date on which the first byte of output or error output was read. */
+@property (readonly, strong) NSDate *firstOutputDate;
+
+/** The date on which brew exited. */
+@property (readonly, strong) NSDate *exitDate;
+
+/** The date on which the delegate was sent brewOperationDidFinish: or
+ * brewOperation:didFailWithError:.
+ */
+@property (readonly, strong) NSDate *deliveryDate;
+
+/** The time between the delegate message being dispatched to the delegate
+ * queue (see the delegateQueue method of the MRBrew class) and being sent.
+ * This is the cost of delivering to the queue, and is zero for delegates sent
+ * messages on the thread that generated them.
+ */
+@property (readonly) NSTimeInterval delegateDispatchLag;
+
+/** The time from the operation being queued until it was launched. */
+- (NSTimeInterval)queueDuration;
+
+/** The time from the operation being launched until brew exited. */
+- (NSTimeInterval)executionDuration;
+
+/** The time from the operation being queued until the delegate was sent its
+ * outcome.
+ */
+- (NSTimeInterval)totalDuration;
+
+/**-----------------------------------------------------------------------------
+ * @name Resource Usage
+ * -----------------------------------------------------------------------------
+ */
+
+/** The number of bytes written by brew to its standard output stream. */
+@property (readonly) unsigned long long outputByteCount;
+
+/** The number of bytes written by brew to its standard error stream. */
+@property (readonly) unsigned long long errorOutputByteCount;
+
+/** The user CPU time used by the brew process, in seconds. */
+@property (readonly) NSTimeInterval userCPUTime;
+
+/** The system CPU time used by the brew process, in seconds. */
+@property (readonly) NSTimeInterval systemCPUTime;
+
+/** The peak resident set size of the brew process, in bytes. */
+@property (readonly) unsigned long long peakResidentSetSize;
+
+@end
@@ -0,0 +1,151 @@
+//
+//  MRBrewOperationMetrics.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewOperationMetrics+Private.h"
+#import "MRBrewOperation.h"
+
+/* Returns the time between two dates, or zero if either is unknown. */
+static NSTimeInterval MRBrewOperationMetricsInterval(NSDate *startDate, NSDate *endDate)
+{
+    if (!startDate || !endDate) {
+        return 0;
+    }
+    
+    return MAX([endDate timeIntervalSinceDate:startDate], 0);
+}
+
+@implementation MRBrewOperationMetrics
+
+@synthesize firstOutputDate = _firstOutputDate;
+@synthesize outputByteCount = _outputByteCount;
+@synthesize errorOutputByteCount = _errorOutputByteCount;
+@synthesize userCPUTime = _userCPUTime;
+@synthesize systemCPUTime = _systemCPUTime;
+@synthesize peakResidentSetSize = _peakResidentSetSize;
+
+#pragma mark - Phases
+
+- (NSTimeInterval)queueDuration
+{
+    return MRBrewOperationMetricsInterval([self enqueueDate], [self launchDate]);
+}
+
+- (NSTimeInterval)executionDuration
+{
+    return MRBrewOperationMetricsInterval([self launchDate], [self exitDate]);
+}
+
+- (NSTimeInterval)totalDuration
+{
+    return MRBrewOperationMetricsInterval([self enqueueDate], [self deliveryDate]);
+}
+
+#pragma mark - Resource Usage
+
+- (void)addByteCount:(NSUInteger)byteCount errorOutput:(BOOL)errorOutput
+{
+    @synchronized(self) {
+        if (!_firstOutputDate) {
+            _firstOutputDate = [NSDate date];
+        }
+        
+        if (errorOutput) {
+            _errorOutputByteCount += byteCount;
+        }
+        else {
+            _outputByteCount += byteCount;
+        }
+    }
+}
+
+- (NSDate *)firstOutputDate
+{
+    @synchronized(self) {
+        return _firstOutputDate;
+    }
+}
+
+- (unsigned long long)outputByteCount
+{
+    @synchronized(self) {
+        return _outputByteCount;
+    }
+}
+
+- (unsigned long long)errorOutputByteCount
+{
+    @synchronized(self) {
+        return _errorOutputByteCount;
+    }
+}
+
+- (void)setResourceUsage:(struct rusage)resourceUsage
+{
+    @synchronized(self) {
+        _userCPUTime = resourceUsage.ru_utime.tv_sec + (resourceUsage.ru_utime.tv_usec / 1e6);
+        _systemCPUTime = resourceUsage.ru_stime.tv_sec + (resourceUsage.ru_stime.tv_usec / 1e6);
+        
+        // ru_maxrss is measured in bytes on OS X, and kilobytes elsewhere
+#ifdef __APPLE__
+        _peakResidentSetSize = (unsigned long long)resourceUsage.ru_maxrss;
+#else
+        _peakResidentSetSize = (unsigned long long)resourceUsage.ru_maxrss * 1024;
+#endif
+    }
+}
+
+- (NSTimeInterval)userCPUTime
+{
+    @synchronized(self) {
+        return _userCPUTime;
+    }
+}
+
+- (NSTimeInterval)systemCPUTime
+{
+    @synchronized(self) {
+        return _systemCPUTime;
+    }
+}
+
+- (unsigned long long)peakResidentSetSize
+{
+    @synchronized(self) {
+        return _peakResidentSetSize;
+    }
+}
+
+#pragma mark - NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, operation: %@, queued: %.1fms, executed: %.1fms, total: %.1fms, output: %llu bytes, CPU: %.1fms>",
+            [self class], self, [self operation],
+            [self queueDuration] * 1000.0, [self executionDuration] * 1000.0, [self totalDuration] * 1000.0,
+            [self outputByteCount] + [self errorOutputByteCount], ([self userCPUTime] + [self systemCPUTime]) * 1000.0];
+}
+
+@end
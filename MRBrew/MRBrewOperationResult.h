@@ -0,0 +1,69 @@
+//
+//  MRBrewOperationResult.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MRBrewOperation;
+
+/** An `MRBrewOperationResult` object holds the outcome of an operation that
+ * was performed using `MRBrew`'s performOperation:completion: or
+ * performOperations:completion: methods.
+ *
+ * For list, search and options operations, and operations performed with JSON
+ * output, the output is parsed as it is generated, on a background thread, and
+ * the result holds the parsed objects rather than the output. The result of an
+ * outdated operation performed in-process holds both its output and the
+ * outdated formulae.
+ */
+@interface MRBrewOperationResult : NSObject
+
+/** The operation that was performed. */
+@property (readonly, copy) MRBrewOperation *operation;
+
+/** The objects parsed from the output of the operation, or `nil` if the
+ * operation failed or its output is not parsed.
+ *
+ * The objects are `MRBrewFormula` objects, or `MRBrewInstallOption` objects
+ * for an options operation (see the objectsForOperation:output:error: method
+ * of the MRBrewOutputParser class). The array is empty if no objects were
+ * parsed.
+ */
+@property (readonly, copy) NSArray *objects;
+
+/** The output of the operation, or `nil` if the operation failed or its
+ * output is parsed.
+ */
+@property (readonly, copy) NSString *output;
+
+/** The error that caused the operation to fail, or `nil` if it finished
+ * successfully. The error's `code` corresponds to one of the `MRBrewError`
+ * constants.
+ */
+@property (readonly, strong) NSError *error;
+
+/** Whether the operation finished successfully. */
+- (BOOL)succeeded;
+
+@end
@@ -0,0 +1,130 @@
+//
+//  MRBrewOutdatedEngine.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const MRBrewOutdatedEngineErrorDomain;
+
+/** These constants indicate why an outdated engine could not decide whether an
+ * installed formula is outdated.
+ */
+typedef NS_ENUM(NSInteger, MRBrewOutdatedEngineError) {
+    /** The formula file of an installed formula could not be found. */
+    MRBrewOutdatedEngineErrorFormulaFileNotFound,
+    /** The version declared by the formula file of an installed formula could
+     * not be determined.
+     */
+    MRBrewOutdatedEngineErrorVersionUndetermined
+};
+
+/** An `MRBrewOutdatedEngine` finds the outdated formulae of a Homebrew
+ * installation in-process, without spawning a Homebrew subprocess or loading
+ * every formula.
+ *
+ * The installed versions of each formula are read from the Cellar and
+ * compared with the version declared by its formula file, which is found in
+ * the `Formula` directory or, failing that, in a tap in the `Taps`
+ * directory. A formula is outdated if none of its installed versions is at
+ * least its current version (including its revision, if any).
+ *
+ * Only the formula files of installed formulae are read. The version
+ * extracted from each file is cached along with the modification date and
+ * size of the file, so repeated queries read only the formula files that have
+ * changed since they were last read.
+ *
+ * The version of a formula is taken from its `version`, or else from its
+ * `url` (or the `:tag` of the url), within the formula class or its `stable`
+ * block. If the formula file of an installed formula cannot be found, or its
+ * version cannot be determined, the engine cannot tell whether the formula is
+ * outdated and returns an error rather than an incomplete result.
+ *
+ * `MRBrew` uses an engine to perform outdated operations whose
+ * performsInProcess property is set.
+ */
+@interface MRBrewOutdatedEngine : NSObject
+
+/** The path of the Cellar. */
+@property (readonly, copy) NSString *cellarPath;
+
+/** The path of the directory holding the core formula files. */
+@property (readonly, copy) NSString *formulaPath;
+
+/** The path of the directory holding taps. */
+@property (readonly, copy) NSString *tapsPath;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating an Outdated Engine
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns an initialized `MRBrewOutdatedEngine` object for the Homebrew
+ * installation with the specified paths.
+ *
+ * @param cellarPath The absolute path of the Cellar (e.g.
+ * `/usr/local/Cellar`).
+ * @param formulaPath The absolute path of the directory holding the core
+ * formula files (e.g. `/usr/local/Library/Formula`), or `nil`.
+ * @param tapsPath The absolute path of the directory holding taps (e.g.
+ * `/usr/local/Library/Taps`), or `nil`.
+ * @return An engine with the specified paths.
+ */
+- (instancetype)initWithCellarPath:(NSString *)cellarPath formulaPath:(NSString *)formulaPath tapsPath:(NSString *)tapsPath;
+
+/** Returns an engine for the Homebrew installation with the specified paths.
+ *
+ * @param cellarPath The absolute path of the Cellar (e.g.
+ * `/usr/local/Cellar`).
+ * @param formulaPath The absolute path of the directory holding the core
+ * formula files (e.g. `/usr/local/Library/Formula`), or `nil`.
+ * @param tapsPath The absolute path of the directory holding taps (e.g.
+ * `/usr/local/Library/Taps`), or `nil`.
+ * @return An engine with the specified paths.
+ */
++ (instancetype)engineWithCellarPath:(NSString *)cellarPath formulaPath:(NSString *)formulaPath tapsPath:(NSString *)tapsPath;
+
+/**-----------------------------------------------------------------------------
+ * @name Finding Outdated Formulae
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the outdated formulae, as an outdated operation would.
+ *
+ * This method is safe to call from any thread; concurrent queries are
+ * performed one at a time.
+ *
+ * @param error If the Cellar cannot be read, upon return contains an error in
+ * the `NSPOSIXErrorDomain` domain. If the current version of an installed
+ * formula cannot be determined, upon return contains an error in the
+ * `MRBrewOutdatedEngineErrorDomain` domain whose `NSFilePathErrorKey` is the
+ * path of the formula file, if one was found. You may specify `nil` for this
+ * parameter.
+ * @return An array of `MRBrewFormula` objects with isInstalled and isUpdated
+ * set, their installedVersions and their current version, sorted by name, or
+ * `nil` if the Cellar cannot be read or the current version of an installed
+ * formula cannot be determined.
+ */
+- (NSArray *)outdatedFormulaeWithError:(NSError **)error;
+
+@end
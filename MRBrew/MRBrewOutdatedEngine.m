@@ -0,0 +1,461 @@
+//
+//  MRBrewOutdatedEngine.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOutdatedEngine.h"
+#import "MRBrewOutdatedEngine+Private.h"
+#import "MRBrewCellar.h"
+#import "MRBrewFormula.h"
+#import "MRBrewVersion.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+    #define MRBrewOutdatedEngineModificationTime(status) ((status).st_mtimespec)
+#else
+    #define MRBrewOutdatedEngineModificationTime(status) ((status).st_mtim)
+#endif
+
+NSString * const MRBrewOutdatedEngineErrorDomain = @"uk.co.fidgetbox.MRBrew";
+
+/* The indentation of the statements of a formula class, and of the statements
+ * of the blocks within it.
+ */
+static const NSUInteger MRBrewOutdatedEngineClassIndentation = 2;
+static const NSUInteger MRBrewOutdatedEngineBlockIndentation = 4;
+
+/* The version extracted from a formula file, and the modification time and
+ * size of the file when it was read. A version that could not be determined
+ * is cached as nil, so that the file is not read again until it changes.
+ */
+@interface MRBrewOutdatedEngineEntry : NSObject
+{
+@public
+    struct timespec _modificationTime;
+    off_t _size;
+}
+
+@property (copy) NSString *version;
+
+@end
+
+@implementation MRBrewOutdatedEngineEntry
+
+@end
+
+@interface MRBrewOutdatedEngine ()
+
+@property (strong) NSMutableDictionary *entries;
+
+@end
+
+@implementation MRBrewOutdatedEngine
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithCellarPath:nil formulaPath:nil tapsPath:nil];
+}
+
+- (instancetype)initWithCellarPath:(NSString *)cellarPath formulaPath:(NSString *)formulaPath tapsPath:(NSString *)tapsPath
+{
+    if (self = [super init]) {
+        _cellarPath = [cellarPath copy];
+        _formulaPath = [formulaPath copy];
+        _tapsPath = [tapsPath copy];
+        _entries = [NSMutableDictionary dictionary];
+    }
+    
+    return self;
+}
+
++ (instancetype)engineWithCellarPath:(NSString *)cellarPath formulaPath:(NSString *)formulaPath tapsPath:(NSString *)tapsPath
+{
+    return [[self alloc] initWithCellarPath:cellarPath formulaPath:formulaPath tapsPath:tapsPath];
+}
+
+#pragma mark - Outdated Formulae
+
+- (NSArray *)outdatedFormulaeWithError:(NSError **)error
+{
+    NSDictionary *installedVersions = [[MRBrewCellar cellarWithPath:[self cellarPath]] installedVersionsWithError:error];
+    
+    if (!installedVersions) {
+        return nil;
+    }
+    
+    NSArray *names = [[installedVersions allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    NSMutableArray *formulae = [NSMutableArray array];
+    
+    @synchronized(self) {
+        NSArray *tapDirectories = [self tapFormulaDirectories];
+        NSMutableSet *formulaFilePaths = [NSMutableSet setWithCapacity:[names count]];
+        
+        for (NSString *name in names) {
+            NSArray *versions = [installedVersions objectForKey:name];
+            if ([versions count] == 0) {
+                continue;
+            }
+            
+            // a formula whose current version is unknown may be outdated, so
+            // the query is left to Homebrew rather than answered incompletely
+            struct stat status;
+            NSString *formulaFilePath = [self pathOfFormulaFileNamed:name tapDirectories:tapDirectories status:&status];
+            if (!formulaFilePath) {
+                [MRBrewOutdatedEngine errorWithCode:MRBrewOutdatedEngineErrorFormulaFileNotFound description:[NSString stringWithFormat:@"The formula file of %@ could not be found.", name] path:nil usingPointer:error];
+                return nil;
+            }
+            [formulaFilePaths addObject:formulaFilePath];
+            
+            NSString *version = [self versionOfFormulaFileAtPath:formulaFilePath status:&status];
+            if (!version) {
+                [MRBrewOutdatedEngine errorWithCode:MRBrewOutdatedEngineErrorVersionUndetermined description:[NSString stringWithFormat:@"The version of %@ could not be determined.", name] path:formulaFilePath usingPointer:error];
+                return nil;
+            }
+            
+            NSString *installedVersion = [MRBrewVersion greatestVersionInVersions:versions];
+            if ([MRBrewVersion compareVersion:installedVersion toVersion:version] == NSOrderedAscending) {
+                MRBrewFormula *formula = [MRBrewFormula formulaWithName:name isNew:NO isUpdated:YES isInstalled:YES];
+                [formula setVersion:version];
+                [formula setInstalledVersions:versions];
+                [formulae addObject:formula];
+            }
+        }
+        
+        // forget the formula files of formulae that are no longer installed
+        for (NSString *path in [[self entries] allKeys]) {
+            if (![formulaFilePaths containsObject:path]) {
+                [[self entries] removeObjectForKey:path];
+            }
+        }
+    }
+    
+    return formulae;
+}
+
+/* Returns the directories of the taps that may hold formula files: the root of
+ * each tap and its Formula and HomebrewFormula directories. Taps are held in
+ * user/repository directories, or in user-repository directories by earlier
+ * versions of Homebrew.
+ */
+- (NSArray *)tapFormulaDirectories
+{
+    if (![self tapsPath]) {
+        return @[];
+    }
+    
+    NSMutableArray *tapPaths = [NSMutableArray array];
+    
+    for (NSString *userPath in [self visibleDirectoriesAtPath:[self tapsPath]]) {
+        [tapPaths addObject:userPath];
+        [tapPaths addObjectsFromArray:[self visibleDirectoriesAtPath:userPath]];
+    }
+    
+    NSMutableArray *directories = [NSMutableArray arrayWithCapacity:[tapPaths count] * 3];
+    
+    for (NSString *tapPath in tapPaths) {
+        [directories addObject:tapPath];
+        [directories addObject:[tapPath stringByAppendingPathComponent:@"Formula"]];
+        [directories addObject:[tapPath stringByAppendingPathComponent:@"HomebrewFormula"]];
+    }
+    
+    return directories;
+}
+
+- (NSArray *)visibleDirectoriesAtPath:(NSString *)path
+{
+    NSArray *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:NULL];
+    NSMutableArray *directories = [NSMutableArray arrayWithCapacity:[contents count]];
+    
+    for (NSString *name in [contents sortedArrayUsingSelector:@selector(compare:)]) {
+        NSString *directory = [path stringByAppendingPathComponent:name];
+        struct stat status;
+        
+        if (![name hasPrefix:@"."] && stat([directory fileSystemRepresentation], &status) == 0 && S_ISDIR(status.st_mode)) {
+            [directories addObject:directory];
+        }
+    }
+    
+    return directories;
+}
+
+/* Returns the path of the formula file with the specified name, preferring a
+ * core formula to one in a tap, and its status; or nil if there is none.
+ */
+- (NSString *)pathOfFormulaFileNamed:(NSString *)name tapDirectories:(NSArray *)tapDirectories status:(struct stat *)status
+{
+    NSString *fileName = [name stringByAppendingPathExtension:@"rb"];
+    
+    if ([self formulaPath]) {
+        NSString *path = [[self formulaPath] stringByAppendingPathComponent:fileName];
+        if (stat([path fileSystemRepresentation], status) == 0 && S_ISREG(status->st_mode)) {
+            return path;
+        }
+    }
+    
+    for (NSString *directory in tapDirectories) {
+        NSString *path = [directory stringByAppendingPathComponent:fileName];
+        if (stat([path fileSystemRepresentation], status) == 0 && S_ISREG(status->st_mode)) {
+            return path;
+        }
+    }
+    
+    return nil;
+}
+
+/* Returns the version of the formula file at the specified path, reading the
+ * file only if it has changed since it was last read.
+ */
+- (NSString *)versionOfFormulaFileAtPath:(NSString *)path status:(struct stat *)status
+{
+    struct timespec modificationTime = MRBrewOutdatedEngineModificationTime(*status);
+    MRBrewOutdatedEngineEntry *entry = [[self entries] objectForKey:path];
+    
+    if (entry && entry->_modificationTime.tv_sec == modificationTime.tv_sec && entry->_modificationTime.tv_nsec == modificationTime.tv_nsec && entry->_size == status->st_size) {
+        return [entry version];
+    }
+    
+    NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL];
+    _formulaFileReadCount++;
+    
+    entry = [[MRBrewOutdatedEngineEntry alloc] init];
+    entry->_modificationTime = modificationTime;
+    entry->_size = status->st_size;
+    [entry setVersion:[[self class] versionOfFormulaWithContents:contents]];
+    [[self entries] setObject:entry forKey:path];
+    
+    return [entry version];
+}
+
+#pragma mark - Formula Versions
+
++ (NSString *)versionOfFormulaWithContents:(NSString *)contents
+{
+    NSString *url = nil;
+    NSString *version = nil;
+    NSString *stableURL = nil;
+    NSString *stableVersion = nil;
+    NSInteger revision = 0;
+    BOOL inStableBlock = NO;
+    
+    // statements are found by their indentation, so that the urls and
+    // versions of the devel, head and resource blocks are never mistaken for
+    // those of the formula
+    for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+        NSUInteger indentation = 0;
+        while (indentation < [line length] && [line characterAtIndex:indentation] == ' ') {
+            indentation++;
+        }
+        
+        NSString *statement = [[line substringFromIndex:indentation] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+        
+        if (inStableBlock) {
+            if (indentation == MRBrewOutdatedEngineClassIndentation && [statement isEqualToString:@"end"]) {
+                inStableBlock = NO;
+            }
+            else if (indentation == MRBrewOutdatedEngineBlockIndentation) {
+                stableURL = [self URLOfStatement:statement] ?: stableURL;
+                stableVersion = [self argumentOfStatement:statement keyword:@"version"] ?: stableVersion;
+            }
+            continue;
+        }
+        
+        if (indentation != MRBrewOutdatedEngineClassIndentation) {
+            continue;
+        }
+        
+        if ([statement isEqualToString:@"stable do"]) {
+            inStableBlock = YES;
+        }
+        else if ([statement hasPrefix:@"revision "]) {
+            revision = [[statement substringFromIndex:[@"revision " length]] integerValue];
+        }
+        else {
+            url = [self URLOfStatement:statement] ?: url;
+            version = [self argumentOfStatement:statement keyword:@"version"] ?: version;
+        }
+    }
+    
+    // a stable block takes the place of the url and version of the class
+    if (stableURL || stableVersion) {
+        url = stableURL;
+        version = stableVersion;
+    }
+    
+    if (!version && url) {
+        version = [self versionFromURL:url];
+    }
+    
+    if (!version) {
+        return nil;
+    }
+    
+    return (revision > 0) ? [NSString stringWithFormat:@"%@_%ld", version, (long)revision] : version;
+}
+
+/* Returns the url of a url statement, or its tag if it has one, as the version
+ * of a formula fetched from a repository is that of its tag.
+ */
++ (NSString *)URLOfStatement:(NSString *)statement
+{
+    NSString *url = [self argumentOfStatement:statement keyword:@"url"];
+    
+    if (!url) {
+        return nil;
+    }
+    
+    NSRange tagRange = [statement rangeOfString:@":tag => "];
+    if (tagRange.location != NSNotFound) {
+        NSString *tag = [self argumentOfStatement:[statement substringFromIndex:NSMaxRange(tagRange)] keyword:nil];
+        if (tag) {
+            return tag;
+        }
+    }
+    
+    return url;
+}
+
+/* Returns the first string literal argument of a statement beginning with the
+ * specified keyword, or of any statement if the keyword is nil.
+ */
++ (NSString *)argumentOfStatement:(NSString *)statement keyword:(NSString *)keyword
+{
+    NSString *arguments = statement;
+    
+    if (keyword) {
+        if (![statement hasPrefix:keyword] || [statement length] <= [keyword length] || [statement characterAtIndex:[keyword length]] != ' ') {
+            return nil;
+        }
+        arguments = [[statement substringFromIndex:[keyword length]] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    }
+    
+    if ([arguments length] < 2) {
+        return nil;
+    }
+    
+    unichar quote = [arguments characterAtIndex:0];
+    if (quote != '"' && quote != '\'') {
+        return nil;
+    }
+    
+    NSRange closingQuote = [arguments rangeOfString:[NSString stringWithCharacters:&quote length:1] options:NSLiteralSearch range:NSMakeRange(1, [arguments length] - 1)];
+    if (closingQuote.location == NSNotFound) {
+        return nil;
+    }
+    
+    return [arguments substringWithRange:NSMakeRange(1, closingQuote.location - 1)];
+}
+
++ (NSString *)versionFromURL:(NSString *)url
+{
+    static NSArray *extensions = nil;
+    static NSArray *suffixes = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        extensions = @[@".tar.gz", @".tar.bz2", @".tar.xz", @".tar.lz", @".tgz", @".tbz", @".tbz2", @".txz", @".zip", @".tar", @".gz", @".bz2", @".xz", @".7z", @".dmg", @".pkg", @".jar", @".gem"];
+        suffixes = @[@"-src", @"_src", @"-source", @".orig", @"-stable", @"-final"];
+    });
+    
+    NSString *path = url;
+    for (NSString *delimiter in @[@"?", @"#"]) {
+        NSRange range = [path rangeOfString:delimiter];
+        if (range.location != NSNotFound) {
+            path = [path substringToIndex:range.location];
+        }
+    }
+    
+    NSArray *components = [path pathComponents];
+    NSString *stem = [components lastObject];
+    
+    // SourceForge urls end with the file name followed by /download
+    if ([stem isEqualToString:@"download"] && [components count] > 1) {
+        stem = [components objectAtIndex:[components count] - 2];
+    }
+    
+    for (NSArray *endings in @[extensions, suffixes]) {
+        for (NSString *ending in endings) {
+            if ([stem length] > [ending length] && [[stem lowercaseString] hasSuffix:ending]) {
+                stem = [stem substringToIndex:[stem length] - [ending length]];
+                break;
+            }
+        }
+    }
+    
+    return [self versionFromStem:stem];
+}
+
+/* Returns the version in a file name without its extension: the whole name if
+ * it begins with a digit (as the archives of tags do, e.g. v1.2.3), or else
+ * what follows the first '-' or '_' that precedes a digit (e.g. wget-1.15).
+ */
++ (NSString *)versionFromStem:(NSString *)stem
+{
+    NSUInteger length = [stem length];
+    NSString *version = nil;
+    
+    for (NSUInteger index = 0; index < length && !version; index++) {
+        unichar character = [stem characterAtIndex:index];
+        NSUInteger start = index;
+        
+        if (index > 0) {
+            if (character != '-' && character != '_') {
+                continue;
+            }
+            start++;
+        }
+        
+        if (start + 1 < length && [stem characterAtIndex:start] == 'v') {
+            start++;
+        }
+        
+        if (start < length && [stem characterAtIndex:start] >= '0' && [stem characterAtIndex:start] <= '9') {
+            version = [stem substringFromIndex:start];
+        }
+    }
+    
+    // versions such as boost_1_55_0 are separated by underscores alone
+    if (version && [version rangeOfString:@"."].location == NSNotFound) {
+        version = [version stringByReplacingOccurrencesOfString:@"_" withString:@"."];
+    }
+    
+    return version;
+}
+
+/* Sets the error pointer (if provided) to a newly instantiated error object
+ * with the outdated engine error domain and the specified error code.
+ */
++ (void)errorWithCode:(MRBrewOutdatedEngineError)code description:(NSString *)description path:(NSString *)path usingPointer:(NSError * __autoreleasing *)errorPtr
+{
+    if (errorPtr) {
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+        if (path) {
+            [userInfo setObject:path forKey:NSFilePathErrorKey];
+        }
+        
+        *errorPtr = [NSError errorWithDomain:MRBrewOutdatedEngineErrorDomain code:code userInfo:userInfo];
+    }
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+//  MRBrewOutputBuffer.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/** An `MRBrewOutputBuffer` accumulates raw output from a Homebrew subprocess
+ * and delivers it to a handler block as UTF-8 strings made up of whole lines.
+ *
+ * Output is coalesced so that the handler is called at most once per
+ * deliveryInterval, or sooner once deliveryThreshold bytes of complete lines
+ * are waiting. Multi-byte characters that are split across reads are held
+ * until the rest of the sequence arrives. The number of bytes held by the
+ * buffer never exceeds its capacity (plus the size of the most recent read);
+ * a line longer than the capacity is delivered in pieces, each ending on a
+ * character boundary.
+ */
+@interface MRBrewOutputBuffer : NSObject
+
+/** The maximum number of bytes held before output is delivered regardless of
+ * line boundaries. Defaults to 64 KiB.
+ */
+@property (assign) NSUInteger capacity;
+
+/** The number of bytes of complete lines that causes output to be delivered
+ * immediately. Defaults to 16 KiB.
+ */
+@property (assign) NSUInteger deliveryThreshold;
+
+/** The longest time that complete lines are held before being delivered.
+ * Defaults to 0.1 seconds.
+ */
+@property (assign) NSTimeInterval deliveryInterval;
+
+/** The number of bytes currently held by the receiver. */
+@property (readonly) NSUInteger length;
+
+/** Returns an initialized output buffer that delivers output to _handler_.
+ *
+ * The handler is called serially, from the thread that appended or flushed
+ * the output or from a background queue when the delivery interval elapses.
+ *
+ * @param handler The block to call with each chunk of output.
+ * @return An output buffer.
+ */
+- (instancetype)initWithHandler:(void (^)(NSString *output))handler;
+
+/** Appends output read from a subprocess.
+ *
+ * @param data The bytes read.
+ */
+- (void)appendData:(NSData *)data;
+
+/** Delivers all held output, including an unterminated final line. */
+- (void)flush;
+
+@end
@@ -0,0 +1,275 @@
+//
+//  MRBrewOutputBuffer.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOutputBuffer.h"
+
+static const NSUInteger MRBrewOutputBufferDefaultCapacity = 64 * 1024;
+static const NSUInteger MRBrewOutputBufferDefaultDeliveryThreshold = 16 * 1024;
+static const NSTimeInterval MRBrewOutputBufferDefaultDeliveryInterval = 0.1;
+
+/* Returns the length of the longest prefix of bytes that does not end part way
+ * through a UTF-8 encoded character.
+ */
+static NSUInteger MRBrewOutputBufferCharacterBoundary(const uint8_t *bytes, NSUInteger length)
+{
+    // walk back over at most three continuation bytes to the lead byte of
+    // the final character and check whether its sequence is complete
+    NSUInteger index = length;
+    NSUInteger continuationBytes = 0;
+    while (index > 0 && continuationBytes < 3 && (bytes[index - 1] & 0xC0) == 0x80) {
+        index--;
+        continuationBytes++;
+    }
+    
+    if (index == 0) {
+        return length;
+    }
+    
+    uint8_t lead = bytes[index - 1];
+    NSUInteger sequenceLength = 1;
+    if ((lead & 0xE0) == 0xC0) sequenceLength = 2;
+    else if ((lead & 0xF0) == 0xE0) sequenceLength = 3;
+    else if ((lead & 0xF8) == 0xF0) sequenceLength = 4;
+    
+    return (continuationBytes + 1 < sequenceLength) ? index - 1 : length;
+}
+
+/* Returns the length of the well-formed UTF-8 sequence at the start of bytes,
+ * or zero if the first byte does not begin one. Overlong forms, surrogates and
+ * code points beyond U+10FFFF are not well-formed.
+ */
+static NSUInteger MRBrewOutputBufferSequenceLength(const uint8_t *bytes, NSUInteger length)
+{
+    uint8_t lead = bytes[0];
+    if (lead < 0x80) {
+        return 1;
+    }
+    
+    NSUInteger sequenceLength;
+    uint8_t minimum = 0x80, maximum = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) sequenceLength = 2;
+    else if (lead == 0xE0) { sequenceLength = 3; minimum = 0xA0; }
+    else if (lead == 0xED) { sequenceLength = 3; maximum = 0x9F; }
+    else if (lead >= 0xE1 && lead <= 0xEF) sequenceLength = 3;
+    else if (lead == 0xF0) { sequenceLength = 4; minimum = 0x90; }
+    else if (lead == 0xF4) { sequenceLength = 4; maximum = 0x8F; }
+    else if (lead >= 0xF1 && lead <= 0xF3) sequenceLength = 4;
+    else return 0;
+    
+    if (length < sequenceLength || bytes[1] < minimum || bytes[1] > maximum) {
+        return 0;
+    }
+    
+    for (NSUInteger index = 2; index < sequenceLength; index++) {
+        if ((bytes[index] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    
+    return sequenceLength;
+}
+
+/* Returns a string for UTF-8 output bytes, in which each byte that is not
+ * part of a well-formed sequence is replaced with U+FFFD, so that the rest of
+ * the output is decoded as it was written.
+ */
+static NSString *MRBrewOutputBufferString(const uint8_t *bytes, NSUInteger length)
+{
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (string) {
+        return string;
+    }
+    
+    NSMutableString *output = [NSMutableString stringWithCapacity:length];
+    NSUInteger runStart = 0;
+    NSUInteger index = 0;
+    
+    while (index < length) {
+        NSUInteger sequenceLength = MRBrewOutputBufferSequenceLength(bytes + index, length - index);
+        if (sequenceLength > 0) {
+            index += sequenceLength;
+            continue;
+        }
+        
+        if (index > runStart) {
+            [output appendString:[[NSString alloc] initWithBytes:bytes + runStart length:index - runStart encoding:NSUTF8StringEncoding]];
+        }
+        [output appendString:@"\uFFFD"];
+        runStart = ++index;
+    }
+    
+    if (length > runStart) {
+        [output appendString:[[NSString alloc] initWithBytes:bytes + runStart length:length - runStart encoding:NSUTF8StringEncoding]];
+    }
+    
+    return output;
+}
+
+@interface MRBrewOutputBuffer ()
+{
+    @private
+    NSMutableData *_bytes;
+    void (^_handler)(NSString *output);
+    NSObject *_deliveryLock;
+    BOOL _deliveryScheduled;
+}
+
+@end
+
+@implementation MRBrewOutputBuffer
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithHandler:nil];
+}
+
+- (instancetype)initWithHandler:(void (^)(NSString *output))handler
+{
+    if (self = [super init]) {
+        _bytes = [NSMutableData data];
+        _handler = [handler copy];
+        _deliveryLock = [[NSObject alloc] init];
+        _capacity = MRBrewOutputBufferDefaultCapacity;
+        _deliveryThreshold = MRBrewOutputBufferDefaultDeliveryThreshold;
+        _deliveryInterval = MRBrewOutputBufferDefaultDeliveryInterval;
+    }
+    
+    return self;
+}
+
+#pragma mark - Buffering
+
+- (NSUInteger)length
+{
+    @synchronized(self) {
+        return [_bytes length];
+    }
+}
+
+- (void)appendData:(NSData *)data
+{
+    if (![data length]) {
+        return;
+    }
+    
+    BOOL delivers;
+    
+    @synchronized(self) {
+        [_bytes appendData:data];
+        delivers = [_bytes length] >= [self deliveryThreshold] || [_bytes length] >= [self capacity];
+    }
+    
+    if (delivers) {
+        [self deliverOutputIncludingPartialLine:NO];
+    }
+    
+    @synchronized(self) {
+        // anything left over is delivered once the delivery interval elapses
+        if ([_bytes length] > 0 && !_deliveryScheduled) {
+            _deliveryScheduled = YES;
+            
+            __weak MRBrewOutputBuffer *weakSelf = self;
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self deliveryInterval] * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [weakSelf deliveryIntervalElapsed];
+            });
+        }
+    }
+}
+
+- (void)flush
+{
+    [self deliverOutputIncludingPartialLine:YES];
+}
+
+- (void)deliveryIntervalElapsed
+{
+    @synchronized(self) {
+        _deliveryScheduled = NO;
+    }
+    
+    [self deliverOutputIncludingPartialLine:NO];
+}
+
+/* Delivers held output up to and including the last complete line, or up to
+ * the last complete character if the buffer has reached its capacity. The
+ * handler is called without holding the buffer's lock, so that it may append
+ * output, and under the delivery lock, so that chunks are delivered in order.
+ */
+- (void)deliverOutputIncludingPartialLine:(BOOL)includePartialLine
+{
+    @synchronized(_deliveryLock) {
+        NSString *output;
+        
+        @synchronized(self) {
+            output = [self takeOutputIncludingPartialLine:includePartialLine];
+        }
+        
+        if (output && _handler) {
+            _handler(output);
+        }
+    }
+}
+
+/* Removes and returns held output up to and including the last complete line,
+ * or up to the last complete character if the buffer has reached its
+ * capacity, or nil if there is none. Must be called while synchronized on the
+ * receiver.
+ */
+- (NSString *)takeOutputIncludingPartialLine:(BOOL)includePartialLine
+{
+    const uint8_t *bytes = [_bytes bytes];
+    NSUInteger length = [_bytes length];
+    NSUInteger end = 0;
+    
+    if (includePartialLine) {
+        end = length;
+    }
+    else {
+        for (NSUInteger index = length; index > 0; index--) {
+            if (bytes[index - 1] == '\n') {
+                end = index;
+                break;
+            }
+        }
+        
+        if (end == 0 && length >= [self capacity]) {
+            end = MRBrewOutputBufferCharacterBoundary(bytes, length);
+        }
+    }
+    
+    if (end == 0) {
+        return nil;
+    }
+    
+    NSString *output = MRBrewOutputBufferString(bytes, end);
+    
+    [_bytes replaceBytesInRange:NSMakeRange(0, end) withBytes:NULL length:0];
+    
+    return output;
+}
+
+@end
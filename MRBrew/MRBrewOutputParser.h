@@ -89,12 +89,17 @@ typedef NS_ENUM(NSInteger, MRBrewOutputParserError) {
  * (i.e. the output string is empty or yieled no objects). For operations
  * whose `name` property is equal to one of the constants
  * `MRBrewOperationListIdentifier` or `MRBrewOperationSearchIdentifier`,
- * the returned array will contain one or more `MRBrewFormula` objects.
- * In addition, for `MRBrewOperationListIdentifier` operations, each operation
+ * the returned array will contain one or more interned (and so immutable)
+ * `MRBrewFormula` objects. In addition, for `MRBrewOperationListIdentifier` operations, each operation
  * object will have its `isInstalled` property set to `YES`. For operations
  * whose `name` property matches the `MRBrewOperationOptionsIdentifier`
  * constant, the returned array will contain one or more `MRBrewInstallOption`
  * objects.
+ *
+ * Output of an info, list or outdated operation that was performed with JSON
+ * output (see the usesJSONOutput property of the MRBrewOperation class) is
+ * decoded into `MRBrewFormula` objects that include the versions and
+ * dependencies of each formula.
  */
 - (NSArray *)objectsForOperation:(MRBrewOperation *)operation output:(NSString *)output error:(NSError **)error;
 
@@ -24,21 +24,22 @@
 //
 
 #import "MRBrewOutputParser.h"
+#import "MRBrewOutputParser+Private.h"
 #import "MRBrewOperation.h"
 #import "MRBrewConstants.h"
 #import "MRBrewFormula.h"
 #import "MRBrewInstallOption.h"
+#import "MRBrewFormulaJSONDecoder.h"
+#include <ctype.h>
 
 NSString * const MRBrewOutputParserErrorDomain = @"uk.co.fidgetbox.MRBrew";
 
-@interface MRBrewOutputParser ()
-
-- (NSArray *)parseFormulaeFromOutput:(NSString *)output;
-- (NSArray *)parseFormulaeFromSearchOperationOutput:(NSString *)output;
-- (NSArray *)parseFormulaeFromListOperationOutput:(NSString *)output;
-- (NSArray *)parseInstallOptionsFromOutput:(NSString *)output;
-
-@end
+/* The states of the install options tokenizer. */
+typedef NS_ENUM(NSInteger, MRBrewOutputParserOptionsState) {
+    MRBrewOutputParserOptionsStateExpectingOption,
+    MRBrewOutputParserOptionsStateExpectingDescription,
+    MRBrewOutputParserOptionsStateInDescription
+};
 
 @implementation MRBrewOutputParser
 
@@ -63,7 +64,17 @@ NSString * const MRBrewOutputParserErrorDomain = @"uk.co.fidgetbox.MRBrew";
     NSArray *objects = nil;
     BOOL errorOccurred = NO;
     
-    if ([[operation name] isEqualToString:MRBrewOperationListIdentifier]) {
+    // JSON output is recognised by its content, since the output of a list
+    // operation never begins with an opening bracket
+    if ([MRBrewOperation supportsJSONOutputForOperationName:[operation name]] && [output hasPrefix:@"["]) {
+        objects = [self parseFormulaeFromJSONOutput:output];
+        
+        if (!objects) {
+            [self errorForErrorType:MRBrewOutputParserErrorSyntax usingPointer:error];
+            errorOccurred = YES;
+        }
+    }
+    else if ([[operation name] isEqualToString:MRBrewOperationListIdentifier]) {
         objects = [self parseFormulaeFromListOperationOutput:output];
     }
     else if ([[operation name] isEqualToString:MRBrewOperationSearchIdentifier]) {
@@ -93,24 +104,63 @@ NSString * const MRBrewOutputParserErrorDomain = @"uk.co.fidgetbox.MRBrew";
 
 #pragma mark - Object Parsing (private)
 
+/* Returns the UTF-8 representation of a string, without copying it where the
+ * string already stores it. Only Core Foundation exposes the storage of a
+ * string, so it is always copied elsewhere.
+ */
+static const char *MRBrewOutputParserUTF8Bytes(NSString *string)
+{
+#ifdef __APPLE__
+    const char *bytes = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingUTF8);
+    if (bytes) {
+        return bytes;
+    }
+#endif
+    
+    return [string UTF8String];
+}
+
 /* Parse output string in which each line is expected to contain the name of a
- * formula, and return an array of one or more MRBrewFormula objects.
+ * formula, and return an array of one or more MRBrewFormula objects with the
+ * specified installed state. The UTF-8 representation of the string is scanned
+ * once, in place where the string allows it, and the interned formula for
+ * each name is returned, so repeated results share their formulae.
  */
-- (NSArray *)parseFormulaeFromOutput:(NSString *)output
+- (NSArray *)parseFormulaeFromOutput:(NSString *)output isInstalled:(BOOL)isInstalled
 {
     NSMutableArray *objects = [NSMutableArray array];
     
-    NSArray *names = [output componentsSeparatedByString:@"\n"];
+    const char *bytes = MRBrewOutputParserUTF8Bytes(output);
     
-    for (NSString *name in names) {
-        if ([name isEqualToString:@""]) {
-            continue;
+    const char *lineStart = bytes;
+    while (lineStart && *lineStart != '\0') {
+        const char *lineEnd = strchr(lineStart, '\n');
+        size_t length = lineEnd ? (size_t)(lineEnd - lineStart) : strlen(lineStart);
+        
+        if (length > 0) {
+            NSString *name = [[NSString alloc] initWithBytes:lineStart length:length encoding:NSUTF8StringEncoding];
+            [objects addObject:[MRBrewFormula internedFormulaWithName:name isNew:NO isUpdated:NO isInstalled:isInstalled]];
         }
         
-        [objects addObject:[MRBrewFormula formulaWithName:name]];
+        lineStart = lineEnd ? lineEnd + 1 : NULL;
     }
     
-    return [NSArray arrayWithArray:objects];
+    return objects;
+}
+
+/* Decode the JSON output of an info, list or outdated operation and return an
+ * array of MRBrewFormula objects. Returns nil if the output is not valid JSON.
+ */
+- (NSArray *)parseFormulaeFromJSONOutput:(NSString *)output
+{
+    NSMutableArray *objects = [NSMutableArray array];
+    
+    MRBrewFormulaJSONDecoder *decoder = [[MRBrewFormulaJSONDecoder alloc] initWithHandler:^(NSArray *formulae) {
+        [objects addObjectsFromArray:formulae];
+    }];
+    [decoder appendString:output];
+    
+    return [decoder finish] ? objects : nil;
 }
 
 /* Parse output string in which each line is expected to contain the name of a
@@ -124,67 +174,119 @@ NSString * const MRBrewOutputParserErrorDomain = @"uk.co.fidgetbox.MRBrew";
         return nil;
     }
     
-    return [self parseFormulaeFromOutput:output];
+    return [self parseFormulaeFromOutput:output isInstalled:NO];
 }
 
+/* Parse output string in which each line is expected to contain the name of an
+ * installed formula, and return an array of one or more MRBrewFormula objects
+ * whose isInstalled property is set to YES.
+ */
 - (NSArray *)parseFormulaeFromListOperationOutput:(NSString *)output
 {
-    NSArray *formulae = [self parseFormulaeFromOutput:output];
-    
-    for (MRBrewFormula *formula in formulae) {
-        [formula setIsInstalled:YES];
-    }
-    
-    return [NSArray arrayWithArray:formulae];
+    return [self parseFormulaeFromOutput:output isInstalled:YES];
 }
 
-/* Parse output string that is expected to contain two lines of text for each
- * option defined by Homebrew. The first line should begin with the string '--',
- * and the second should begin with a tab character. Returns nil if the string
- * parsing was unsuccessful, an empty array if the output string is empty, or an
- * array of one or more MRBrewFormula objects if parsing was successful.
+/* Parse output string that is expected to contain an option line beginning
+ * with the string '--' for each option defined by Homebrew, followed by a
+ * description line beginning with a tab character. The description may also
+ * follow the option on the same line after a tab, may contain tabs, and may
+ * continue over further lines, which are joined with a single space. The UTF-8
+ * representation of the string is walked once by a small state machine. Returns
+ * nil if the string does not match this format or contains no options,
+ * otherwise an array of one or more MRBrewInstallOption objects.
  */
 - (NSArray *)parseInstallOptionsFromOutput:(NSString *)output
 {
     NSMutableArray *objects = [NSMutableArray array];
-
-    NSUInteger optionIndex = 0;
-    NSUInteger descriptionIndex = 1;
     
-    for (NSString *line in [output componentsSeparatedByString:@"\n--"]) {
-        
-        NSMutableArray *optionWithDescription = [[line componentsSeparatedByString:@"\t"] mutableCopy];
+    const char *bytes = MRBrewOutputParserUTF8Bytes(output);
+    
+    MRBrewOutputParserOptionsState state = MRBrewOutputParserOptionsStateExpectingOption;
+    NSString *name = nil;
+    id description = nil;
+    
+    const char *lineStart = bytes;
+    while (lineStart) {
+        const char *lineEnd = strchr(lineStart, '\n');
+        const char *end = lineEnd ? lineEnd : lineStart + strlen(lineStart);
+        const char *start = lineStart;
         
-        // after separating the components into an array, we expect there to be
-        // precisely two elements -- the option and description strings
-        if ([optionWithDescription count] != 2) {
-            return nil;
+        // trim surrounding whitespace, noting whether the line was indented
+        while (end > start && isspace((unsigned char)end[-1])) {
+            end--;
         }
-        
-        // replace '--' prefix that was removed when separating into components
-        if (![[optionWithDescription objectAtIndex:optionIndex] hasPrefix:@"--"]) {
-            [optionWithDescription setObject:[NSString stringWithFormat:@"--%@", [optionWithDescription objectAtIndex:optionIndex]] atIndexedSubscript:optionIndex];
+        BOOL indented = (start < end && (*start == '\t' || *start == ' '));
+        while (start < end && (*start == '\t' || *start == ' ')) {
+            start++;
         }
         
-        // remove unnecessary line breaks from the option string
-        if ([[optionWithDescription objectAtIndex:optionIndex] rangeOfString:@"\n"].location != NSNotFound) {
-            [optionWithDescription setObject:[[optionWithDescription objectAtIndex:optionIndex] stringByReplacingOccurrencesOfString:@"\n" withString:@""] atIndexedSubscript:optionIndex];
+        if (start == end) {
+            // a blank line ends the current option
+            if (state == MRBrewOutputParserOptionsStateExpectingDescription) {
+                return nil;
+            }
+            if (state == MRBrewOutputParserOptionsStateInDescription) {
+                [objects addObject:[MRBrewInstallOption installOptionWithName:name description:description selected:NO]];
+                state = MRBrewOutputParserOptionsStateExpectingOption;
+            }
         }
-        
-        // remove unnecessary line breaks from the description string
-        if ([[optionWithDescription objectAtIndex:descriptionIndex] rangeOfString:@"\n"].location != NSNotFound) {
-            [optionWithDescription setObject:[[optionWithDescription objectAtIndex:descriptionIndex] stringByReplacingOccurrencesOfString:@"\n" withString:@""] atIndexedSubscript:descriptionIndex];
+        else if (!indented && end - start >= 2 && start[0] == '-' && start[1] == '-') {
+            // an option line, which ends the previous option
+            if (state == MRBrewOutputParserOptionsStateExpectingDescription) {
+                return nil;
+            }
+            if (state == MRBrewOutputParserOptionsStateInDescription) {
+                [objects addObject:[MRBrewInstallOption installOptionWithName:name description:description selected:NO]];
+            }
+            
+            const char *tab = memchr(start, '\t', end - start);
+            const char *nameEnd = tab ? tab : end;
+            name = [[NSString alloc] initWithBytes:start length:nameEnd - start encoding:NSUTF8StringEncoding];
+            state = MRBrewOutputParserOptionsStateExpectingDescription;
+            
+            if (tab) {
+                const char *descriptionStart = tab;
+                while (descriptionStart < end && (*descriptionStart == '\t' || *descriptionStart == ' ')) {
+                    descriptionStart++;
+                }
+                
+                if (descriptionStart < end) {
+                    description = [[NSString alloc] initWithBytes:descriptionStart length:end - descriptionStart encoding:NSUTF8StringEncoding];
+                    state = MRBrewOutputParserOptionsStateInDescription;
+                }
+            }
+        }
+        else if (state == MRBrewOutputParserOptionsStateExpectingDescription && indented) {
+            description = [[NSString alloc] initWithBytes:start length:end - start encoding:NSUTF8StringEncoding];
+            state = MRBrewOutputParserOptionsStateInDescription;
+        }
+        else if (state == MRBrewOutputParserOptionsStateInDescription) {
+            // a continuation of the description
+            if (![description isKindOfClass:[NSMutableString class]]) {
+                description = [description mutableCopy];
+            }
+            NSString *continuation = [[NSString alloc] initWithBytesNoCopy:(void *)start length:end - start encoding:NSUTF8StringEncoding freeWhenDone:NO];
+            [description appendString:@" "];
+            [description appendString:continuation];
+        }
+        else {
+            // text that is neither an option nor a description
+            return nil;
         }
         
-        // instantiate an install option object for each option we encounter
-        MRBrewInstallOption *option = [MRBrewInstallOption installOptionWithName:[optionWithDescription objectAtIndex:optionIndex] description:[optionWithDescription objectAtIndex:descriptionIndex] selected:NO];
-        [objects addObject:option];
+        lineStart = lineEnd ? lineEnd + 1 : NULL;
     }
     
-    return [NSArray arrayWithArray:objects];
+    if (state == MRBrewOutputParserOptionsStateExpectingDescription) {
+        return nil;
+    }
+    if (state == MRBrewOutputParserOptionsStateInDescription) {
+        [objects addObject:[MRBrewInstallOption installOptionWithName:name description:description selected:NO]];
+    }
+    
+    return [objects count] > 0 ? objects : nil;
 }
 
-
 /* Sets the error pointer (if provided) to a newly instantiated error object
  * with a default error domain and the specified error code.
  */
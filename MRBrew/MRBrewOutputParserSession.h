@@ -0,0 +1,101 @@
+//
+//  MRBrewOutputParserSession.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MRBrewOperation;
+
+/** An `MRBrewOutputParserSession` parses the output of an operation
+ * incrementally, as it is received, rather than once the operation has
+ * finished.
+ *
+ * Output is appended to a session in chunks of any size using appendData: or
+ * appendString:, and the session's handler is called with the objects parsed
+ * from each complete line (or, for options output, each complete option) as
+ * soon as it is available. Only the incomplete trailing part of the output is
+ * held by the session. Call finish once all output has been appended to parse
+ * any remaining output.
+ *
+ * The objects parsed are those that the `MRBrewOutputParser` method
+ * objectsForOperation:output:error: would return for the complete output.
+ * Parsing is only supported for operations whose `name` property matches one
+ * of the constants `MRBrewOperationListIdentifier`,
+ * `MRBrewOperationSearchIdentifier` or `MRBrewOperationOptionsIdentifier`, and
+ * for info and outdated operations performed with JSON output. The JSON output
+ * of an operation is decoded using an `MRBrewFormulaJSONDecoder`, with formulae
+ * delivered as each is completed rather than line by line.
+ */
+@interface MRBrewOutputParserSession : NSObject
+
+/** The operation whose output is parsed by the receiver. */
+@property (readonly, copy) MRBrewOperation *operation;
+
+/**-----------------------------------------------------------------------------
+ * @name Creating a Parser Session
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns whether the output of an operation can be parsed incrementally.
+ *
+ * @param operation The operation.
+ * @return `YES` if the operation's output can be parsed, otherwise `NO`.
+ */
++ (BOOL)supportsOperation:(MRBrewOperation *)operation;
+
+/** Returns an initialized parser session for the output of an operation.
+ *
+ * @param operation The operation whose output will be parsed.
+ * @param handler The block called with each non-empty array of objects parsed.
+ * The block is called on the thread that appended the output, or that called
+ * finish.
+ * @return A parser session, or `nil` if parsing is not supported for the
+ * operation.
+ */
+- (instancetype)initWithOperation:(MRBrewOperation *)operation handler:(void (^)(NSArray *objects))handler;
+
+/**-----------------------------------------------------------------------------
+ * @name Parsing Output
+ * -----------------------------------------------------------------------------
+ */
+
+/** Parses a chunk of output bytes, which may end part way through a line or
+ * a UTF-8 character sequence.
+ *
+ * @param data The UTF-8 encoded output.
+ */
+- (void)appendData:(NSData *)data;
+
+/** Parses a chunk of output, which may end part way through a line.
+ *
+ * @param string The output string.
+ */
+- (void)appendString:(NSString *)string;
+
+/** Parses any output held by the receiver. Output appended after this method
+ * is called is ignored.
+ */
+- (void)finish;
+
+@end
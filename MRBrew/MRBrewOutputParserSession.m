@@ -0,0 +1,246 @@
+//
+//  MRBrewOutputParserSession.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewOutputParserSession.h"
+#import "MRBrewOutputParser.h"
+#import "MRBrewOutputParser+Private.h"
+#import "MRBrewOperation.h"
+#import "MRBrewConstants.h"
+#import "MRBrewFormulaJSONDecoder.h"
+
+/* Returns a string for UTF-8 output bytes, falling back to Latin-1 if the bytes
+ * are not valid UTF-8 so that no output is lost.
+ */
+static NSString *MRBrewOutputParserSessionString(const void *bytes, NSUInteger length)
+{
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] ?: [[NSString alloc] initWithBytes:bytes length:length encoding:NSISOLatin1StringEncoding];
+}
+
+@interface MRBrewOutputParserSession ()
+{
+    @private
+    MRBrewOutputParser *_parser;
+    MRBrewFormulaJSONDecoder *_decoder;
+    void (^_handler)(NSArray *objects);
+    NSMutableData *_pendingData;
+    NSMutableString *_pendingOption;
+    BOOL _parsesOptions;
+    BOOL _receivedOutput;
+    BOOL _ignoresOutput;
+}
+
+@end
+
+@implementation MRBrewOutputParserSession
+
+#pragma mark - Lifecycle
+
++ (BOOL)supportsOperation:(MRBrewOperation *)operation
+{
+    NSString *name = [operation name];
+    
+    if ([name isEqualToString:MRBrewOperationListIdentifier] || [name isEqualToString:MRBrewOperationSearchIdentifier] || [name isEqualToString:MRBrewOperationOptionsIdentifier]) {
+        return YES;
+    }
+    
+    return [operation isJSONOperation];
+}
+
+- (instancetype)init
+{
+    return [self initWithOperation:nil handler:nil];
+}
+
+- (instancetype)initWithOperation:(MRBrewOperation *)operation handler:(void (^)(NSArray *objects))handler
+{
+    if (![[self class] supportsOperation:operation]) {
+        return nil;
+    }
+    
+    if (self = [super init]) {
+        _operation = [operation copy];
+        _parser = [MRBrewOutputParser outputParser];
+        _handler = [handler copy];
+        _pendingData = [NSMutableData data];
+        _parsesOptions = [[operation name] isEqualToString:MRBrewOperationOptionsIdentifier];
+        
+        // JSON output is decoded token by token rather than line by line
+        if ([operation isJSONOperation]) {
+            __weak MRBrewOutputParserSession *weakSelf = self;
+            _decoder = [[MRBrewFormulaJSONDecoder alloc] initWithHandler:^(NSArray *formulae) {
+                [weakSelf deliverObjects:formulae];
+            }];
+        }
+    }
+    
+    return self;
+}
+
+#pragma mark - Parsing
+
+- (void)appendData:(NSData *)data
+{
+    @synchronized(self) {
+        if (_ignoresOutput) {
+            return;
+        }
+        
+        if (_decoder) {
+            [_decoder appendData:data];
+            return;
+        }
+        
+        [_pendingData appendData:data];
+        
+        // parse up to the last line break, holding on to the incomplete line
+        // (which may end part way through a character) that follows it
+        const char *bytes = [_pendingData bytes];
+        NSUInteger end = [_pendingData length];
+        while (end > 0 && bytes[end - 1] != '\n') {
+            end--;
+        }
+        
+        if (end == 0) {
+            return;
+        }
+        
+        NSString *lines = MRBrewOutputParserSessionString(bytes, end);
+        [_pendingData replaceBytesInRange:NSMakeRange(0, end) withBytes:NULL length:0];
+        [self parseLines:lines];
+    }
+}
+
+- (void)appendString:(NSString *)string
+{
+    @synchronized(self) {
+        if (_ignoresOutput) {
+            return;
+        }
+        
+        if (_decoder) {
+            [_decoder appendString:string];
+            return;
+        }
+        
+        // an incomplete line is held as bytes, so append to it as bytes
+        if ([_pendingData length] > 0) {
+            [self appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+            return;
+        }
+        
+        NSRange lineBreak = [string rangeOfString:@"\n" options:NSBackwardsSearch];
+        if (lineBreak.location == NSNotFound) {
+            [_pendingData appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+            return;
+        }
+        
+        NSUInteger end = NSMaxRange(lineBreak);
+        if (end < [string length]) {
+            [_pendingData appendData:[[string substringFromIndex:end] dataUsingEncoding:NSUTF8StringEncoding]];
+            string = [string substringToIndex:end];
+        }
+        
+        [self parseLines:string];
+    }
+}
+
+- (void)finish
+{
+    @synchronized(self) {
+        if (_ignoresOutput) {
+            return;
+        }
+        
+        if (_decoder) {
+            [_decoder finish];
+            _ignoresOutput = YES;
+            return;
+        }
+        
+        if ([_pendingData length] > 0) {
+            NSString *line = MRBrewOutputParserSessionString([_pendingData bytes], [_pendingData length]);
+            [_pendingData setLength:0];
+            [self parseLines:line];
+        }
+        
+        if ([_pendingOption length] > 0) {
+            [self deliverObjects:[_parser parseInstallOptionsFromOutput:_pendingOption]];
+            _pendingOption = nil;
+        }
+        
+        _ignoresOutput = YES;
+    }
+}
+
+/* Parses one or more complete lines of output. Must be called while
+ * synchronized on the receiver.
+ */
+- (void)parseLines:(NSString *)lines
+{
+    // search output that starts by reporting that nothing was found contains
+    // no formula names
+    if (!_receivedOutput) {
+        _receivedOutput = YES;
+        
+        if ([[[self operation] name] isEqualToString:MRBrewOperationSearchIdentifier] && [lines hasPrefix:@"No formula found"]) {
+            _ignoresOutput = YES;
+            return;
+        }
+    }
+    
+    if (!_parsesOptions) {
+        BOOL isInstalled = [[[self operation] name] isEqualToString:MRBrewOperationListIdentifier];
+        [self deliverObjects:[_parser parseFormulaeFromOutput:lines isInstalled:isInstalled]];
+        return;
+    }
+    
+    // an option is complete once the line naming the next option is received,
+    // since its description may span more than one line
+    [lines enumerateSubstringsInRange:NSMakeRange(0, [lines length]) options:NSStringEnumerationByLines usingBlock:^(NSString *line, NSRange lineRange, NSRange enclosingRange, BOOL *stop) {
+        if ([line hasPrefix:@"--"] && [_pendingOption length] > 0) {
+            [self deliverObjects:[_parser parseInstallOptionsFromOutput:_pendingOption]];
+            _pendingOption = nil;
+        }
+        
+        if ([line length] == 0 && [_pendingOption length] == 0) {
+            return;
+        }
+        
+        if (!_pendingOption) {
+            _pendingOption = [NSMutableString string];
+        }
+        [_pendingOption appendString:line];
+        [_pendingOption appendString:@"\n"];
+    }];
+}
+
+- (void)deliverObjects:(NSArray *)objects
+{
+    if ([objects count] > 0 && _handler) {
+        _handler(objects);
+    }
+}
+
+@end
@@ -0,0 +1,111 @@
+//
+//  MRBrewResultCache.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewWatcherDelegate.h"
+
+@class MRBrewOperation;
+
+/** An `MRBrewResultCache` holds the output of read-only operations (see the
+ * isReadOnly method of the MRBrewOperation class) so that repeated requests
+ * for the same information can be answered without spawning a Homebrew
+ * subprocess.
+ *
+ * Output is keyed on the operation's name, formula name and parameters, and
+ * the least recently used output is discarded once the total size of the
+ * cached output exceeds byteLimit.
+ *
+ * Cached output becomes stale when the Homebrew installation changes. `MRBrew`
+ * discards all cached output whenever it performs an operation that is not
+ * read-only; to also discard it when Homebrew is changed by another process,
+ * specify the cache as the delegate of an `MRBrewWatcher` object.
+ *
+ * Each time cached output is discarded the cache's generation is incremented,
+ * so that output generated by an operation started before the Homebrew
+ * installation changed can be recognised as stale and is not cached.
+ */
+@interface MRBrewResultCache : NSObject <MRBrewWatcherDelegate>
+
+/** The maximum number of bytes of output held by the cache. Defaults to
+ * 4 MiB.
+ */
+@property (assign) NSUInteger byteLimit;
+
+/** The number of bytes of output currently held by the cache. */
+@property (readonly) NSUInteger byteCount;
+
+/** The number of lookups that returned cached output. */
+@property (readonly) NSUInteger hitCount;
+
+/** The number of lookups that found no cached output. */
+@property (readonly) NSUInteger missCount;
+
+/** The generation of the cache, which is incremented each time all cached
+ * output is discarded.
+ */
+@property (readonly) NSUInteger generation;
+
+/**-----------------------------------------------------------------------------
+ * @name Accessing Cached Output
+ * -----------------------------------------------------------------------------
+ */
+
+/** Returns the cached output of an operation.
+ *
+ * @param operation The operation.
+ * @return The output of an equal operation that was previously performed, or
+ * `nil` if no output is cached.
+ */
+- (NSString *)outputForOperation:(MRBrewOperation *)operation;
+
+/** Caches the output of an operation.
+ *
+ * Output is not cached if the operation is not read-only or if the output is
+ * larger than the receiver's byteLimit.
+ *
+ * @param output The output string generated by the operation.
+ * @param operation The operation.
+ */
+- (void)setOutput:(NSString *)output forOperation:(MRBrewOperation *)operation;
+
+/** Caches the output of an operation that was started in the specified
+ * generation of the cache.
+ *
+ * Output is not cached if the operation is not read-only, if the output is
+ * larger than the receiver's byteLimit, or if cached output has been
+ * discarded since the operation was started, as the output may no longer
+ * reflect the Homebrew installation.
+ *
+ * @param output The output string generated by the operation.
+ * @param operation The operation.
+ * @param generation The generation of the receiver when the operation was
+ * started.
+ */
+- (void)setOutput:(NSString *)output forOperation:(MRBrewOperation *)operation generation:(NSUInteger)generation;
+
+/** Discards all cached output, and increments the generation of the cache. */
+- (void)removeAllOutput;
+
+@end
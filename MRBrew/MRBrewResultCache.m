@@ -0,0 +1,228 @@
+//
+//  MRBrewResultCache.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewResultCache.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+
+static const NSUInteger MRBrewResultCacheDefaultByteLimit = 4 * 1024 * 1024;
+
+/* Returns the key for an operation, composed of the same values that are
+ * compared by isEqualToOperation: that affect the output of the operation.
+ */
+static NSString * MRBrewResultCacheKey(MRBrewOperation *operation)
+{
+    NSMutableString *key = [NSMutableString stringWithString:([operation name] ?: @"")];
+    
+    [key appendString:@"\x1e"];
+    for (NSString *parameter in [operation parameters]) {
+        [key appendString:parameter];
+        [key appendString:@"\x1f"];
+    }
+    
+    [key appendString:@"\x1e"];
+    if ([operation formula]) {
+        [key appendString:[[operation formula] name] ?: @""];
+    }
+    
+    if ([operation usesJSONOutput]) {
+        [key appendString:@"\x1ejson"];
+    }
+    
+    return key;
+}
+
+/* Returns the approximate number of bytes occupied by a string. */
+static NSUInteger MRBrewResultCacheByteCount(NSString *output)
+{
+    return [output length] * sizeof(unichar);
+}
+
+@interface MRBrewResultCache ()
+{
+    @private
+    NSMutableDictionary *_outputs;
+    NSMutableOrderedSet *_recentlyUsedKeys;
+    NSUInteger _byteLimit;
+    NSUInteger _byteCount;
+    NSUInteger _hitCount;
+    NSUInteger _missCount;
+    NSUInteger _generation;
+}
+
+@end
+
+@implementation MRBrewResultCache
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _outputs = [NSMutableDictionary dictionary];
+        _recentlyUsedKeys = [NSMutableOrderedSet orderedSet];
+        _byteLimit = MRBrewResultCacheDefaultByteLimit;
+    }
+    
+    return self;
+}
+
+#pragma mark - Cached Output
+
+- (NSUInteger)byteLimit
+{
+    @synchronized(self) {
+        return _byteLimit;
+    }
+}
+
+- (void)setByteLimit:(NSUInteger)byteLimit
+{
+    @synchronized(self) {
+        _byteLimit = byteLimit;
+        [self evictOutputToByteLimit];
+    }
+}
+
+- (NSUInteger)byteCount
+{
+    @synchronized(self) {
+        return _byteCount;
+    }
+}
+
+- (NSUInteger)hitCount
+{
+    @synchronized(self) {
+        return _hitCount;
+    }
+}
+
+- (NSUInteger)missCount
+{
+    @synchronized(self) {
+        return _missCount;
+    }
+}
+
+- (NSUInteger)generation
+{
+    @synchronized(self) {
+        return _generation;
+    }
+}
+
+- (NSString *)outputForOperation:(MRBrewOperation *)operation
+{
+    NSString *key = MRBrewResultCacheKey(operation);
+    
+    @synchronized(self) {
+        NSString *output = [_outputs objectForKey:key];
+        
+        if (!output) {
+            _missCount++;
+            return nil;
+        }
+        
+        // mark the output as the most recently used
+        _hitCount++;
+        [_recentlyUsedKeys removeObject:key];
+        [_recentlyUsedKeys addObject:key];
+        
+        return output;
+    }
+}
+
+- (void)setOutput:(NSString *)output forOperation:(MRBrewOperation *)operation
+{
+    [self setOutput:output forOperation:operation generation:[self generation]];
+}
+
+- (void)setOutput:(NSString *)output forOperation:(MRBrewOperation *)operation generation:(NSUInteger)generation
+{
+    if (!output || ![MRBrewOperation isReadOnlyOperationName:[operation name]]) {
+        return;
+    }
+    
+    NSString *key = MRBrewResultCacheKey(operation);
+    
+    @synchronized(self) {
+        // the output was generated before the cached output was discarded
+        if (generation != _generation || MRBrewResultCacheByteCount(output) > _byteLimit) {
+            return;
+        }
+        
+        [self removeOutputForKey:key];
+        
+        [_outputs setObject:[output copy] forKey:key];
+        [_recentlyUsedKeys addObject:key];
+        _byteCount += MRBrewResultCacheByteCount(output);
+        
+        [self evictOutputToByteLimit];
+    }
+}
+
+- (void)removeAllOutput
+{
+    @synchronized(self) {
+        [_outputs removeAllObjects];
+        [_recentlyUsedKeys removeAllObjects];
+        _byteCount = 0;
+        _generation++;
+    }
+}
+
+/* Removes the output for a key. Must be called while synchronized on the
+ * receiver.
+ */
+- (void)removeOutputForKey:(NSString *)key
+{
+    NSString *output = [_outputs objectForKey:key];
+    
+    if (output) {
+        _byteCount -= MRBrewResultCacheByteCount(output);
+        [_outputs removeObjectForKey:key];
+        [_recentlyUsedKeys removeObject:key];
+    }
+}
+
+/* Removes the least recently used output until the size of the cached output
+ * is within the byte limit. Must be called while synchronized on the receiver.
+ */
+- (void)evictOutputToByteLimit
+{
+    while (_byteCount > _byteLimit && [_recentlyUsedKeys count] > 0) {
+        [self removeOutputForKey:[_recentlyUsedKeys objectAtIndex:0]];
+    }
+}
+
+#pragma mark - MRBrewWatcherDelegate protocol
+
+- (void)brewChangeDidOccur:(NSArray *)paths
+{
+    [self removeAllOutput];
+}
+
+@end
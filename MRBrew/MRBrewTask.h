@@ -0,0 +1,67 @@
+//
+//  MRBrewTask.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#include <sys/resource.h>
+
+@class MRBrewLauncher;
+
+/* An MRBrewTask runs a process spawned by an MRBrewLauncher. It implements the
+ * subset of the NSTask interface used by MRBrewWorker, with the same
+ * semantics: standardOutput and standardError may be an NSPipe or an
+ * NSFileHandle, the termination handler is called on a background thread
+ * once the process has exited, and terminationStatus is the exit status of
+ * the process or, if it was terminated by a signal, the signal number.
+ *
+ * Unlike NSTask, the resources used by the process are available once it has
+ * exited, from resourceUsage, and the process can be launched in its own
+ * process group, in which case interrupt, terminate and kill signal every
+ * process in the group. If killsProcessGroupOnExit is set, the processes left
+ * in the group are killed once the process exits, before it is reaped, so
+ * that the group ID cannot have been reused.
+ */
+@interface MRBrewTask : NSObject
+
+@property (copy) NSString *launchPath;
+@property (copy) NSArray *arguments;
+@property (copy) NSDictionary *environment;
+@property (strong) id standardOutput;
+@property (strong) id standardError;
+@property (copy) void (^terminationHandler)(MRBrewTask *task);
+@property (assign) BOOL createsProcessGroup;
+@property (assign) BOOL killsProcessGroupOnExit;
+
+- (instancetype)initWithLauncher:(MRBrewLauncher *)launcher;
+
+- (void)launch;
+- (void)interrupt;
+- (void)terminate;
+- (void)kill;
+- (BOOL)isRunning;
+- (int)processIdentifier;
+- (int)terminationStatus;
+- (struct rusage)resourceUsage;
+
+@end
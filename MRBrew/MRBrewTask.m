@@ -0,0 +1,367 @@
+//
+//  MRBrewTask.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewTask.h"
+#import "MRBrewLauncher.h"
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+@interface MRBrewTask ()
+{
+    @private
+    MRBrewLauncher *_launcher;
+    pid_t _processIdentifier;
+    int _terminationStatus;
+    struct rusage _resourceUsage;
+    BOOL _launched;
+    BOOL _running;
+}
+
+@end
+
+@implementation MRBrewTask
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithLauncher:nil];
+}
+
+- (instancetype)initWithLauncher:(MRBrewLauncher *)launcher
+{
+    if (self = [super init]) {
+        _launcher = launcher ?: [[MRBrewLauncher alloc] init];
+    }
+    
+    return self;
+}
+
+#pragma mark - Launching
+
+/* Returns the descriptor that a standard stream of the process is written to,
+ * or the descriptor of the stream it inherits if none was specified.
+ */
+static int MRBrewTaskOutputDescriptor(id stream, int inheritedDescriptor)
+{
+    if ([stream isKindOfClass:[NSPipe class]]) {
+        return [[stream fileHandleForWriting] fileDescriptor];
+    }
+    
+    if ([stream isKindOfClass:[NSFileHandle class]]) {
+        return [stream fileDescriptor];
+    }
+    
+    return inheritedDescriptor;
+}
+
+- (void)launch
+{
+    @synchronized(self) {
+        if (_launched) {
+            [NSException raise:NSInvalidArgumentException format:@"MRBrewTask: Task has already been launched"];
+        }
+        
+        int errorNumber = 0;
+        _processIdentifier = [_launcher spawnProcessWithLaunchPath:[self launchPath]
+                                                         arguments:[self arguments]
+                                                       environment:[self environment]
+                                                    standardOutput:MRBrewTaskOutputDescriptor([self standardOutput], STDOUT_FILENO)
+                                                     standardError:MRBrewTaskOutputDescriptor([self standardError], STDERR_FILENO)
+                                                      processGroup:[self createsProcessGroup]
+                                                             error:&errorNumber];
+        
+        if (_processIdentifier == 0) {
+            [NSException raise:NSInvalidArgumentException format:@"MRBrewTask: Launch path not accessible (%@: %s)", [self launchPath], strerror(errorNumber)];
+        }
+        
+        _launched = YES;
+        _running = YES;
+    }
+    
+    // the process has its own copies of the write ends of its pipes, which
+    // must be the only ones for the end of its output to be read
+    if ([[self standardOutput] isKindOfClass:[NSPipe class]]) {
+        [[[self standardOutput] fileHandleForWriting] closeFile];
+    }
+    if ([[self standardError] isKindOfClass:[NSPipe class]]) {
+        [[[self standardError] fileHandleForWriting] closeFile];
+    }
+    
+    [self monitorProcess];
+}
+
+/* Returns a dispatch source that fires once the process has exited, or NULL if
+ * the exit of a single process cannot be watched. OS X provides process
+ * sources; on Linux the process is watched through a descriptor referring to
+ * it, which becomes readable when it exits.
+ */
+static dispatch_source_t MRBrewTaskCreateExitSource(pid_t processIdentifier, dispatch_queue_t queue)
+{
+#ifdef __APPLE__
+    return dispatch_source_create(DISPATCH_SOURCE_TYPE_PROC, (uintptr_t)processIdentifier, DISPATCH_PROC_EXIT, queue);
+#elif defined(SYS_pidfd_open)
+    int descriptor = (int)syscall(SYS_pidfd_open, processIdentifier, 0);
+    if (descriptor == -1) {
+        return NULL;
+    }
+    
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)descriptor, 0, queue);
+    if (!source) {
+        close(descriptor);
+    }
+    
+    return source;
+#else
+    return NULL;
+#endif
+}
+
+/* Watches for the exit of the process. The task is retained by the dispatch
+ * source until the process has been reaped, as an NSTask is while it runs.
+ */
+- (void)monitorProcess
+{
+    dispatch_source_t source = MRBrewTaskCreateExitSource(_processIdentifier, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+    
+    if (!source) {
+        [self watchForChildSignal];
+        return;
+    }
+    
+    dispatch_source_set_event_handler(source, ^{
+        if ([self reapProcess]) {
+            dispatch_source_cancel(source);
+        }
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+#ifndef __APPLE__
+        close((int)dispatch_source_get_handle(source));
+#endif
+#if !OS_OBJECT_USE_OBJC
+        dispatch_release(source);
+#endif
+    });
+    dispatch_resume(source);
+    
+    // the process may have exited before the source was watching it
+    if ([self reapProcess]) {
+        dispatch_source_cancel(source);
+    }
+}
+
+/* The tasks whose processes are reaped when SIGCHLD is received. */
+static NSMutableSet *MRBrewTaskChildSignalTasks = nil;
+
+/* Reaps the process of each task waiting for SIGCHLD that has exited. A
+ * signal may stand for several children, so every task is checked, without
+ * blocking.
+ */
+static void MRBrewTaskReapChildSignalTasks(void)
+{
+    NSArray *tasks;
+    
+    @synchronized(MRBrewTaskChildSignalTasks) {
+        tasks = [MRBrewTaskChildSignalTasks allObjects];
+    }
+    
+    for (MRBrewTask *task in tasks) {
+        if ([task reapProcess]) {
+            @synchronized(MRBrewTaskChildSignalTasks) {
+                [MRBrewTaskChildSignalTasks removeObject:task];
+            }
+        }
+    }
+}
+
+/* Reaps the process once SIGCHLD is received; used only if the exit of the
+ * process cannot be watched on its own. A single signal source is shared by
+ * every task, which is retained until its process has been reaped.
+ */
+- (void)watchForChildSignal
+{
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        MRBrewTaskChildSignalTasks = [NSMutableSet set];
+        
+        // the source is never cancelled
+        dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGCHLD, 0, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+        if (source) {
+            dispatch_source_set_event_handler(source, ^{
+                MRBrewTaskReapChildSignalTasks();
+            });
+            dispatch_resume(source);
+        }
+    });
+    
+    @synchronized(MRBrewTaskChildSignalTasks) {
+        [MRBrewTaskChildSignalTasks addObject:self];
+    }
+    
+    // the process may have exited before the task was waiting for the signal
+    MRBrewTaskReapChildSignalTasks();
+}
+
+/* Reaps the process if it has exited, returning whether it has. */
+- (BOOL)reapProcess
+{
+    void (^terminationHandler)(MRBrewTask *) = nil;
+    
+    @synchronized(self) {
+        if (!_running) {
+            return YES;
+        }
+        
+        // the exited process is left unreaped while its group is killed, as
+        // its ID (and so that of the group) is not reused until then
+        if ([self createsProcessGroup] && [self killsProcessGroupOnExit]) {
+            siginfo_t info;
+            info.si_pid = 0;
+            int waitResult;
+            do {
+                waitResult = waitid(P_PID, (id_t)_processIdentifier, &info, WEXITED | WNOHANG | WNOWAIT);
+            } while (waitResult == -1 && errno == EINTR);
+            
+            if (waitResult == 0 && info.si_pid == 0) {
+                return NO;
+            }
+            if (waitResult == 0) {
+                kill(-_processIdentifier, SIGKILL);
+            }
+        }
+        
+        int status = 0;
+        struct rusage resourceUsage;
+        pid_t result;
+        do {
+            result = wait4(_processIdentifier, &status, WNOHANG, &resourceUsage);
+        } while (result == -1 && errno == EINTR);
+        
+        if (result == 0) {
+            return NO;
+        }
+        
+        terminationHandler = [self recordExitWithResult:result status:status resourceUsage:resourceUsage];
+    }
+    
+    if (terminationHandler) {
+        terminationHandler(self);
+    }
+    
+    return YES;
+}
+
+/* Records the exit of the process, returning the termination handler to be
+ * called. Must be called while synchronized on the receiver.
+ */
+- (void (^)(MRBrewTask *))recordExitWithResult:(pid_t)result status:(int)status resourceUsage:(struct rusage)resourceUsage
+{
+    _running = NO;
+    
+    if (result == -1) {
+        _terminationStatus = 1;
+    }
+    else if (WIFSIGNALED(status)) {
+        _terminationStatus = WTERMSIG(status);
+        _resourceUsage = resourceUsage;
+    }
+    else {
+        _terminationStatus = WEXITSTATUS(status);
+        _resourceUsage = resourceUsage;
+    }
+    
+    // the handler is released once called, as by NSTask, so that blocks
+    // referring to the task do not keep it alive
+    void (^terminationHandler)(MRBrewTask *) = [self terminationHandler];
+    [self setTerminationHandler:nil];
+    
+    return terminationHandler;
+}
+
+#pragma mark - Process State
+
+- (void)interrupt
+{
+    [self signalProcess:SIGINT];
+}
+
+- (void)terminate
+{
+    [self signalProcess:SIGTERM];
+}
+
+- (void)kill
+{
+    [self signalProcess:SIGKILL];
+}
+
+/* Sends a signal to the process, and to its process group if it has one,
+ * while it is running.
+ */
+- (void)signalProcess:(int)signal
+{
+    @synchronized(self) {
+        if (_running) {
+            kill([self createsProcessGroup] ? -_processIdentifier : _processIdentifier, signal);
+        }
+    }
+}
+
+- (BOOL)isRunning
+{
+    @synchronized(self) {
+        return _running;
+    }
+}
+
+- (int)processIdentifier
+{
+    @synchronized(self) {
+        return _processIdentifier;
+    }
+}
+
+- (int)terminationStatus
+{
+    @synchronized(self) {
+        return _terminationStatus;
+    }
+}
+
+- (struct rusage)resourceUsage
+{
+    @synchronized(self) {
+        return _resourceUsage;
+    }
+}
+
+@end
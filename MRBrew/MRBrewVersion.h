@@ -0,0 +1,43 @@
+//
+//  MRBrewVersion.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/* MRBrewVersion compares the versions of formulae as Homebrew does. A version
+ * is split into numeric and alphabetic tokens at '.', '-', '_' and '+', and at
+ * each change between digits and letters. Numeric tokens are compared as
+ * numbers and alphabetic tokens case-insensitively; a missing token is equal
+ * to zero, greater than a pre-release token (dev, alpha, beta, pre or rc) and
+ * less than any other. A trailing revision (the 1 of 1.15_1) is compared only
+ * when the versions are otherwise equal.
+ */
+@interface MRBrewVersion : NSObject
+
++ (NSComparisonResult)compareVersion:(NSString *)version toVersion:(NSString *)otherVersion;
+
+/* Returns the greatest of an array of versions, or nil if it is empty. */
++ (NSString *)greatestVersionInVersions:(NSArray *)versions;
+
+@end
@@ -0,0 +1,205 @@
+//
+//  MRBrewVersion.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewVersion.h"
+
+/* The kinds of token, in ascending order of the tokens that do not compare
+ * with one another by value.
+ */
+typedef NS_ENUM(NSInteger, MRBrewVersionTokenKind) {
+    MRBrewVersionTokenKindPreRelease,
+    MRBrewVersionTokenKindNone,
+    MRBrewVersionTokenKindAlphabetic,
+    MRBrewVersionTokenKindNumeric
+};
+
+static BOOL MRBrewVersionIsSeparator(unichar character)
+{
+    return character == '.' || character == '-' || character == '_' || character == '+';
+}
+
+static BOOL MRBrewVersionIsDigit(unichar character)
+{
+    return character >= '0' && character <= '9';
+}
+
+/* Returns the rank of a pre-release token, or NSNotFound if the token does not
+ * denote a pre-release.
+ */
+static NSUInteger MRBrewVersionPreReleaseRank(NSString *token)
+{
+    static NSArray *preReleaseTokens = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        preReleaseTokens = @[@"dev", @"alpha", @"beta", @"pre", @"rc"];
+    });
+    
+    return [preReleaseTokens indexOfObject:[token lowercaseString]];
+}
+
+static MRBrewVersionTokenKind MRBrewVersionKindOfToken(NSString *token)
+{
+    if (!token) {
+        return MRBrewVersionTokenKindNone;
+    }
+    
+    if (MRBrewVersionIsDigit([token characterAtIndex:0])) {
+        return MRBrewVersionTokenKindNumeric;
+    }
+    
+    return (MRBrewVersionPreReleaseRank(token) == NSNotFound) ? MRBrewVersionTokenKindAlphabetic : MRBrewVersionTokenKindPreRelease;
+}
+
+/* Compares two numeric tokens of any length without converting them to
+ * integers, by the number of significant digits and then digit by digit.
+ */
+static NSComparisonResult MRBrewVersionCompareNumbers(NSString *number, NSString *otherNumber)
+{
+    NSCharacterSet *zeroes = [NSCharacterSet characterSetWithCharactersInString:@"0"];
+    NSRange significant = [number rangeOfCharacterFromSet:[zeroes invertedSet]];
+    NSRange otherSignificant = [otherNumber rangeOfCharacterFromSet:[zeroes invertedSet]];
+    NSString *digits = (significant.location == NSNotFound) ? @"" : [number substringFromIndex:significant.location];
+    NSString *otherDigits = (otherSignificant.location == NSNotFound) ? @"" : [otherNumber substringFromIndex:otherSignificant.location];
+    
+    if ([digits length] != [otherDigits length]) {
+        return ([digits length] < [otherDigits length]) ? NSOrderedAscending : NSOrderedDescending;
+    }
+    
+    return [digits compare:otherDigits options:NSLiteralSearch];
+}
+
+static NSComparisonResult MRBrewVersionCompareTokens(NSString *token, NSString *otherToken)
+{
+    MRBrewVersionTokenKind kind = MRBrewVersionKindOfToken(token);
+    MRBrewVersionTokenKind otherKind = MRBrewVersionKindOfToken(otherToken);
+    
+    // a missing token is equal to zero, so that 1.0 and 1 are the same version
+    if (kind == MRBrewVersionTokenKindNone && otherKind == MRBrewVersionTokenKindNumeric) {
+        return MRBrewVersionCompareNumbers(@"0", otherToken);
+    }
+    if (kind == MRBrewVersionTokenKindNumeric && otherKind == MRBrewVersionTokenKindNone) {
+        return MRBrewVersionCompareNumbers(token, @"0");
+    }
+    
+    if (kind != otherKind) {
+        return (kind < otherKind) ? NSOrderedAscending : NSOrderedDescending;
+    }
+    
+    switch (kind) {
+        case MRBrewVersionTokenKindNumeric:
+            return MRBrewVersionCompareNumbers(token, otherToken);
+        case MRBrewVersionTokenKindPreRelease: {
+            NSUInteger rank = MRBrewVersionPreReleaseRank(token);
+            NSUInteger otherRank = MRBrewVersionPreReleaseRank(otherToken);
+            if (rank == otherRank) {
+                return NSOrderedSame;
+            }
+            return (rank < otherRank) ? NSOrderedAscending : NSOrderedDescending;
+        }
+        case MRBrewVersionTokenKindAlphabetic:
+            return [token caseInsensitiveCompare:otherToken];
+        default:
+            return NSOrderedSame;
+    }
+}
+
+@implementation MRBrewVersion
+
+/* Splits a version into its tokens, after removing its revision (if any). */
++ (NSArray *)tokensOfVersion:(NSString *)version revision:(NSString * __autoreleasing *)revision
+{
+    NSUInteger length = [version length];
+    NSUInteger revisionStart = length;
+    
+    // a revision is a trailing run of digits following an underscore
+    while (revisionStart > 0 && MRBrewVersionIsDigit([version characterAtIndex:revisionStart - 1])) {
+        revisionStart--;
+    }
+    if (revisionStart > 1 && revisionStart < length && [version characterAtIndex:revisionStart - 1] == '_') {
+        *revision = [version substringFromIndex:revisionStart];
+        length = revisionStart - 1;
+    }
+    else {
+        *revision = @"0";
+    }
+    
+    NSMutableArray *tokens = [NSMutableArray array];
+    NSUInteger tokenStart = 0;
+    
+    for (NSUInteger index = 0; index <= length; index++) {
+        BOOL ends = (index == length);
+        unichar character = ends ? 0 : [version characterAtIndex:index];
+        
+        if (!ends && !MRBrewVersionIsSeparator(character)) {
+            // a token also ends where digits and letters meet
+            if (index == tokenStart || MRBrewVersionIsDigit(character) == MRBrewVersionIsDigit([version characterAtIndex:index - 1])) {
+                continue;
+            }
+        }
+        
+        if (index > tokenStart) {
+            [tokens addObject:[version substringWithRange:NSMakeRange(tokenStart, index - tokenStart)]];
+        }
+        tokenStart = (ends || MRBrewVersionIsSeparator(character)) ? index + 1 : index;
+    }
+    
+    return tokens;
+}
+
++ (NSComparisonResult)compareVersion:(NSString *)version toVersion:(NSString *)otherVersion
+{
+    NSString *revision = nil;
+    NSString *otherRevision = nil;
+    NSArray *tokens = [self tokensOfVersion:version revision:&revision];
+    NSArray *otherTokens = [self tokensOfVersion:otherVersion revision:&otherRevision];
+    NSUInteger count = MAX([tokens count], [otherTokens count]);
+    
+    for (NSUInteger index = 0; index < count; index++) {
+        NSString *token = (index < [tokens count]) ? [tokens objectAtIndex:index] : nil;
+        NSString *otherToken = (index < [otherTokens count]) ? [otherTokens objectAtIndex:index] : nil;
+        NSComparisonResult result = MRBrewVersionCompareTokens(token, otherToken);
+        
+        if (result != NSOrderedSame) {
+            return result;
+        }
+    }
+    
+    return MRBrewVersionCompareNumbers(revision, otherRevision);
+}
+
++ (NSString *)greatestVersionInVersions:(NSArray *)versions
+{
+    NSString *greatestVersion = nil;
+    
+    for (NSString *version in versions) {
+        if (!greatestVersion || [self compareVersion:version toVersion:greatestVersion] == NSOrderedDescending) {
+            greatestVersion = version;
+        }
+    }
+    
+    return greatestVersion;
+}
+
+@end
@@ -69,9 +69,21 @@ typedef NS_OPTIONS(NSInteger, MRBrewWatcherLocation) {
  object using either initWithPath:delegate: or watcherWithPath:delegate: and
  specify the absolute path to the directory to watch for events.
  
+ To be told which formulae were installed, removed, upgraded, linked or pinned,
+ create your watcher object using either initWithPrefix:delegate: or
+ watcherWithPrefix:delegate:. The watcher keeps a snapshot of the Cellar and
+ of the `LinkedKegs` and `PinnedKegs` paths, and sends the delegate the
+ differences from the snapshot when events occur, so that the installed
+ formulae can be kept current without performing a list operation.
+ 
  To start watching for events call the startWatching method, and to stop
  watching call the stopWatching method.
  
+ Events are watched with FSEvents on OS X, and with inotify on Linux. The
+ events that occur during the latency of the watcher are coalesced, so that
+ the delegate receives each path that changed once, along with every kind of
+ change that occurred there.
+ 
  @warning After starting a watcher object, calls to the MRBrew class method
  performOperation:delegate: may result in file system events occurring at the
  watched location, which will trigger a delegate callback. If you are only
@@ -84,6 +96,27 @@ typedef NS_OPTIONS(NSInteger, MRBrewWatcherLocation) {
 /** The delegate object for this watcher. */
 @property (weak) id<MRBrewWatcherDelegate> delegate;
 
+/**-----------------------------------------------------------------------------
+ * @name Configuring a Watcher
+ * -----------------------------------------------------------------------------
+ */
+
+/** The number of seconds over which events are coalesced before the delegate
+ * is sent a message.
+ *
+ * The latency begins when an event occurs after the delegate was last sent a
+ * message. Changing the latency affects events that occur after the delegate
+ * is next sent a message. The default latency is 3 seconds.
+ */
+@property (assign) NSTimeInterval latency;
+
+/** The queue on which messages are sent to the delegate.
+ *
+ * The default queue is the main queue. If nil, messages are sent on a private
+ * serial queue of the watcher, and must return quickly.
+ */
+@property (strong) NSOperationQueue *delegateQueue;
+
 /**-----------------------------------------------------------------------------
  * @name Initialising a Watcher
  * -----------------------------------------------------------------------------
@@ -111,6 +144,19 @@ typedef NS_OPTIONS(NSInteger, MRBrewWatcherLocation) {
  */
 - (instancetype)initWithPath:(NSString *)path delegate:(id<MRBrewWatcherDelegate>)delegate;
 
+/** Returns an initialized `MRBrewWatcher` object that watches the kegs of the
+ * Homebrew installation at the specified prefix.
+ *
+ * @param prefix The absolute path of the Homebrew installation (e.g.
+ * `/usr/local`), whose `Cellar`, `Library/LinkedKegs` and `Library/PinnedKegs`
+ * paths are watched for file system events.
+ * @param delegate The delegate object for this watcher. The delegate will
+ * receive a message when file system events occur at the watched paths, and
+ * when the installed formulae change.
+ * @return A watcher with the specified prefix and delegate.
+ */
+- (instancetype)initWithPrefix:(NSString *)prefix delegate:(id<MRBrewWatcherDelegate>)delegate;
+
 /**-----------------------------------------------------------------------------
  * @name Creating a Watcher
  * -----------------------------------------------------------------------------
@@ -136,6 +182,19 @@ typedef NS_OPTIONS(NSInteger, MRBrewWatcherLocation) {
  */
 + (instancetype)watcherWithPath:(NSString *)path delegate:(id<MRBrewWatcherDelegate>)delegate;
 
+/** Returns a watcher that watches the kegs of the Homebrew installation at the
+ * specified prefix.
+ *
+ * @param prefix The absolute path of the Homebrew installation (e.g.
+ * `/usr/local`), whose `Cellar`, `Library/LinkedKegs` and `Library/PinnedKegs`
+ * paths are watched for file system events.
+ * @param delegate The delegate object for this watcher. The delegate will
+ * receive a message when file system events occur at the watched paths, and
+ * when the installed formulae change.
+ * @return A watcher with the specified prefix and delegate.
+ */
++ (instancetype)watcherWithPrefix:(NSString *)prefix delegate:(id<MRBrewWatcherDelegate>)delegate;
+
 /**-----------------------------------------------------------------------------
  * @name Starting and Stopping a Watcher
  * -----------------------------------------------------------------------------
@@ -24,6 +24,11 @@
 //
 
 #import "MRBrewWatcher.h"
+#import "MRBrewWatcher+Private.h"
+#import "MRBrewFSEventsWatcherBackend.h"
+#import "MRBrewInotifyWatcherBackend.h"
+#import "MRBrewKegSnapshot.h"
+#import "MRBrewKegChanges.h"
 
 NSString * const MRBrewLibraryLocationPath = @"/usr/local/Library";
 NSString * const MRBrewFormulaLocationPath = @"/usr/local/Library/Formula";
@@ -32,13 +37,30 @@ NSString * const MRBrewAliasesLocationPath = @"/usr/local/Library/Aliases";
 NSString * const MRBrewLinkedKegsLocationPath = @"/usr/local/Library/LinkedKegs";
 NSString * const MRBrewPinnedKegsLocationPath = @"/usr/local/Library/PinnedKegs";
 
+static const NSTimeInterval MRBrewWatcherDefaultLatency = 3.0;
+
+/* The depth watched below the Cellar, so that the versions of each formula
+ * are watched, but not their contents.
+ */
+static const NSUInteger MRBrewWatcherKegsMaximumDepth = 1;
+
 @interface MRBrewWatcher ()
 {
     @private
-    FSEventStreamRef _eventStream;
     NSMutableArray *_pathsToWatch;
+    id<MRBrewWatcherBackend> _backend;
+    dispatch_queue_t _eventQueue;
+    NSMutableDictionary *_pendingChanges;
+    BOOL _deliveryScheduled;
+    NSUInteger _maximumDepth;
+    NSString *_cellarPath;
+    NSString *_linkedKegsPath;
+    NSString *_pinnedKegsPath;
+    MRBrewKegSnapshot *_kegSnapshot;
 }
 
+- (instancetype)initWithPaths:(NSArray *)paths delegate:(id<MRBrewWatcherDelegate>)delegate;
+
 @end
 
 @implementation MRBrewWatcher
@@ -51,58 +73,88 @@ NSString * const MRBrewPinnedKegsLocationPath = @"/usr/local/Library/PinnedKegs"
 
 - (instancetype)initWithLocation:(MRBrewWatcherLocation)location delegate:(id<MRBrewWatcherDelegate>)delegate
 {
-    self = [super init];
-    
-    if (self) {
-        // test bitmask for paths to use
-        _pathsToWatch = [NSMutableArray array];
-        if (location & MRBrewWatcherLibraryLocation) {
-            [_pathsToWatch addObject:MRBrewLibraryLocationPath];
+    // test bitmask for paths to use
+    NSMutableArray *paths = [NSMutableArray array];
+    if (location & MRBrewWatcherLibraryLocation) {
+        [paths addObject:MRBrewLibraryLocationPath];
+    }
+    // since the library path contains all other paths we test
+    // this exclusively and only test for other options in the
+    // else clause if the library location bit has not been set
+    else {
+        if (location & MRBrewWatcherFormulaLocation) {
+            [paths addObject:MRBrewFormulaLocationPath];
         }
-        // since the library path contains all other paths we test
-        // this exclusively and only test for other options in the
-        // else clause if the library location bit has not been set
-        else {
-            if (location & MRBrewWatcherFormulaLocation) {
-                [_pathsToWatch addObject:MRBrewFormulaLocationPath];
-            }
-            
-            if (location & MRBrewWatcherTapsLocation) {
-                [_pathsToWatch addObject:MRBrewTapsLocationPath];
-            }
-            
-            if (location & MRBrewWatcherAliasesLocation) {
-                [_pathsToWatch addObject:MRBrewAliasesLocationPath];
-            }
-            
-            if (location & MRBrewWatcherLinkedKegsLocation) {
-                [_pathsToWatch addObject:MRBrewLinkedKegsLocationPath];
-            }
-            
-            if (location & MRBrewWatcherPinnedKegsLocation) {
-                [_pathsToWatch addObject:MRBrewPinnedKegsLocationPath];
-            }
+        
+        if (location & MRBrewWatcherTapsLocation) {
+            [paths addObject:MRBrewTapsLocationPath];
         }
         
-        _delegate = delegate;
+        if (location & MRBrewWatcherAliasesLocation) {
+            [paths addObject:MRBrewAliasesLocationPath];
+        }
+        
+        if (location & MRBrewWatcherLinkedKegsLocation) {
+            [paths addObject:MRBrewLinkedKegsLocationPath];
+        }
+        
+        if (location & MRBrewWatcherPinnedKegsLocation) {
+            [paths addObject:MRBrewPinnedKegsLocationPath];
+        }
     }
     
-    return self;
+    return [self initWithPaths:paths delegate:delegate];
 }
 
 - (instancetype)initWithPath:(NSString *)path delegate:(id<MRBrewWatcherDelegate>)delegate
+{
+    return [self initWithPaths:@[path] delegate:delegate];
+}
+
+- (instancetype)initWithPrefix:(NSString *)prefix delegate:(id<MRBrewWatcherDelegate>)delegate
+{
+    NSString *cellarPath = [prefix stringByAppendingPathComponent:@"Cellar"];
+    NSString *linkedKegsPath = [prefix stringByAppendingPathComponent:@"Library/LinkedKegs"];
+    NSString *pinnedKegsPath = [prefix stringByAppendingPathComponent:@"Library/PinnedKegs"];
+    
+    self = [self initWithPaths:@[cellarPath, linkedKegsPath, pinnedKegsPath] delegate:delegate];
+    
+    if (self) {
+        _cellarPath = cellarPath;
+        _linkedKegsPath = linkedKegsPath;
+        _pinnedKegsPath = pinnedKegsPath;
+        _maximumDepth = MRBrewWatcherKegsMaximumDepth;
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithPaths:(NSArray *)paths delegate:(id<MRBrewWatcherDelegate>)delegate
 {
     self = [super init];
     
     if (self) {
-        _pathsToWatch = [NSMutableArray array];
-        [_pathsToWatch addObject:path];
+        _pathsToWatch = [paths mutableCopy];
+        _maximumDepth = NSUIntegerMax;
         _delegate = delegate;
+        _latency = MRBrewWatcherDefaultLatency;
+        _delegateQueue = [NSOperationQueue mainQueue];
+        _backendClass = [[self class] defaultBackendClass];
+        _eventQueue = dispatch_queue_create("uk.co.fidgetbox.MRBrew.watcher", DISPATCH_QUEUE_SERIAL);
+        _pendingChanges = [NSMutableDictionary dictionary];
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    [_backend stopWatching];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_eventQueue);
+#endif
+}
+
 + (instancetype)watcherWithLocation:(MRBrewWatcherLocation)location delegate:(id<MRBrewWatcherDelegate>)delegate
 {
     return [[self alloc] initWithLocation:location delegate:delegate];
@@ -113,74 +165,199 @@ NSString * const MRBrewPinnedKegsLocationPath = @"/usr/local/Library/PinnedKegs"
     return [[self alloc] initWithPath:path delegate:delegate];
 }
 
-#pragma mark - FSEvents Callback
++ (instancetype)watcherWithPrefix:(NSString *)prefix delegate:(id<MRBrewWatcherDelegate>)delegate
+{
+    return [[self alloc] initWithPrefix:prefix delegate:delegate];
+}
 
-static void fileSystemEventsCallback(ConstFSEventStreamRef streamRef, void *userData, size_t numEvents, void *eventPaths, const FSEventStreamEventFlags eventFlags[], const FSEventStreamEventId eventIds[])
+#pragma mark - Backends
+
++ (Class)defaultBackendClass
 {
-    MRBrewWatcher *informer = (__bridge MRBrewWatcher *)userData;
-    
-    NSMutableArray *modifiedPaths = [NSMutableArray array];
-    
-    size_t i;
-    for(i = 0; i < numEvents; i++){
-        if(![modifiedPaths containsObject:[(__bridge NSArray *)eventPaths objectAtIndex:i]]) {
-            [modifiedPaths addObject:[(__bridge NSArray *)eventPaths objectAtIndex:i]];
-        }
-    }
-    
-    if ([[informer delegate] respondsToSelector:@selector(brewChangeDidOccur:)]) {
-        [[informer delegate] brewChangeDidOccur:modifiedPaths];
-    }
+#if defined(__APPLE__)
+    return [MRBrewFSEventsWatcherBackend class];
+#elif defined(__linux__)
+    return [MRBrewInotifyWatcherBackend class];
+#else
+    return nil;
+#endif
+}
+
+- (NSArray *)pathsToWatch
+{
+    return [_pathsToWatch copy];
+}
+
+- (BOOL)tracksKegs
+{
+    return _cellarPath != nil;
 }
 
 #pragma mark - Control
 
 - (void)startWatching
 {
-    // stop existing event stream if one exists
-    if (_eventStream) {
-		[self stopWatching];
-	}
-    
-    // create an event stream context with a reference to this
-    // watcher object for use by our callback method
-    FSEventStreamContext eventStreamContext;
-    eventStreamContext.info = (__bridge void *)(self);
-    eventStreamContext.version = 0;
-    eventStreamContext.retain = NULL;
-    eventStreamContext.release = NULL;
-    eventStreamContext.copyDescription = NULL;
-    
-    // create an event stream and register a callback
-    NSTimeInterval latency = 3.0;
-    _eventStream = FSEventStreamCreate(NULL,
-                                       &fileSystemEventsCallback,
-                                       &eventStreamContext,
-                                       (__bridge CFArrayRef) _pathsToWatch,
-                                       kFSEventStreamEventIdSinceNow,
-                                       (CFAbsoluteTime) latency,
-                                       kFSEventStreamCreateFlagUseCFTypes);
-    
-    FSEventStreamScheduleWithRunLoop(_eventStream,
-                                     CFRunLoopGetCurrent(),
-                                     kCFRunLoopDefaultMode);
-    FSEventStreamStart(_eventStream);
+    @synchronized(self) {
+        // stop existing backend if one exists
+        [self stopWatching];
+        
+        __weak MRBrewWatcher *weakWatcher = self;
+        id<MRBrewWatcherBackend> backend = [[[self backendClass] alloc] initWithPaths:_pathsToWatch
+                                                                                queue:_eventQueue
+                                                                              handler:^(NSString *path, MRBrewWatcherEvent events) {
+            [weakWatcher recordEvents:events atPath:path];
+        }];
+        
+        [backend setMaximumDepth:_maximumDepth];
+        
+        if ([backend startWatching]) {
+            _backend = backend;
+            
+            // the snapshot is taken once the backend is watching, so that
+            // any change made after it is reported
+            if ([self tracksKegs]) {
+                MRBrewKegSnapshot *kegSnapshot = [self currentKegSnapshot];
+                dispatch_async(_eventQueue, ^{
+                    _kegSnapshot = kegSnapshot;
+                });
+            }
+        }
+    }
 }
 
 - (void)stopWatching
 {
-	if (!(_eventStream)) {
-		return;
-	}
-    
-	FSEventStreamStop(_eventStream);
-	FSEventStreamInvalidate(_eventStream);
-	FSEventStreamRelease(_eventStream);
-	_eventStream = NULL;
+    @synchronized(self) {
+        if (!_backend) {
+            return;
+        }
+        
+        [_backend stopWatching];
+        _backend = nil;
+        
+        // changes that have not been delivered are discarded once the events
+        // already read by the backend have been recorded
+        dispatch_async(_eventQueue, ^{
+            [_pendingChanges removeAllObjects];
+            _kegSnapshot = nil;
+        });
+    }
 }
 
 - (BOOL)isWatching {
-    return _eventStream != NULL;
+    @synchronized(self) {
+        return _backend != nil;
+    }
+}
+
+#pragma mark - Coalescing
+
+/* Records events reported by the backend. The events for each path are
+ * combined until the latency has elapsed since the first event was recorded,
+ * when every path that changed is delivered at once. Must be called on the
+ * event queue.
+ */
+- (void)recordEvents:(MRBrewWatcherEvent)events atPath:(NSString *)path
+{
+    NSNumber *recordedEvents = [_pendingChanges objectForKey:path];
+    [_pendingChanges setObject:@([recordedEvents unsignedIntegerValue] | events) forKey:path];
+    
+    if (_deliveryScheduled) {
+        return;
+    }
+    
+    _deliveryScheduled = YES;
+    
+    __weak MRBrewWatcher *weakWatcher = self;
+    dispatch_time_t deliveryTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self latency] * NSEC_PER_SEC));
+    dispatch_after(deliveryTime, _eventQueue, ^{
+        [weakWatcher deliverPendingChanges];
+    });
+}
+
+/* Delivers the changes recorded during the latency. Must be called on the
+ * event queue.
+ */
+- (void)deliverPendingChanges
+{
+    _deliveryScheduled = NO;
+    
+    if ([_pendingChanges count] == 0) {
+        return;
+    }
+    
+    NSDictionary *changes = _pendingChanges;
+    _pendingChanges = [NSMutableDictionary dictionary];
+    
+    // kegs changed since the last snapshot if there is one, which there is
+    // not if the watcher was stopped since the events occurred
+    MRBrewKegChanges *kegChanges = nil;
+    if (_kegSnapshot) {
+        MRBrewKegSnapshot *kegSnapshot = [self currentKegSnapshot];
+        kegChanges = [kegSnapshot changesSinceSnapshot:_kegSnapshot];
+        _kegSnapshot = kegSnapshot;
+    }
+    
+    [self deliverChanges:changes kegChanges:([kegChanges isEmpty] ? nil : kegChanges)];
+}
+
+- (void)deliverChanges:(NSDictionary *)changes kegChanges:(MRBrewKegChanges *)kegChanges
+{
+    NSArray *directories = [self directoriesForChanges:changes];
+    
+    void (^delivery)(void) = ^{
+        id<MRBrewWatcherDelegate> delegate = [self delegate];
+        
+        if (kegChanges && [delegate respondsToSelector:@selector(brewKegsDidChange:)]) {
+            [delegate brewKegsDidChange:kegChanges];
+        }
+        
+        if ([delegate respondsToSelector:@selector(brewChangeDidOccur:)]) {
+            [delegate brewChangeDidOccur:directories];
+        }
+        
+        if ([delegate respondsToSelector:@selector(brewChangesDidOccur:)]) {
+            [delegate brewChangesDidOccur:changes];
+        }
+    };
+    
+    NSOperationQueue *delegateQueue = [self delegateQueue];
+    if (delegateQueue) {
+        [delegateQueue addOperationWithBlock:delivery];
+    }
+    else {
+        delivery();
+    }
+}
+
+- (MRBrewKegSnapshot *)currentKegSnapshot
+{
+    return [[MRBrewKegSnapshot alloc] initWithCellarPath:_cellarPath linkedKegsPath:_linkedKegsPath pinnedKegsPath:_pinnedKegsPath];
+}
+
+/* Returns the directories in which changes occurred, which are the paths
+ * themselves for watched paths, directories and paths that must be rescanned,
+ * and the parent directories of other items. Must be called on the event
+ * queue.
+ */
+- (NSArray *)directoriesForChanges:(NSDictionary *)changes
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSMutableSet *directories = [NSMutableSet setWithCapacity:[changes count]];
+    
+    [changes enumerateKeysAndObjectsUsingBlock:^(NSString *path, NSNumber *events, BOOL *stop) {
+        BOOL isDirectory = NO;
+        if (([events unsignedIntegerValue] & MRBrewWatcherRescanEvent) ||
+            [_pathsToWatch containsObject:path] ||
+            ([fileManager fileExistsAtPath:path isDirectory:&isDirectory] && isDirectory)) {
+            [directories addObject:path];
+        }
+        else {
+            [directories addObject:[path stringByDeletingLastPathComponent]];
+        }
+    }];
+    
+    return [directories allObjects];
 }
 
 @end
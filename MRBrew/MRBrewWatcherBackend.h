@@ -0,0 +1,53 @@
+//
+//  MRBrewWatcherBackend.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "MRBrewWatcherDelegate.h"
+
+typedef void (^MRBrewWatcherBackendHandler)(NSString *path, MRBrewWatcherEvent events);
+
+/* A watcher backend reports file system events below a set of paths using the
+ * facility provided by the host, calling its handler on its queue once for
+ * each event. Events are not coalesced by the backend, as they are by the
+ * MRBrewWatcher that owns it.
+ *
+ * An MRBrewWatcher uses MRBrewFSEventsWatcherBackend on OS X, and
+ * MRBrewInotifyWatcherBackend on Linux.
+ *
+ * The maximum depth, set before the backend starts watching, is the number of
+ * directory levels below each path that are watched; NSUIntegerMax, the
+ * default, watches every level. Every backend reports the same events for a
+ * depth: those for the items in the watched directories, but not for the items
+ * in directories below them.
+ */
+@protocol MRBrewWatcherBackend <NSObject>
+
+@property (assign) NSUInteger maximumDepth;
+
+- (instancetype)initWithPaths:(NSArray *)paths queue:(dispatch_queue_t)queue handler:(MRBrewWatcherBackendHandler)handler;
+
+- (BOOL)startWatching;
+- (void)stopWatching;
+
+@end
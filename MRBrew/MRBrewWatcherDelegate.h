@@ -25,14 +25,36 @@
 
 #import <Foundation/Foundation.h>
 
-/** The `MRBrewWatcherDelegate` protocol defines the optional method
- * brewChangeDidOccur: that is implemented by delegates of the MRBrewWatcher
- * class.
+@class MRBrewKegChanges;
+
+/** These constants describe the changes that occurred at a path. */
+typedef NS_OPTIONS(NSUInteger, MRBrewWatcherEvent) {
+    /** An item was created at the path, or moved to it */
+    MRBrewWatcherCreatedEvent  = 1 << 0,
+    /** The item at the path was removed, or moved away from it */
+    MRBrewWatcherRemovedEvent  = 1 << 1,
+    /** The contents or attributes of the item at the path were modified */
+    MRBrewWatcherModifiedEvent = 1 << 2,
+    /** Events below the path were dropped, and it must be rescanned */
+    MRBrewWatcherRescanEvent   = 1 << 3
+};
+
+/** The `MRBrewWatcherDelegate` protocol defines the optional methods
+ * brewChangeDidOccur:, brewChangesDidOccur: and brewKegsDidChange: that are
+ * implemented by delegates of the MRBrewWatcher class.
  *
  * MRBrewWatcher objects call the delegate method brewChangeDidOccur: when a
  * file system event occurs at a watched location (e.g. file modification,
  * deletion or creation). An array of strings representing the directory paths
  * where changes occurred is passed to this method.
+ *
+ * Delegates that need to know what changed implement brewChangesDidOccur:,
+ * which is passed the path of each item that changed along with the
+ * MRBrewWatcherEvent flags describing its changes.
+ *
+ * Delegates of watchers created with a Homebrew prefix may implement
+ * brewKegsDidChange:, which is passed the formulae that were installed,
+ * removed, upgraded, linked or pinned.
  */
 @protocol MRBrewWatcherDelegate <NSObject>
 
@@ -45,4 +67,22 @@
  */
 - (void)brewChangeDidOccur:(NSArray *)paths;
 
+/** This method is called with the changes that occurred at a watched location
+ * during the latency of the watcher.
+ *
+ * @param changes A dictionary whose keys are the paths of the items that
+ * changed, and whose values are `NSNumber` objects containing the
+ * MRBrewWatcherEvent flags for every change that occurred at each path.
+ */
+- (void)brewChangesDidOccur:(NSDictionary *)changes;
+
+/** This method is called when the installed formulae change, for watchers
+ * created with initWithPrefix:delegate: or watcherWithPrefix:delegate:. It is
+ * called before the other methods of the protocol, with the changes since
+ * the installed formulae were last reported or the watcher started watching.
+ *
+ * @param changes The formulae that changed, which are never all empty.
+ */
+- (void)brewKegsDidChange:(MRBrewKegChanges *)changes;
+
 @end
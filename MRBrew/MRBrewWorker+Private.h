@@ -25,6 +25,11 @@
 
 #import <Foundation/Foundation.h>
 
+@class MRBrewOutputBuffer;
+@class MRBrewTask;
+@class MRBrewOperationMetrics;
+@class MRBrewOutputParserSession;
+
 typedef NS_ENUM(NSInteger, MRBrewWorkerTaskTerminationMode) {
     MRBrewWorkerTaskTerminationModeInterrupt,
     MRBrewWorkerTaskTerminationModeTerminate,
@@ -33,14 +38,46 @@ typedef NS_ENUM(NSInteger, MRBrewWorkerTaskTerminationMode) {
 
 @interface MRBrewWorker ()
 
-@property (nonatomic, strong) NSTask *task;
-@property (nonatomic, strong) NSDate *taskTerminationTime;
+@property (nonatomic, strong) MRBrewTask *task;
+@property (nonatomic, strong) MRBrewOutputBuffer *outputBuffer;
+@property (nonatomic, strong) MRBrewOutputBuffer *errorOutputBuffer;
+@property (nonatomic, strong) NSMutableString *errorOutput;
+@property (nonatomic, strong) NSMutableString *generatedOutput;
+@property (nonatomic, assign) NSUInteger resultCacheGeneration;
+@property (nonatomic, strong) NSMutableArray *attachments;
+@property (nonatomic, strong) MRBrewOutputParserSession *parserSession;
+@property (nonatomic, strong) NSMutableArray *parsedObjects;
+@property (nonatomic, assign, getter=isAcceptingAttachments) BOOL acceptingAttachments;
+@property (nonatomic, assign) NSUInteger pendingTaskEvents;
+@property (nonatomic, assign, getter=isOutputDrained) BOOL outputDrained;
+@property (nonatomic, assign, getter=isErrorOutputDrained) BOOL errorOutputDrained;
 @property (readonly, getter=isExecuting) BOOL executing;
 @property (readonly, getter=isFinished) BOOL finished;
 @property (nonatomic, assign) MRBrewWorkerTaskTerminationMode taskTerminationMode;
+@property (nonatomic, assign) NSUInteger helperRequest;
+@property (nonatomic, assign) int helperTerminationStatus;
+@property (nonatomic, assign) BOOL helperGeneratedData;
+@property (nonatomic, strong) MRBrewOperationMetrics *metrics;
+@property (nonatomic, strong) NSMutableArray *pendingDeliveries;
+@property (nonatomic, assign, getter=isDeliveryScheduled) BOOL deliveryScheduled;
+@property (assign) BOOL succeeded;
 
 - (void)changeFinishedState:(BOOL)finished;
 - (void)changeExecutingState:(BOOL)executing;
+- (void)launchTask;
+- (BOOL)dependencyFailed;
+- (BOOL)sendHelperRequest;
+- (void)helperRequestTerminated:(BOOL)exited status:(int)status;
+- (int)terminationStatus;
+- (void)terminateTask;
+- (void)taskTerminated;
+- (void)taskOutputDrained;
+- (void)taskErrorOutputDrained;
+- (void)enqueueDelivery:(void (^)(void))delivery;
+- (void)performInlineDeliveries;
+- (void)performPendingDeliveriesOnQueue:(NSOperationQueue *)queue;
+- (void)notifyDelegateOperationGeneratedOutput:(NSString *)output;
+- (void)notifyDelegateOperationGeneratedErrorOutput:(NSString *)output;
 - (void)taskExited:(NSNotification *)notification;
 
 @end
@@ -26,6 +26,9 @@
 #import <Foundation/Foundation.h>
 
 @class MRBrewOperation;
+@class MRBrewResultCache;
+@class MRBrewHelper;
+@class MRBrewOperationMetrics;
 @protocol MRBrewDelegate;
 
 @interface MRBrewWorker : NSOperation
@@ -33,5 +36,36 @@
 @property (copy) MRBrewOperation *operation;
 @property (copy) NSArray *arguments;
 @property (weak) id<MRBrewDelegate> delegate;
+@property (strong) MRBrewResultCache *resultCache;
+@property (strong) MRBrewHelper *helper;
+@property (copy) void (^metricsHandler)(MRBrewOperationMetrics *metrics);
+
+/* The time allowed for brew to exit after it is interrupted, and then after
+ * it is terminated, before it is killed when the worker is cancelled.
+ */
+@property (assign) NSTimeInterval interruptGracePeriod;
+@property (assign) NSTimeInterval terminationGracePeriod;
+
+/* The queue on which delegates are sent messages, in the order they were
+ * generated; the main queue by default. If nil, delegates are sent messages on
+ * the worker's threads as they are generated. Must be set before the worker is
+ * started.
+ */
+@property (strong) NSOperationQueue *delegateQueue;
+
+/* Called on the worker's thread as it begins performing its operation, before
+ * brew is launched. Not called for a worker that is cancelled while queued.
+ */
+@property (copy) void (^startHandler)(void);
+
+/* Whether the operation finished successfully; NO until the worker has
+ * finished. A worker that depends on a worker that did not succeed is
+ * cancelled when it starts.
+ */
+@property (readonly) BOOL succeeded;
+
+- (BOOL)attachDelegate:(id<MRBrewDelegate>)delegate operation:(MRBrewOperation *)operation;
+- (void)cancelForDelegate:(id<MRBrewDelegate>)delegate;
+- (void)deliverToDelegates:(void (^)(void))delivery;
 
 @end
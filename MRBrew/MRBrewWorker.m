@@ -30,9 +30,32 @@
 #import "MRBrewConstants.h"
 #import "MRBrewDelegate.h"
 #import "MRBrewWorkerTaskConstants.h"
+#import "MRBrewOutputBuffer.h"
+#import "MRBrewResultCache.h"
+#import "MRBrewOutputParserSession.h"
+#import "MRBrewHelper.h"
+#import "MRBrewTask.h"
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewOperationMetrics+Private.h"
+#import "MRBrew+Private.h"
 
 static NSString * const MRBrewErrorDomain = @"uk.co.fidgetbox.MRBrew";
-static const NSTimeInterval MRBrewWorkerTaskTerminationTimeout = 5.0;
+static const NSTimeInterval MRBrewWorkerDefaultInterruptGracePeriod = 5.0;
+static const NSTimeInterval MRBrewWorkerDefaultTerminationGracePeriod = 5.0;
+static const NSTimeInterval MRBrewWorkerOutputDrainTimeout = 1.0;
+static const NSUInteger MRBrewWorkerErrorOutputLimit = 16 * 1024;
+
+/* A delegate attached to a worker, along with the operation it requested. */
+@interface MRBrewWorkerAttachment : NSObject
+
+@property (strong) MRBrewOperation *operation;
+@property (weak) id<MRBrewDelegate> delegate;
+
+@end
+
+@implementation MRBrewWorkerAttachment
+
+@end
 
 @implementation MRBrewWorker
 
@@ -42,8 +65,17 @@ static const NSTimeInterval MRBrewWorkerTaskTerminationTimeout = 5.0;
 - (instancetype)init
 {
     if (self = [super init]) {
-        _task = [[NSTask alloc] init];
+        _task = [[MRBrewTask alloc] initWithLauncher:[[MRBrew sharedBrew] launcher]];
+        [_task setCreatesProcessGroup:YES];
         _taskTerminationMode = MRBrewWorkerTaskTerminationModeInterrupt;
+        _interruptGracePeriod = MRBrewWorkerDefaultInterruptGracePeriod;
+        _terminationGracePeriod = MRBrewWorkerDefaultTerminationGracePeriod;
+        _delegateQueue = [NSOperationQueue mainQueue];
+        _pendingDeliveries = [NSMutableArray array];
+        _attachments = [NSMutableArray array];
+        _acceptingAttachments = YES;
+        _metrics = [[MRBrewOperationMetrics alloc] init];
+        [_metrics setEnqueueDate:[NSDate date]];
     }
     
     return self;
@@ -51,88 +83,512 @@ static const NSTimeInterval MRBrewWorkerTaskTerminationTimeout = 5.0;
 
 - (void)start
 {
+    // operations that depend on an operation that failed are not performed
+    if ([self dependencyFailed]) {
+        [self cancel];
+    }
+    
+    // a queued worker that was cancelled reports the cancellation, so that
+    // every operation that is performed either finishes or fails
     if ([self isCancelled]) {
+        @synchronized(self) {
+            [self setAcceptingAttachments:NO];
+        }
+        [self notifyDelegateOperationFailed];
         [self changeFinishedState:YES];
         return;
     }
     
     [self changeExecutingState:YES];
     
+    if ([self startHandler]) {
+        [self startHandler]();
+    }
+    
+    __weak MRBrewWorker *weakSelf = self;
+
+    // configure a buffer that delivers output to the delegate in whole lines
+    [self setOutputBuffer:[[MRBrewOutputBuffer alloc] initWithHandler:^(NSString *output) {
+        [weakSelf notifyDelegateOperationGeneratedOutput:output];
+    }]];
+
+    [self setErrorOutputBuffer:[[MRBrewOutputBuffer alloc] initWithHandler:^(NSString *output) {
+        [weakSelf notifyDelegateOperationGeneratedErrorOutput:output];
+    }]];
+    [self setErrorOutput:[NSMutableString string]];
+    
+    // retain the output of read-only operations for the result cache and for
+    // replaying to delegates that attach while the task is running
+    if ([MRBrewOperation isReadOnlyOperationName:[_operation name]]) {
+        [self setGeneratedOutput:[NSMutableString string]];
+        
+        // output is only cached if the cache has not been invalidated by the
+        // time the operation finishes
+        [self setResultCacheGeneration:[[self resultCache] generation]];
+    }
+    
+    // perform the operation using the helper process where one is available,
+    // falling back to launching brew if the helper cannot be launched
+    if (![self helper] || ![self sendHelperRequest]) {
+        [self launchTask];
+    }
+}
+
+- (BOOL)dependencyFailed
+{
+    for (NSOperation *dependency in [self dependencies]) {
+        if ([dependency isKindOfClass:[MRBrewWorker class]] && ![(MRBrewWorker *)dependency succeeded]) {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+- (void)launchTask
+{
     // configure the brew task instance
     [[self task] setLaunchPath:[[MRBrew sharedBrew] brewPath]];
     [[self task] setArguments:_arguments];
     [[self task] setStandardOutput:[NSPipe pipe]];
+    [[self task] setStandardError:[NSPipe pipe]];
     
     NSDictionary *environment = [[MRBrew sharedBrew] environment];
     if (environment) {
         [[self task] setEnvironment:environment];
     }
 
-    // register for task termination notification
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(taskExited:) name:NSTaskDidTerminateNotification object:[self task]];
+    // the operation finishes once the task has exited and both of its output
+    // streams have been drained, so that output is always delivered before
+    // completion
+    [self setPendingTaskEvents:3];
+    
+    __weak MRBrewWorker *weakSelf = self;
+    [[self task] setTerminationHandler:^(MRBrewTask *task) {
+        [weakSelf taskTerminated];
+    }];
 
-    // configure read handler for asynchronous brew output
+    // configure read handlers for asynchronous brew output; each stream has its
+    // own handler so that both pipes are drained concurrently and neither can
+    // fill up and stall the task
     [[[[self task] standardOutput] fileHandleForReading] setReadabilityHandler:^(NSFileHandle *file) {
         NSData *data = [file availableData];
-        NSString *output = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
-        if ([_delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
-            [[NSOperationQueue mainQueue] addOperationWithBlock:^{
-                [_delegate brewOperation:_operation didGenerateOutput:output];
-            }];
+        if ([data length] > 0) {
+            [[weakSelf metrics] addByteCount:[data length] errorOutput:NO];
+            [[weakSelf outputBuffer] appendData:data];
+        }
+        else {
+            [weakSelf taskOutputDrained];
         }
     }];
     
-    [self main];
+    [[[[self task] standardError] fileHandleForReading] setReadabilityHandler:^(NSFileHandle *file) {
+        NSData *data = [file availableData];
+        if ([data length] > 0) {
+            [[weakSelf metrics] addByteCount:[data length] errorOutput:YES];
+            [[weakSelf errorOutputBuffer] appendData:data];
+        }
+        else {
+            [weakSelf taskErrorOutputDrained];
+        }
+    }];
+    
+    @try {
+        [[self task] launch];
+    }
+    @catch (NSException *exception) {
+        NSLog(@"MRBrewWorker: An internal exception was raised (%@: %@)",[exception name], exception);
+        
+        // cleanup
+        @synchronized(self) {
+            [self setAcceptingAttachments:NO];
+        }
+        [[self task] setTerminationHandler:nil];
+        [[[[self task] standardOutput] fileHandleForReading] setReadabilityHandler:nil];
+        [[[[self task] standardError] fileHandleForReading] setReadabilityHandler:nil];
+        
+        // a task that could not be launched fails, so that every operation
+        // that is performed either finishes or fails
+        [self notifyDelegateOperationFailed];
+        [self changeExecutingState:NO];
+        [self changeFinishedState:YES];
+        return;
+    }
+    
+    [[self metrics] setLaunchDate:[NSDate date]];
+    
+    // a cancellation message may have arrived while the task was launching
+    if ([self isCancelled]) {
+        [self terminateTask];
+    }
 }
 
-- (void)main
+- (BOOL)sendHelperRequest
 {
-    @try {
-        [[self task] launch];
+    __weak MRBrewWorker *weakSelf = self;
+    NSUInteger helperRequest = [[self helper] sendRequestWithArguments:_arguments dataHandler:^(MRBrewHelperStream stream, NSData *data) {
+        [weakSelf helperGeneratedData:data stream:stream];
+    } terminationHandler:^(BOOL exited, int status) {
+        [weakSelf helperRequestTerminated:exited status:status];
+    }];
+    
+    if (helperRequest == 0) {
+        return NO;
+    }
+    
+    [[self metrics] setLaunchDate:[NSDate date]];
+    
+    @synchronized(self) {
+        [self setHelperRequest:helperRequest];
+    }
+    
+    // a cancellation message may have arrived while the request was sent
+    if ([self isCancelled]) {
+        [self terminateTask];
+    }
+    
+    return YES;
+}
+
+- (void)helperGeneratedData:(NSData *)data stream:(MRBrewHelperStream)stream
+{
+    @synchronized(self) {
+        [self setHelperGeneratedData:YES];
+    }
+    
+    [[self metrics] addByteCount:[data length] errorOutput:(stream == MRBrewHelperStreamErrorOutput)];
+    
+    if (stream == MRBrewHelperStreamOutput) {
+        [[self outputBuffer] appendData:data];
+    }
+    else {
+        [[self errorOutputBuffer] appendData:data];
+    }
+}
+
+- (void)helperRequestTerminated:(BOOL)exited status:(int)status
+{
+    BOOL fallsBack = NO;
+    
+    @synchronized(self) {
+        if (exited) {
+            [self setHelperTerminationStatus:status];
+        }
+        else {
+            // the helper exited before the command did; if nothing has been
+            // delivered yet the operation can be performed again by brew
+            fallsBack = ![self helperGeneratedData] && ![self isCancelled];
+            [self setHelperTerminationStatus:MRBrewWorkerTaskHelperExited];
+        }
+        
+        if (fallsBack) {
+            [self setHelperRequest:0];
+        }
+        else if ([self isCancelled] && [self helperTerminationStatus] != MRBrewWorkerTaskExitedNormally) {
+            [self setHelperTerminationStatus:MRBrewWorkerTaskCancelled];
+        }
+    }
+    
+    if (fallsBack) {
+        [self launchTask];
+        return;
+    }
+    
+    [[self metrics] setExitDate:[NSDate date]];
+    [[self outputBuffer] flush];
+    [[self errorOutputBuffer] flush];
+    [self taskExited:nil];
+}
+
+- (int)terminationStatus
+{
+    @synchronized(self) {
+        if ([self helperRequest]) {
+            return [self helperTerminationStatus];
+        }
+    }
+    
+    return [[self task] terminationStatus];
+}
+
+- (id<MRBrewDelegate>)delegate
+{
+    @synchronized(self) {
+        return [[self attachments] count] > 0 ? [[[self attachments] objectAtIndex:0] delegate] : nil;
+    }
+}
+
+- (void)setDelegate:(id<MRBrewDelegate>)delegate
+{
+    MRBrewWorkerAttachment *attachment = [[MRBrewWorkerAttachment alloc] init];
+    [attachment setDelegate:delegate];
+    
+    @synchronized(self) {
+        [[self attachments] removeAllObjects];
+        [[self attachments] addObject:attachment];
+    }
+}
 
-        // polling loop for operation cancellation and task termination
-        while ([[self task] isRunning]) {
-
-            // spin run loop to allow for delivery of task termination notification
-            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:1.0]];
-
-            // poll for cancellation status and skip to the next iteration of
-            // the loop unless we have received a cancellation message
-            if (![self isCancelled]) continue;
-
-            // a cancellation message was received so we attempt to terminate the task,
-            // starting with a SIGINT signal and then increasing the severity of the
-            // signal in subsequent attempts if the timeout period has been reached
-            static BOOL taskSentInitialInterrupt = NO;
-            if (!taskSentInitialInterrupt || [[self taskTerminationTime] timeIntervalSinceDate:[NSDate date]] >= MRBrewWorkerTaskTerminationTimeout) {
-                taskSentInitialInterrupt = YES;
-                [self setTaskTerminationTime:[NSDate date]];
-
-                // signal task termination using the current termination mode and increase
-                // the severity to the next level for subsequent attempts (SIGINT->SIGTERM->SIGKILL)
-                switch ([self taskTerminationMode]) {
-                    case MRBrewWorkerTaskTerminationModeInterrupt:
-                        [[self task] interrupt];
-                        [self setTaskTerminationMode:MRBrewWorkerTaskTerminationModeTerminate];
-                        break;
-                    case MRBrewWorkerTaskTerminationModeTerminate:
-                        [[self task] terminate];
-                        [self setTaskTerminationMode:MRBrewWorkerTaskTerminationModeKill];
-                        break;
-                    case MRBrewWorkerTaskTerminationModeKill:
-                        kill([[self task] processIdentifier], SIGKILL);
-                        break;
+- (BOOL)attachDelegate:(id<MRBrewDelegate>)delegate operation:(MRBrewOperation *)operation
+{
+    MRBrewWorkerAttachment *attachment = [[MRBrewWorkerAttachment alloc] init];
+    [attachment setOperation:[operation copy]];
+    [attachment setDelegate:delegate];
+    
+    @synchronized(self) {
+        // too late to attach once the outcome is being delivered
+        if (![self isAcceptingAttachments] || [self isCancelled]) {
+            return NO;
+        }
+        
+        [[self attachments] addObject:attachment];
+        
+        // replay any output generated before the delegate attached; this is
+        // enqueued while synchronized so that it precedes subsequent output
+        NSString *output = [[self generatedOutput] copy];
+        NSString *errorOutput = [[self errorOutput] copy];
+        NSArray *parsedObjects = [[self parsedObjects] copy];
+        if ([output length] > 0 || [errorOutput length] > 0) {
+            [self enqueueDelivery:^{
+                id<MRBrewDelegate> delegate = [attachment delegate];
+                MRBrewOperation *operation = [attachment operation];
+                
+                if ([output length] > 0 && [delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
+                    [delegate brewOperation:operation didGenerateOutput:output];
+                }
+                
+                if ([errorOutput length] > 0 && [delegate respondsToSelector:@selector(brewOperation:didGenerateErrorOutput:)]) {
+                    [delegate brewOperation:operation didGenerateErrorOutput:errorOutput];
+                }
+                
+                if ([parsedObjects count] > 0 && [delegate respondsToSelector:@selector(brewOperation:didParseObjects:)]) {
+                    [delegate brewOperation:operation didParseObjects:parsedObjects];
                 }
+            }];
+        }
+    }
+    
+    [self performInlineDeliveries];
+    
+    return YES;
+}
+
+- (void)cancelForDelegate:(id<MRBrewDelegate>)delegate
+{
+    MRBrewWorkerAttachment *detached = nil;
+    BOOL lastAttachment = NO;
+    
+    @synchronized(self) {
+        if (![self isAcceptingAttachments]) {
+            return;
+        }
+        
+        for (MRBrewWorkerAttachment *attachment in [self attachments]) {
+            if ([attachment delegate] == delegate) {
+                detached = attachment;
+                break;
             }
         }
+        
+        if (!detached) {
+            return;
+        }
+        
+        // the last attached delegate is notified when the task is cancelled
+        lastAttachment = [[self attachments] count] == 1;
+        if (!lastAttachment) {
+            [[self attachments] removeObjectIdenticalTo:detached];
+        }
     }
-    @catch (NSException *exception) {
-        NSLog(@"MRBrewWorker: An internal exception was raised (%@: %@)",[exception name], exception);
+    
+    if (lastAttachment) {
+        [self cancel];
     }
-    @finally {
-        // cleanup
-        [self changeExecutingState:NO];
-        [self changeFinishedState:YES];
+    else {
+        NSError *error = [NSError errorWithDomain:MRBrewErrorDomain code:MRBrewErrorOperationCancelled userInfo:nil];
+        [self deliverToDelegates:^{
+            id<MRBrewDelegate> delegate = [detached delegate];
+            if ([delegate respondsToSelector:@selector(brewOperation:didFailWithError:)]) {
+                [delegate brewOperation:([detached operation] ?: _operation) didFailWithError:error];
+            }
+        }];
+    }
+}
+
+#pragma mark - Delivering to Delegates
+
+- (void)deliverToDelegates:(void (^)(void))delivery
+{
+    [self enqueueDelivery:delivery];
+    [self performInlineDeliveries];
+}
+
+/* Adds a delivery to those pending, in the order in which deliveries are
+ * performed. Deliveries are performed one at a time, so that output precedes
+ * the outcome even on a concurrent delegate queue. May be called while
+ * synchronized on the receiver, provided performInlineDeliveries is called
+ * once it is not.
+ */
+- (void)enqueueDelivery:(void (^)(void))delivery
+{
+    NSOperationQueue *queue = [self delegateQueue];
+    
+    BOOL scheduling;
+    @synchronized([self pendingDeliveries]) {
+        [[self pendingDeliveries] addObject:[delivery copy]];
+        scheduling = queue && ![self isDeliveryScheduled];
+        if (scheduling) {
+            [self setDeliveryScheduled:YES];
+        }
+    }
+    
+    if (scheduling) {
+        [queue addOperationWithBlock:^{
+            [self performPendingDeliveriesOnQueue:queue];
+        }];
+    }
+}
+
+/* Performs the pending deliveries on the current thread if there is no delegate
+ * queue, unless another thread is already performing them. Deliveries are not
+ * performed while synchronized on the receiver, so that a delegate waiting for
+ * another thread that is sending a message to the worker cannot deadlock it.
+ */
+- (void)performInlineDeliveries
+{
+    if ([self delegateQueue]) {
+        return;
+    }
+    
+    @synchronized([self pendingDeliveries]) {
+        if ([self isDeliveryScheduled]) {
+            return;
+        }
+        [self setDeliveryScheduled:YES];
+    }
+    
+    while (YES) {
+        NSArray *deliveries;
+        @synchronized([self pendingDeliveries]) {
+            deliveries = [[self pendingDeliveries] copy];
+            [[self pendingDeliveries] removeAllObjects];
+            if ([deliveries count] == 0) {
+                [self setDeliveryScheduled:NO];
+                return;
+            }
+        }
+        
+        for (void (^delivery)(void) in deliveries) {
+            delivery();
+        }
+    }
+}
+
+/* Performs the deliveries made so far, and schedules another operation for any
+ * made meanwhile rather than performing them too, so that a worker generating
+ * output quickly does not monopolise a serial delegate queue.
+ */
+- (void)performPendingDeliveriesOnQueue:(NSOperationQueue *)queue
+{
+    NSArray *deliveries;
+    @synchronized([self pendingDeliveries]) {
+        deliveries = [[self pendingDeliveries] copy];
+        [[self pendingDeliveries] removeAllObjects];
+    }
+    
+    for (void (^delivery)(void) in deliveries) {
+        delivery();
+    }
+    
+    BOOL rescheduling;
+    @synchronized([self pendingDeliveries]) {
+        rescheduling = [[self pendingDeliveries] count] > 0;
+        [self setDeliveryScheduled:rescheduling];
+    }
+    
+    if (rescheduling) {
+        [queue addOperationWithBlock:^{
+            [self performPendingDeliveriesOnQueue:queue];
+        }];
+    }
+}
+
+- (NSArray *)attachmentsSnapshot
+{
+    @synchronized(self) {
+        return [[self attachments] copy];
+    }
+}
+
+- (void)cancel
+{
+    BOOL wasCancelled = [self isCancelled];
+    
+    [super cancel];
+    
+    // begin terminating the task as soon as the cancellation message arrives;
+    // queued workers are finished by start instead
+    if (!wasCancelled && [self isExecuting]) {
+        [self terminateTask];
+    }
+}
+
+- (void)terminateTask
+{
+    NSTimeInterval gracePeriod = 0;
+    BOOL escalate = YES;
+    NSUInteger helperRequest;
+    
+    @synchronized(self) {
+        helperRequest = [self helperRequest];
+    }
+    
+    // the helper interrupts the command on receipt of a cancel request
+    if (helperRequest) {
+        [[self helper] cancelRequest:helperRequest];
+        return;
+    }
+    
+    @synchronized(self) {
+        if (![[self task] isRunning]) {
+            return;
+        }
+        
+        // processes brew launched may outlive it when it exits early, so any
+        // left in its process group are killed once the cancelled task exits
+        if ([[self task] respondsToSelector:@selector(setKillsProcessGroupOnExit:)]) {
+            [[self task] setKillsProcessGroupOnExit:YES];
+        }
+        
+        // signal task termination using the current termination mode and increase
+        // the severity to the next level for subsequent attempts (SIGINT->SIGTERM->SIGKILL);
+        // the task leads its own process group, so the processes brew launched
+        // (curl, git, compilers) receive each signal too
+        switch ([self taskTerminationMode]) {
+            case MRBrewWorkerTaskTerminationModeInterrupt:
+                [[self task] interrupt];
+                [self setTaskTerminationMode:MRBrewWorkerTaskTerminationModeTerminate];
+                gracePeriod = [self interruptGracePeriod];
+                break;
+            case MRBrewWorkerTaskTerminationModeTerminate:
+                [[self task] terminate];
+                [self setTaskTerminationMode:MRBrewWorkerTaskTerminationModeKill];
+                gracePeriod = [self terminationGracePeriod];
+                break;
+            case MRBrewWorkerTaskTerminationModeKill:
+                [[self task] kill];
+                escalate = NO;
+                break;
+        }
+    }
+    
+    // try again with a more severe signal if the task is still running once the
+    // grace period has passed
+    if (escalate) {
+        __weak MRBrewWorker *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(gracePeriod * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [weakSelf terminateTask];
+        });
     }
 }
 
@@ -165,40 +621,271 @@ static const NSTimeInterval MRBrewWorkerTaskTerminationTimeout = 5.0;
     [self didChangeValueForKey:@"isExecuting"];
 }
 
+- (void)taskTerminated
+{
+    [[self metrics] setExitDate:[NSDate date]];
+    if ([[self task] respondsToSelector:@selector(resourceUsage)]) {
+        [[self metrics] setResourceUsage:[[self task] resourceUsage]];
+    }
+    
+    [self taskEventOccurred];
+    
+    // a subprocess of the task may hold the pipes open after the task exits, so
+    // stop waiting for the end of its output once the timeout is reached
+    __weak MRBrewWorker *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MRBrewWorkerOutputDrainTimeout * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [weakSelf taskOutputDrained];
+        [weakSelf taskErrorOutputDrained];
+    });
+}
+
+- (void)taskOutputDrained
+{
+    @synchronized(self) {
+        if ([self isOutputDrained]) {
+            return;
+        }
+        [self setOutputDrained:YES];
+    }
+    
+    [[[[self task] standardOutput] fileHandleForReading] setReadabilityHandler:nil];
+    [[self outputBuffer] flush];
+    [self taskEventOccurred];
+}
+
+- (void)taskErrorOutputDrained
+{
+    @synchronized(self) {
+        if ([self isErrorOutputDrained]) {
+            return;
+        }
+        [self setErrorOutputDrained:YES];
+    }
+    
+    [[[[self task] standardError] fileHandleForReading] setReadabilityHandler:nil];
+    [[self errorOutputBuffer] flush];
+    [self taskEventOccurred];
+}
+
+- (void)taskEventOccurred
+{
+    NSUInteger pendingTaskEvents;
+    
+    @synchronized(self) {
+        pendingTaskEvents = [self pendingTaskEvents] - 1;
+        [self setPendingTaskEvents:pendingTaskEvents];
+    }
+    
+    if (pendingTaskEvents == 0) {
+        [self taskExited:nil];
+    }
+}
+
 - (void)taskExited:(NSNotification *)notification
 {
-    if ([[self task] terminationStatus] == MRBrewWorkerTaskExitedNormally) {
+    // delegates attaching from now on would miss the outcome
+    @synchronized(self) {
+        [self setAcceptingAttachments:NO];
+    }
+    
+    if ([self terminationStatus] == MRBrewWorkerTaskExitedNormally) {
+        [self setSucceeded:YES];
+        [[self resultCache] setOutput:[self generatedOutput] forOperation:_operation generation:[self resultCacheGeneration]];
+        @synchronized(self) {
+            [self parseGeneratedOutput:@""];
+            [[self parserSession] finish];
+        }
         [self notifyDelegateOperationCompleted];
     }
     else {
         [self notifyDelegateOperationFailed];
     }
+    
+    // an operation that is not read-only may have invalidated output cached
+    // while it was executing
+    if ([self resultCache] && ![MRBrewOperation isReadOnlyOperationName:[_operation name]]) {
+        [[self resultCache] removeAllOutput];
+    }
 
     // stop reading and cleanup file handle's structures
-    [[[[self task] standardOutput] fileHandleForReading] setReadabilityHandler:nil];
+    BOOL usedHelper;
+    @synchronized(self) {
+        usedHelper = [self helperRequest] != 0;
+    }
+    if (!usedHelper) {
+        [[[[self task] standardOutput] fileHandleForReading] setReadabilityHandler:nil];
+    }
+    
+    // the task has exited so the operation is complete
+    [self changeExecutingState:NO];
+    [self changeFinishedState:YES];
 }
 
-- (void)notifyDelegateOperationFailed {
-    NSInteger errorCode = [[self task] terminationStatus] == MRBrewWorkerTaskCancelled ? MRBrewErrorOperationCancelled : MRBrewErrorUnknown;
-    NSError *error = [NSError errorWithDomain:MRBrewErrorDomain code:errorCode userInfo:nil];
-    if ([_delegate respondsToSelector:@selector(brewOperation:didFailWithError:)]) {
-        [[NSOperationQueue mainQueue] addOperationWithBlock:^{
-            [_delegate brewOperation:_operation didFailWithError:error];
+- (void)notifyDelegateOperationGeneratedOutput:(NSString *)output {
+    @synchronized(self) {
+        [self parseGeneratedOutput:output];
+        [[self generatedOutput] appendString:output];
+        
+        NSArray *attachments = [[self attachments] copy];
+        [self enqueueDelivery:^{
+            for (MRBrewWorkerAttachment *attachment in attachments) {
+                id<MRBrewDelegate> delegate = [attachment delegate];
+                if ([delegate respondsToSelector:@selector(brewOperation:didGenerateOutput:)]) {
+                    [delegate brewOperation:([attachment operation] ?: _operation) didGenerateOutput:output];
+                }
+            }
         }];
     }
+    
+    [self performInlineDeliveries];
 }
 
-- (void)notifyDelegateOperationCompleted {
-    if ([_delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
-        [[NSOperationQueue mainQueue] addOperationWithBlock:^{
-            [_delegate brewOperationDidFinish:_operation];
+/* Parses output for delegates that implement brewOperation:didParseObjects:,
+ * starting a parser session when the first such delegate is attached. Must be
+ * called while synchronized on the receiver.
+ */
+- (void)parseGeneratedOutput:(NSString *)output
+{
+    if (![self parserSession]) {
+        BOOL parsingRequested = NO;
+        for (MRBrewWorkerAttachment *attachment in [self attachments]) {
+            if ([[attachment delegate] respondsToSelector:@selector(brewOperation:didParseObjects:)]) {
+                parsingRequested = YES;
+                break;
+            }
+        }
+        
+        if (!parsingRequested || ![MRBrewOutputParserSession supportsOperation:_operation]) {
+            return;
+        }
+        
+        __weak MRBrewWorker *weakSelf = self;
+        [self setParsedObjects:[NSMutableArray array]];
+        [self setParserSession:[[MRBrewOutputParserSession alloc] initWithOperation:_operation handler:^(NSArray *objects) {
+            [weakSelf notifyDelegateOperationParsedObjects:objects];
+        }]];
+        
+        // parse the output that was generated before the session started
+        if ([[self generatedOutput] length] > 0) {
+            [[self parserSession] appendString:[self generatedOutput]];
+        }
+    }
+    
+    [[self parserSession] appendString:output];
+}
+
+/* Must be called while synchronized on the receiver, which is the case for
+ * the parser session's handler.
+ */
+- (void)notifyDelegateOperationParsedObjects:(NSArray *)objects {
+    [[self parsedObjects] addObjectsFromArray:objects];
+    
+    NSArray *attachments = [[self attachments] copy];
+    [self enqueueDelivery:^{
+        for (MRBrewWorkerAttachment *attachment in attachments) {
+            id<MRBrewDelegate> delegate = [attachment delegate];
+            if ([delegate respondsToSelector:@selector(brewOperation:didParseObjects:)]) {
+                [delegate brewOperation:([attachment operation] ?: _operation) didParseObjects:objects];
+            }
+        }
+    }];
+}
+
+- (void)notifyDelegateOperationGeneratedErrorOutput:(NSString *)output {
+    // retain the most recent error output for inclusion in the error object
+    // passed to the delegate if the operation fails
+    @synchronized(self) {
+        NSMutableString *errorOutput = [self errorOutput];
+        [errorOutput appendString:output];
+        if ([errorOutput length] > MRBrewWorkerErrorOutputLimit) {
+            [errorOutput deleteCharactersInRange:[errorOutput rangeOfComposedCharacterSequencesForRange:NSMakeRange(0, [errorOutput length] - MRBrewWorkerErrorOutputLimit)]];
+        }
+        
+        NSArray *attachments = [[self attachments] copy];
+        [self enqueueDelivery:^{
+            for (MRBrewWorkerAttachment *attachment in attachments) {
+                id<MRBrewDelegate> delegate = [attachment delegate];
+                if ([delegate respondsToSelector:@selector(brewOperation:didGenerateErrorOutput:)]) {
+                    [delegate brewOperation:([attachment operation] ?: _operation) didGenerateErrorOutput:output];
+                }
+            }
         }];
     }
+    
+    [self performInlineDeliveries];
+}
+
+- (void)notifyDelegateOperationFailed {
+    // a cancelled task may have been terminated or killed by a signal rather
+    // than exiting in response to the interrupt
+    BOOL cancelled = [self isCancelled] || [self terminationStatus] == MRBrewWorkerTaskCancelled;
+    NSInteger errorCode = cancelled ? MRBrewErrorOperationCancelled : MRBrewErrorUnknown;
+    NSDictionary *userInfo = nil;
+    @synchronized(self) {
+        if ([[self errorOutput] length] > 0) {
+            userInfo = @{MRBrewErrorOutputKey: [[self errorOutput] copy]};
+        }
+    }
+    NSError *error = [NSError errorWithDomain:MRBrewErrorDomain code:errorCode userInfo:userInfo];
+    NSArray *attachments = [self attachmentsSnapshot];
+    NSDate *dispatchDate = [NSDate date];
+    [self deliverToDelegates:^{
+        [self recordDeliveryDispatchedOnDate:dispatchDate succeeded:NO];
+        for (MRBrewWorkerAttachment *attachment in attachments) {
+            id<MRBrewDelegate> delegate = [attachment delegate];
+            if ([delegate respondsToSelector:@selector(brewOperation:didFailWithError:)]) {
+                [delegate brewOperation:([attachment operation] ?: _operation) didFailWithError:error];
+            }
+        }
+        [self notifyDelegateOperationCollectedMetrics:attachments];
+    }];
 }
 
-- (void)dealloc
+- (void)notifyDelegateOperationCompleted {
+    NSArray *attachments = [self attachmentsSnapshot];
+    NSDate *dispatchDate = [NSDate date];
+    [self deliverToDelegates:^{
+        [self recordDeliveryDispatchedOnDate:dispatchDate succeeded:YES];
+        for (MRBrewWorkerAttachment *attachment in attachments) {
+            id<MRBrewDelegate> delegate = [attachment delegate];
+            if ([delegate respondsToSelector:@selector(brewOperationDidFinish:)]) {
+                [delegate brewOperationDidFinish:([attachment operation] ?: _operation)];
+            }
+        }
+        [self notifyDelegateOperationCollectedMetrics:attachments];
+    }];
+}
+
+/* Records the delivery of the outcome of the operation, which was dispatched
+ * to the delegate queue on the specified date. Must be called from a delivery.
+ */
+- (void)recordDeliveryDispatchedOnDate:(NSDate *)dispatchDate succeeded:(BOOL)succeeded
 {
-    [[NSNotificationCenter defaultCenter] removeObserver:self name:NSTaskDidTerminateNotification object:[self task]];
+    NSDate *deliveryDate = [NSDate date];
+    
+    [[self metrics] setOperation:_operation];
+    [[self metrics] setSucceeded:succeeded];
+    [[self metrics] setDeliveryDate:deliveryDate];
+    [[self metrics] setDelegateDispatchLag:[deliveryDate timeIntervalSinceDate:dispatchDate]];
+}
+
+/* Must be called from a delivery, once the outcome of the operation has been
+ * delivered.
+ */
+- (void)notifyDelegateOperationCollectedMetrics:(NSArray *)attachments
+{
+    MRBrewOperationMetrics *metrics = [self metrics];
+    
+    for (MRBrewWorkerAttachment *attachment in attachments) {
+        id<MRBrewDelegate> delegate = [attachment delegate];
+        if ([delegate respondsToSelector:@selector(brewOperation:didCollectMetrics:)]) {
+            [delegate brewOperation:([attachment operation] ?: _operation) didCollectMetrics:metrics];
+        }
+    }
+    
+    if ([self metricsHandler]) {
+        [self metricsHandler](metrics);
+    }
 }
 
 @end
@@ -27,3 +27,4 @@
 
 extern int const MRBrewWorkerTaskExitedNormally;
 extern int const MRBrewWorkerTaskCancelled;
+extern int const MRBrewWorkerTaskHelperExited;
@@ -26,4 +26,5 @@
 #import "MRBrewWorkerTaskConstants.h"
 
 int const MRBrewWorkerTaskExitedNormally = 0;
-int const MRBrewWorkerTaskCancelled = 130;
\ No newline at end of file
+int const MRBrewWorkerTaskCancelled = 130;
+int const MRBrewWorkerTaskHelperExited = -1;
\ No newline at end of file
@@ -0,0 +1,99 @@
+//
+//  MRBrewBenchmark.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewDelegate.h"
+
+@class MRBrewOperation;
+@class MRBrewBenchmarkResult;
+
+/* Keys of the options passed to the fake brew executable; see fake-brew.c. */
+extern NSString * const MRBrewBenchmarkStartupDelayOption;
+extern NSString * const MRBrewBenchmarkOutputLinesOption;
+extern NSString * const MRBrewBenchmarkErrorLinesOption;
+extern NSString * const MRBrewBenchmarkChunkLinesOption;
+extern NSString * const MRBrewBenchmarkChunkDelayOption;
+extern NSString * const MRBrewBenchmarkExitStatusOption;
+extern NSString * const MRBrewBenchmarkIgnoreSignalsOption;
+extern NSString * const MRBrewBenchmarkSignalDelayOption;
+
+/* Measures operations performed end to end by MRBrew against the fake brew
+ * executable: queueing, launching, reading and parsing output, and delivering
+ * callbacks to the delegate queue. Must be used on the main thread, which is
+ * run until the operations being measured have finished.
+ */
+@interface MRBrewBenchmark : NSObject <MRBrewDelegate>
+
+- (instancetype)initWithFakeBrewPath:(NSString *)fakeBrewPath;
+
+@property (readonly, copy) NSString *fakeBrewPath;
+
+/* The time allowed for each scenario to finish; 120 seconds by default. */
+@property (assign) NSTimeInterval timeout;
+
+/* The queue on which callbacks are delivered, or nil to deliver them on the
+ * threads that generate them; the main queue by default.
+ */
+@property (strong) NSOperationQueue *delegateQueue;
+
+/* Performs the operations with the fake brew executable configured by the
+ * options, measuring the latency of each from the time it is performed until
+ * its metrics are delivered.
+ */
+- (MRBrewBenchmarkResult *)measureOperations:(NSArray *)operations named:(NSString *)name options:(NSDictionary *)options;
+
+/* Performs the operations, cancelling each once it has generated output, and
+ * measures the latency from cancellation until its failure is delivered.
+ */
+- (MRBrewBenchmarkResult *)measureCancellationOfOperations:(NSArray *)operations named:(NSString *)name options:(NSDictionary *)options;
+
+/* Parses the output repeatedly, in a single string when chunkLength is 0 or
+ * in chunks of chunkLength bytes through an output parser session, and
+ * measures the latency of each iteration.
+ */
+- (MRBrewBenchmarkResult *)measureParsingOutput:(NSString *)output forOperation:(MRBrewOperation *)operation chunkLength:(NSUInteger)chunkLength iterations:(NSUInteger)iterations named:(NSString *)name;
+
+/* Parses the output repeatedly, keeping the objects parsed by the last
+ * retainedResultCount iterations alive as a long-running client caching its
+ * recent results would, and measures the latency of each iteration. The
+ * growth in live allocations shows the memory retained by those results.
+ */
+- (MRBrewBenchmarkResult *)measureRetainingParsedOutput:(NSString *)output forOperation:(MRBrewOperation *)operation retainedResultCount:(NSUInteger)retainedResultCount iterations:(NSUInteger)iterations named:(NSString *)name;
+
+/* Reads a synthetic Cellar of formulaCount racks, each holding versionCount
+ * kegs, repeatedly, and measures the latency of each iteration; this is the
+ * work of a list operation performed in-process.
+ */
+- (MRBrewBenchmarkResult *)measureReadingCellarWithFormulaCount:(NSUInteger)formulaCount versionCount:(NSUInteger)versionCount iterations:(NSUInteger)iterations named:(NSString *)name;
+
+/* Finds the outdated formulae of a synthetic installation of formulaCount
+ * formulae, a tenth of which are outdated, repeatedly, and measures the
+ * latency of each iteration; this is the work of an outdated operation
+ * performed in-process. Unless reusesEngine is set, each iteration uses a new
+ * engine and so reads every formula file.
+ */
+- (MRBrewBenchmarkResult *)measureFindingOutdatedFormulaeWithFormulaCount:(NSUInteger)formulaCount reusesEngine:(BOOL)reusesEngine iterations:(NSUInteger)iterations named:(NSString *)name;
+
+@end
@@ -0,0 +1,503 @@
+//
+//  MRBrewBenchmark.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewBenchmark.h"
+#import "MRBrewBenchmarkResult.h"
+#import "MRBrewBenchmarkAllocations.h"
+#import "MRBrew.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewOutputParser.h"
+#import "MRBrewOutputParserSession.h"
+#import "MRBrewCellar.h"
+#import "MRBrewOutdatedEngine.h"
+#include <sys/resource.h>
+
+NSString * const MRBrewBenchmarkStartupDelayOption = @"MRBREW_FAKE_STARTUP_DELAY";
+NSString * const MRBrewBenchmarkOutputLinesOption = @"MRBREW_FAKE_OUTPUT_LINES";
+NSString * const MRBrewBenchmarkErrorLinesOption = @"MRBREW_FAKE_ERROR_LINES";
+NSString * const MRBrewBenchmarkChunkLinesOption = @"MRBREW_FAKE_CHUNK_LINES";
+NSString * const MRBrewBenchmarkChunkDelayOption = @"MRBREW_FAKE_CHUNK_DELAY";
+NSString * const MRBrewBenchmarkExitStatusOption = @"MRBREW_FAKE_EXIT_STATUS";
+NSString * const MRBrewBenchmarkIgnoreSignalsOption = @"MRBREW_FAKE_IGNORE_SIGNALS";
+NSString * const MRBrewBenchmarkSignalDelayOption = @"MRBREW_FAKE_SIGNAL_DELAY";
+
+static const NSTimeInterval MRBrewBenchmarkDefaultTimeout = 120.0;
+static const NSTimeInterval MRBrewBenchmarkDrainTimeout = 15.0;
+
+/* Returns the peak resident set size of the benchmark process in bytes. */
+static unsigned long long MRBrewBenchmarkPeakResidentSetSize(void)
+{
+    struct rusage resourceUsage;
+    
+    if (getrusage(RUSAGE_SELF, &resourceUsage) != 0) {
+        return 0;
+    }
+    
+    // ru_maxrss is measured in bytes on OS X, and kilobytes elsewhere
+#ifdef __APPLE__
+    return (unsigned long long)resourceUsage.ru_maxrss;
+#else
+    return (unsigned long long)resourceUsage.ru_maxrss * 1024;
+#endif
+}
+
+/* Returns the key identifying an operation in callbacks, which receive copies
+ * of the operations performed. Scenarios give each operation its own formula.
+ */
+static NSString *MRBrewBenchmarkOperationKey(MRBrewOperation *operation)
+{
+    return [NSString stringWithFormat:@"%@ %@", [operation name], [[operation formula] name] ?: @""];
+}
+
+@interface MRBrewBenchmark ()
+{
+    @private
+    MRBrewBenchmarkResult *_result;
+    NSCountedSet *_pendingOperationKeys;
+    NSMutableArray *_latencies;
+    NSMutableDictionary *_cancellationDates;
+    BOOL _cancelling;
+}
+
+@end
+
+@implementation MRBrewBenchmark
+
+#pragma mark - Lifecycle
+
+- (instancetype)init
+{
+    return [self initWithFakeBrewPath:nil];
+}
+
+- (instancetype)initWithFakeBrewPath:(NSString *)fakeBrewPath
+{
+    if (self = [super init]) {
+        _fakeBrewPath = [fakeBrewPath copy];
+        _timeout = MRBrewBenchmarkDefaultTimeout;
+        _delegateQueue = [NSOperationQueue mainQueue];
+    }
+    
+    return self;
+}
+
+#pragma mark - Measuring Operations
+
+- (MRBrewBenchmarkResult *)measureOperations:(NSArray *)operations named:(NSString *)name options:(NSDictionary *)options
+{
+    return [self performOperations:operations named:name options:options cancelling:NO];
+}
+
+- (MRBrewBenchmarkResult *)measureCancellationOfOperations:(NSArray *)operations named:(NSString *)name options:(NSDictionary *)options
+{
+    return [self performOperations:operations named:name options:options cancelling:YES];
+}
+
+- (MRBrewBenchmarkResult *)performOperations:(NSArray *)operations named:(NSString *)name options:(NSDictionary *)options cancelling:(BOOL)cancelling
+{
+    MRBrew *brew = [MRBrew sharedBrew];
+    [brew setBrewPath:[self fakeBrewPath]];
+    [brew setEnvironment:options];
+    [brew setDelegateQueue:[self delegateQueue]];
+    
+    _result = [[MRBrewBenchmarkResult alloc] init];
+    [_result setName:name];
+    [_result setOperationCount:[operations count]];
+    _pendingOperationKeys = [NSCountedSet set];
+    _latencies = [NSMutableArray arrayWithCapacity:[operations count]];
+    _cancellationDates = [NSMutableDictionary dictionary];
+    _cancelling = cancelling;
+    
+    for (MRBrewOperation *operation in operations) {
+        [_pendingOperationKeys addObject:MRBrewBenchmarkOperationKey(operation)];
+    }
+    
+    unsigned long long allocationCount = MRBrewBenchmarkAllocationCount();
+    unsigned long long allocatedByteCount = MRBrewBenchmarkAllocatedByteCount();
+    long long liveAllocationCount = MRBrewBenchmarkLiveAllocationCount();
+    NSDate *startDate = [NSDate date];
+    NSDate *timeoutDate = [startDate dateByAddingTimeInterval:[self timeout]];
+    
+    for (MRBrewOperation *operation in operations) {
+        [brew performOperation:operation delegate:self];
+    }
+    
+    // callbacks are delivered on the main queue, which runs with the run loop,
+    // unless they are delivered on another queue or inline
+    while ([self completedOperationCount] < [operations count] && [timeoutDate timeIntervalSinceNow] > 0) {
+        @autoreleasepool {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+    }
+    
+    BOOL timedOut;
+    @synchronized(self) {
+        [_result setElapsedTime:-[startDate timeIntervalSinceNow]];
+        [_result setAllocationCount:MRBrewBenchmarkAllocationCount() - allocationCount];
+        [_result setAllocatedByteCount:MRBrewBenchmarkAllocatedByteCount() - allocatedByteCount];
+        [_result setLiveAllocationCount:MRBrewBenchmarkLiveAllocationCount() - liveAllocationCount];
+        [_result setLatencies:_latencies];
+        [_result setPeakResidentSetSize:MRBrewBenchmarkPeakResidentSetSize()];
+        
+        timedOut = [_result completedOperationCount] < [operations count];
+        [_result setTimedOut:timedOut];
+    }
+    
+    if (timedOut) {
+        [self drainOperations];
+    }
+    
+    MRBrewBenchmarkResult *result;
+    @synchronized(self) {
+        result = _result;
+        _result = nil;
+        _pendingOperationKeys = nil;
+    }
+    
+    return result;
+}
+
+/* Returns the number of operations completed in the current scenario. Callbacks
+ * may be delivered on other threads, so the state they update is synchronized
+ * on the receiver.
+ */
+- (NSUInteger)completedOperationCount
+{
+    @synchronized(self) {
+        return [_result completedOperationCount];
+    }
+}
+
+/* Cancels the operations of a scenario that timed out, and waits for them to
+ * finish so that they do not disturb the next scenario.
+ */
+- (void)drainOperations
+{
+    [[MRBrew sharedBrew] cancelAllOperations];
+    
+    NSDate *drainDate = [NSDate dateWithTimeIntervalSinceNow:MRBrewBenchmarkDrainTimeout];
+    while ([[MRBrew sharedBrew] operationCount] > 0 && [drainDate timeIntervalSinceNow] > 0) {
+        @autoreleasepool {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+    }
+}
+
+#pragma mark - Measuring Parsing
+
+- (MRBrewBenchmarkResult *)measureParsingOutput:(NSString *)output forOperation:(MRBrewOperation *)operation chunkLength:(NSUInteger)chunkLength iterations:(NSUInteger)iterations named:(NSString *)name
+{
+    MRBrewBenchmarkResult *result = [[MRBrewBenchmarkResult alloc] init];
+    [result setName:name];
+    [result setOperationCount:iterations];
+    
+    NSData *data = [output dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:iterations];
+    __block NSUInteger objectCount = 0;
+    
+    unsigned long long allocationCount = MRBrewBenchmarkAllocationCount();
+    unsigned long long allocatedByteCount = MRBrewBenchmarkAllocatedByteCount();
+    long long liveAllocationCount = MRBrewBenchmarkLiveAllocationCount();
+    NSDate *startDate = [NSDate date];
+    
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        @autoreleasepool {
+            NSDate *iterationDate = [NSDate date];
+            
+            if (chunkLength == 0) {
+                NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:NULL];
+                if (!objects) {
+                    [result setFailedOperationCount:[result failedOperationCount] + 1];
+                }
+                objectCount += [objects count];
+            }
+            else {
+                MRBrewOutputParserSession *session = [[MRBrewOutputParserSession alloc] initWithOperation:operation handler:^(NSArray *objects) {
+                    objectCount += [objects count];
+                }];
+                
+                for (NSUInteger location = 0; location < [data length]; location += chunkLength) {
+                    [session appendData:[data subdataWithRange:NSMakeRange(location, MIN(chunkLength, [data length] - location))]];
+                }
+                [session finish];
+            }
+            
+            [latencies addObject:@(-[iterationDate timeIntervalSinceNow])];
+        }
+    }
+    
+    [result setElapsedTime:-[startDate timeIntervalSinceNow]];
+    [result setAllocationCount:MRBrewBenchmarkAllocationCount() - allocationCount];
+    [result setAllocatedByteCount:MRBrewBenchmarkAllocatedByteCount() - allocatedByteCount];
+    [result setLiveAllocationCount:MRBrewBenchmarkLiveAllocationCount() - liveAllocationCount];
+    [result setCompletedOperationCount:iterations];
+    [result setObjectCount:objectCount];
+    [result setByteCount:(unsigned long long)[data length] * iterations];
+    [result setLatencies:latencies];
+    [result setPeakResidentSetSize:MRBrewBenchmarkPeakResidentSetSize()];
+    
+    return result;
+}
+
+- (MRBrewBenchmarkResult *)measureRetainingParsedOutput:(NSString *)output forOperation:(MRBrewOperation *)operation retainedResultCount:(NSUInteger)retainedResultCount iterations:(NSUInteger)iterations named:(NSString *)name
+{
+    MRBrewBenchmarkResult *result = [[MRBrewBenchmarkResult alloc] init];
+    [result setName:name];
+    [result setOperationCount:iterations];
+    
+    NSMutableArray *retainedResults = [NSMutableArray arrayWithCapacity:retainedResultCount + 1];
+    NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:iterations];
+    NSUInteger objectCount = 0;
+    
+    unsigned long long allocationCount = MRBrewBenchmarkAllocationCount();
+    unsigned long long allocatedByteCount = MRBrewBenchmarkAllocatedByteCount();
+    long long liveAllocationCount = MRBrewBenchmarkLiveAllocationCount();
+    NSDate *startDate = [NSDate date];
+    
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        @autoreleasepool {
+            NSDate *iterationDate = [NSDate date];
+            
+            NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:NULL];
+            if (!objects) {
+                [result setFailedOperationCount:[result failedOperationCount] + 1];
+            }
+            objectCount += [objects count];
+            
+            [retainedResults addObject:(objects ?: @[])];
+            if ([retainedResults count] > retainedResultCount) {
+                [retainedResults removeObjectAtIndex:0];
+            }
+            
+            [latencies addObject:@(-[iterationDate timeIntervalSinceNow])];
+        }
+    }
+    
+    [result setElapsedTime:-[startDate timeIntervalSinceNow]];
+    [result setAllocationCount:MRBrewBenchmarkAllocationCount() - allocationCount];
+    [result setAllocatedByteCount:MRBrewBenchmarkAllocatedByteCount() - allocatedByteCount];
+    [result setLiveAllocationCount:MRBrewBenchmarkLiveAllocationCount() - liveAllocationCount];
+    [result setCompletedOperationCount:iterations];
+    [result setObjectCount:objectCount];
+    [result setByteCount:(unsigned long long)[output lengthOfBytesUsingEncoding:NSUTF8StringEncoding] * iterations];
+    [result setLatencies:latencies];
+    [result setPeakResidentSetSize:MRBrewBenchmarkPeakResidentSetSize()];
+    
+    return result;
+}
+
+#pragma mark - Measuring In-Process Operations
+
+- (MRBrewBenchmarkResult *)measureReadingCellarWithFormulaCount:(NSUInteger)formulaCount versionCount:(NSUInteger)versionCount iterations:(NSUInteger)iterations named:(NSString *)name
+{
+    MRBrewBenchmarkResult *result = [[MRBrewBenchmarkResult alloc] init];
+    [result setName:name];
+    [result setOperationCount:iterations];
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *cellarPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[@"MRBrewBenchmarks-Cellar-" stringByAppendingString:[[NSProcessInfo processInfo] globallyUniqueString]]];
+    
+    for (NSUInteger formulaIndex = 0; formulaIndex < formulaCount; formulaIndex++) {
+        for (NSUInteger versionIndex = 0; versionIndex < versionCount; versionIndex++) {
+            NSString *kegPath = [cellarPath stringByAppendingPathComponent:[NSString stringWithFormat:@"formula-%lu/1.%lu/bin", (unsigned long)formulaIndex, (unsigned long)versionIndex]];
+            [fileManager createDirectoryAtPath:kegPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        }
+    }
+    
+    MRBrewCellar *cellar = [MRBrewCellar cellarWithPath:cellarPath];
+    NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:iterations];
+    NSUInteger objectCount = 0;
+    
+    unsigned long long allocationCount = MRBrewBenchmarkAllocationCount();
+    unsigned long long allocatedByteCount = MRBrewBenchmarkAllocatedByteCount();
+    long long liveAllocationCount = MRBrewBenchmarkLiveAllocationCount();
+    NSDate *startDate = [NSDate date];
+    
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        @autoreleasepool {
+            NSDate *iterationDate = [NSDate date];
+            
+            NSArray *formulae = [cellar installedFormulaeWithError:NULL];
+            if ([formulae count] != formulaCount) {
+                [result setFailedOperationCount:[result failedOperationCount] + 1];
+            }
+            objectCount += [formulae count];
+            
+            [latencies addObject:@(-[iterationDate timeIntervalSinceNow])];
+        }
+    }
+    
+    [result setElapsedTime:-[startDate timeIntervalSinceNow]];
+    [result setAllocationCount:MRBrewBenchmarkAllocationCount() - allocationCount];
+    [result setAllocatedByteCount:MRBrewBenchmarkAllocatedByteCount() - allocatedByteCount];
+    [result setLiveAllocationCount:MRBrewBenchmarkLiveAllocationCount() - liveAllocationCount];
+    [result setCompletedOperationCount:iterations];
+    [result setObjectCount:objectCount];
+    [result setLatencies:latencies];
+    [result setPeakResidentSetSize:MRBrewBenchmarkPeakResidentSetSize()];
+    
+    [fileManager removeItemAtPath:cellarPath error:NULL];
+    
+    return result;
+}
+
+- (MRBrewBenchmarkResult *)measureFindingOutdatedFormulaeWithFormulaCount:(NSUInteger)formulaCount reusesEngine:(BOOL)reusesEngine iterations:(NSUInteger)iterations named:(NSString *)name
+{
+    MRBrewBenchmarkResult *result = [[MRBrewBenchmarkResult alloc] init];
+    [result setName:name];
+    [result setOperationCount:iterations];
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *prefix = [NSTemporaryDirectory() stringByAppendingPathComponent:[@"MRBrewBenchmarks-Prefix-" stringByAppendingString:[[NSProcessInfo processInfo] globallyUniqueString]]];
+    NSString *cellarPath = [prefix stringByAppendingPathComponent:@"Cellar"];
+    NSString *formulaPath = [prefix stringByAppendingPathComponent:@"Library/Formula"];
+    NSString *tapsPath = [prefix stringByAppendingPathComponent:@"Library/Taps"];
+    [fileManager createDirectoryAtPath:formulaPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    NSUInteger outdatedCount = 0;
+    for (NSUInteger formulaIndex = 0; formulaIndex < formulaCount; formulaIndex++) {
+        NSString *formulaName = [NSString stringWithFormat:@"formula-%lu", (unsigned long)formulaIndex];
+        BOOL outdated = (formulaIndex % 10 == 0);
+        outdatedCount += outdated ? 1 : 0;
+        
+        NSString *kegPath = [cellarPath stringByAppendingPathComponent:[formulaName stringByAppendingPathComponent:@"1.0"]];
+        [fileManager createDirectoryAtPath:kegPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        
+        NSString *contents = [NSString stringWithFormat:@"class Formula%lu < Formula\n  homepage \"http://example.com\"\n  url \"http://example.com/%@-%@.tar.gz\"\n  sha1 \"0\"\n\n  def install\n    system \"make\", \"install\"\n  end\nend\n", (unsigned long)formulaIndex, formulaName, outdated ? @"1.1" : @"1.0"];
+        [contents writeToFile:[formulaPath stringByAppendingPathComponent:[formulaName stringByAppendingPathExtension:@"rb"]] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    }
+    
+    MRBrewOutdatedEngine *engine = [MRBrewOutdatedEngine engineWithCellarPath:cellarPath formulaPath:formulaPath tapsPath:tapsPath];
+    NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:iterations];
+    NSUInteger objectCount = 0;
+    
+    unsigned long long allocationCount = MRBrewBenchmarkAllocationCount();
+    unsigned long long allocatedByteCount = MRBrewBenchmarkAllocatedByteCount();
+    long long liveAllocationCount = MRBrewBenchmarkLiveAllocationCount();
+    NSDate *startDate = [NSDate date];
+    
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        @autoreleasepool {
+            NSDate *iterationDate = [NSDate date];
+            
+            if (!reusesEngine) {
+                engine = [MRBrewOutdatedEngine engineWithCellarPath:cellarPath formulaPath:formulaPath tapsPath:tapsPath];
+            }
+            
+            NSArray *formulae = [engine outdatedFormulaeWithError:NULL];
+            if ([formulae count] != outdatedCount) {
+                [result setFailedOperationCount:[result failedOperationCount] + 1];
+            }
+            objectCount += [formulae count];
+            
+            [latencies addObject:@(-[iterationDate timeIntervalSinceNow])];
+        }
+    }
+    
+    [result setElapsedTime:-[startDate timeIntervalSinceNow]];
+    [result setAllocationCount:MRBrewBenchmarkAllocationCount() - allocationCount];
+    [result setAllocatedByteCount:MRBrewBenchmarkAllocatedByteCount() - allocatedByteCount];
+    [result setLiveAllocationCount:MRBrewBenchmarkLiveAllocationCount() - liveAllocationCount];
+    [result setCompletedOperationCount:iterations];
+    [result setObjectCount:objectCount];
+    [result setLatencies:latencies];
+    [result setPeakResidentSetSize:MRBrewBenchmarkPeakResidentSetSize()];
+    
+    [fileManager removeItemAtPath:prefix error:NULL];
+    
+    return result;
+}
+
+#pragma mark - MRBrewDelegate protocol
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
+{
+    @synchronized(self) {
+        if (!_cancelling) {
+            return;
+        }
+        
+        NSString *key = MRBrewBenchmarkOperationKey(operation);
+        if (![_pendingOperationKeys containsObject:key] || [_cancellationDates objectForKey:key]) {
+            return;
+        }
+        [_cancellationDates setObject:[NSDate date] forKey:key];
+    }
+    
+    // cancelling is not synchronized, as the failure may be delivered inline
+    // on another thread
+    [[MRBrew sharedBrew] cancelOperation:operation];
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didParseObjects:(NSArray *)objects
+{
+    @synchronized(self) {
+        if ([_pendingOperationKeys containsObject:MRBrewBenchmarkOperationKey(operation)]) {
+            [_result setObjectCount:[_result objectCount] + [objects count]];
+        }
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    @synchronized(self) {
+        NSString *key = MRBrewBenchmarkOperationKey(operation);
+        if (![_pendingOperationKeys containsObject:key]) {
+            return;
+        }
+        
+        [_result setFailedOperationCount:[_result failedOperationCount] + 1];
+        
+        NSDate *cancellationDate = [_cancellationDates objectForKey:key];
+        if (cancellationDate) {
+            [_latencies addObject:@(-[cancellationDate timeIntervalSinceNow])];
+        }
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didCollectMetrics:(MRBrewOperationMetrics *)metrics
+{
+    @synchronized(self) {
+        NSString *key = MRBrewBenchmarkOperationKey(operation);
+        if (![_pendingOperationKeys containsObject:key]) {
+            return;
+        }
+        
+        [_pendingOperationKeys removeObject:key];
+        [_result setCompletedOperationCount:[_result completedOperationCount] + 1];
+        [_result setByteCount:[_result byteCount] + [metrics outputByteCount] + [metrics errorOutputByteCount]];
+        [_result setPeakChildResidentSetSize:MAX([_result peakChildResidentSetSize], [metrics peakResidentSetSize])];
+        
+        [_result setDelegateDispatchLag:[_result delegateDispatchLag] + [metrics delegateDispatchLag]];
+        
+        if (!_cancelling) {
+            [_latencies addObject:@([metrics totalDuration])];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,159 @@
+//
+//  MRBrewBenchmarkAllocations.c
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include "MRBrewBenchmarkAllocations.h"
+#include <stddef.h>
+#include <errno.h>
+
+#if defined(__GLIBC__)
+
+/* glibc exports its allocator under these names, so the definitions of malloc
+ * and friends below can count each call and forward it.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *pointer);
+
+static unsigned long long MRBrewBenchmarkAllocations = 0;
+static unsigned long long MRBrewBenchmarkAllocatedBytes = 0;
+static unsigned long long MRBrewBenchmarkFrees = 0;
+
+static void MRBrewBenchmarkCountAllocation(size_t size)
+{
+    __atomic_fetch_add(&MRBrewBenchmarkAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&MRBrewBenchmarkAllocatedBytes, size, __ATOMIC_RELAXED);
+}
+
+static void MRBrewBenchmarkCountFrees(unsigned long long count)
+{
+    __atomic_fetch_add(&MRBrewBenchmarkFrees, count, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size)
+{
+    MRBrewBenchmarkCountAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    MRBrewBenchmarkCountAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    MRBrewBenchmarkCountAllocation(size);
+    
+    // resizing an allocation replaces it, and resizing it to zero frees it
+    if (pointer) {
+        MRBrewBenchmarkCountFrees(size > 0 ? 1 : 2);
+    }
+    
+    return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    MRBrewBenchmarkCountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    MRBrewBenchmarkCountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    
+    MRBrewBenchmarkCountAllocation(size);
+    void *allocation = __libc_memalign(alignment, size);
+    if (!allocation) {
+        return ENOMEM;
+    }
+    
+    *pointer = allocation;
+    return 0;
+}
+
+void free(void *pointer)
+{
+    if (pointer) {
+        MRBrewBenchmarkCountFrees(1);
+    }
+    
+    __libc_free(pointer);
+}
+
+bool MRBrewBenchmarkAllocationCountingIsSupported(void)
+{
+    return true;
+}
+
+unsigned long long MRBrewBenchmarkAllocationCount(void)
+{
+    return __atomic_load_n(&MRBrewBenchmarkAllocations, __ATOMIC_RELAXED);
+}
+
+unsigned long long MRBrewBenchmarkAllocatedByteCount(void)
+{
+    return __atomic_load_n(&MRBrewBenchmarkAllocatedBytes, __ATOMIC_RELAXED);
+}
+
+long long MRBrewBenchmarkLiveAllocationCount(void)
+{
+    return (long long)(__atomic_load_n(&MRBrewBenchmarkAllocations, __ATOMIC_RELAXED) - __atomic_load_n(&MRBrewBenchmarkFrees, __ATOMIC_RELAXED));
+}
+
+#else
+
+bool MRBrewBenchmarkAllocationCountingIsSupported(void)
+{
+    return false;
+}
+
+unsigned long long MRBrewBenchmarkAllocationCount(void)
+{
+    return 0;
+}
+
+unsigned long long MRBrewBenchmarkAllocatedByteCount(void)
+{
+    return 0;
+}
+
+long long MRBrewBenchmarkLiveAllocationCount(void)
+{
+    return 0;
+}
+
+#endif
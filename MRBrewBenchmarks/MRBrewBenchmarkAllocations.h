@@ -0,0 +1,45 @@
+//
+//  MRBrewBenchmarkAllocations.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdbool.h>
+
+/* Counts the memory allocations made by the benchmark process. Counting is
+ * supported where malloc can be interposed (glibc); elsewhere the counts are
+ * always zero and MRBrewBenchmarkAllocationCountingIsSupported() returns false.
+ */
+
+bool MRBrewBenchmarkAllocationCountingIsSupported(void);
+
+/* The number of allocations made since the process started. */
+unsigned long long MRBrewBenchmarkAllocationCount(void);
+
+/* The number of bytes requested by those allocations. */
+unsigned long long MRBrewBenchmarkAllocatedByteCount(void);
+
+/* The number of those allocations that have not been freed, so that the growth
+ * of the memory retained by the process can be told apart from the memory it
+ * allocates and frees.
+ */
+long long MRBrewBenchmarkLiveAllocationCount(void);
@@ -0,0 +1,68 @@
+//
+//  MRBrewBenchmarkResult.h
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/* The measurements taken by a benchmark scenario. */
+@interface MRBrewBenchmarkResult : NSObject
+
+@property (copy) NSString *name;
+@property (assign) NSUInteger operationCount;
+@property (assign) NSUInteger completedOperationCount;
+@property (assign) NSUInteger failedOperationCount;
+@property (assign) NSUInteger objectCount;
+@property (assign) unsigned long long byteCount;
+@property (assign) NSTimeInterval elapsedTime;
+@property (assign, getter=isTimedOut) BOOL timedOut;
+
+/* Latency of each operation, in seconds. */
+@property (copy) NSArray *latencies;
+
+/* Total time the outcomes of the operations waited to be delivered to the
+ * delegate queue, in seconds.
+ */
+@property (assign) NSTimeInterval delegateDispatchLag;
+
+@property (assign) unsigned long long allocationCount;
+@property (assign) unsigned long long allocatedByteCount;
+
+/* The growth in the number of allocations that have not been freed. */
+@property (assign) long long liveAllocationCount;
+
+/* Peak resident set size of the benchmark process, and of the largest brew
+ * process it launched, in bytes.
+ */
+@property (assign) unsigned long long peakResidentSetSize;
+@property (assign) unsigned long long peakChildResidentSetSize;
+
+- (double)operationsPerSecond;
+- (double)bytesPerSecond;
+- (NSTimeInterval)latencyAtPercentile:(double)percentile;
+- (NSTimeInterval)meanDelegateDispatchLag;
+
++ (NSString *)summaryHeader;
+- (NSString *)summary;
+
+@end
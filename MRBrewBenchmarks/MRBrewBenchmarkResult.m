@@ -0,0 +1,97 @@
+//
+//  MRBrewBenchmarkResult.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import "MRBrewBenchmarkResult.h"
+#import "MRBrewBenchmarkAllocations.h"
+
+static const double MRBrewBenchmarkResultMegabyte = 1024.0 * 1024.0;
+
+@implementation MRBrewBenchmarkResult
+
+#pragma mark - Measurements
+
+- (double)operationsPerSecond
+{
+    return [self elapsedTime] > 0 ? [self completedOperationCount] / [self elapsedTime] : 0;
+}
+
+- (double)bytesPerSecond
+{
+    return [self elapsedTime] > 0 ? [self byteCount] / [self elapsedTime] : 0;
+}
+
+- (NSTimeInterval)latencyAtPercentile:(double)percentile
+{
+    NSArray *latencies = [[self latencies] sortedArrayUsingSelector:@selector(compare:)];
+    
+    if ([latencies count] == 0) {
+        return 0;
+    }
+    
+    // nearest rank, so that p100 is the slowest operation
+    NSUInteger rank = (NSUInteger)ceil((MIN(MAX(percentile, 0), 100) / 100.0) * [latencies count]);
+    
+    return [[latencies objectAtIndex:(rank > 0 ? rank - 1 : 0)] doubleValue];
+}
+
+- (NSTimeInterval)meanDelegateDispatchLag
+{
+    return [self completedOperationCount] > 0 ? [self delegateDispatchLag] / [self completedOperationCount] : 0;
+}
+
+#pragma mark - Reporting
+
++ (NSString *)summaryHeader
+{
+    return [NSString stringWithFormat:@"%-24s %6s %10s %9s %9s %9s %9s %10s %9s %9s %9s %9s",
+            "scenario", "ops", "ops/s", "MB/s", "p50 ms", "p99 ms", "lag ms", "allocs", "alloc MB", "live", "RSS MB", "brew MB"];
+}
+
+- (NSString *)summary
+{
+    NSString *allocations = MRBrewBenchmarkAllocationCountingIsSupported() ? [NSString stringWithFormat:@"%llu", [self allocationCount]] : @"n/a";
+    NSString *allocatedBytes = MRBrewBenchmarkAllocationCountingIsSupported() ? [NSString stringWithFormat:@"%.1f", [self allocatedByteCount] / MRBrewBenchmarkResultMegabyte] : @"n/a";
+    NSString *liveAllocations = MRBrewBenchmarkAllocationCountingIsSupported() ? [NSString stringWithFormat:@"%lld", [self liveAllocationCount]] : @"n/a";
+    
+    NSMutableString *summary = [NSMutableString stringWithFormat:@"%-24s %6lu %10.1f %9.2f %9.2f %9.2f %9.3f %10s %9s %9s %9.1f %9.1f",
+                                [[self name] UTF8String], (unsigned long)[self completedOperationCount],
+                                [self operationsPerSecond], [self bytesPerSecond] / MRBrewBenchmarkResultMegabyte,
+                                [self latencyAtPercentile:50] * 1000.0, [self latencyAtPercentile:99] * 1000.0,
+                                [self meanDelegateDispatchLag] * 1000.0, [allocations UTF8String], [allocatedBytes UTF8String],
+                                [liveAllocations UTF8String],
+                                [self peakResidentSetSize] / MRBrewBenchmarkResultMegabyte, [self peakChildResidentSetSize] / MRBrewBenchmarkResultMegabyte];
+    
+    if ([self failedOperationCount] > 0) {
+        [summary appendFormat:@"  (%lu failed)", (unsigned long)[self failedOperationCount]];
+    }
+    
+    if ([self isTimedOut]) {
+        [summary appendFormat:@"  (timed out after %lu of %lu)", (unsigned long)[self completedOperationCount], (unsigned long)[self operationCount]];
+    }
+    
+    return summary;
+}
+
+@end
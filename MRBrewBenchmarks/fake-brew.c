@@ -0,0 +1,270 @@
+//
+//  fake-brew.c
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+/* A stand-in for the brew executable whose behaviour is set by environment
+ * variables, so that benchmarks measure MRBrew rather than Homebrew. Output
+ * depends only on the arguments and the variables below, so every run of a
+ * benchmark does the same work.
+ *
+ *   MRBREW_FAKE_STARTUP_DELAY   microseconds to wait before writing output
+ *   MRBREW_FAKE_OUTPUT_LINES    lines to write to standard output (default 1)
+ *   MRBREW_FAKE_ERROR_LINES     warnings to write to standard error (default 0)
+ *   MRBREW_FAKE_CHUNK_LINES     lines written per write(2) (default: all)
+ *   MRBREW_FAKE_CHUNK_DELAY     microseconds to wait between chunks
+ *   MRBREW_FAKE_EXIT_STATUS     status to exit with (default 0)
+ *   MRBREW_FAKE_IGNORE_SIGNALS  comma separated signals to ignore, e.g. INT,TERM
+ *   MRBREW_FAKE_SIGNAL_DELAY    microseconds to spend cleaning up after SIGINT
+ *                               or SIGTERM before terminating
+ *
+ * The first argument selects the format of the output: list and search write
+ * formula names, options writes install options (two lines per option), info
+ * writes version lines, and anything else writes progress lines.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t FakeBrewReceivedSignal = 0;
+
+static void FakeBrewSignalHandler(int signal)
+{
+    FakeBrewReceivedSignal = signal;
+}
+
+static unsigned long FakeBrewVariable(const char *name, unsigned long defaultValue)
+{
+    const char *value = getenv(name);
+    
+    if (!value || *value == '\0') {
+        return defaultValue;
+    }
+    
+    return strtoul(value, NULL, 10);
+}
+
+/* Sleeps for the specified number of microseconds, returning early if a signal
+ * that should terminate the process is received.
+ */
+static void FakeBrewSleep(unsigned long microseconds)
+{
+    struct timespec remaining = { (time_t)(microseconds / 1000000), (long)(microseconds % 1000000) * 1000 };
+    
+    while (!FakeBrewReceivedSignal && nanosleep(&remaining, &remaining) == -1 && errno == EINTR) {
+        continue;
+    }
+}
+
+/* Terminates the process in response to a signal, after the configured clean
+ * up delay, the way Homebrew does when interrupted.
+ */
+static void FakeBrewTerminateForSignal(int signal)
+{
+    unsigned long delay = FakeBrewVariable("MRBREW_FAKE_SIGNAL_DELAY", 0);
+    struct timespec remaining = { (time_t)(delay / 1000000), (long)(delay % 1000000) * 1000 };
+    
+    while (nanosleep(&remaining, &remaining) == -1 && errno == EINTR) {
+        continue;
+    }
+    
+    static const char message[] = "Error: Interrupted\n";
+    (void)write(STDERR_FILENO, message, sizeof(message) - 1);
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_DFL;
+    sigaction(signal, &action, NULL);
+    raise(signal);
+    _exit(128 + signal);
+}
+
+static void FakeBrewInstallSignalHandlers(void)
+{
+    const char *ignored = getenv("MRBREW_FAKE_IGNORE_SIGNALS");
+    int signals[] = { SIGINT, SIGTERM };
+    const char *names[] = { "INT", "TERM" };
+    
+    for (size_t index = 0; index < sizeof(signals) / sizeof(signals[0]); index++) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        sigemptyset(&action.sa_mask);
+        
+        const char *match = ignored ? strstr(ignored, names[index]) : NULL;
+        size_t length = strlen(names[index]);
+        if (match && (match[length] == '\0' || match[length] == ',')) {
+            action.sa_handler = SIG_IGN;
+        }
+        else {
+            action.sa_handler = FakeBrewSignalHandler;
+        }
+        
+        sigaction(signals[index], &action, NULL);
+    }
+    
+    signal(SIGPIPE, SIG_IGN);
+}
+
+static int FakeBrewWrite(int descriptor, const char *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(descriptor, bytes, length);
+        
+        if (written < 0) {
+            if (errno == EINTR) {
+                if (FakeBrewReceivedSignal) {
+                    return -1;
+                }
+                continue;
+            }
+            return -1;
+        }
+        
+        bytes += written;
+        length -= (size_t)written;
+    }
+    
+    return 0;
+}
+
+/* Appends line number `index` of the output for a command to the buffer. */
+static int FakeBrewFormatLine(char *buffer, size_t size, const char *command, const char *formula, unsigned long index)
+{
+    if (strcmp(command, "list") == 0 || strcmp(command, "search") == 0) {
+        return snprintf(buffer, size, "formula-%06lu\n", index);
+    }
+    
+    if (strcmp(command, "options") == 0) {
+        return snprintf(buffer, size, (index % 2 == 0) ? "--with-option-%06lu\n" : "\tBuild with support for option %06lu\n", index / 2);
+    }
+    
+    if (strcmp(command, "info") == 0) {
+        return snprintf(buffer, size, "%s: stable 1.0.%lu (bottled)\n", formula, index);
+    }
+    
+    if (strcmp(command, "warning") == 0) {
+        return snprintf(buffer, size, "Warning: %s: message %lu\n", formula, index);
+    }
+    
+    if (strcmp(command, "--version") == 0) {
+        return snprintf(buffer, size, "Homebrew 0.9.5\n");
+    }
+    
+    return snprintf(buffer, size, "==> %s %s: step %lu\n", command, formula, index);
+}
+
+/* Writes the specified number of lines to a descriptor, in chunks separated by
+ * the configured delay. Returns the signal that interrupted the output, or 0.
+ */
+static int FakeBrewWriteLines(int descriptor, const char *command, const char *formula, unsigned long lineCount, unsigned long chunkLines, unsigned long chunkDelay)
+{
+    size_t capacity = 4096;
+    char *chunk = malloc(capacity);
+    if (!chunk) {
+        return 0;
+    }
+    
+    unsigned long index = 0;
+    while (index < lineCount) {
+        size_t length = 0;
+        
+        for (unsigned long chunkIndex = 0; chunkIndex < chunkLines && index < lineCount; chunkIndex++, index++) {
+            char line[256];
+            int lineLength = FakeBrewFormatLine(line, sizeof(line), command, formula, index);
+            if (lineLength < 0) {
+                continue;
+            }
+            
+            if ((size_t)lineLength >= sizeof(line)) {
+                lineLength = sizeof(line) - 1;
+            }
+            
+            if (length + (size_t)lineLength > capacity) {
+                char *larger = realloc(chunk, capacity * 2 + (size_t)lineLength);
+                if (!larger) {
+                    free(chunk);
+                    return 0;
+                }
+                chunk = larger;
+                capacity = capacity * 2 + (size_t)lineLength;
+            }
+            
+            memcpy(chunk + length, line, (size_t)lineLength);
+            length += (size_t)lineLength;
+        }
+        
+        if (FakeBrewReceivedSignal || FakeBrewWrite(descriptor, chunk, length) != 0) {
+            break;
+        }
+        
+        if (index < lineCount && chunkDelay > 0) {
+            FakeBrewSleep(chunkDelay);
+        }
+        
+        if (FakeBrewReceivedSignal) {
+            break;
+        }
+    }
+    
+    free(chunk);
+    
+    return FakeBrewReceivedSignal;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *command = argc > 1 ? argv[1] : "help";
+    const char *formula = argc > 2 ? argv[argc - 1] : "formula";
+    
+    FakeBrewInstallSignalHandlers();
+    
+    unsigned long outputLines = FakeBrewVariable("MRBREW_FAKE_OUTPUT_LINES", 1);
+    unsigned long errorLines = FakeBrewVariable("MRBREW_FAKE_ERROR_LINES", 0);
+    unsigned long chunkLines = FakeBrewVariable("MRBREW_FAKE_CHUNK_LINES", 0);
+    unsigned long chunkDelay = FakeBrewVariable("MRBREW_FAKE_CHUNK_DELAY", 0);
+    
+    if (chunkLines == 0) {
+        chunkLines = outputLines > 0 ? outputLines : 1;
+    }
+    
+    FakeBrewSleep(FakeBrewVariable("MRBREW_FAKE_STARTUP_DELAY", 0));
+    
+    if (!FakeBrewReceivedSignal) {
+        FakeBrewWriteLines(STDOUT_FILENO, command, formula, outputLines, chunkLines, chunkDelay);
+    }
+    
+    if (!FakeBrewReceivedSignal && errorLines > 0) {
+        FakeBrewWriteLines(STDERR_FILENO, "warning", formula, errorLines, errorLines, 0);
+    }
+    
+    if (FakeBrewReceivedSignal) {
+        FakeBrewTerminateForSignal(FakeBrewReceivedSignal);
+    }
+    
+    return (int)FakeBrewVariable("MRBREW_FAKE_EXIT_STATUS", 0);
+}
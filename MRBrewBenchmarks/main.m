@@ -0,0 +1,286 @@
+//
+//  main.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "MRBrewBenchmark.h"
+#import "MRBrewBenchmarkResult.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+
+/* Runs the benchmark scenarios against the fake brew executable and prints
+ * a line of measurements for each. Exits with a non-zero status if a scenario
+ * times out, or if its operations do not succeed or fail as expected.
+ *
+ *   MRBrewBenchmarks [--fake-brew PATH] [--scenario NAME ...] [--list]
+ */
+
+typedef MRBrewBenchmarkResult *(^MRBrewBenchmarksScenario)(MRBrewBenchmark *benchmark);
+
+/* Returns operations created by the block, one for each formula named
+ * formula-0 to formula-(count - 1).
+ */
+static NSArray *MRBrewBenchmarksOperations(NSUInteger count, MRBrewOperation *(^operation)(MRBrewFormula *formula))
+{
+    NSMutableArray *operations = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger index = 0; index < count; index++) {
+        [operations addObject:operation([MRBrewFormula formulaWithName:[NSString stringWithFormat:@"formula-%lu", (unsigned long)index]])];
+    }
+    
+    return operations;
+}
+
+/* Returns output in the format written by the fake brew executable. */
+static NSString *MRBrewBenchmarksOutput(NSUInteger lineCount, NSString *format)
+{
+    NSMutableString *output = [NSMutableString stringWithCapacity:lineCount * 24];
+    
+    for (NSUInteger index = 0; index < lineCount; index++) {
+        [output appendFormat:format, (unsigned long)index, (unsigned long)index];
+    }
+    
+    return output;
+}
+
+/* Returns the scenarios in the order they are run, keyed by name. */
+static NSDictionary *MRBrewBenchmarksScenarios(NSArray **names)
+{
+    NSMutableDictionary *scenarios = [NSMutableDictionary dictionary];
+    NSMutableArray *orderedNames = [NSMutableArray array];
+    
+    void (^addScenario)(NSString *, MRBrewBenchmarksScenario) = ^(NSString *name, MRBrewBenchmarksScenario scenario) {
+        [scenarios setObject:[scenario copy] forKey:name];
+        [orderedNames addObject:name];
+    };
+    
+    // parsing alone, without launching brew
+    addScenario(@"parse-list", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureParsingOutput:MRBrewBenchmarksOutput(100000, @"formula-%06lu\n") forOperation:[MRBrewOperation listOperation] chunkLength:0 iterations:20 named:@"parse-list"];
+    });
+    
+    addScenario(@"parse-list-chunked", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureParsingOutput:MRBrewBenchmarksOutput(100000, @"formula-%06lu\n") forOperation:[MRBrewOperation listOperation] chunkLength:4096 iterations:20 named:@"parse-list-chunked"];
+    });
+    
+    addScenario(@"parse-options", ^(MRBrewBenchmark *benchmark) {
+        MRBrewOperation *operation = [MRBrewOperation optionsOperation:[MRBrewFormula formulaWithName:@"formula"]];
+        return [benchmark measureParsingOutput:MRBrewBenchmarksOutput(20000, @"--with-option-%06lu\n\tBuild with support for option %06lu\n") forOperation:operation chunkLength:0 iterations:20 named:@"parse-options"];
+    });
+    
+    // a client that keeps its recent list and search results, whose formulae
+    // are interned, so that the memory it retains stops growing
+    addScenario(@"parse-list-retained", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureRetainingParsedOutput:MRBrewBenchmarksOutput(5000, @"formula-%06lu\n") forOperation:[MRBrewOperation listOperation] retainedResultCount:10 iterations:100 named:@"parse-list-retained"];
+    });
+    
+    addScenario(@"parse-search-retained", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureRetainingParsedOutput:MRBrewBenchmarksOutput(5000, @"formula-%06lu\n") forOperation:[MRBrewOperation searchOperation] retainedResultCount:10 iterations:100 named:@"parse-search-retained"];
+    });
+    
+    // listing installed formulae in-process, rather than launching brew and
+    // parsing its output
+    addScenario(@"list-cellar", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureReadingCellarWithFormulaCount:1000 versionCount:2 iterations:20 named:@"list-cellar"];
+    });
+    
+    // finding outdated formulae in-process, reading every formula file and
+    // then only those that changed (none, between iterations)
+    addScenario(@"outdated-engine", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureFindingOutdatedFormulaeWithFormulaCount:1000 reusesEngine:NO iterations:20 named:@"outdated-engine"];
+    });
+    
+    addScenario(@"outdated-engine-cached", ^(MRBrewBenchmark *benchmark) {
+        return [benchmark measureFindingOutdatedFormulaeWithFormulaCount:1000 reusesEngine:YES iterations:20 named:@"outdated-engine-cached"];
+    });
+    
+    // the cost of launching brew and delivering its outcome
+    addScenario(@"launch", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(200, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation infoOperation:formula];
+        });
+        return [benchmark measureOperations:operations named:@"launch" options:@{}];
+    });
+    
+    // the same, with callbacks delivered on brew's reader threads rather than
+    // the main queue, which measures the cost of the hop to the main queue
+    addScenario(@"launch-inline", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(200, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation infoOperation:formula];
+        });
+        [benchmark setDelegateQueue:nil];
+        MRBrewBenchmarkResult *result = [benchmark measureOperations:operations named:@"launch-inline" options:@{}];
+        [benchmark setDelegateQueue:[NSOperationQueue mainQueue]];
+        return result;
+    });
+    
+    // reading, parsing and delivering large output
+    addScenario(@"large-output", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(4, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation searchOperation:formula];
+        });
+        return [benchmark measureOperations:operations named:@"large-output" options:@{MRBrewBenchmarkOutputLinesOption: @"200000", MRBrewBenchmarkChunkLinesOption: @"1000"}];
+    });
+    
+    // output trickling in, as it does from a slow brew
+    addScenario(@"streaming-output", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(20, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation searchOperation:formula];
+        });
+        return [benchmark measureOperations:operations named:@"streaming-output" options:@{MRBrewBenchmarkOutputLinesOption: @"500", MRBrewBenchmarkChunkLinesOption: @"5", MRBrewBenchmarkChunkDelayOption: @"1000"}];
+    });
+    
+    addScenario(@"streaming-output-inline", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(20, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation searchOperation:formula];
+        });
+        [benchmark setDelegateQueue:nil];
+        MRBrewBenchmarkResult *result = [benchmark measureOperations:operations named:@"streaming-output-inline" options:@{MRBrewBenchmarkOutputLinesOption: @"500", MRBrewBenchmarkChunkLinesOption: @"5", MRBrewBenchmarkChunkDelayOption: @"1000"}];
+        [benchmark setDelegateQueue:[NSOperationQueue mainQueue]];
+        return result;
+    });
+    
+    // operations that modify the installation run one at a time
+    addScenario(@"serial-install", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(50, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation installOperation:formula];
+        });
+        return [benchmark measureOperations:operations named:@"serial-install" options:@{MRBrewBenchmarkStartupDelayOption: @"20000", MRBrewBenchmarkOutputLinesOption: @"20"}];
+    });
+    
+    addScenario(@"failures", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(100, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation infoOperation:formula];
+        });
+        return [benchmark measureOperations:operations named:@"failures" options:@{MRBrewBenchmarkErrorLinesOption: @"20", MRBrewBenchmarkExitStatusOption: @"1"}];
+    });
+    
+    // latency from cancelling an operation until its failure is delivered
+    addScenario(@"cancel", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(20, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation infoOperation:formula];
+        });
+        return [benchmark measureCancellationOfOperations:operations named:@"cancel" options:@{MRBrewBenchmarkOutputLinesOption: @"1000", MRBrewBenchmarkChunkLinesOption: @"1", MRBrewBenchmarkChunkDelayOption: @"10000", MRBrewBenchmarkSignalDelayOption: @"5000"}];
+    });
+    
+    // brew ignores the interrupt, so cancellation escalates to terminate
+    addScenario(@"cancel-escalation", ^(MRBrewBenchmark *benchmark) {
+        NSArray *operations = MRBrewBenchmarksOperations(4, ^(MRBrewFormula *formula) {
+            return [MRBrewOperation infoOperation:formula];
+        });
+        return [benchmark measureCancellationOfOperations:operations named:@"cancel-escalation" options:@{MRBrewBenchmarkOutputLinesOption: @"1000", MRBrewBenchmarkChunkLinesOption: @"1", MRBrewBenchmarkChunkDelayOption: @"10000", MRBrewBenchmarkIgnoreSignalsOption: @"INT"}];
+    });
+    
+    *names = orderedNames;
+    
+    return scenarios;
+}
+
+/* Returns whether a result is as expected for its scenario. */
+static BOOL MRBrewBenchmarksResultIsValid(MRBrewBenchmarkResult *result)
+{
+    if ([result isTimedOut] || [result completedOperationCount] != [result operationCount]) {
+        return NO;
+    }
+    
+    BOOL expectsFailures = [[result name] isEqualToString:@"failures"] || [[result name] hasPrefix:@"cancel"];
+    if (expectsFailures) {
+        return [result failedOperationCount] == [result operationCount];
+    }
+    
+    return [result failedOperationCount] == 0;
+}
+
+static void MRBrewBenchmarksPrint(FILE *stream, NSString *line)
+{
+    fprintf(stream, "%s\n", [line UTF8String]);
+    fflush(stream);
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        NSArray *arguments = [[NSProcessInfo processInfo] arguments];
+        NSString *fakeBrewPath = [[[arguments objectAtIndex:0] stringByDeletingLastPathComponent] stringByAppendingPathComponent:@"fake-brew"];
+        NSMutableArray *selectedNames = [NSMutableArray array];
+        BOOL listing = NO;
+        
+        NSArray *names = nil;
+        NSDictionary *scenarios = MRBrewBenchmarksScenarios(&names);
+        
+        for (NSUInteger index = 1; index < [arguments count]; index++) {
+            NSString *argument = [arguments objectAtIndex:index];
+            
+            if ([argument isEqualToString:@"--fake-brew"] && index + 1 < [arguments count]) {
+                fakeBrewPath = [arguments objectAtIndex:++index];
+            }
+            else if ([argument isEqualToString:@"--scenario"] && index + 1 < [arguments count]) {
+                NSString *name = [arguments objectAtIndex:++index];
+                if (![scenarios objectForKey:name]) {
+                    MRBrewBenchmarksPrint(stderr, [NSString stringWithFormat:@"unknown scenario: %@", name]);
+                    return 2;
+                }
+                [selectedNames addObject:name];
+            }
+            else if ([argument isEqualToString:@"--list"]) {
+                listing = YES;
+            }
+            else {
+                MRBrewBenchmarksPrint(stderr, @"usage: MRBrewBenchmarks [--fake-brew PATH] [--scenario NAME ...] [--list]");
+                return 2;
+            }
+        }
+        
+        if (listing) {
+            for (NSString *name in names) {
+                MRBrewBenchmarksPrint(stdout, name);
+            }
+            return 0;
+        }
+        
+        if (![[NSFileManager defaultManager] isExecutableFileAtPath:fakeBrewPath]) {
+            MRBrewBenchmarksPrint(stderr, [NSString stringWithFormat:@"fake brew executable not found: %@", fakeBrewPath]);
+            return 2;
+        }
+        
+        MRBrewBenchmark *benchmark = [[MRBrewBenchmark alloc] initWithFakeBrewPath:fakeBrewPath];
+        int status = 0;
+        
+        MRBrewBenchmarksPrint(stdout, [MRBrewBenchmarkResult summaryHeader]);
+        for (NSString *name in ([selectedNames count] > 0 ? selectedNames : names)) {
+            @autoreleasepool {
+                MRBrewBenchmarksScenario scenario = [scenarios objectForKey:name];
+                MRBrewBenchmarkResult *result = scenario(benchmark);
+                
+                MRBrewBenchmarksPrint(stdout, [result summary]);
+                if (!MRBrewBenchmarksResultIsValid(result)) {
+                    MRBrewBenchmarksPrint(stderr, [NSString stringWithFormat:@"%@: unexpected outcome", name]);
+                    status = 1;
+                }
+            }
+        }
+        
+        return status;
+    }
+}
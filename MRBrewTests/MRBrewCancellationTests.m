@@ -25,15 +25,26 @@
 
 #import <XCTest/XCTest.h>
 #import <OCMock/OCMock.h>
+#import <signal.h>
+#import <errno.h>
 #import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewDelegate.h"
 #import "MRBrewConstants.h"
 #import "MRBrewWorker.h"
 #import "MRBrew.h"
 #import "MRBrew+Private.h"
 
-@interface MRBrewCancellationTests : XCTestCase {
+static const NSUInteger MRBrewCancellationTestsStressOperationCount = 50;
+static const NSTimeInterval MRBrewCancellationTestsGracePeriod = 0.25;
+static const NSTimeInterval MRBrewCancellationTestsDeadline = 5.0;
+
+@interface MRBrewCancellationTests : XCTestCase <MRBrewDelegate> {
     NSMutableArray *_mockWorkers;
     NSArray *_operationIdentifiers;
+    NSUInteger _failedOperationCount;
+    NSTimeInterval _originalInterruptGracePeriod;
+    NSTimeInterval _originalTerminationGracePeriod;
 }
 
 @end
@@ -52,6 +63,9 @@
                               MRBrewOperationRemoveIdentifier,
                               MRBrewOperationSearchIdentifier,
                               MRBrewOperationUpdateIdentifier];
+    
+    _originalInterruptGracePeriod = [[MRBrew sharedBrew] interruptGracePeriod];
+    _originalTerminationGracePeriod = [[MRBrew sharedBrew] terminationGracePeriod];
 }
 
 - (void)tearDown
@@ -59,6 +73,9 @@
    [_mockWorkers removeAllObjects];
    _mockWorkers = nil;
     
+    [[MRBrew sharedBrew] setInterruptGracePeriod:_originalInterruptGracePeriod];
+    [[MRBrew sharedBrew] setTerminationGracePeriod:_originalTerminationGracePeriod];
+    
     [super tearDown];
 }
 
@@ -252,4 +269,149 @@
     }
 }
 
+#pragma mark - Cancelling Running Operations
+
+- (void)testCancelAllOperationsKillsRunningProcessGroupsWithinDeadline
+{
+    // setup: a brew that ignores interrupts and termination, as do the
+    // processes it launches, so that cancellation must escalate to killing
+    // the process group
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    NSString *brewPath = [directory stringByAppendingPathComponent:@"brew"];
+    NSString *identifiersPath = [directory stringByAppendingPathComponent:@"pids"];
+    
+    NSString *script = [NSString stringWithFormat:@"#!/bin/sh\ntrap '' INT TERM\n/bin/sleep 60 &\necho $! >> '%@'\necho started\nwait\n", identifiersPath];
+    [script writeToFile:brewPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:brewPath error:nil];
+    
+    NSString *originalBrewPath = [[MRBrew sharedBrew] brewPath];
+    NSOperationQueue *originalQueue = [[MRBrew sharedBrew] backgroundQueue];
+    NSOperationQueue *queue = [[NSOperationQueue alloc] init];
+    [queue setMaxConcurrentOperationCount:MRBrewCancellationTestsStressOperationCount];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    [[MRBrew sharedBrew] setBrewPath:brewPath];
+    [[MRBrew sharedBrew] setInterruptGracePeriod:MRBrewCancellationTestsGracePeriod];
+    [[MRBrew sharedBrew] setTerminationGracePeriod:MRBrewCancellationTestsGracePeriod];
+    _failedOperationCount = 0;
+    
+    for (NSUInteger index = 0; index < MRBrewCancellationTestsStressOperationCount; index++) {
+        MRBrewFormula *formula = [MRBrewFormula formulaWithName:[NSString stringWithFormat:@"formula-%lu", (unsigned long)index]];
+        [[MRBrew sharedBrew] performOperation:[MRBrewOperation infoOperation:formula] delegate:self];
+    }
+    
+    // wait for every brew to have launched its child process
+    NSArray *childIdentifiers = @[];
+    NSDate *launchTimeout = [NSDate dateWithTimeIntervalSinceNow:30.0];
+    while ([childIdentifiers count] < MRBrewCancellationTestsStressOperationCount && [launchTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        NSString *identifiers = [NSString stringWithContentsOfFile:identifiersPath encoding:NSUTF8StringEncoding error:nil];
+        childIdentifiers = [[identifiers componentsSeparatedByString:@"\n"] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"length > 0"]];
+    }
+    
+    // execute
+    NSDate *cancelDate = [NSDate date];
+    [[MRBrew sharedBrew] cancelAllOperations];
+    
+    NSDate *deadline = [cancelDate dateByAddingTimeInterval:MRBrewCancellationTestsDeadline];
+    while (_failedOperationCount < MRBrewCancellationTestsStressOperationCount && [deadline timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    NSTimeInterval cancellationTime = -[cancelDate timeIntervalSinceNow];
+    
+    // killed children are reaped by their new parent shortly after they exit
+    NSMutableArray *survivingIdentifiers = [NSMutableArray array];
+    NSDate *reapTimeout = [NSDate dateWithTimeIntervalSinceNow:2.0];
+    do {
+        [survivingIdentifiers removeAllObjects];
+        for (NSString *identifier in childIdentifiers) {
+            if (kill((pid_t)[identifier intValue], 0) == 0 || errno != ESRCH) {
+                [survivingIdentifiers addObject:identifier];
+            }
+        }
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    } while ([survivingIdentifiers count] > 0 && [reapTimeout timeIntervalSinceNow] > 0);
+    
+    // verify
+    XCTAssertEqual([childIdentifiers count], MRBrewCancellationTestsStressOperationCount, @"Every operation should have launched a child process before being cancelled.");
+    XCTAssertEqual(_failedOperationCount, MRBrewCancellationTestsStressOperationCount, @"Every cancelled operation should fail within the deadline (took %.2fs).", cancellationTime);
+    XCTAssertEqual([survivingIdentifiers count], (NSUInteger)0, @"No process launched by a cancelled operation should be left running: %@", survivingIdentifiers);
+    
+    // cleanup
+    for (NSString *identifier in survivingIdentifiers) {
+        kill((pid_t)[identifier intValue], SIGKILL);
+    }
+    [[MRBrew sharedBrew] setBrewPath:originalBrewPath];
+    [[MRBrew sharedBrew] setBackgroundQueue:originalQueue];
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testCancelledOperationKillsProcessesLeftInGroupWhenBrewExits
+{
+    // setup: a brew that exits when interrupted, leaving a process it launched
+    // that ignores interrupts and termination
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    NSString *brewPath = [directory stringByAppendingPathComponent:@"brew"];
+    NSString *identifiersPath = [directory stringByAppendingPathComponent:@"pids"];
+    
+    NSString *script = [NSString stringWithFormat:@"#!/bin/sh\n/bin/sh -c \"trap '' INT TERM; exec /bin/sleep 60\" &\necho $! >> '%@'\necho started\nwait\n", identifiersPath];
+    [script writeToFile:brewPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:brewPath error:nil];
+    
+    NSString *originalBrewPath = [[MRBrew sharedBrew] brewPath];
+    NSOperationQueue *originalQueue = [[MRBrew sharedBrew] backgroundQueue];
+    [[MRBrew sharedBrew] setBackgroundQueue:[[NSOperationQueue alloc] init]];
+    [[MRBrew sharedBrew] setBrewPath:brewPath];
+    [[MRBrew sharedBrew] setInterruptGracePeriod:MRBrewCancellationTestsDeadline];
+    [[MRBrew sharedBrew] setTerminationGracePeriod:MRBrewCancellationTestsDeadline];
+    _failedOperationCount = 0;
+    
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"formula"]] delegate:self];
+    
+    NSString *childIdentifier = nil;
+    NSDate *launchTimeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+    while ([childIdentifier length] == 0 && [launchTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        childIdentifier = [[NSString stringWithContentsOfFile:identifiersPath encoding:NSUTF8StringEncoding error:nil] stringByTrimmingCharactersInSet:[NSCharacterSet newlineCharacterSet]];
+    }
+    
+    // execute
+    [[MRBrew sharedBrew] cancelAllOperations];
+    
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:MRBrewCancellationTestsDeadline];
+    while (_failedOperationCount < 1 && [deadline timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    BOOL childSurvived;
+    NSDate *reapTimeout = [NSDate dateWithTimeIntervalSinceNow:2.0];
+    do {
+        childSurvived = kill((pid_t)[childIdentifier intValue], 0) == 0 || errno != ESRCH;
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    } while (childSurvived && [reapTimeout timeIntervalSinceNow] > 0);
+    
+    // verify
+    XCTAssertTrue([childIdentifier length] > 0, @"The operation should have launched a child process before being cancelled.");
+    XCTAssertEqual(_failedOperationCount, (NSUInteger)1, @"The cancelled operation should fail once brew has exited.");
+    XCTAssertFalse(childSurvived, @"A process left in the group of a cancelled brew should be killed when brew exits.");
+    
+    // cleanup
+    if (childSurvived) {
+        kill((pid_t)[childIdentifier intValue], SIGKILL);
+    }
+    [[MRBrew sharedBrew] setBrewPath:originalBrewPath];
+    [[MRBrew sharedBrew] setBackgroundQueue:originalQueue];
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+#pragma mark - MRBrewDelegate protocol
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    if ([error code] == MRBrewErrorOperationCancelled) {
+        _failedOperationCount++;
+    }
+}
+
 @end
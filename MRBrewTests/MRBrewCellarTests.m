@@ -0,0 +1,106 @@
+//
+//  MRBrewCellarTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <XCTest/XCTest.h>
+#import "MRBrewCellar.h"
+#import "MRBrewFormula.h"
+
+@interface MRBrewCellarTests : XCTestCase
+{
+    NSString *_cellarPath;
+}
+
+@end
+
+@implementation MRBrewCellarTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // a synthetic Cellar, with files in kegs that are never read
+    _cellarPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    for (NSString *kegPath in @[@"wget/1.9/bin", @"wget/1.15/bin", @"git/1.9.0/bin", @"empty"]) {
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_cellarPath stringByAppendingPathComponent:kegPath] withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    [[NSData data] writeToFile:[_cellarPath stringByAppendingPathComponent:@".DS_Store"] atomically:NO];
+    [[NSData data] writeToFile:[_cellarPath stringByAppendingPathComponent:@"wget/.DS_Store"] atomically:NO];
+    [[NSData data] writeToFile:[_cellarPath stringByAppendingPathComponent:@"wget/1.15/bin/wget"] atomically:NO];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:_cellarPath error:NULL];
+    _cellarPath = nil;
+    
+    [super tearDown];
+}
+
+#pragma mark - Installed Formulae
+
+- (void)testInstalledVersionsAreReadFromRacks
+{
+    // setup
+    MRBrewCellar *cellar = [MRBrewCellar cellarWithPath:_cellarPath];
+    
+    // execute
+    NSDictionary *installedVersions = [cellar installedVersionsWithError:NULL];
+    
+    // verify
+    NSDictionary *expectedVersions = @{ @"wget" : @[@"1.9", @"1.15"], @"git" : @[@"1.9.0"], @"empty" : @[] };
+    XCTAssertEqualObjects(installedVersions, expectedVersions, @"Should read the versions in each rack in version order, ignoring hidden files.");
+}
+
+- (void)testInstalledFormulaeAreSortedByName
+{
+    // setup
+    MRBrewCellar *cellar = [MRBrewCellar cellarWithPath:_cellarPath];
+    
+    // execute
+    NSArray *formulae = [cellar installedFormulaeWithError:NULL];
+    
+    // verify
+    XCTAssertEqualObjects([formulae valueForKey:@"name"], (@[@"empty", @"git", @"wget"]), @"Should list every rack, sorted by name, as brew list does.");
+    XCTAssertTrue([[formulae lastObject] isInstalled], @"Formulae should be installed.");
+    XCTAssertEqualObjects([[formulae lastObject] installedVersions], (@[@"1.9", @"1.15"]), @"Formulae should include their installed versions.");
+}
+
+- (void)testMissingCellarReturnsError
+{
+    // setup
+    MRBrewCellar *cellar = [MRBrewCellar cellarWithPath:[_cellarPath stringByAppendingPathComponent:@"missing"]];
+    NSError *error = nil;
+    
+    // execute
+    NSArray *formulae = [cellar installedFormulaeWithError:&error];
+    
+    // verify
+    XCTAssertNil(formulae, @"Should not return formulae for a missing Cellar.");
+    XCTAssertEqualObjects([error domain], NSPOSIXErrorDomain, @"Should return a POSIX error.");
+    XCTAssertEqual([error code], (NSInteger)ENOENT, @"Should return the error that occurred reading the Cellar.");
+}
+
+@end
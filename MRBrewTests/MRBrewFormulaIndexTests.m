@@ -0,0 +1,283 @@
+//
+//  MRBrewFormulaIndexTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewFormulaIndex.h"
+#import "MRBrewFormula.h"
+
+@interface MRBrewFormulaIndexTests : XCTestCase
+{
+    MRBrewFormulaIndex *_index;
+    NSString *_temporaryDirectory;
+}
+
+@end
+
+@implementation MRBrewFormulaIndexTests
+
+static NSString * const MRBrewFormulaIndexTestsSearchOutput = @"curl\nlibxml2\nwget\nwgetpaste\nhomebrew/dupes/zlib\n";
+static NSString * const MRBrewFormulaIndexTestsListOutput = @"wget\n";
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _index = [MRBrewFormulaIndex indexWithSearchOutput:MRBrewFormulaIndexTestsSearchOutput listOutput:MRBrewFormulaIndexTestsListOutput];
+    
+    _temporaryDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:_temporaryDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:_temporaryDirectory error:NULL];
+    
+    [super tearDown];
+}
+
+#pragma mark - Building
+
+- (void)testIndexContainsEachFormulaFromSearchOutput
+{
+    // execute & verify
+    XCTAssertEqual([_index count], (NSUInteger)5, @"Should contain one entry for each formula name in the search output.");
+}
+
+- (void)testIndexBuiltFromEmptySearchResultsIsEmpty
+{
+    // setup
+    MRBrewFormulaIndex *index = [MRBrewFormulaIndex indexWithSearchOutput:@"No formula found for \"zzz\".\n" listOutput:nil];
+    
+    // execute & verify
+    XCTAssertEqual([index count], (NSUInteger)0, @"Should not contain entries for an empty search result.");
+}
+
+#pragma mark - Queries
+
+- (void)testFormulaWithNameReturnsExactMatch
+{
+    // execute
+    MRBrewFormula *formula = [_index formulaWithName:@"wget"];
+    
+    // verify
+    XCTAssertEqualObjects([formula name], @"wget", @"Should return the formula with the specified name.");
+    XCTAssertTrue([formula isInstalled], @"Formula listed by the list operation should be installed.");
+}
+
+- (void)testFormulaWithNameReturnsNilForPrefixOfName
+{
+    // execute & verify
+    XCTAssertNil([_index formulaWithName:@"wge"], @"Should not return a formula whose name only begins with the specified name.");
+    XCTAssertNil([_index formulaWithName:@"aaa"], @"Should not return a formula for an unknown name.");
+}
+
+- (void)testFormulaeWithPrefixReturnsSortedMatches
+{
+    // execute
+    NSArray *formulae = [_index formulaeWithPrefix:@"wget"];
+    
+    // verify
+    XCTAssertEqualObjects([formulae valueForKey:@"name"], (@[@"wget", @"wgetpaste"]), @"Should return each formula whose name begins with the prefix, sorted by name.");
+    XCTAssertFalse([[formulae objectAtIndex:1] isInstalled], @"Formula not listed by the list operation should not be installed.");
+}
+
+- (void)testFormulaeContainingStringReturnsSortedMatches
+{
+    // execute
+    NSArray *formulae = [_index formulaeContainingString:@"l"];
+    
+    // verify
+    XCTAssertEqualObjects([formulae valueForKey:@"name"], (@[@"curl", @"homebrew/dupes/zlib", @"libxml2"]), @"Should return each formula whose name contains the string once, sorted by name.");
+}
+
+- (void)testFormulaeContainingStringWithNoMatchesIsEmpty
+{
+    // execute & verify
+    XCTAssertEqual([[_index formulaeContainingString:@"ruby"] count], (NSUInteger)0, @"Should return an empty array when no name contains the string.");
+}
+
+#pragma mark - Persistence
+
+- (void)testIndexWrittenToFileCanBeLoaded
+{
+    // setup
+    NSString *path = [_temporaryDirectory stringByAppendingPathComponent:@"formula.index"];
+    XCTAssertTrue([_index writeToFile:path error:nil], @"Should write the index to a file.");
+    
+    // execute
+    NSError *error = nil;
+    MRBrewFormulaIndex *index = [MRBrewFormulaIndex indexWithContentsOfFile:path error:&error];
+    
+    // verify
+    XCTAssertNotNil(index, @"Should load an index from a file written by the index. Error: %@", error);
+    XCTAssertEqualObjects([index path], path, @"Should record the path the index was loaded from.");
+    XCTAssertEqualObjects([[index formulaeWithPrefix:@"w"] valueForKey:@"name"], (@[@"wget", @"wgetpaste"]), @"Loaded index should answer queries.");
+}
+
+- (void)testLoadingInvalidFileFails
+{
+    // setup
+    NSString *path = [_temporaryDirectory stringByAppendingPathComponent:@"invalid.index"];
+    [[@"wget\n" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path atomically:YES];
+    
+    // execute
+    NSError *error = nil;
+    MRBrewFormulaIndex *index = [MRBrewFormulaIndex indexWithContentsOfFile:path error:&error];
+    
+    // verify
+    XCTAssertNil(index, @"Should not load a file that is not a formula index.");
+    XCTAssertEqual([error code], (NSInteger)MRBrewFormulaIndexErrorInvalidFormat, @"Error code should indicate an invalid format.");
+}
+
+- (void)testLoadingTruncatedFileFails
+{
+    // setup
+    NSString *path = [_temporaryDirectory stringByAppendingPathComponent:@"truncated.index"];
+    [_index writeToFile:path error:nil];
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    [[data subdataWithRange:NSMakeRange(0, [data length] - 4)] writeToFile:path atomically:YES];
+    
+    // execute
+    NSError *error = nil;
+    MRBrewFormulaIndex *index = [MRBrewFormulaIndex indexWithContentsOfFile:path error:&error];
+    
+    // verify
+    XCTAssertNil(index, @"Should not load a truncated index.");
+    XCTAssertEqual([error code], (NSInteger)MRBrewFormulaIndexErrorInvalidFormat, @"Error code should indicate an invalid format.");
+}
+
+- (void)testLoadingFileWithOutOfOrderNamesFails
+{
+    // setup: the second entry refers to the name of the first
+    NSString *path = [_temporaryDirectory stringByAppendingPathComponent:@"reordered.index"];
+    [_index writeToFile:path error:nil];
+    NSMutableData *data = [NSMutableData dataWithContentsOfFile:path];
+    uint32_t nameOffset = 0;
+    [data replaceBytesInRange:NSMakeRange(5 * sizeof(uint32_t) + 12, sizeof(nameOffset)) withBytes:&nameOffset];
+    [data writeToFile:path atomically:YES];
+    
+    // execute
+    NSError *error = nil;
+    MRBrewFormulaIndex *index = [MRBrewFormulaIndex indexWithContentsOfFile:path error:&error];
+    
+    // verify
+    XCTAssertNil(index, @"Should not load an index whose names are not laid out in entry order.");
+    XCTAssertEqual([error code], (NSInteger)MRBrewFormulaIndexErrorInvalidFormat, @"Error code should indicate an invalid format.");
+}
+
+#pragma mark - Updating
+
+- (void)testUpdateAddsAndRemovesFormulaeForDirectory
+{
+    // setup
+    NSString *directory = [_temporaryDirectory stringByAppendingPathComponent:@"Formula"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSData data] writeToFile:[directory stringByAppendingPathComponent:@"aria2.rb"] atomically:YES];
+    [[NSData data] writeToFile:[directory stringByAppendingPathComponent:@"wget.rb"] atomically:YES];
+    [_index updateFormulaeInDirectory:directory];
+    
+    // execute
+    [[NSFileManager defaultManager] removeItemAtPath:[directory stringByAppendingPathComponent:@"aria2.rb"] error:NULL];
+    [_index brewChangeDidOccur:@[directory]];
+    
+    // verify
+    XCTAssertNil([_index formulaWithName:@"aria2"], @"Should remove a formula whose file was removed from the directory.");
+    XCTAssertNotNil([_index formulaWithName:@"wget"], @"Should retain formulae whose files remain in the directory.");
+    XCTAssertTrue([[_index formulaWithName:@"wget"] isInstalled], @"Should retain the installed state of existing formulae.");
+    XCTAssertNotNil([_index formulaWithName:@"curl"], @"Should retain formulae from other sources.");
+}
+
+- (void)testChangesToSeveralFilesUpdateEachDirectory
+{
+    // setup
+    NSString *directory = [_temporaryDirectory stringByAppendingPathComponent:@"Formula"];
+    NSString *tapDirectory = [_temporaryDirectory stringByAppendingPathComponent:@"Taps/homebrew/homebrew-science"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:tapDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+    NSArray *paths = @[[directory stringByAppendingPathComponent:@"aria2.rb"],
+                       [directory stringByAppendingPathComponent:@"zsh.rb"],
+                       [tapDirectory stringByAppendingPathComponent:@"samtools.rb"]];
+    for (NSString *path in paths) {
+        [[NSData data] writeToFile:path atomically:YES];
+    }
+    
+    // execute
+    [_index brewChangeDidOccur:paths];
+    
+    // verify
+    XCTAssertEqual([_index count], (NSUInteger)8, @"Should add each formula once.");
+    XCTAssertEqualObjects([[_index formulaeWithPrefix:@""] valueForKey:@"name"], (@[@"aria2", @"curl", @"homebrew/dupes/zlib", @"homebrew/science/samtools", @"libxml2", @"wget", @"wgetpaste", @"zsh"]), @"Should keep the entries sorted by name.");
+    XCTAssertTrue([[_index formulaWithName:@"wget"] isInstalled], @"Should retain the installed state of existing formulae.");
+}
+
+- (void)testChangeInCellarUpdatesInstalledFormulae
+{
+    // setup
+    NSString *cellarPath = [_temporaryDirectory stringByAppendingPathComponent:@"Cellar"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"curl/7.36.0"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"wget"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    // execute
+    [_index brewChangeDidOccur:@[[cellarPath stringByAppendingPathComponent:@"curl"]]];
+    
+    // verify
+    XCTAssertTrue([[_index formulaWithName:@"curl"] isInstalled], @"Should mark a formula installed once it has a keg in the Cellar.");
+    XCTAssertFalse([[_index formulaWithName:@"wget"] isInstalled], @"Should mark a formula whose rack has no kegs as not installed.");
+    XCTAssertEqual([_index count], (NSUInteger)5, @"Should not add or remove formulae for a change in the Cellar.");
+}
+
+- (void)testUpdateNamesTapFormulaeWithTapPrefix
+{
+    // setup
+    NSString *directory = [_temporaryDirectory stringByAppendingPathComponent:@"Taps/homebrew/homebrew-science"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSData data] writeToFile:[directory stringByAppendingPathComponent:@"samtools.rb"] atomically:YES];
+    
+    // execute
+    [_index updateFormulaeInDirectory:directory];
+    
+    // verify
+    XCTAssertNotNil([_index formulaWithName:@"homebrew/science/samtools"], @"Should name tap formulae using the tap's user/repository prefix.");
+}
+
+- (void)testUpdateRewritesIndexFile
+{
+    // setup
+    NSString *path = [_temporaryDirectory stringByAppendingPathComponent:@"formula.index"];
+    NSString *directory = [_temporaryDirectory stringByAppendingPathComponent:@"Formula"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSData data] writeToFile:[directory stringByAppendingPathComponent:@"aria2.rb"] atomically:YES];
+    [_index writeToFile:path error:nil];
+    
+    // execute
+    [_index updateFormulaeInDirectory:directory];
+    
+    // verify
+    XCTAssertNotNil([[MRBrewFormulaIndex indexWithContentsOfFile:path error:nil] formulaWithName:@"aria2"], @"Should rewrite the index file after an update.");
+}
+
+@end
@@ -0,0 +1,179 @@
+//
+//  MRBrewFormulaJSONDecoderTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewFormulaJSONDecoder.h"
+#import "MRBrewFormula.h"
+
+@interface MRBrewFormulaJSONDecoderTests : XCTestCase
+{
+    NSMutableArray *_decodedFormulae;
+    NSUInteger _handlerCallCount;
+}
+
+@end
+
+@implementation MRBrewFormulaJSONDecoderTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _decodedFormulae = [NSMutableArray array];
+    _handlerCallCount = 0;
+}
+
+- (MRBrewFormulaJSONDecoder *)decoder
+{
+    return [[MRBrewFormulaJSONDecoder alloc] initWithHandler:^(NSArray *formulae) {
+        [_decodedFormulae addObjectsFromArray:formulae];
+        _handlerCallCount++;
+    }];
+}
+
+#pragma mark - Decoding
+
+- (void)testInfoOutputIsDecodedIntoFormulae
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    NSString *output = @"[{\"name\":\"wget\",\"full_name\":\"wget\",\"desc\":null,\"versions\":{\"stable\":\"1.16\",\"bottle\":true,\"devel\":null,\"head\":\"HEAD\"},\"revision\":0,"
+                        "\"installed\":[{\"version\":\"1.15\",\"used_options\":[],\"built_as_bottle\":true},{\"version\":\"1.16\",\"used_options\":[\"--with-debug\"]}],"
+                        "\"linked_keg\":\"1.16\",\"keg_only\":false,\"dependencies\":[\"openssl\",\"libidn\"],\"conflicts_with\":[],\"caveats\":null,"
+                        "\"requirements\":[{\"name\":\"x11\",\"version\":\"2.7\"}],\"options\":[{\"option\":\"--with-debug\",\"description\":\"Build with \\\"debug\\\" symbols\"}]},"
+                        "{\"name\":\"git\",\"versions\":{\"stable\":\"2.1.2\"},\"installed\":[],\"dependencies\":[]}]\n";
+    
+    // execute
+    [decoder appendString:output];
+    BOOL valid = [decoder finish];
+    
+    // verify
+    XCTAssertTrue(valid, @"Info output should be valid JSON.");
+    XCTAssertEqual([_decodedFormulae count], (NSUInteger)2, @"Should decode a formula for each object in the output.");
+    
+    MRBrewFormula *wget = [_decodedFormulae objectAtIndex:0];
+    XCTAssertEqualObjects([wget name], @"wget", @"Should decode the formula name.");
+    XCTAssertEqualObjects([wget version], @"1.16", @"Should decode the stable version.");
+    XCTAssertEqualObjects([wget installedVersions], (@[@"1.15", @"1.16"]), @"Should decode each installed version.");
+    XCTAssertEqualObjects([wget dependencies], (@[@"openssl", @"libidn"]), @"Should decode the dependencies without those of nested values.");
+    XCTAssertTrue([wget isInstalled], @"A formula with installed versions should be installed.");
+    
+    MRBrewFormula *git = [_decodedFormulae objectAtIndex:1];
+    XCTAssertEqualObjects([git installedVersions], @[], @"Should decode an empty array of installed versions.");
+    XCTAssertFalse([git isInstalled], @"A formula without installed versions should not be installed.");
+}
+
+- (void)testOutputAppendedAByteAtATimeIsDecoded
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    NSData *output = [@"[{\"name\":\"caf\\u00e9\",\"versions\":{\"stable\":\"1.0\"}},{\"name\":\"\u00fcml\\ud83c\\udf7a\",\"installed\":[{\"version\":\"2.0\"}]}]" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    // execute
+    for (NSUInteger i = 0; i < [output length]; i++) {
+        [decoder appendData:[output subdataWithRange:NSMakeRange(i, 1)]];
+    }
+    BOOL valid = [decoder finish];
+    
+    // verify
+    XCTAssertTrue(valid, @"Output split into single bytes should be valid JSON.");
+    XCTAssertEqualObjects([_decodedFormulae valueForKey:@"name"], (@[@"caf\u00e9", @"\u00fcml\U0001F37A"]), @"Should decode escaped and multibyte characters split across chunks.");
+    XCTAssertEqual(_handlerCallCount, (NSUInteger)2, @"Should deliver each formula once it is completed.");
+}
+
+- (void)testEmptyArrayIsValidAndYieldsNoFormulae
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    
+    // execute
+    [decoder appendString:@" [ ] "];
+    
+    // verify
+    XCTAssertTrue([decoder finish], @"An empty array should be valid JSON.");
+    XCTAssertEqual(_handlerCallCount, (NSUInteger)0, @"Should not call the handler when no formulae are decoded.");
+}
+
+- (void)testObjectWithoutNameYieldsNoFormula
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    
+    // execute
+    [decoder appendString:@"[{\"versions\":{\"stable\":\"1.0\"}}]"];
+    
+    // verify
+    XCTAssertTrue([decoder finish], @"An object without a name should be valid JSON.");
+    XCTAssertEqual([_decodedFormulae count], (NSUInteger)0, @"Should not decode a formula without a name.");
+}
+
+#pragma mark - Invalid Output
+
+- (void)testIncompleteOutputIsInvalid
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    
+    // execute
+    [decoder appendString:@"[{\"name\":\"wget\"}"];
+    
+    // verify
+    XCTAssertTrue([decoder isValid], @"Incomplete output should be valid until the decoder is finished.");
+    XCTAssertFalse([decoder finish], @"Incomplete output should be invalid once the decoder is finished.");
+}
+
+- (void)testMalformedOutputIsInvalid
+{
+    // setup
+    NSArray *outputs = @[@"", @"[,]", @"[1,]", @"[{\"name\" \"wget\"}]", @"[{\"name\":\"wget\"]", @"[tru]", @"[{\"name\":\"\\x\"}]", @"[] []", @"Error: No available formula"];
+    
+    for (NSString *output in outputs) {
+        MRBrewFormulaJSONDecoder *decoder = [self decoder];
+        
+        // execute
+        [decoder appendString:output];
+        
+        // verify
+        XCTAssertFalse([decoder finish], @"Malformed output '%@' should be invalid.", output);
+    }
+}
+
+- (void)testOutputAfterInvalidTokenIsIgnored
+{
+    // setup
+    MRBrewFormulaJSONDecoder *decoder = [self decoder];
+    
+    // execute
+    [decoder appendString:@"[{\"name\":\"wget\"}}"];
+    [decoder appendString:@",{\"name\":\"git\"}]"];
+    
+    // verify
+    XCTAssertFalse([decoder isValid], @"Output with a mismatched bracket should be invalid.");
+    XCTAssertEqualObjects([_decodedFormulae valueForKey:@"name"], (@[@"wget"]), @"Should not decode formulae after an invalid token.");
+}
+
+@end
@@ -190,6 +190,37 @@
     XCTAssertFalse([formula1 isEqualToFormula:formula2], @"Formulae that have a different 'installed' property should not be equal.");
 }
 
+- (void)testEqualityOfFormulaeWithDifferentVersionProperty
+{
+    MRBrewFormula *formula1 = [MRBrewFormula formulaWithName:@"formula-name"];
+    MRBrewFormula *formula2 = [MRBrewFormula formulaWithName:@"formula-name"];
+    [formula2 setVersion:@"1.0"];
+    
+    // execute & verify
+    XCTAssertFalse([formula1 isEqualToFormula:formula2], @"Formulae that have a different 'version' property should not be equal.");
+}
+
+- (void)testEqualityOfFormulaeWithDifferentInstalledVersionsProperty
+{
+    MRBrewFormula *formula1 = [MRBrewFormula formulaWithName:@"formula-name"];
+    MRBrewFormula *formula2 = [MRBrewFormula formulaWithName:@"formula-name"];
+    [formula1 setInstalledVersions:@[@"1.0"]];
+    [formula2 setInstalledVersions:@[@"1.0", @"1.1"]];
+    
+    // execute & verify
+    XCTAssertFalse([formula1 isEqualToFormula:formula2], @"Formulae that have a different 'installedVersions' property should not be equal.");
+}
+
+- (void)testEqualityOfFormulaeWithDifferentDependenciesProperty
+{
+    MRBrewFormula *formula1 = [MRBrewFormula formulaWithName:@"formula-name"];
+    MRBrewFormula *formula2 = [MRBrewFormula formulaWithName:@"formula-name"];
+    [formula2 setDependencies:@[@"dependency"]];
+    
+    // execute & verify
+    XCTAssertFalse([formula1 isEqualToFormula:formula2], @"Formulae that have a different 'dependencies' property should not be equal.");
+}
+
 - (void)testEqualityOfFormulaWithNil
 {
     // setup
@@ -209,6 +240,72 @@
     XCTAssertFalse([formula isEqualToFormula:string], @"Formulae should never be equal to objects of another class.");
 }
 
+- (void)testEqualFormulaeHaveEqualHashes
+{
+    // setup
+    MRBrewFormula *formula1 = [MRBrewFormula formulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    MRBrewFormula *formula2 = [MRBrewFormula formulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    
+    // execute & verify
+    XCTAssertEqualObjects(formula1, formula2, @"Formulae with equal properties should be equal.");
+    XCTAssertEqual([formula1 hash], [formula2 hash], @"Equal formulae should have equal hashes.");
+    XCTAssertEqual([[NSSet setWithObjects:formula1, formula2, nil] count], (NSUInteger)1, @"Equal formulae should be the same member of a set.");
+}
+
+#pragma mark - Interning
+
+- (void)testInternedFormulaIsSharedForNameAndStatus
+{
+    // execute
+    MRBrewFormula *formula1 = [MRBrewFormula internedFormulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    MRBrewFormula *formula2 = [MRBrewFormula internedFormulaWithName:[NSMutableString stringWithString:@"formula-name"] isNew:NO isUpdated:NO isInstalled:YES];
+    MRBrewFormula *formula3 = [MRBrewFormula internedFormulaWithName:@"formula-name"];
+    
+    // verify
+    XCTAssertEqual(formula1, formula2, @"Should return the same formula for the same name and status.");
+    XCTAssertNotEqual(formula1, formula3, @"Should return a different formula for a different status.");
+    XCTAssertFalse([formula3 isInstalled], @"Interned formula should have the requested status.");
+}
+
+- (void)testInternedFormulaIsImmutable
+{
+    // setup
+    MRBrewFormula *formula = [MRBrewFormula internedFormulaWithName:@"formula-name"];
+    
+    // execute & verify
+    XCTAssertTrue([formula isImmutable], @"Interned formula should be immutable.");
+    XCTAssertFalse([[MRBrewFormula formulaWithName:@"formula-name"] isImmutable], @"Formula should be mutable.");
+    XCTAssertThrowsSpecificNamed([formula setIsInstalled:YES], NSException, NSInternalInconsistencyException, @"Changing an interned formula should raise an exception.");
+    XCTAssertFalse([formula isInstalled], @"Interned formula should be unchanged.");
+}
+
+- (void)testInternedFormulaIsEqualToMutableFormula
+{
+    // setup
+    MRBrewFormula *internedFormula = [MRBrewFormula internedFormulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    MRBrewFormula *formula = [MRBrewFormula formulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    
+    // execute & verify
+    XCTAssertTrue([internedFormula isEqualToFormula:formula], @"Interned formula should be equal to a mutable formula with equal properties.");
+    XCTAssertTrue([formula isEqualToFormula:internedFormula], @"Mutable formula should be equal to an interned formula with equal properties.");
+    XCTAssertEqual([internedFormula hash], [formula hash], @"Equal formulae should have equal hashes.");
+}
+
+- (void)testCopiedInternedFormulaIsSameFormula
+{
+    // setup
+    MRBrewFormula *formula = [MRBrewFormula internedFormulaWithName:@"formula-name"];
+    
+    // execute
+    MRBrewFormula *copy = [formula copy];
+    MRBrewFormula *mutableCopy = [formula mutableCopy];
+    
+    // verify
+    XCTAssertEqual(copy, formula, @"Copying an interned formula should return the formula itself.");
+    XCTAssertFalse([mutableCopy isImmutable], @"Mutable copy of an interned formula should be mutable.");
+    XCTAssertEqualObjects(mutableCopy, formula, @"Mutable copy should be equal to the interned formula.");
+}
+
 #pragma mark - Copying
 
 -(void)testCopiedFormulaIsEqualToOriginalFormula
@@ -221,4 +318,17 @@
     XCTAssertTrue([copy isEqualToFormula:formula], @"Formula copy should be identical to original formula.");
 }
 
+-(void)testCopiedFormulaWithVersionsIsEqualToOriginalFormula
+{
+    // setup
+    MRBrewFormula *formula = [MRBrewFormula formulaWithName:@"formula-name" isNew:NO isUpdated:NO isInstalled:YES];
+    [formula setVersion:@"1.1"];
+    [formula setInstalledVersions:@[@"1.0"]];
+    [formula setDependencies:@[@"dependency"]];
+    MRBrewFormula *copy = [formula copy];
+    
+    // execute & verify
+    XCTAssertTrue([copy isEqualToFormula:formula], @"Formula copy should be identical to original formula.");
+}
+
 @end
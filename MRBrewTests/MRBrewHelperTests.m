@@ -0,0 +1,321 @@
+//
+//  MRBrewHelperTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewHelper.h"
+#import "MRBrewWorker.h"
+#import "MRBrew.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewDelegate.h"
+#import "MRBrewConstants.h"
+
+static const NSTimeInterval MRBrewHelperTestsTimeout = 5.0;
+
+/* A stand-in helper that implements the helper protocol without Homebrew. It
+ * answers each request by echoing its arguments, except for the following
+ * commands: `fail` writes error output and exits with status 1, `hold` is not
+ * answered until it is cancelled, `crash` exits the helper, and `close` closes
+ * the helper's standard input without exiting.
+ */
+static NSString * const MRBrewHelperTestsScript =
+    @"#!/usr/bin/perl\n"
+    @"use strict;\n"
+    @"$| = 1;\n"
+    @"binmode STDIN; binmode STDOUT;\n"
+    @"my $buffer = '';\n"
+    @"my %held;\n"
+    @"sub frame { my ($type, $id, $payload) = @_; print \"$type $id \" . length($payload) . \"\\n\" . $payload; }\n"
+    @"while (sysread(STDIN, $buffer, 65536, length($buffer))) {\n"
+    @"    while ($buffer =~ /^(\\w) (\\d+) (\\d+)\\n/) {\n"
+    @"        my ($type, $id, $length, $header) = ($1, $2, $3, length($&));\n"
+    @"        last if length($buffer) < $header + $length;\n"
+    @"        my @arguments = split(/\\0/, substr($buffer, $header, $length));\n"
+    @"        $buffer = substr($buffer, $header + $length);\n"
+    @"        if ($type eq 'C') { frame('X', $id, '130') if delete $held{$id}; next; }\n"
+    @"        if ($arguments[0] eq 'crash') { exit 1; }\n"
+    @"        elsif ($arguments[0] eq 'close') { close(STDIN); frame('X', $id, '0'); sleep(5); exit 0; }\n"
+    @"        elsif ($arguments[0] eq 'hold') { $held{$id} = 1; }\n"
+    @"        elsif ($arguments[0] eq 'fail') { frame('E', $id, \"Error: failed\\n\"); frame('X', $id, '1'); }\n"
+    @"        else { frame('O', $id, join(' ', @arguments) . \"\\n\"); frame('X', $id, '0'); }\n"
+    @"    }\n"
+    @"}\n";
+
+@interface MRBrewHelperTests : XCTestCase <MRBrewDelegate> {
+    NSString *_helperPath;
+    MRBrewHelper *_helper;
+    NSMutableArray *_events;
+    BOOL _delegateReceivedDidFinishCallback;
+    BOOL _delegateReceivedDidFailWithErrorCallback;
+    NSMutableString *_delegateReceivedOutput;
+}
+
+@end
+
+@implementation MRBrewHelperTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _helperPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"MRBrewHelperTests-helper"];
+    [MRBrewHelperTestsScript writeToFile:_helperPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:_helperPath error:nil];
+    
+    _helper = [[MRBrewHelper alloc] initWithLaunchPath:_helperPath arguments:nil];
+    _events = [NSMutableArray array];
+    _delegateReceivedDidFinishCallback = NO;
+    _delegateReceivedDidFailWithErrorCallback = NO;
+    _delegateReceivedOutput = [NSMutableString string];
+}
+
+- (void)tearDown
+{
+    [_helper terminate];
+    [[NSFileManager defaultManager] removeItemAtPath:_helperPath error:nil];
+    
+    [super tearDown];
+}
+
+/* Sends a request whose output and termination are recorded as events. */
+- (NSUInteger)sendRequestWithArguments:(NSArray *)arguments
+{
+    NSMutableArray *events = _events;
+    
+    return [_helper sendRequestWithArguments:arguments dataHandler:^(MRBrewHelperStream stream, NSData *data) {
+        NSString *output = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        @synchronized(events) {
+            [events addObject:[NSString stringWithFormat:@"%@ %@", (stream == MRBrewHelperStreamOutput ? @"output" : @"error"), output]];
+        }
+    } terminationHandler:^(BOOL exited, int status) {
+        @synchronized(events) {
+            [events addObject:(exited ? [NSString stringWithFormat:@"%@ exited %d", [arguments objectAtIndex:0], status] : [NSString stringWithFormat:@"%@ failed", [arguments objectAtIndex:0]])];
+        }
+    }];
+}
+
+/* Waits until the specified number of events have been recorded, returning a
+ * copy of the recorded events.
+ */
+- (NSArray *)waitForEventCount:(NSUInteger)count
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewHelperTestsTimeout];
+    
+    while ([timeout timeIntervalSinceNow] > 0) {
+        @synchronized(_events) {
+            if ([_events count] >= count) {
+                break;
+            }
+        }
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    @synchronized(_events) {
+        return [_events copy];
+    }
+}
+
+#pragma mark - Requests
+
+- (void)testRequestReceivesOutputAndExitStatus
+{
+    // execute
+    NSUInteger identifier = [self sendRequestWithArguments:@[@"info", @"wget"]];
+    NSArray *events = [self waitForEventCount:2];
+    
+    // verify
+    XCTAssertTrue(identifier > 0, @"Should return an identifier for the request.");
+    XCTAssertEqualObjects(events, (@[@"output info wget\n", @"info exited 0"]), @"Should deliver the output of the request followed by its exit status.");
+}
+
+- (void)testRequestReceivesErrorOutput
+{
+    // execute
+    [self sendRequestWithArguments:@[@"fail"]];
+    NSArray *events = [self waitForEventCount:2];
+    
+    // verify
+    XCTAssertEqualObjects(events, (@[@"error Error: failed\n", @"fail exited 1"]), @"Should deliver error output separately from output.");
+}
+
+- (void)testPipelinedRequestsAreAnsweredIndependently
+{
+    // setup
+    NSUInteger heldIdentifier = [self sendRequestWithArguments:@[@"hold"]];
+    [self sendRequestWithArguments:@[@"list"]];
+    [self sendRequestWithArguments:@[@"search", @"git"]];
+    
+    // execute
+    NSArray *events = [self waitForEventCount:4];
+    [_helper cancelRequest:heldIdentifier];
+    NSArray *allEvents = [self waitForEventCount:5];
+    
+    // verify
+    XCTAssertEqualObjects(events, (@[@"output list\n", @"list exited 0", @"output search git\n", @"search exited 0"]), @"Requests sent behind an unanswered request should be answered.");
+    XCTAssertEqualObjects([allEvents lastObject], @"hold exited 130", @"A cancelled request should receive its exit status.");
+    XCTAssertEqual([_helper launchCount], (NSUInteger)1, @"Pipelined requests should share one helper process.");
+}
+
+- (void)testHelperIsLaunchedOnceForSuccessiveRequests
+{
+    // execute
+    [self sendRequestWithArguments:@[@"list"]];
+    [self waitForEventCount:2];
+    [self sendRequestWithArguments:@[@"list"]];
+    [self waitForEventCount:4];
+    
+    // verify
+    XCTAssertEqual([_helper launchCount], (NSUInteger)1, @"The helper should be kept running between requests.");
+    XCTAssertTrue([_helper isRunning], @"The helper should be running.");
+}
+
+#pragma mark - Crash Recovery
+
+- (void)testOutstandingRequestsFailWhenHelperExits
+{
+    // setup
+    [self sendRequestWithArguments:@[@"hold"]];
+    
+    // execute
+    [self sendRequestWithArguments:@[@"crash"]];
+    NSArray *events = [self waitForEventCount:2];
+    
+    // verify
+    XCTAssertEqualObjects(events, (@[@"hold failed", @"crash failed"]), @"Requests outstanding when the helper exits should fail in the order they were sent.");
+}
+
+- (void)testHelperIsLaunchedAgainAfterExiting
+{
+    // setup
+    [self sendRequestWithArguments:@[@"crash"]];
+    [self waitForEventCount:1];
+    
+    // execute
+    [self sendRequestWithArguments:@[@"list"]];
+    NSArray *events = [self waitForEventCount:3];
+    
+    // verify
+    XCTAssertEqualObjects([events lastObject], @"list exited 0", @"A request sent after the helper exits should be answered.");
+    XCTAssertEqual([_helper launchCount], (NSUInteger)2, @"The helper should be launched again after exiting.");
+}
+
+- (void)testRequestToHelperThatStoppedReadingIsNotSent
+{
+    // setup
+    [self sendRequestWithArguments:@[@"close"]];
+    [self waitForEventCount:1];
+    
+    // execute
+    NSUInteger identifier = [self sendRequestWithArguments:@[@"list"]];
+    
+    // verify
+    XCTAssertEqual(identifier, (NSUInteger)0, @"Should not return an identifier if the helper no longer reads requests.");
+    XCTAssertFalse([_helper isRunning], @"A helper that no longer reads requests should be terminated.");
+}
+
+- (void)testRequestToMissingHelperIsNotSent
+{
+    // setup
+    MRBrewHelper *helper = [[MRBrewHelper alloc] initWithLaunchPath:@"/nonexistent/helper" arguments:nil];
+    
+    // execute
+    NSUInteger identifier = [helper sendRequestWithArguments:@[@"list"] dataHandler:nil terminationHandler:nil];
+    
+    // verify
+    XCTAssertEqual(identifier, (NSUInteger)0, @"Should not return an identifier if the helper cannot be launched.");
+}
+
+#pragma mark - Workers
+
+- (void)waitForDelegateCallback
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewHelperTestsTimeout];
+    
+    while (!_delegateReceivedDidFinishCallback && !_delegateReceivedDidFailWithErrorCallback && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+}
+
+- (void)testWorkerPerformsOperationUsingHelper
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:[MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]]];
+    [worker setArguments:@[@"info", @"wget"]];
+    [worker setHelper:_helper];
+    [worker setDelegate:self];
+    
+    // execute
+    [[[NSOperationQueue alloc] init] addOperation:worker];
+    [self waitForDelegateCallback];
+    
+    // verify
+    XCTAssertTrue(_delegateReceivedDidFinishCallback, @"Delegate should receive brewOperationDidFinish: callback when the helper reports success.");
+    XCTAssertEqualObjects(_delegateReceivedOutput, @"info wget\n", @"Delegate should receive the output sent by the helper.");
+    XCTAssertEqual([_helper launchCount], (NSUInteger)1, @"The operation should be performed by the helper.");
+}
+
+- (void)testWorkerLaunchesBrewWhenHelperExitsBeforeGeneratingOutput
+{
+    // setup
+    NSString *brewPath = [[MRBrew sharedBrew] brewPath];
+    [[MRBrew sharedBrew] setBrewPath:@"/bin/echo"];
+    
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:[MRBrewOperation operationWithName:@"crash" formula:nil parameters:nil]];
+    [worker setArguments:@[@"crash"]];
+    [worker setHelper:_helper];
+    [worker setDelegate:self];
+    
+    // execute
+    [[[NSOperationQueue alloc] init] addOperation:worker];
+    [self waitForDelegateCallback];
+    
+    // verify
+    XCTAssertTrue(_delegateReceivedDidFinishCallback, @"The operation should succeed once performed by brew.");
+    XCTAssertEqualObjects(_delegateReceivedOutput, @"crash\n", @"Delegate should receive the output of brew.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:brewPath];
+}
+
+#pragma mark - MRBrewDelegate methods
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    _delegateReceivedDidFinishCallback = YES;
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    _delegateReceivedDidFailWithErrorCallback = YES;
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
+{
+    [_delegateReceivedOutput appendString:output];
+}
+
+@end
@@ -0,0 +1,115 @@
+//
+//  MRBrewHistogramTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewHistogram.h"
+
+@interface MRBrewHistogramTests : XCTestCase
+
+@end
+
+@implementation MRBrewHistogramTests
+
+#pragma mark - Recording Durations
+
+- (void)testEmptyHistogramHasNoDurations
+{
+    // setup
+    MRBrewHistogram *histogram = [[MRBrewHistogram alloc] init];
+    
+    // execute & verify
+    XCTAssertEqual([histogram count], (NSUInteger)0, @"Empty histogram should have no durations.");
+    XCTAssertEqual([histogram mean], (NSTimeInterval)0, @"Empty histogram should have zero mean.");
+    XCTAssertEqual([histogram durationAtPercentile:50], (NSTimeInterval)0, @"Empty histogram should have zero percentiles.");
+}
+
+- (void)testHistogramSummarisesRecordedDurations
+{
+    // setup
+    MRBrewHistogram *histogram = [[MRBrewHistogram alloc] init];
+    
+    // execute
+    [histogram recordDuration:0.01];
+    [histogram recordDuration:0.02];
+    [histogram recordDuration:0.06];
+    
+    // verify
+    XCTAssertEqual([histogram count], (NSUInteger)3, @"Histogram should count each recorded duration.");
+    XCTAssertEqualWithAccuracy([histogram minimum], 0.01, 0.0001, @"Histogram should record the shortest duration.");
+    XCTAssertEqualWithAccuracy([histogram maximum], 0.06, 0.0001, @"Histogram should record the longest duration.");
+    XCTAssertEqualWithAccuracy([histogram mean], 0.03, 0.0001, @"Histogram should record the mean duration.");
+}
+
+- (void)testPercentilesAreBoundedByBucketAndMaximum
+{
+    // setup
+    MRBrewHistogram *histogram = [[MRBrewHistogram alloc] init];
+    for (NSUInteger index = 0; index < 99; index++) {
+        [histogram recordDuration:0.003];
+    }
+    [histogram recordDuration:1.5];
+    
+    // execute & verify
+    XCTAssertEqualWithAccuracy([histogram durationAtPercentile:50], 0.004, 0.0001, @"Median should be the upper bound of the bucket containing it.");
+    XCTAssertEqualWithAccuracy([histogram durationAtPercentile:99], 0.004, 0.0001, @"99th percentile should exclude the single outlier.");
+    XCTAssertEqualWithAccuracy([histogram durationAtPercentile:100], 1.5, 0.0001, @"100th percentile should not exceed the longest duration.");
+}
+
+#pragma mark - Buckets
+
+- (void)testDurationsAreCountedInLogarithmicBuckets
+{
+    // setup
+    MRBrewHistogram *histogram = [[MRBrewHistogram alloc] init];
+    
+    // execute
+    [histogram recordDuration:0.0005];
+    [histogram recordDuration:0.0015];
+    [histogram recordDuration:0.002];
+    [histogram recordDuration:100000];
+    
+    // verify
+    XCTAssertEqual([histogram countForBucketAtIndex:0], (NSUInteger)1, @"Durations up to 1ms should be counted in the first bucket.");
+    XCTAssertEqual([histogram countForBucketAtIndex:1], (NSUInteger)2, @"Durations up to 2ms should be counted in the second bucket.");
+    XCTAssertEqual([histogram countForBucketAtIndex:[histogram bucketCount] - 1], (NSUInteger)1, @"Very long durations should be counted in the last bucket.");
+    XCTAssertEqualWithAccuracy([histogram upperBoundForBucketAtIndex:1], 0.002, 0.0001, @"Each bucket should double the upper bound of the previous bucket.");
+}
+
+- (void)testCopyIsIndependentOfOriginal
+{
+    // setup
+    MRBrewHistogram *histogram = [[MRBrewHistogram alloc] init];
+    [histogram recordDuration:0.01];
+    
+    // execute
+    MRBrewHistogram *copy = [histogram copy];
+    [histogram recordDuration:0.02];
+    
+    // verify
+    XCTAssertEqual([copy count], (NSUInteger)1, @"Copy should not record durations recorded by the original.");
+    XCTAssertEqualWithAccuracy([copy maximum], 0.01, 0.0001, @"Copy should retain the durations recorded before copying.");
+}
+
+@end
@@ -0,0 +1,160 @@
+//
+//  MRBrewInProcessWorkerTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "MRBrewInProcessWorker.h"
+#import "MRBrew.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewDelegate.h"
+
+static const NSTimeInterval MRBrewInProcessWorkerTestsTimeout = 5.0;
+
+@interface MRBrewInProcessWorkerTests : XCTestCase
+
+@end
+
+@implementation MRBrewInProcessWorkerTests
+
+- (MRBrewInProcessWorker *)workerWithDelegate:(id<MRBrewDelegate>)delegate formulae:(NSArray *)formulae
+{
+    MRBrewInProcessWorker *worker = [[MRBrewInProcessWorker alloc] init];
+    [worker setOperation:[MRBrewOperation listOperation]];
+    [worker setDelegate:delegate];
+    [worker setDelegateQueue:nil];
+    [worker setReader:^{
+        return formulae;
+    }];
+    
+    return worker;
+}
+
+- (void)waitForQueue:(NSOperationQueue *)queue
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewInProcessWorkerTestsTimeout];
+    
+    while ([queue operationCount] > 0 && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+}
+
+#pragma mark - Performing
+
+- (void)testFormulaeAreDeliveredWithOutputOfBrew
+{
+    // setup
+    NSArray *formulae = @[[MRBrewFormula formulaWithName:@"git"], [MRBrewFormula formulaWithName:@"wget"]];
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didGenerateOutput:@"git\nwget\n"];
+    [[delegate expect] brewOperation:[OCMArg any] didParseObjects:formulae];
+    [[delegate expect] brewOperationDidFinish:[OCMArg any]];
+    MRBrewInProcessWorker *worker = [self workerWithDelegate:delegate formulae:formulae];
+    
+    // execute
+    [worker start];
+    
+    // verify
+    [delegate verify];
+}
+
+- (void)testOperationIsPerformedByFallbackHandlerIfReaderFails
+{
+    // setup
+    __block MRBrewOperation *fallbackOperation = nil;
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    MRBrewInProcessWorker *worker = [self workerWithDelegate:delegate formulae:nil];
+    [worker setFallbackHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> fallbackDelegate) {
+        fallbackOperation = operation;
+    }];
+    
+    // execute
+    [worker start];
+    
+    // verify
+    [delegate verify];
+    XCTAssertTrue([fallbackOperation isEqualToOperation:[MRBrewOperation listOperation]], @"The operation should be performed by the fallback handler.");
+}
+
+#pragma mark - Cancellation
+
+- (void)testQueuedWorkerThatIsCancelledFails
+{
+    // setup
+    __block BOOL read = NO;
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didFailWithError:[OCMArg checkWithBlock:^BOOL(id error) { return [error code] == MRBrewErrorOperationCancelled; }]];
+    MRBrewInProcessWorker *worker = [self workerWithDelegate:delegate formulae:@[]];
+    [worker setReader:^{
+        read = YES;
+        return @[];
+    }];
+    
+    // execute
+    [worker cancel];
+    [worker start];
+    
+    // verify
+    [delegate verify];
+    XCTAssertFalse(read, @"A cancelled worker should not read the installation.");
+    XCTAssertTrue([worker isFinished], @"A cancelled worker should finish.");
+}
+
+- (void)testWorkerCancelledBeforeDeliveryFailsInsteadOfFinishing
+{
+    // setup: the outcome is delivered on a queue that is held until the
+    // worker has been cancelled
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    [delegateQueue setSuspended:YES];
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didFailWithError:[OCMArg checkWithBlock:^BOOL(id error) { return [error code] == MRBrewErrorOperationCancelled; }]];
+    MRBrewInProcessWorker *worker = [self workerWithDelegate:delegate formulae:@[[MRBrewFormula formulaWithName:@"wget"]]];
+    [worker setDelegateQueue:delegateQueue];
+    
+    // execute
+    [worker start];
+    [worker cancel];
+    [delegateQueue setSuspended:NO];
+    [self waitForQueue:delegateQueue];
+    
+    // verify
+    [delegate verify];
+}
+
+- (void)testCancelForDelegateCancelsOnlyForItsDelegate
+{
+    // setup
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    id otherDelegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    MRBrewInProcessWorker *worker = [self workerWithDelegate:delegate formulae:@[]];
+    
+    // execute & verify
+    [worker cancelForDelegate:otherDelegate];
+    XCTAssertFalse([worker isCancelled], @"Should not be cancelled for another delegate.");
+    [worker cancelForDelegate:delegate];
+    XCTAssertTrue([worker isCancelled], @"Should be cancelled for its delegate.");
+}
+
+@end
@@ -0,0 +1,159 @@
+//
+//  MRBrewKegSnapshotTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <XCTest/XCTest.h>
+#import "MRBrewKegSnapshot.h"
+#import "MRBrewKegChanges.h"
+#import "MRBrewFormula.h"
+
+@interface MRBrewKegSnapshotTests : XCTestCase
+{
+    NSString *_prefix;
+}
+
+@end
+
+@implementation MRBrewKegSnapshotTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _prefix = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Library/LinkedKegs"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Library/PinnedKegs"] withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:_prefix error:NULL];
+    _prefix = nil;
+    
+    [super tearDown];
+}
+
+- (void)installKeg:(NSString *)name version:(NSString *)version
+{
+    NSString *kegPath = [_prefix stringByAppendingPathComponent:[NSString stringWithFormat:@"Cellar/%@/%@/bin", name, version]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:kegPath withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)linkKeg:(NSString *)name version:(NSString *)version inDirectory:(NSString *)directory
+{
+    NSString *linkPath = [_prefix stringByAppendingPathComponent:[NSString stringWithFormat:@"Library/%@/%@", directory, name]];
+    [[NSFileManager defaultManager] removeItemAtPath:linkPath error:NULL];
+    [[NSFileManager defaultManager] createSymbolicLinkAtPath:linkPath withDestinationPath:[NSString stringWithFormat:@"../../Cellar/%@/%@", name, version] error:NULL];
+}
+
+- (MRBrewKegSnapshot *)snapshot
+{
+    return [[MRBrewKegSnapshot alloc] initWithCellarPath:[_prefix stringByAppendingPathComponent:@"Cellar"]
+                                          linkedKegsPath:[_prefix stringByAppendingPathComponent:@"Library/LinkedKegs"]
+                                          pinnedKegsPath:[_prefix stringByAppendingPathComponent:@"Library/PinnedKegs"]];
+}
+
+#pragma mark - Snapshots
+
+- (void)testSnapshotRecordsInstalledLinkedAndPinnedVersions
+{
+    // setup
+    [self installKeg:@"wget" version:@"1.9"];
+    [self installKeg:@"wget" version:@"1.15"];
+    [self linkKeg:@"wget" version:@"1.15" inDirectory:@"LinkedKegs"];
+    [self linkKeg:@"wget" version:@"1.15" inDirectory:@"PinnedKegs"];
+    
+    // execute
+    MRBrewKegSnapshot *snapshot = [self snapshot];
+    
+    // verify
+    XCTAssertEqualObjects([snapshot installedVersions], (@{ @"wget" : @[@"1.9", @"1.15"] }), @"Should record the installed versions in version order.");
+    XCTAssertEqualObjects([snapshot linkedVersions], @{ @"wget" : @"1.15" }, @"Should record the linked version.");
+    XCTAssertEqualObjects([snapshot pinnedVersions], @{ @"wget" : @"1.15" }, @"Should record the pinned version.");
+}
+
+- (void)testSnapshotOfMissingDirectoriesIsEmpty
+{
+    // setup
+    MRBrewKegSnapshot *snapshot = [[MRBrewKegSnapshot alloc] initWithCellarPath:[_prefix stringByAppendingPathComponent:@"Missing"] linkedKegsPath:nil pinnedKegsPath:nil];
+    
+    // execute & verify
+    XCTAssertEqual([[snapshot installedVersions] count], (NSUInteger)0, @"A missing Cellar should hold no kegs.");
+    XCTAssertEqual([[snapshot linkedVersions] count], (NSUInteger)0, @"A nil path should hold no kegs.");
+}
+
+#pragma mark - Changes
+
+- (void)testChangesReportInstalledRemovedAndUpgradedFormulae
+{
+    // setup
+    [self installKeg:@"wget" version:@"1.14"];
+    [self installKeg:@"curl" version:@"7.35.0"];
+    MRBrewKegSnapshot *previousSnapshot = [self snapshot];
+    
+    [self installKeg:@"wget" version:@"1.15"];
+    [self installKeg:@"git" version:@"1.9.0"];
+    [[NSFileManager defaultManager] removeItemAtPath:[_prefix stringByAppendingPathComponent:@"Cellar/curl"] error:NULL];
+    
+    // execute
+    MRBrewKegChanges *changes = [[self snapshot] changesSinceSnapshot:previousSnapshot];
+    
+    // verify
+    MRBrewFormula *installed = [[changes installedFormulae] firstObject];
+    MRBrewFormula *upgraded = [[changes upgradedFormulae] firstObject];
+    MRBrewFormula *removed = [[changes removedFormulae] firstObject];
+    XCTAssertEqual([[changes installedFormulae] count], (NSUInteger)1, @"Should report one installed formula.");
+    XCTAssertEqualObjects([installed name], @"git", @"Should report the installed formula.");
+    XCTAssertTrue([installed isNew] && [installed isInstalled], @"An installed formula should be new and installed.");
+    XCTAssertEqualObjects([upgraded name], @"wget", @"Should report the upgraded formula.");
+    XCTAssertTrue([upgraded isUpdated], @"An upgraded formula should be updated.");
+    XCTAssertEqualObjects([upgraded installedVersions], (@[@"1.14", @"1.15"]), @"Should hold the versions installed after the change.");
+    XCTAssertEqualObjects([removed name], @"curl", @"Should report the removed formula.");
+    XCTAssertFalse([removed isInstalled], @"A removed formula should not be installed.");
+    XCTAssertEqual([[changes linkedFormulae] count], (NSUInteger)0, @"Should not report formulae whose links did not change.");
+}
+
+- (void)testChangesReportLinkedAndUnpinnedFormulae
+{
+    // setup
+    [self installKeg:@"wget" version:@"1.15"];
+    [self linkKeg:@"wget" version:@"1.15" inDirectory:@"PinnedKegs"];
+    MRBrewKegSnapshot *previousSnapshot = [self snapshot];
+    
+    [self linkKeg:@"wget" version:@"1.15" inDirectory:@"LinkedKegs"];
+    [[NSFileManager defaultManager] removeItemAtPath:[_prefix stringByAppendingPathComponent:@"Library/PinnedKegs/wget"] error:NULL];
+    
+    // execute
+    MRBrewKegChanges *changes = [[self snapshot] changesSinceSnapshot:previousSnapshot];
+    
+    // verify
+    XCTAssertEqualObjects([[[changes linkedFormulae] firstObject] name], @"wget", @"Should report the linked formula.");
+    XCTAssertEqualObjects([[[changes unpinnedFormulae] firstObject] name], @"wget", @"Should report the unpinned formula.");
+    XCTAssertEqual([[changes installedFormulae] count], (NSUInteger)0, @"Linking should not report an installed formula.");
+    XCTAssertFalse([changes isEmpty], @"Changes with a linked formula should not be empty.");
+    XCTAssertTrue([[[self snapshot] changesSinceSnapshot:[self snapshot]] isEmpty], @"Identical snapshots should have no changes.");
+}
+
+@end
@@ -0,0 +1,311 @@
+//
+//  MRBrewLauncherTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import <signal.h>
+#import <errno.h>
+#import "MRBrew.h"
+#import "MRBrew+Private.h"
+#import "MRBrewLauncher.h"
+#import "MRBrewTask.h"
+
+static const NSTimeInterval MRBrewLauncherTestsTimeout = 5.0;
+
+@interface MRBrewLauncherTests : XCTestCase
+
+@end
+
+@implementation MRBrewLauncherTests
+
+/* Launches a shell command and waits for it to exit, returning its output. */
+- (NSString *)outputOfCommand:(NSString *)command task:(MRBrewTask *)task
+{
+    __block BOOL terminated = NO;
+    NSPipe *outputPipe = [NSPipe pipe];
+    
+    [task setLaunchPath:@"/bin/sh"];
+    [task setArguments:@[@"-c", command]];
+    [task setStandardOutput:outputPipe];
+    [task setTerminationHandler:^(MRBrewTask *terminatedTask) {
+        terminated = YES;
+    }];
+    [task launch];
+    
+    NSData *output = [[outputPipe fileHandleForReading] readDataToEndOfFile];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewLauncherTestsTimeout];
+    while (!terminated && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    XCTAssertTrue(terminated, @"The termination handler should be called once the process exits.");
+    
+    return [[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Tasks
+
+- (void)testTaskDeliversOutputAndExitStatus
+{
+    // setup
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    
+    // execute
+    NSString *output = [self outputOfCommand:@"echo hello; exit 3" task:task];
+    
+    // verify
+    XCTAssertEqualObjects(output, @"hello\n", @"Should deliver the output of the process.");
+    XCTAssertEqual([task terminationStatus], 3, @"Should return the exit status of the process.");
+    XCTAssertFalse([task isRunning], @"Should not be running once the process has exited.");
+}
+
+- (void)testTaskReportsSignalAsTerminationStatus
+{
+    // setup
+    __block BOOL terminated = NO;
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    [task setLaunchPath:@"/bin/sleep"];
+    [task setArguments:@[@"10"]];
+    [task setTerminationHandler:^(MRBrewTask *terminatedTask) {
+        terminated = YES;
+    }];
+    [task launch];
+    
+    // execute
+    [task terminate];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewLauncherTestsTimeout];
+    while (!terminated && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqual([task terminationStatus], SIGTERM, @"Should return the signal that terminated the process.");
+}
+
+- (void)testConcurrentTasksAreEachReaped
+{
+    // setup
+    NSUInteger taskCount = 16;
+    NSMutableArray *tasks = [NSMutableArray array];
+    __block NSUInteger terminatedCount = 0;
+    
+    for (NSUInteger index = 0; index < taskCount; index++) {
+        MRBrewTask *task = [[MRBrewTask alloc] init];
+        [task setLaunchPath:@"/bin/sh"];
+        [task setArguments:@[@"-c", [NSString stringWithFormat:@"exit %lu", (unsigned long)index]]];
+        [task setTerminationHandler:^(MRBrewTask *terminatedTask) {
+            @synchronized(tasks) {
+                terminatedCount++;
+            }
+        }];
+        [tasks addObject:task];
+    }
+    
+    // execute
+    [tasks makeObjectsPerformSelector:@selector(launch)];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewLauncherTestsTimeout];
+    while ([timeout timeIntervalSinceNow] > 0) {
+        @synchronized(tasks) {
+            if (terminatedCount == taskCount) {
+                break;
+            }
+        }
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqual(terminatedCount, taskCount, @"The termination handler of every task should be called once its process exits.");
+    [tasks enumerateObjectsUsingBlock:^(MRBrewTask *task, NSUInteger index, BOOL *stop) {
+        XCTAssertEqual([task terminationStatus], (int)index, @"Should return the exit status of each process.");
+    }];
+}
+
+- (void)testTaskInOwnProcessGroupSignalsWholeGroup
+{
+    // setup
+    __block BOOL terminated = NO;
+    NSPipe *outputPipe = [NSPipe pipe];
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    [task setLaunchPath:@"/bin/sh"];
+    [task setArguments:@[@"-c", @"/bin/sleep 10 & echo $!; wait"]];
+    [task setStandardOutput:outputPipe];
+    [task setCreatesProcessGroup:YES];
+    [task setTerminationHandler:^(MRBrewTask *terminatedTask) {
+        terminated = YES;
+    }];
+    [task launch];
+    
+    NSString *line = [[NSString alloc] initWithData:[[outputPipe fileHandleForReading] availableData] encoding:NSUTF8StringEncoding];
+    pid_t childIdentifier = (pid_t)[line intValue];
+    
+    // execute
+    [task kill];
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewLauncherTestsTimeout];
+    while ((!terminated || kill(childIdentifier, 0) == 0) && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue(childIdentifier > 0, @"The process should report the identifier of its child.");
+    XCTAssertEqual([task terminationStatus], SIGKILL, @"The process should be killed.");
+    XCTAssertTrue(kill(childIdentifier, 0) == -1 && errno == ESRCH, @"Processes launched by the process should be killed with it.");
+}
+
+- (void)testTaskIsLaunchedWithEnvironment
+{
+    // setup
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    [task setEnvironment:@{@"MRBREW_TEST_VARIABLE": @"test_value"}];
+    
+    // execute
+    NSString *output = [self outputOfCommand:@"echo \"$MRBREW_TEST_VARIABLE\"" task:task];
+    
+    // verify
+    XCTAssertEqualObjects(output, @"test_value\n", @"The process should receive the environment of the task.");
+}
+
+- (void)testLaunchingMissingExecutableRaises
+{
+    // setup
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    [task setLaunchPath:@"/nonexistent/brew"];
+    
+    // execute & verify
+    XCTAssertThrows([task launch], @"Should raise an exception if the process cannot be launched, as NSTask does.");
+    XCTAssertFalse([task isRunning], @"Should not be running if the process could not be launched.");
+}
+
+- (void)testSymbolicLinkIsLaunchedAsGiven
+{
+    // setup: a script that writes the path it was run as, linked to from
+    // another directory as /usr/local/bin/brew is
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[directory stringByAppendingPathComponent:@"bin"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    NSString *scriptPath = [directory stringByAppendingPathComponent:@"script"];
+    NSString *linkPath = [directory stringByAppendingPathComponent:@"bin/brew"];
+    [@"#!/bin/sh\necho \"$0\"\n" writeToFile:scriptPath atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:scriptPath error:NULL];
+    [[NSFileManager defaultManager] createSymbolicLinkAtPath:linkPath withDestinationPath:scriptPath error:NULL];
+    
+    __block BOOL terminated = NO;
+    NSPipe *outputPipe = [NSPipe pipe];
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    [task setLaunchPath:linkPath];
+    [task setStandardOutput:outputPipe];
+    [task setTerminationHandler:^(MRBrewTask *terminatedTask) {
+        terminated = YES;
+    }];
+    
+    // execute
+    [task launch];
+    NSData *output = [[outputPipe fileHandleForReading] readDataToEndOfFile];
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewLauncherTestsTimeout];
+    while (!terminated && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    NSString *expectedOutput = [[linkPath stringByStandardizingPath] stringByAppendingString:@"\n"];
+    XCTAssertEqualObjects([[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding], expectedOutput, @"Should run the process as the link, as Homebrew finds its prefix from that path.");
+    
+    // cleanup
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+}
+
+- (void)testUnrelatedDescriptorsAreNotInherited
+{
+    // setup
+    NSPipe *unrelatedPipe = [NSPipe pipe];
+    int descriptor = [[unrelatedPipe fileHandleForWriting] fileDescriptor];
+    MRBrewTask *task = [[MRBrewTask alloc] init];
+    
+    // execute
+    NSString *command = [NSString stringWithFormat:@"if { : >&%d; } 2>/dev/null; then echo open; else echo closed; fi", descriptor];
+    NSString *output = [self outputOfCommand:command task:task];
+    
+    // verify
+    XCTAssertEqualObjects(output, @"closed\n", @"Descriptors other than the standard streams should be closed in the process.");
+}
+
+#pragma mark - Launcher
+
+- (void)testLauncherFlattensEnvironmentOnlyWhenItChanges
+{
+    // setup
+    NSDictionary *environment = @{@"MRBREW_TEST_VARIABLE": @"test_value"};
+    MRBrewLauncher *launcher = [[MRBrewLauncher alloc] initWithLaunchPath:@"/bin/sh" environment:environment];
+    
+    // execute
+    for (NSUInteger i = 0; i < 3; i++) {
+        MRBrewTask *task = [[MRBrewTask alloc] initWithLauncher:launcher];
+        [task setEnvironment:environment];
+        [self outputOfCommand:@"true" task:task];
+    }
+    NSUInteger launchFlattenCount = [launcher environmentFlattenCount];
+    [launcher setEnvironment:@{@"MRBREW_TEST_VARIABLE": @"other_value"}];
+    
+    // verify
+    XCTAssertEqual(launchFlattenCount, (NSUInteger)1, @"The environment should not be flattened for each launch.");
+    XCTAssertEqual([launcher environmentFlattenCount], (NSUInteger)2, @"The environment should be flattened when it is changed.");
+}
+
+- (void)testLauncherFlattensOtherEnvironmentForSingleLaunch
+{
+    // setup
+    MRBrewLauncher *launcher = [[MRBrewLauncher alloc] initWithLaunchPath:@"/bin/sh" environment:@{@"MRBREW_TEST_VARIABLE": @"test_value"}];
+    MRBrewTask *task = [[MRBrewTask alloc] initWithLauncher:launcher];
+    [task setEnvironment:@{@"MRBREW_TEST_VARIABLE": @"other_value"}];
+    
+    // execute
+    NSString *output = [self outputOfCommand:@"echo \"$MRBREW_TEST_VARIABLE\"" task:task];
+    
+    // verify
+    XCTAssertEqualObjects(output, @"other_value\n", @"The process should receive the environment of the task.");
+    XCTAssertEqualObjects([launcher environment], @{@"MRBREW_TEST_VARIABLE": @"test_value"}, @"The environment of the launcher should not change.");
+}
+
+- (void)testBrewEnvironmentAndPathAreSetOnLauncher
+{
+    // setup
+    NSDictionary *environment = @{@"MRBREW_TEST_VARIABLE": @"test_value"};
+    NSString *brewPath = [[MRBrew sharedBrew] brewPath];
+    
+    // execute
+    [[MRBrew sharedBrew] setEnvironment:environment];
+    [[MRBrew sharedBrew] setBrewPath:@"/usr/bin/brew"];
+    
+    // verify
+    XCTAssertEqualObjects([[[MRBrew sharedBrew] launcher] environment], environment, @"The launcher should use the environment of MRBrew.");
+    XCTAssertEqualObjects([[[MRBrew sharedBrew] launcher] launchPath], @"/usr/bin/brew", @"The launcher should use the brew path of MRBrew.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setEnvironment:nil];
+    [[MRBrew sharedBrew] setBrewPath:brewPath];
+}
+
+@end
@@ -0,0 +1,341 @@
+//
+//  MRBrewOperationBatchTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "MRBrew.h"
+#import "MRBrewOperationBatch.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewConstants.h"
+#import "MRBrewDelegate.h"
+#import "MRBrewWorker.h"
+
+@interface MRBrewOperationBatchTests : XCTestCase
+
+@end
+
+@implementation MRBrewOperationBatchTests
+
+- (MRBrewOperation *)installOperation:(NSString *)formulaName
+{
+    return [MRBrewOperation installOperation:[MRBrewFormula formulaWithName:formulaName]];
+}
+
+#pragma mark - Batching
+
+- (void)testOnlyInstallAndRemoveOperationsWithFormulaCanBeBatched
+{
+    // execute & verify
+    XCTAssertTrue([MRBrewOperationBatch canBatchOperation:[self installOperation:@"wget"]], @"Install operations should be batched.");
+    XCTAssertTrue([MRBrewOperationBatch canBatchOperation:[MRBrewOperation removeOperation:[MRBrewFormula formulaWithName:@"wget"]]], @"Remove operations should be batched.");
+    XCTAssertFalse([MRBrewOperationBatch canBatchOperation:[MRBrewOperation installOperation:nil]], @"Operations without a formula should not be batched.");
+    XCTAssertFalse([MRBrewOperationBatch canBatchOperation:[MRBrewOperation updateOperation]], @"Update operations should not be batched.");
+    XCTAssertFalse([MRBrewOperationBatch canBatchOperation:[MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]]], @"Info operations should not be batched.");
+}
+
+- (void)testOperationsWithDifferentParametersAreNotBatchedTogether
+{
+    // setup
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    MRBrewOperation *operation = [MRBrewOperation operationWithName:MRBrewOperationInstallIdentifier formula:[MRBrewFormula formulaWithName:@"git"] parameters:@[@"--HEAD"]];
+    
+    // execute & verify
+    XCTAssertFalse([batch addOperation:operation delegate:nil], @"Operations with different parameters should not share a batch.");
+    XCTAssertFalse([batch addOperation:[MRBrewOperation removeOperation:[MRBrewFormula formulaWithName:@"git"]] delegate:nil], @"Operations with different names should not share a batch.");
+    XCTAssertEqual([batch operationCount], (NSUInteger)1, @"Rejected operations should not be added to the batch.");
+}
+
+- (void)testArgumentsNameEachFormulaOnce
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation operationWithName:MRBrewOperationInstallIdentifier formula:[MRBrewFormula formulaWithName:@"wget"] parameters:@[@"--build-from-source"]];
+    MRBrewOperation *otherOperation = [MRBrewOperation operationWithName:MRBrewOperationInstallIdentifier formula:[MRBrewFormula formulaWithName:@"git"] parameters:@[@"--build-from-source"]];
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:operation delegate:nil];
+    [batch addOperation:otherOperation delegate:nil];
+    [batch addOperation:operation delegate:nil];
+    
+    // execute
+    NSArray *arguments = [batch arguments];
+    
+    // verify
+    NSArray *expectedArguments = @[MRBrewOperationInstallIdentifier, @"--build-from-source", @"wget", @"git"];
+    XCTAssertEqualObjects(arguments, expectedArguments, @"Should name each formula once, after the parameters.");
+    XCTAssertEqual([batch operationCount], (NSUInteger)3, @"Should retain every operation in the batch.");
+}
+
+- (void)testSealedBatchRejectsOperations
+{
+    // setup
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch seal];
+    
+    // execute & verify
+    XCTAssertFalse([batch addOperation:[self installOperation:@"git"] delegate:nil], @"A sealed batch should not accept further operations.");
+}
+
+- (void)testQueuePriorityIsHighestPriorityOfOperations
+{
+    // setup
+    MRBrewOperation *operation = [self installOperation:@"git"];
+    [operation setPriority:MRBrewOperationPriorityHigh];
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch addOperation:operation delegate:nil];
+    
+    // execute & verify
+    XCTAssertEqual([batch queuePriority], NSOperationQueuePriorityHigh, @"The batch should be queued with the highest priority of its operations.");
+}
+
+#pragma mark - Delivering Messages
+
+- (void)testOutputAndCompletionAreDeliveredToEachDelegateWithItsOperation
+{
+    // setup
+    MRBrewOperation *operation = [self installOperation:@"wget"];
+    MRBrewOperation *otherOperation = [self installOperation:@"git"];
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    id otherDelegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg checkWithBlock:^BOOL(id value) { return [value isEqualToOperation:operation]; }] didGenerateOutput:@"==> Pouring\n"];
+    [[delegate expect] brewOperationDidFinish:[OCMArg checkWithBlock:^BOOL(id value) { return [value isEqualToOperation:operation]; }]];
+    [[otherDelegate expect] brewOperation:[OCMArg checkWithBlock:^BOOL(id value) { return [value isEqualToOperation:otherOperation]; }] didGenerateOutput:@"==> Pouring\n"];
+    [[otherDelegate expect] brewOperationDidFinish:[OCMArg checkWithBlock:^BOOL(id value) { return [value isEqualToOperation:otherOperation]; }]];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:operation delegate:delegate];
+    [batch addOperation:otherOperation delegate:otherDelegate];
+    [batch seal];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didGenerateOutput:@"==> Pouring\n"];
+    [batch brewOperationDidFinish:[batch combinedOperation]];
+    
+    // verify
+    [delegate verify];
+    [otherDelegate verify];
+}
+
+- (void)testOutputIsDeliveredToDelegateOfFormulaNamedByHeader
+{
+    // setup
+    MRBrewOperation *operation = [self installOperation:@"wget"];
+    MRBrewOperation *otherOperation = [self installOperation:@"git"];
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    id otherDelegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didGenerateOutput:@"==> Downloading wget-1.15.tar.gz\n######## 100.0%\n"];
+    [[delegate expect] brewOperation:[OCMArg any] didGenerateErrorOutput:@"Warning: wget-1.15 is keg-only\n"];
+    [[otherDelegate expect] brewOperation:[OCMArg any] didGenerateOutput:@"==> Pouring git-1.9.0.mavericks.bottle.tar.gz\n==> Caveats\n"];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:operation delegate:delegate];
+    [batch addOperation:otherOperation delegate:otherDelegate];
+    [batch seal];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didGenerateOutput:@"==> Downloading wget-1.15.tar.gz\n######## 100.0%\n==> Pouring git-1.9.0.mavericks.bottle.tar.gz\n==> Caveats\n"];
+    [batch brewOperation:[batch combinedOperation] didGenerateErrorOutput:@"Warning: wget-1.15 is keg-only\n"];
+    
+    // verify
+    [delegate verify];
+    [otherDelegate verify];
+}
+
+- (void)testOutputPrecedingFirstHeaderIsHeldForFormulaItNames
+{
+    // setup
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didGenerateOutput:@"Updating Homebrew...\n"];
+    [[delegate expect] brewOperation:[OCMArg any] didGenerateOutput:@"==> Installing wget-extras\n"];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch addOperation:[self installOperation:@"wget-extras"] delegate:delegate];
+    [batch seal];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didGenerateOutput:@"Updating Homebrew...\n"];
+    [batch brewOperation:[batch combinedOperation] didGenerateOutput:@"==> Installing wget-extras\n"];
+    
+    // verify
+    [delegate verify];
+}
+
+- (void)testFailureRetriesEachOperation
+{
+    // setup
+    NSString *cellarPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:cellarPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    NSMutableArray *retriedOperations = [NSMutableArray array];
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch addOperation:[self installOperation:@"git"] delegate:nil];
+    [batch setCellarPath:cellarPath];
+    [batch setRetryHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        [retriedOperations addObject:operation];
+    }];
+    [batch seal];
+    [batch recordInstalledVersions];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didFailWithError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorUnknown userInfo:nil]];
+    
+    // verify
+    XCTAssertEqualObjects([retriedOperations valueForKeyPath:@"formula.name"], (@[@"wget", @"git"]), @"Each operation in a failed batch should be performed again on its own.");
+    
+    // cleanup
+    [[NSFileManager defaultManager] removeItemAtPath:cellarPath error:NULL];
+}
+
+- (void)testFailureIsDeliveredToEachOperationIfInstalledVersionsAreUnknown
+{
+    // setup
+    __block BOOL retried = NO;
+    id firstDelegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[firstDelegate expect] brewOperation:[OCMArg any] didFailWithError:[OCMArg checkWithBlock:^BOOL(id error) { return [error code] == MRBrewErrorUnknown; }]];
+    id secondDelegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[secondDelegate expect] brewOperation:[OCMArg any] didFailWithError:[OCMArg checkWithBlock:^BOOL(id error) { return [error code] == MRBrewErrorUnknown; }]];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:firstDelegate];
+    [batch addOperation:[self installOperation:@"git"] delegate:secondDelegate];
+    [batch setCellarPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]];
+    [batch setRetryHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        retried = YES;
+    }];
+    [batch seal];
+    [batch recordInstalledVersions];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didFailWithError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorUnknown userInfo:nil]];
+    
+    // verify
+    [firstDelegate verify];
+    [secondDelegate verify];
+    XCTAssertFalse(retried, @"Operations of a failed batch should not be performed again if the Cellar cannot be read.");
+}
+
+- (void)testFailureFinishesOperationsWhoseFormulaWasInstalled
+{
+    // setup
+    NSString *cellarPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"git/1.8.5"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    NSMutableArray *retriedOperations = [NSMutableArray array];
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperationDidFinish:[OCMArg checkWithBlock:^BOOL(id value) { return [[[value formula] name] isEqualToString:@"wget"]; }]];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:delegate];
+    [batch addOperation:[self installOperation:@"git"] delegate:nil];
+    [batch setCellarPath:cellarPath];
+    [batch setRetryHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        [retriedOperations addObject:operation];
+    }];
+    [batch seal];
+    [batch recordInstalledVersions];
+    
+    // execute
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"wget/1.15"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [batch brewOperation:[batch combinedOperation] didFailWithError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorUnknown userInfo:nil]];
+    
+    // verify
+    [delegate verify];
+    XCTAssertEqualObjects([retriedOperations valueForKeyPath:@"formula.name"], (@[@"git"]), @"Only operations whose formula did not change should be performed again.");
+    
+    // cleanup
+    [[NSFileManager defaultManager] removeItemAtPath:cellarPath error:NULL];
+}
+
+- (void)testCancellationIsDeliveredWithoutRetrying
+{
+    // setup
+    __block BOOL retried = NO;
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    [[delegate expect] brewOperation:[OCMArg any] didFailWithError:[OCMArg checkWithBlock:^BOOL(id error) { return [error code] == MRBrewErrorOperationCancelled; }]];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:delegate];
+    [batch addOperation:[self installOperation:@"git"] delegate:nil];
+    [batch setRetryHandler:^(MRBrewOperation *operation, id<MRBrewDelegate> delegate) {
+        retried = YES;
+    }];
+    [batch seal];
+    
+    // execute
+    [batch brewOperation:[batch combinedOperation] didFailWithError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorOperationCancelled userInfo:nil]];
+    
+    // verify
+    [delegate verify];
+    XCTAssertFalse(retried, @"A cancelled batch should not be performed again.");
+}
+
+#pragma mark - Cancellation
+
+- (void)testCancellingOperationBeforeBatchIsSealedRemovesIt
+{
+    // setup
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch addOperation:[self installOperation:@"git"] delegate:nil];
+    
+    // execute
+    BOOL cancelled = [batch cancelOperation:[self installOperation:@"wget"]];
+    
+    // verify
+    XCTAssertTrue(cancelled, @"Should cancel an operation in the batch.");
+    XCTAssertEqualObjects([batch arguments], (@[MRBrewOperationInstallIdentifier, @"git"]), @"A cancelled operation should not be performed.");
+}
+
+- (void)testCancellingOneOfSeveralOperationsOfSealedBatchIsRefused
+{
+    // setup
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    id worker = [OCMockObject mockForClass:[MRBrewWorker class]];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:delegate];
+    [batch addOperation:[self installOperation:@"git"] delegate:nil];
+    [batch setWorker:worker];
+    [batch seal];
+    
+    // execute
+    BOOL cancelled = [batch cancelOperation:[self installOperation:@"wget"]];
+    
+    // verify
+    XCTAssertFalse(cancelled, @"An operation being performed with others should not be reported as cancelled.");
+    XCTAssertEqual([batch operationCount], (NSUInteger)2, @"The operation should remain in the batch.");
+    [worker verify];
+    [delegate verify];
+}
+
+- (void)testCancellingLastOperationOfSealedBatchCancelsWorker
+{
+    // setup
+    id worker = [OCMockObject mockForClass:[MRBrewWorker class]];
+    [[worker expect] cancel];
+    
+    MRBrewOperationBatch *batch = [[MRBrewOperationBatch alloc] initWithOperation:[self installOperation:@"wget"] delegate:nil];
+    [batch setWorker:worker];
+    [batch seal];
+    
+    // execute
+    [batch cancelOperation:[self installOperation:@"wget"]];
+    
+    // verify
+    [worker verify];
+}
+
+@end
@@ -0,0 +1,277 @@
+//
+//  MRBrewOperationGraphTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "MRBrew.h"
+#import "MRBrew+Private.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewOperationGraph.h"
+#import "MRBrewOperationGraph+Private.h"
+#import "MRBrewOperationResult.h"
+#import "MRBrewOperationResult+Private.h"
+#import "MRBrewOperationMetrics.h"
+
+@interface MRBrewOperationGraphTests : XCTestCase
+{
+    NSOperationQueue *_originalBackgroundQueue;
+    NSOperationQueue *_originalMutatingQueue;
+}
+
+@end
+
+@implementation MRBrewOperationGraphTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // other tests may leave mock queues in place, so graphs are performed on
+    // queues of their own
+    _originalBackgroundQueue = [[MRBrew sharedBrew] backgroundQueue];
+    _originalMutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    [[MRBrew sharedBrew] setBackgroundQueue:[[NSOperationQueue alloc] init]];
+    
+    NSOperationQueue *mutatingQueue = [[NSOperationQueue alloc] init];
+    [mutatingQueue setMaxConcurrentOperationCount:1];
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+}
+
+- (void)tearDown
+{
+    [[MRBrew sharedBrew] setBackgroundQueue:_originalBackgroundQueue];
+    [[MRBrew sharedBrew] setMutatingQueue:_originalMutatingQueue];
+    _originalBackgroundQueue = nil;
+    _originalMutatingQueue = nil;
+    
+    [super tearDown];
+}
+
+#pragma mark - Adding Operations
+
+- (void)testAddOperationReturnsNodeWithDependencies
+{
+    // setup
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    
+    // execute
+    MRBrewOperationGraphNode *update = [graph addOperation:[MRBrewOperation updateOperation]];
+    MRBrewOperationGraphNode *list = [graph addOperation:[MRBrewOperation listOperation] dependencies:@[update]];
+    
+    // verify
+    XCTAssertEqualObjects([graph nodes], (@[update, list]), @"Should return the nodes in the order they were added.");
+    XCTAssertEqualObjects([update dependencies], @[], @"A node added without dependencies should have none.");
+    XCTAssertEqualObjects([list dependencies], @[update], @"A node should have the dependencies it was added with.");
+    XCTAssertEqual([list state], MRBrewOperationGraphNodeStatePending, @"A node should be pending until its operation has finished.");
+}
+
+- (void)testAddOperationWithDependencyFromAnotherGraphReturnsNil
+{
+    // setup
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraph *otherGraph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraphNode *update = [otherGraph addOperation:[MRBrewOperation updateOperation]];
+    
+    // execute
+    MRBrewOperationGraphNode *list = [graph addOperation:[MRBrewOperation listOperation] dependencies:@[update]];
+    
+    // verify
+    XCTAssertNil(list, @"Should only depend on nodes of the same graph, so that the graph cannot contain a cycle.");
+    XCTAssertEqual([[graph nodes] count], (NSUInteger)0, @"Should not add the operation.");
+}
+
+- (void)testAddOperationToPerformedGraphReturnsNil
+{
+    // setup
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    [graph beginPerforming];
+    
+    // execute
+    MRBrewOperationGraphNode *node = [graph addOperation:[MRBrewOperation listOperation]];
+    
+    // verify
+    XCTAssertNil(node, @"Should not add operations once the graph has been performed.");
+    XCTAssertFalse([graph beginPerforming], @"Should only be performed once.");
+}
+
+#pragma mark - Completing Nodes
+
+- (void)testCompleteNodeSetsStateFromResult
+{
+    // setup
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraphNode *install = [graph addOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]]];
+    MRBrewOperationGraphNode *list = [graph addOperation:[MRBrewOperation listOperation] dependencies:@[install]];
+    [graph beginPerforming];
+    
+    MRBrewOperationResult *failedResult = [[MRBrewOperationResult alloc] init];
+    [failedResult setError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorUnknown userInfo:nil]];
+    MRBrewOperationResult *cancelledResult = [[MRBrewOperationResult alloc] init];
+    [cancelledResult setError:[NSError errorWithDomain:@"uk.co.fidgetbox.MRBrew" code:MRBrewErrorOperationCancelled userInfo:nil]];
+    
+    // execute
+    BOOL finishedAfterInstall = [graph completeNode:install result:failedResult metrics:nil];
+    BOOL finishedAfterList = [graph completeNode:list result:cancelledResult metrics:nil];
+    
+    // verify
+    XCTAssertFalse(finishedAfterInstall, @"Graph should not finish while a node is pending.");
+    XCTAssertTrue(finishedAfterList, @"Graph should finish once every node has finished.");
+    XCTAssertEqual([install state], MRBrewOperationGraphNodeStateFailed, @"A node whose operation failed should be failed.");
+    XCTAssertEqual([list state], MRBrewOperationGraphNodeStateCancelled, @"A node whose operation was cancelled should be cancelled.");
+    XCTAssertFalse([graph succeeded], @"Graph should not succeed if any node failed.");
+    XCTAssertNotNil([graph finishDate], @"Graph should record when it finished.");
+}
+
+#pragma mark - Performing Graphs
+
+- (void)testPerformOperationGraphCancelsDependentsOfFailedOperation
+{
+    // setup: a brew that fails to install a formula named broken
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    NSString *brewPath = [directory stringByAppendingPathComponent:@"brew"];
+    NSString *script = @"#!/bin/sh\ncase \"$*\" in *broken*) echo 'Error: broken' >&2; exit 1;; esac\necho \"$@\"\n";
+    [script writeToFile:brewPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:brewPath error:nil];
+    
+    NSString *originalBrewPath = [[MRBrew sharedBrew] brewPath];
+    [[MRBrew sharedBrew] setBrewPath:brewPath];
+    
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraphNode *update = [graph addOperation:[MRBrewOperation updateOperation]];
+    MRBrewOperationGraphNode *install = [graph addOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"broken"]] dependencies:@[update]];
+    MRBrewOperationGraphNode *info = [graph addOperation:[MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]] dependencies:@[update]];
+    MRBrewOperationGraphNode *list = [graph addOperation:[MRBrewOperation listOperation] dependencies:@[install, info]];
+    
+    __block MRBrewOperationGraph *completedGraph = nil;
+    __block NSUInteger completionCount = 0;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:10];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperationGraph:graph completion:^(MRBrewOperationGraph *graph) {
+        completedGraph = graph;
+        completionCount++;
+    }];
+    
+    while (!completedGraph && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqual(completedGraph, graph, @"Completion should receive the graph once every operation has finished.");
+    XCTAssertEqual(completionCount, (NSUInteger)1, @"Completion should be called once.");
+    XCTAssertEqual([update state], MRBrewOperationGraphNodeStateSucceeded, @"An operation whose dependencies succeeded should be performed.");
+    XCTAssertEqual([install state], MRBrewOperationGraphNodeStateFailed, @"A failed operation should be reported as failed.");
+    XCTAssertEqual([info state], MRBrewOperationGraphNodeStateSucceeded, @"An operation that does not depend on the failed operation should be performed.");
+    XCTAssertEqualObjects([[info result] output], @"info wget\n", @"A node should hold the result of its operation.");
+    XCTAssertEqual([list state], MRBrewOperationGraphNodeStateCancelled, @"An operation that depends on a failed operation should be cancelled.");
+    XCTAssertNotNil([[update metrics] deliveryDate], @"A node should hold the metrics of its operation.");
+    XCTAssertTrue([[info metrics] queueDuration] >= 0, @"A node should record how long its operation was queued.");
+    XCTAssertFalse([graph succeeded], @"Graph should not succeed if an operation failed.");
+    XCTAssertEqual([[[MRBrew sharedBrew] operationGraphs] count], (NSUInteger)0, @"Should release the graph once it has finished.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:originalBrewPath];
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testPerformOperationGraphCompletesIfOperationCannotBeLaunched
+{
+    // setup
+    NSString *originalBrewPath = [[MRBrew sharedBrew] brewPath];
+    [[MRBrew sharedBrew] setBrewPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]];
+    
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraphNode *update = [graph addOperation:[MRBrewOperation updateOperation]];
+    MRBrewOperationGraphNode *list = [graph addOperation:[MRBrewOperation listOperation] dependencies:@[update]];
+    
+    __block MRBrewOperationGraph *completedGraph = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperationGraph:graph completion:^(MRBrewOperationGraph *graph) {
+        completedGraph = graph;
+    }];
+    
+    while (!completedGraph && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqual(completedGraph, graph, @"Completion should receive the graph even if an operation cannot be launched.");
+    XCTAssertEqual([update state], MRBrewOperationGraphNodeStateFailed, @"An operation that cannot be launched should be reported as failed.");
+    XCTAssertNotNil([update metrics], @"A node whose operation cannot be launched should hold its metrics.");
+    XCTAssertEqual([list state], MRBrewOperationGraphNodeStateCancelled, @"An operation that depends on one that cannot be launched should be cancelled.");
+    XCTAssertEqual([[[MRBrew sharedBrew] operationGraphs] count], (NSUInteger)0, @"Should release the graph once it has finished.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:originalBrewPath];
+}
+
+- (void)testPerformOperationGraphDoesNotCoalesceOtherOperationsWithItsOperations
+{
+    // setup
+    [[MRBrew sharedBrew] setBackgroundQueue:[OCMockObject niceMockForClass:[NSOperationQueue class]]];
+    [[MRBrew sharedBrew] setMutatingQueue:[OCMockObject niceMockForClass:[NSOperationQueue class]]];
+    
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    MRBrewOperationGraphNode *update = [graph addOperation:[MRBrewOperation updateOperation]];
+    [graph addOperation:[MRBrewOperation listOperation] dependencies:@[update]];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperationGraph:graph completion:nil];
+    
+    // verify
+    XCTAssertEqual([[[MRBrew sharedBrew] inFlightWorkers] count], (NSUInteger)0, @"Operations of a graph, which wait for their dependencies, should not be attached to by other operations.");
+    
+    // cleanup
+    [[[MRBrew sharedBrew] operationGraphs] removeAllObjects];
+}
+
+- (void)testPerformEmptyOperationGraphCallsCompletion
+{
+    // setup
+    MRBrewOperationGraph *graph = [MRBrewOperationGraph operationGraph];
+    __block BOOL completed = NO;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperationGraph:graph completion:^(MRBrewOperationGraph *graph) {
+        completed = YES;
+    }];
+    
+    while (!completed && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue(completed, @"Completion should be called for a graph without operations.");
+    XCTAssertTrue([graph succeeded], @"A graph without operations should succeed.");
+}
+
+@end
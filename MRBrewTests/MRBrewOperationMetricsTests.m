@@ -0,0 +1,102 @@
+//
+//  MRBrewOperationMetricsTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewOperationMetrics+Private.h"
+
+@interface MRBrewOperationMetricsTests : XCTestCase
+
+@end
+
+@implementation MRBrewOperationMetricsTests
+
+#pragma mark - Phases
+
+- (void)testPhaseDurationsAreMeasuredBetweenDates
+{
+    // setup
+    NSDate *enqueueDate = [NSDate dateWithTimeIntervalSinceReferenceDate:100];
+    MRBrewOperationMetrics *metrics = [[MRBrewOperationMetrics alloc] init];
+    [metrics setEnqueueDate:enqueueDate];
+    [metrics setLaunchDate:[enqueueDate dateByAddingTimeInterval:0.5]];
+    [metrics setExitDate:[enqueueDate dateByAddingTimeInterval:2.0]];
+    [metrics setDeliveryDate:[enqueueDate dateByAddingTimeInterval:2.25]];
+    
+    // execute & verify
+    XCTAssertEqualWithAccuracy([metrics queueDuration], 0.5, 0.0001, @"Queue duration should be measured from enqueue to launch.");
+    XCTAssertEqualWithAccuracy([metrics executionDuration], 1.5, 0.0001, @"Execution duration should be measured from launch to exit.");
+    XCTAssertEqualWithAccuracy([metrics totalDuration], 2.25, 0.0001, @"Total duration should be measured from enqueue to delivery.");
+}
+
+- (void)testPhasesThatDidNotOccurHaveZeroDuration
+{
+    // setup
+    MRBrewOperationMetrics *metrics = [[MRBrewOperationMetrics alloc] init];
+    [metrics setEnqueueDate:[NSDate date]];
+    
+    // execute & verify
+    XCTAssertEqual([metrics queueDuration], (NSTimeInterval)0, @"Operations that never launched should have zero queue duration.");
+    XCTAssertEqual([metrics executionDuration], (NSTimeInterval)0, @"Operations that never launched should have zero execution duration.");
+}
+
+#pragma mark - Resource Usage
+
+- (void)testByteCountsAreRecordedPerStream
+{
+    // setup
+    MRBrewOperationMetrics *metrics = [[MRBrewOperationMetrics alloc] init];
+    
+    // execute
+    [metrics addByteCount:10 errorOutput:NO];
+    NSDate *firstOutputDate = [metrics firstOutputDate];
+    [metrics addByteCount:5 errorOutput:YES];
+    [metrics addByteCount:20 errorOutput:NO];
+    
+    // verify
+    XCTAssertEqual([metrics outputByteCount], 30ULL, @"Output bytes should be accumulated.");
+    XCTAssertEqual([metrics errorOutputByteCount], 5ULL, @"Error output bytes should be accumulated separately.");
+    XCTAssertNotNil(firstOutputDate, @"Date of first output should be recorded.");
+    XCTAssertEqualObjects([metrics firstOutputDate], firstOutputDate, @"Date of first output should not change once recorded.");
+}
+
+- (void)testResourceUsageIsConvertedToSeconds
+{
+    // setup
+    MRBrewOperationMetrics *metrics = [[MRBrewOperationMetrics alloc] init];
+    struct rusage resourceUsage = {0};
+    resourceUsage.ru_utime.tv_sec = 1;
+    resourceUsage.ru_utime.tv_usec = 500000;
+    resourceUsage.ru_stime.tv_usec = 250000;
+    
+    // execute
+    [metrics setResourceUsage:resourceUsage];
+    
+    // verify
+    XCTAssertEqualWithAccuracy([metrics userCPUTime], 1.5, 0.0001, @"User CPU time should be converted to seconds.");
+    XCTAssertEqualWithAccuracy([metrics systemCPUTime], 0.25, 0.0001, @"System CPU time should be converted to seconds.");
+}
+
+@end
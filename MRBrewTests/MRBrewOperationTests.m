@@ -428,6 +428,17 @@
     XCTAssertFalse([operation1 isEqualToOperation:operation2], @"Operations that have a different 'parameters' property should not be equal.");
 }
 
+- (void)testEqualityOfOperationsWithDifferentJSONOutputProperty
+{
+    // setup
+    MRBrewOperation *operation1 = [MRBrewOperation listOperation];
+    MRBrewOperation *operation2 = [MRBrewOperation listOperation];
+    [operation2 setUsesJSONOutput:YES];
+    
+    // execute & verify
+    XCTAssertFalse([operation1 isEqualToOperation:operation2], @"Operations that have a different 'usesJSONOutput' property should not be equal.");
+}
+
 - (void)testEqualityOfOperationWithNil
 {
     // setup
@@ -487,6 +498,83 @@
     XCTAssertTrue([[operation description] isEqualToString:@"operation-name"], @"Should contain operation name.");
 }
 
+#pragma mark - Classifying Operations
+
+- (void)testQueryOperationsAreReadOnly
+{
+    // execute & verify
+    XCTAssertTrue([[MRBrewOperation listOperation] isReadOnly], @"List operation should be read-only.");
+    XCTAssertTrue([[MRBrewOperation searchOperation] isReadOnly], @"Search operation should be read-only.");
+    XCTAssertTrue([[MRBrewOperation infoOperation:_formula] isReadOnly], @"Info operation should be read-only.");
+    XCTAssertTrue([[MRBrewOperation optionsOperation:_formula] isReadOnly], @"Options operation should be read-only.");
+    XCTAssertTrue([[MRBrewOperation outdatedOperation] isReadOnly], @"Outdated operation should be read-only.");
+}
+
+- (void)testMutatingOperationsAreNotReadOnly
+{
+    // execute & verify
+    XCTAssertFalse([[MRBrewOperation updateOperation] isReadOnly], @"Update operation should not be read-only.");
+    XCTAssertFalse([[MRBrewOperation installOperation:_formula] isReadOnly], @"Install operation should not be read-only.");
+    XCTAssertFalse([[MRBrewOperation removeOperation:_formula] isReadOnly], @"Remove operation should not be read-only.");
+    XCTAssertFalse([[MRBrewOperation operationWithName:@"operation-name" formula:nil parameters:nil] isReadOnly], @"Unknown operations should not be read-only.");
+}
+
+- (void)testJSONOutputIsSupportedByInfoListAndOutdatedOperations
+{
+    // execute & verify
+    XCTAssertTrue([MRBrewOperation supportsJSONOutputForOperationName:MRBrewOperationInfoIdentifier], @"Info operations should support JSON output.");
+    XCTAssertTrue([MRBrewOperation supportsJSONOutputForOperationName:MRBrewOperationListIdentifier], @"List operations should support JSON output.");
+    XCTAssertTrue([MRBrewOperation supportsJSONOutputForOperationName:MRBrewOperationOutdatedIdentifier], @"Outdated operations should support JSON output.");
+    XCTAssertFalse([MRBrewOperation supportsJSONOutputForOperationName:MRBrewOperationSearchIdentifier], @"Search operations should not support JSON output.");
+    XCTAssertFalse([MRBrewOperation supportsJSONOutputForOperationName:nil], @"Operations without a name should not support JSON output.");
+}
+
+- (void)testOperationIsJSONOperationOnlyWhenJSONOutputIsSupported
+{
+    // setup
+    MRBrewOperation *listOperation = [MRBrewOperation listOperation];
+    MRBrewOperation *searchOperation = [MRBrewOperation searchOperation];
+    [listOperation setUsesJSONOutput:YES];
+    [searchOperation setUsesJSONOutput:YES];
+    
+    // execute & verify
+    XCTAssertFalse([[MRBrewOperation listOperation] isJSONOperation], @"Operations should not use JSON output by default.");
+    XCTAssertTrue([listOperation isJSONOperation], @"A list operation using JSON output should be a JSON operation.");
+    XCTAssertFalse([searchOperation isJSONOperation], @"A search operation should never be a JSON operation.");
+}
+
+- (void)testOperationIsInProcessOperationOnlyForUnqualifiedListOperation
+{
+    // setup
+    MRBrewOperation *listOperation = [MRBrewOperation listOperation];
+    MRBrewOperation *versionsOperation = [MRBrewOperation operationWithType:MRBrewOperationList formula:nil parameters:@[@"--versions"]];
+    MRBrewOperation *JSONOperation = [MRBrewOperation listOperation];
+    MRBrewOperation *searchOperation = [MRBrewOperation searchOperation];
+    for (MRBrewOperation *operation in @[listOperation, versionsOperation, JSONOperation, searchOperation]) {
+        [operation setPerformsInProcess:YES];
+    }
+    [JSONOperation setUsesJSONOutput:YES];
+    
+    // execute & verify
+    XCTAssertFalse([[MRBrewOperation listOperation] isInProcessOperation], @"Operations should not be performed in-process by default.");
+    XCTAssertTrue([listOperation isInProcessOperation], @"A list operation performed in-process should be an in-process operation.");
+    XCTAssertFalse([versionsOperation isInProcessOperation], @"A list operation with parameters should be performed by brew.");
+    XCTAssertFalse([JSONOperation isInProcessOperation], @"A list operation with JSON output should be performed by brew.");
+    XCTAssertFalse([searchOperation isInProcessOperation], @"A search operation should never be an in-process operation.");
+    XCTAssertTrue([[listOperation copy] performsInProcess], @"A copy should be performed in-process.");
+    XCTAssertTrue([listOperation isEqualToOperation:[MRBrewOperation listOperation]], @"Operations that differ only in where they are performed should be equal.");
+}
+
+- (void)testOutdatedOperationIsInProcessOperation
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation outdatedOperation];
+    [operation setPerformsInProcess:YES];
+    
+    // execute & verify
+    XCTAssertTrue([operation isInProcessOperation], @"An outdated operation performed in-process should be an in-process operation.");
+}
+
 #pragma mark - Copying
 
 -(void)testCopiedOperationIsEqualToOriginalOperation
@@ -500,4 +588,57 @@
     XCTAssertTrue([copy isEqualToOperation:operation], @"Operation copy should be identical to original operation.");
 }
 
+- (void)testOperationSharesInternedFormula
+{
+    // setup
+    MRBrewFormula *formula = [MRBrewFormula internedFormulaWithName:@"formula-name"];
+    
+    // execute
+    MRBrewOperation *operation = [MRBrewOperation installOperation:formula];
+    MRBrewOperation *copy = [operation copy];
+    
+    // verify
+    XCTAssertEqual([operation formula], formula, @"Operation should share an interned formula rather than copy it.");
+    XCTAssertEqual([copy formula], formula, @"Operation copy should share an interned formula rather than copy it.");
+}
+
+- (void)testOperationPriorityIsNormalByDefault
+{
+    // execute & verify
+    XCTAssertEqual([[MRBrewOperation listOperation] priority], MRBrewOperationPriorityNormal, @"Operations should have normal priority by default.");
+}
+
+- (void)testEqualityOfOperationsWithDifferentPriorityProperty
+{
+    // setup
+    MRBrewOperation *operation1 = [MRBrewOperation listOperation];
+    MRBrewOperation *operation2 = [MRBrewOperation listOperation];
+    [operation2 setPriority:MRBrewOperationPriorityHigh];
+    
+    // execute & verify
+    XCTAssertTrue([operation1 isEqualToOperation:operation2], @"Operations that differ only in priority should be equal.");
+}
+
+-(void)testCopiedOperationRetainsPriorityProperty
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [operation setPriority:MRBrewOperationPriorityLow];
+    MRBrewOperation *copy = [operation copy];
+    
+    // execute & verify
+    XCTAssertEqual([copy priority], MRBrewOperationPriorityLow, @"Operation copy should have the priority of the original operation.");
+}
+
+-(void)testCopiedOperationRetainsJSONOutputProperty
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation outdatedOperation];
+    [operation setUsesJSONOutput:YES];
+    MRBrewOperation *copy = [operation copy];
+    
+    // execute & verify
+    XCTAssertTrue([copy usesJSONOutput], @"Operation copy should use JSON output when the original operation does.");
+}
+
 @end
@@ -0,0 +1,199 @@
+//
+//  MRBrewOutdatedEngineTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewOutdatedEngine.h"
+#import "MRBrewOutdatedEngine+Private.h"
+#import "MRBrewFormula.h"
+
+@interface MRBrewOutdatedEngineTests : XCTestCase
+{
+    NSString *_prefix;
+    MRBrewOutdatedEngine *_engine;
+}
+
+@end
+
+@implementation MRBrewOutdatedEngineTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // a synthetic installation with outdated core and tap formulae
+    _prefix = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    for (NSString *kegPath in @[@"wget/1.14", @"git/1.9.0", @"foo/2.0"]) {
+        [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:[@"Cellar" stringByAppendingPathComponent:kegPath]] withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Library/Formula"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Library/Taps/homebrew/homebrew-science"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    [self writeFormula:@"Formula/wget.rb" url:@"http://ftpmirror.gnu.org/wget/wget-1.15.tar.xz" extra:@""];
+    [self writeFormula:@"Formula/git.rb" url:@"https://git-core.googlecode.com/files/git-1.9.0.tar.gz" extra:@""];
+    [self writeFormula:@"Taps/homebrew/homebrew-science/foo.rb" url:@"http://example.com/foo-2.0.tar.gz" extra:@"  revision 1\n"];
+    
+    _engine = [MRBrewOutdatedEngine engineWithCellarPath:[_prefix stringByAppendingPathComponent:@"Cellar"]
+                                             formulaPath:[_prefix stringByAppendingPathComponent:@"Library/Formula"]
+                                                tapsPath:[_prefix stringByAppendingPathComponent:@"Library/Taps"]];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:_prefix error:NULL];
+    _prefix = nil;
+    _engine = nil;
+    
+    [super tearDown];
+}
+
+- (void)writeFormula:(NSString *)path url:(NSString *)url extra:(NSString *)extra
+{
+    NSString *name = [[path lastPathComponent] stringByDeletingPathExtension];
+    NSString *contents = [NSString stringWithFormat:@"class %@ < Formula\n  homepage \"http://example.com\"\n  url \"%@\"\n  sha1 \"0\"\n%@\n  devel do\n    url \"http://example.com/%@-9.0.tar.gz\"\n  end\nend\n", [name capitalizedString], url, extra, name];
+    [contents writeToFile:[[_prefix stringByAppendingPathComponent:@"Library"] stringByAppendingPathComponent:path] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+}
+
+#pragma mark - Outdated Formulae
+
+- (void)testOutdatedFormulaeCompareCellarWithFormulaFiles
+{
+    // execute
+    NSArray *formulae = [_engine outdatedFormulaeWithError:NULL];
+    
+    // verify
+    XCTAssertEqualObjects([formulae valueForKey:@"name"], (@[@"foo", @"wget"]), @"Should return the formulae whose installed versions precede those of their formula files, sorted by name.");
+    XCTAssertTrue([[formulae lastObject] isUpdated], @"Outdated formulae should be updated.");
+    XCTAssertTrue([[formulae lastObject] isInstalled], @"Outdated formulae should be installed.");
+    XCTAssertEqualObjects([[formulae lastObject] version], @"1.15", @"Outdated formulae should include their current version.");
+    XCTAssertEqualObjects([[formulae lastObject] installedVersions], @[@"1.14"], @"Outdated formulae should include their installed versions.");
+    XCTAssertEqualObjects([[formulae objectAtIndex:0] version], @"2.0_1", @"A formula in a tap whose revision has changed should be outdated.");
+}
+
+- (void)testRepeatedQueryReadsOnlyChangedFormulaFiles
+{
+    // setup
+    [_engine outdatedFormulaeWithError:NULL];
+    NSUInteger initialReadCount = [_engine formulaFileReadCount];
+    
+    // execute
+    [_engine outdatedFormulaeWithError:NULL];
+    NSUInteger unchangedReadCount = [_engine formulaFileReadCount];
+    
+    [self writeFormula:@"Formula/git.rb" url:@"https://git-core.googlecode.com/files/git-1.9.1.tar.gz" extra:@""];
+    NSString *gitPath = [_prefix stringByAppendingPathComponent:@"Library/Formula/git.rb"];
+    [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:60]} ofItemAtPath:gitPath error:NULL];
+    NSArray *formulae = [_engine outdatedFormulaeWithError:NULL];
+    
+    // verify
+    XCTAssertEqual(initialReadCount, (NSUInteger)3, @"Should read the formula file of each installed formula.");
+    XCTAssertEqual(unchangedReadCount, initialReadCount, @"Should not read formula files that have not changed.");
+    XCTAssertEqual([_engine formulaFileReadCount], initialReadCount + 1, @"Should read only the formula file that changed.");
+    XCTAssertEqualObjects([formulae valueForKey:@"name"], (@[@"foo", @"git", @"wget"]), @"Should return the formula whose file changed.");
+}
+
+- (void)testMissingCellarReturnsError
+{
+    // setup
+    MRBrewOutdatedEngine *engine = [MRBrewOutdatedEngine engineWithCellarPath:[_prefix stringByAppendingPathComponent:@"missing"] formulaPath:nil tapsPath:nil];
+    NSError *error = nil;
+    
+    // execute
+    NSArray *formulae = [engine outdatedFormulaeWithError:&error];
+    
+    // verify
+    XCTAssertNil(formulae, @"Should not return formulae for a missing Cellar.");
+    XCTAssertEqualObjects([error domain], NSPOSIXErrorDomain, @"Should return a POSIX error.");
+}
+
+- (void)testInstalledFormulaWithoutFormulaFileReturnsError
+{
+    // setup
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Cellar/orphan/1.0"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    NSError *error = nil;
+    
+    // execute
+    NSArray *formulae = [_engine outdatedFormulaeWithError:&error];
+    
+    // verify
+    XCTAssertNil(formulae, @"Should not return formulae when an installed formula has no formula file.");
+    XCTAssertEqualObjects([error domain], MRBrewOutdatedEngineErrorDomain, @"Should return an outdated engine error.");
+    XCTAssertEqual([error code], (NSInteger)MRBrewOutdatedEngineErrorFormulaFileNotFound, @"Should report that the formula file could not be found.");
+}
+
+- (void)testInstalledFormulaWithUndeterminedVersionReturnsError
+{
+    // setup
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_prefix stringByAppendingPathComponent:@"Cellar/bar/HEAD"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    NSString *barPath = [_prefix stringByAppendingPathComponent:@"Library/Formula/bar.rb"];
+    [@"class Bar < Formula\n  head \"https://example.com/bar.git\"\nend\n" writeToFile:barPath atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    NSError *error = nil;
+    
+    // execute
+    NSArray *formulae = [_engine outdatedFormulaeWithError:&error];
+    
+    // verify
+    XCTAssertNil(formulae, @"Should not return formulae when the version of an installed formula cannot be determined.");
+    XCTAssertEqualObjects([error domain], MRBrewOutdatedEngineErrorDomain, @"Should return an outdated engine error.");
+    XCTAssertEqual([error code], (NSInteger)MRBrewOutdatedEngineErrorVersionUndetermined, @"Should report that the version could not be determined.");
+    XCTAssertEqualObjects([[error userInfo] objectForKey:NSFilePathErrorKey], barPath, @"Should include the path of the formula file.");
+}
+
+#pragma mark - Formula Versions
+
+- (void)testVersionOfFormulaPrefersStableBlockAndExplicitVersion
+{
+    // setup
+    NSString *contents = @"class Foo < Formula\n"
+                         @"  url \"http://example.com/foo-1.0.tar.gz\"\n"
+                         @"  stable do\n"
+                         @"    url \"http://example.com/foo-latest.tar.gz\"\n"
+                         @"    version \"1.2\"\n"
+                         @"  end\n"
+                         @"  resource \"bar\" do\n"
+                         @"    url \"http://example.com/bar-3.0.tar.gz\"\n"
+                         @"  end\n"
+                         @"  def install\n"
+                         @"    version = \"4.0\"\n"
+                         @"  end\n"
+                         @"end\n";
+    
+    // execute & verify
+    XCTAssertEqualObjects([MRBrewOutdatedEngine versionOfFormulaWithContents:contents], @"1.2", @"Should take the version of the stable block, ignoring other blocks.");
+    XCTAssertNil([MRBrewOutdatedEngine versionOfFormulaWithContents:@"class Foo < Formula\n  head \"https://example.com/foo.git\"\nend\n"], @"Should return nil for a formula without a version.");
+}
+
+- (void)testVersionFromURL
+{
+    // execute & verify
+    XCTAssertEqualObjects([MRBrewOutdatedEngine versionFromURL:@"http://ftpmirror.gnu.org/wget/wget-1.15.tar.xz"], @"1.15", @"Should take the version from the file name.");
+    XCTAssertEqualObjects([MRBrewOutdatedEngine versionFromURL:@"https://github.com/joyent/node/archive/v0.10.26.tar.gz"], @"0.10.26", @"Should take the version of a tag archive.");
+    XCTAssertEqualObjects([MRBrewOutdatedEngine versionFromURL:@"http://downloads.sourceforge.net/project/boost/boost/1.55.0/boost_1_55_0.tar.bz2"], @"1.55.0", @"Should separate versions separated by underscores with periods.");
+    XCTAssertEqualObjects([MRBrewOutdatedEngine versionFromURL:@"http://sourceforge.net/projects/foo/files/foo-2.1-src.zip/download"], @"2.1", @"Should take the version from the file name of a SourceForge download.");
+    XCTAssertNil([MRBrewOutdatedEngine versionFromURL:@"http://example.com/foo.tar.gz"], @"Should return nil for a url without a version.");
+}
+
+@end
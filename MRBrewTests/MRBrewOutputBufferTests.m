@@ -0,0 +1,252 @@
+//
+//  MRBrewOutputBufferTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewOutputBuffer.h"
+
+@interface MRBrewOutputBufferTests : XCTestCase {
+    NSMutableArray *_deliveredOutput;
+    MRBrewOutputBuffer *_buffer;
+}
+
+@end
+
+@implementation MRBrewOutputBufferTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _deliveredOutput = [NSMutableArray array];
+    
+    NSMutableArray *deliveredOutput = _deliveredOutput;
+    _buffer = [[MRBrewOutputBuffer alloc] initWithHandler:^(NSString *output) {
+        @synchronized(deliveredOutput) {
+            [deliveredOutput addObject:output];
+        }
+    }];
+    
+    // disable time-based delivery unless a test explicitly relies upon it
+    [_buffer setDeliveryInterval:60.0];
+}
+
+- (void)tearDown
+{
+    _buffer = nil;
+    _deliveredOutput = nil;
+    
+    [super tearDown];
+}
+
+- (void)appendString:(NSString *)string
+{
+    [_buffer appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)testBufferHasDefaultProperties
+{
+    // execute
+    MRBrewOutputBuffer *buffer = [[MRBrewOutputBuffer alloc] init];
+    
+    // verify
+    XCTAssertTrue([buffer capacity] == 64 * 1024, @"Default capacity should be 64 KiB.");
+    XCTAssertTrue([buffer deliveryThreshold] == 16 * 1024, @"Default delivery threshold should be 16 KiB.");
+    XCTAssertEqualWithAccuracy([buffer deliveryInterval], 0.1, 0.0001, @"Default delivery interval should be 0.1 seconds.");
+    XCTAssertTrue([buffer length] == 0, @"A new buffer should not hold any bytes.");
+}
+
+- (void)testOutputIsDeliveredOnFlush
+{
+    // execute
+    [self appendString:@"test-formula\ntest-formula-two\n"];
+    [_buffer flush];
+    
+    // verify
+    XCTAssertEqualObjects(_deliveredOutput, @[@"test-formula\ntest-formula-two\n"], @"Held output should be delivered when the buffer is flushed.");
+    XCTAssertTrue([_buffer length] == 0, @"No bytes should be held after the buffer is flushed.");
+}
+
+- (void)testSmallWritesAreCoalescedIntoSingleDelivery
+{
+    // execute
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self appendString:@"line\n"];
+    }
+    
+    // verify
+    XCTAssertTrue([_deliveredOutput count] == 0, @"Output below the delivery threshold should be held.");
+    
+    // execute
+    [_buffer flush];
+    
+    // verify
+    XCTAssertTrue([_deliveredOutput count] == 1, @"Held output should be delivered in a single call.");
+    XCTAssertTrue([[_deliveredOutput firstObject] length] == 500, @"All held output should be delivered.");
+}
+
+- (void)testOutputIsDeliveredWhenThresholdIsReached
+{
+    // setup
+    [_buffer setDeliveryThreshold:8];
+    
+    // execute
+    [self appendString:@"test-formula\n"];
+    
+    // verify
+    XCTAssertEqualObjects(_deliveredOutput, @[@"test-formula\n"], @"Output should be delivered once the delivery threshold is reached.");
+}
+
+- (void)testPartialLineIsHeldUntilLineIsComplete
+{
+    // setup
+    [_buffer setDeliveryThreshold:1];
+    
+    // execute
+    [self appendString:@"first\nsec"];
+    
+    // verify
+    XCTAssertEqualObjects(_deliveredOutput, @[@"first\n"], @"Only complete lines should be delivered.");
+    XCTAssertTrue([_buffer length] == 3, @"The partial line should be held by the buffer.");
+    
+    // execute
+    [self appendString:@"ond\n"];
+    
+    // verify
+    XCTAssertEqualObjects([_deliveredOutput lastObject], @"second\n", @"The partial line should be delivered once it is complete.");
+}
+
+- (void)testMultibyteCharacterSplitAcrossReadsIsPreserved
+{
+    // setup
+    [_buffer setDeliveryThreshold:1];
+    const uint8_t first[] = {'c', 'a', 'f', 0xC3};
+    const uint8_t second[] = {0xA9, '\n'};
+    
+    // execute
+    [_buffer appendData:[NSData dataWithBytes:first length:sizeof(first)]];
+    [_buffer appendData:[NSData dataWithBytes:second length:sizeof(second)]];
+    
+    // verify
+    XCTAssertEqualObjects(_deliveredOutput, @[@"café\n"], @"A character split across reads should be delivered intact.");
+}
+
+- (void)testInvalidBytesAreReplacedWithoutAffectingValidOutput
+{
+    // setup
+    const uint8_t bytes[] = {'c', 'a', 'f', 0xC3, 0xA9, ' ', 0xFF, ' ', 0xE2, 0x9C, 0x93, 0xC0, 0xAF, '\n'};
+    
+    // execute
+    [_buffer appendData:[NSData dataWithBytes:bytes length:sizeof(bytes)]];
+    [_buffer flush];
+    
+    // verify
+    XCTAssertEqualObjects(_deliveredOutput, @[@"caf\u00E9 \uFFFD \u2713\uFFFD\uFFFD\n"], @"Only bytes that are not valid UTF-8 should be replaced.");
+}
+
+- (void)testOutputCanBeAppendedFromAnotherThreadWhileHandlerIsCalled
+{
+    // setup
+    __block BOOL appended = NO;
+    __block MRBrewOutputBuffer *buffer = nil;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    buffer = [[MRBrewOutputBuffer alloc] initWithHandler:^(NSString *output) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [buffer appendData:[@"second\n" dataUsingEncoding:NSUTF8StringEncoding]];
+            dispatch_semaphore_signal(semaphore);
+        });
+        appended = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2.0 * NSEC_PER_SEC))) == 0;
+    }];
+    [buffer setDeliveryInterval:60.0];
+    [buffer appendData:[@"first\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    // execute
+    [buffer flush];
+    
+    // verify
+    XCTAssertTrue(appended, @"The buffer should not be locked while its handler is called.");
+    XCTAssertTrue([buffer length] == 7, @"Output appended while the handler is called should be held.");
+    
+    // cleanup
+    buffer = nil;
+}
+
+- (void)testHeldBytesAreBoundedByCapacity
+{
+    // setup
+    [_buffer setCapacity:16];
+    NSMutableString *line = [NSMutableString string];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [line appendString:@"x"];
+    }
+    
+    // execute
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self appendString:@"x"];
+        
+        // verify
+        XCTAssertTrue([_buffer length] < 16, @"The number of held bytes should not reach the capacity of the buffer.");
+    }
+    [_buffer flush];
+    
+    // verify
+    XCTAssertEqualObjects([_deliveredOutput componentsJoinedByString:@""], line, @"A line longer than the capacity should be delivered in pieces.");
+}
+
+- (void)testLongLineIsNotSplitWithinMultibyteCharacter
+{
+    // setup
+    [_buffer setCapacity:4];
+    
+    // execute
+    [self appendString:@"abcéé"];
+    [_buffer flush];
+    
+    // verify
+    for (NSString *output in _deliveredOutput) {
+        XCTAssertTrue([output rangeOfString:@"�"].location == NSNotFound, @"Pieces of a long line should end on a character boundary.");
+    }
+    XCTAssertEqualObjects([_deliveredOutput componentsJoinedByString:@""], @"abcéé", @"All output should be delivered.");
+}
+
+- (void)testOutputIsDeliveredWhenIntervalElapses
+{
+    // setup
+    [_buffer setDeliveryInterval:0.05];
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [self appendString:@"test-formula\n"];
+    
+    while ([_deliveredOutput count] == 0 && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    @synchronized(_deliveredOutput) {
+        XCTAssertEqualObjects(_deliveredOutput, @[@"test-formula\n"], @"Held lines should be delivered once the delivery interval elapses.");
+    }
+}
+
+@end
@@ -0,0 +1,218 @@
+//
+//  MRBrewOutputParserSessionTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewOutputParserSession.h"
+#import "MRBrewOutputParser.h"
+#import "MRBrewOperation.h"
+#import "MRBrewFormula.h"
+#import "MRBrewInstallOption.h"
+
+@interface MRBrewOutputParserSessionTests : XCTestCase
+{
+    NSMutableArray *_parsedObjects;
+    NSUInteger _handlerCallCount;
+}
+
+@end
+
+@implementation MRBrewOutputParserSessionTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _parsedObjects = [NSMutableArray array];
+    _handlerCallCount = 0;
+}
+
+- (MRBrewOutputParserSession *)sessionForOperation:(MRBrewOperation *)operation
+{
+    return [[MRBrewOutputParserSession alloc] initWithOperation:operation handler:^(NSArray *objects) {
+        [_parsedObjects addObjectsFromArray:objects];
+        _handlerCallCount++;
+    }];
+}
+
+#pragma mark - Supported Operations
+
+- (void)testSessionIsNotCreatedForUnsupportedOperation
+{
+    // execute & verify
+    XCTAssertNil([self sessionForOperation:[MRBrewOperation updateOperation]], @"Should not create a session for an operation whose output cannot be parsed.");
+}
+
+#pragma mark - List and Search Output
+
+- (void)testFormulaeAreParsedAsEachLineIsCompleted
+{
+    // setup
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation listOperation]];
+    
+    // execute
+    [session appendString:@"wget\ncu"];
+    
+    // verify
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"wget"]), @"Should parse complete lines without waiting for the output to finish.");
+    
+    // execute
+    [session appendString:@"rl\n"];
+    [session finish];
+    
+    // verify
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"wget", @"curl"]), @"Should parse a line split across chunks once it is completed.");
+    XCTAssertTrue([[_parsedObjects objectAtIndex:1] isInstalled], @"Formulae parsed from list output should be installed.");
+}
+
+- (void)testFinishParsesLineWithoutLineBreak
+{
+    // setup
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation listOperation]];
+    [session appendString:@"wget"];
+    
+    // execute
+    [session finish];
+    
+    // verify
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"wget"]), @"Should parse the final line when the session is finished.");
+}
+
+- (void)testMultibyteCharacterSplitAcrossDataChunksIsParsed
+{
+    // setup
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation searchOperation]];
+    NSData *data = [@"café\n" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    // execute
+    [session appendData:[data subdataWithRange:NSMakeRange(0, 4)]];
+    [session appendData:[data subdataWithRange:NSMakeRange(4, [data length] - 4)]];
+    
+    // verify
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"café"]), @"Should parse a character split across chunks of data.");
+    XCTAssertFalse([[_parsedObjects objectAtIndex:0] isInstalled], @"Formulae parsed from search output should not be installed.");
+}
+
+- (void)testSearchOutputReportingNoFormulaFoundYieldsNoObjects
+{
+    // setup
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation searchOperation]];
+    
+    // execute
+    [session appendString:@"No formula found for \"zzz\".\n"];
+    [session finish];
+    
+    // verify
+    XCTAssertEqual(_handlerCallCount, (NSUInteger)0, @"Should not parse objects from search output reporting no results.");
+}
+
+- (void)testOutputAppendedAfterFinishIsIgnored
+{
+    // setup
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation listOperation]];
+    [session finish];
+    
+    // execute
+    [session appendString:@"wget\n"];
+    
+    // verify
+    XCTAssertEqual([_parsedObjects count], (NSUInteger)0, @"Should ignore output appended after the session is finished.");
+}
+
+#pragma mark - Options Output
+
+- (void)testOptionIsParsedOnceTheNextOptionBegins
+{
+    // setup
+    MRBrewFormula *formula = [MRBrewFormula formulaWithName:@"test-formula"];
+    MRBrewOutputParserSession *session = [self sessionForOperation:[MRBrewOperation optionsOperation:formula]];
+    
+    // execute
+    [session appendString:@"--test-option\n\tTest option description\n"];
+    
+    // verify
+    XCTAssertEqual([_parsedObjects count], (NSUInteger)0, @"Should not parse an option whose description may continue.");
+    
+    // execute
+    [session appendString:@"--test-option-two\n\tTest option description two\n\n"];
+    [session finish];
+    
+    // verify
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"--test-option", @"--test-option-two"]), @"Should parse each option in order.");
+}
+
+#pragma mark - JSON Output
+
+- (void)testSessionIsCreatedForInfoOperationOnlyWithJSONOutput
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    MRBrewOperation *JSONOperation = [MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [JSONOperation setUsesJSONOutput:YES];
+    
+    // execute & verify
+    XCTAssertNil([self sessionForOperation:operation], @"Should not create a session for the text output of an info operation.");
+    XCTAssertNotNil([self sessionForOperation:JSONOperation], @"Should create a session for the JSON output of an info operation.");
+}
+
+- (void)testFormulaeAreDecodedAsEachJSONObjectIsCompleted
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [operation setUsesJSONOutput:YES];
+    MRBrewOutputParserSession *session = [self sessionForOperation:operation];
+    
+    // execute & verify
+    [session appendString:@"[{\"name\":\"wget\",\"installed\":[{\"version\":\"1.15\"}]},{\"na"];
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"wget"]), @"Should decode the completed formula only.");
+    
+    [session appendString:@"me\":\"git\",\"installed\":[{\"version\":\"2.1.2\"}]}]"];
+    [session finish];
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], (@[@"wget", @"git"]), @"Should decode the remaining formula.");
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"installedVersions"], (@[@[@"1.15"], @[@"2.1.2"]]), @"Should decode the installed versions of each formula.");
+}
+
+#pragma mark - Equivalence
+
+- (void)testObjectsMatchThoseParsedFromCompleteOutput
+{
+    // setup
+    NSString *output = @"a\nbb\n\nccc\ndddd\neeeee\n";
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    MRBrewOutputParserSession *session = [self sessionForOperation:operation];
+    
+    // execute
+    for (NSUInteger i = 0; i < [output length]; i++) {
+        [session appendString:[output substringWithRange:NSMakeRange(i, 1)]];
+    }
+    [session finish];
+    
+    // verify
+    NSArray *expected = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:nil];
+    XCTAssertEqualObjects([_parsedObjects valueForKey:@"name"], [expected valueForKey:@"name"], @"Output appended a character at a time should yield the same objects as the complete output.");
+}
+
+@end
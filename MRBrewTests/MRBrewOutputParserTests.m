@@ -121,6 +121,49 @@
     XCTAssertNil(error, @"An error object should not be returned when a valid output string is provided.");
 }
 
+- (void)testParsedObjectsForListOperationAreInstalled
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationListIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:_fakeOutputFromListOperation error:nil];
+    
+    // verify
+    for (MRBrewFormula *formula in objects) {
+        XCTAssertTrue([formula isInstalled], @"Formulae parsed from list operation output should be installed.");
+    }
+}
+
+- (void)testParsedObjectsForListOperationHaveNamesInOutputOrder
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationListIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"wget\n\ncafé\nzsh" error:nil];
+    
+    // verify
+    XCTAssertEqualObjects([objects valueForKey:@"name"], (@[@"wget", @"café", @"zsh"]), @"Should parse each non-blank line, including non-ASCII names and a final line without a line break.");
+}
+
+- (void)testRepeatedlyParsedObjectsForListOperationAreShared
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationListIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:_fakeOutputFromListOperation error:nil];
+    NSArray *repeatedObjects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:_fakeOutputFromListOperation error:nil];
+    
+    // verify
+    XCTAssertEqual([objects objectAtIndex:0], [repeatedObjects objectAtIndex:0], @"Formulae parsed repeatedly should be the same interned formula.");
+    XCTAssertTrue([[objects objectAtIndex:0] isImmutable], @"Formulae parsed from list operation output should be immutable.");
+}
+
 #pragma mark - Valid Search Output Parsing
 
 - (void)testParsedObjectArrayForSearchOperationIsNotNil
@@ -176,6 +219,21 @@
     XCTAssertNil(error, @"An error object should not be returned when a valid output string is provided.");
 }
 
+- (void)testParsedObjectsForSearchOperationAreNotInstalled
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationSearchIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:_fakeOutputFromSearchOperation error:nil];
+    
+    // verify
+    for (MRBrewFormula *formula in objects) {
+        XCTAssertFalse([formula isInstalled], @"Formulae parsed from search operation output should not be installed.");
+    }
+}
+
 #pragma mark - Valid Options Output Parsing
 
 - (void)testParsedObjectArrayForOptionsOperationIsNotNil
@@ -231,6 +289,157 @@
     XCTAssertNil(error, @"An error object should not be returned when a valid output string is provided.");
 }
 
+- (void)testParsedOptionsHaveNamesAndDescriptionsWithoutLineBreaks
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOptionsIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:_fakeOutputFromOptionsOperation error:nil];
+    
+    // verify
+    XCTAssertEqualObjects([objects valueForKey:@"name"], (@[@"--test-option", @"--test-option-two"]), @"Option names should include the '--' prefix.");
+    XCTAssertEqualObjects([objects valueForKey:@"optionDescription"], (@[@"Test option description", @"Test option description two"]), @"Descriptions should not include the leading tab or line breaks.");
+}
+
+- (void)testOptionDescriptionContainingTabIsParsed
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOptionsIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"--with-x\n\tBuild with\tX11 support\n" error:nil];
+    
+    // verify
+    XCTAssertEqualObjects([[objects objectAtIndex:0] optionDescription], @"Build with\tX11 support", @"Tabs within a description should be preserved.");
+}
+
+- (void)testMultiLineOptionDescriptionIsJoined
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOptionsIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"--universal\n\tBuild a universal binary\n\tfor i386 and x86_64\n--HEAD\n\tInstall HEAD version\n" error:nil];
+    
+    // verify
+    XCTAssertEqualObjects([objects valueForKey:@"optionDescription"], (@[@"Build a universal binary for i386 and x86_64", @"Install HEAD version"]), @"Description lines should be joined with a single space.");
+}
+
+- (void)testOptionDescriptionOnSameLineIsParsed
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOptionsIdentifier] name];
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"--with-x\tBuild with X11 support\n" error:nil];
+    
+    // verify
+    XCTAssertEqualObjects([[objects objectAtIndex:0] name], @"--with-x", @"Option name should end at the tab.");
+    XCTAssertEqualObjects([[objects objectAtIndex:0] optionDescription], @"Build with X11 support", @"Description should follow the tab.");
+}
+
+- (void)testOptionWithoutDescriptionIsRejected
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOptionsIdentifier] name];
+    
+    // execute & verify
+    XCTAssertNil([[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"--test-option\n--test-option-two\n\tTest option description two\n" error:nil], @"Nil should be returned when an option has no description.");
+}
+
+#pragma mark - Fuzzed Options Output Parsing
+
+/* Returns options output for a number of pseudo-randomly generated options,
+ * along with the names and descriptions the parser should return for it.
+ */
+- (NSString *)fuzzedOptionsOutputWithCount:(NSUInteger)count names:(NSMutableArray *)names descriptions:(NSMutableArray *)descriptions
+{
+    NSString *alphabet = @"abcdefghijklmnopqrstuvwxyz0123456789-_=é";
+    NSMutableString *output = [NSMutableString string];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        NSMutableString *name = [NSMutableString stringWithFormat:@"--option-%lu", (unsigned long)i];
+        for (long length = random() % 12; length > 0; length--) {
+            [name appendString:[alphabet substringWithRange:NSMakeRange(random() % [alphabet length], 1)]];
+        }
+        
+        // descriptions of one to three lines of words, some separated by tabs
+        NSMutableString *description = [NSMutableString string];
+        NSMutableString *formattedDescription = [NSMutableString stringWithString:@"\t"];
+        long lineCount = 1 + random() % 3;
+        for (long line = 0; line < lineCount; line++) {
+            if (line > 0) {
+                [description appendString:@" "];
+                [formattedDescription appendString:@"\n\t"];
+            }
+            for (long word = 0; word < 1 + random() % 5; word++) {
+                NSString *separator = (word == 0 ? @"" : (random() % 4 == 0 ? @"\t" : @" "));
+                NSString *text = [NSString stringWithFormat:@"word%ld", random() % 1000];
+                [description appendFormat:@"%@%@", separator, text];
+                [formattedDescription appendFormat:@"%@%@", separator, text];
+            }
+        }
+        
+        [output appendFormat:@"%@\n%@\n", name, formattedDescription];
+        [names addObject:name];
+        [descriptions addObject:description];
+    }
+    
+    return output;
+}
+
+- (void)testFuzzedOptionsOutputIsParsedExactly
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation optionsOperation:[MRBrewFormula formulaWithName:@"test-formula"]];
+    srandom(20140101);
+    
+    for (NSUInteger iteration = 0; iteration < 200; iteration++) {
+        NSMutableArray *names = [NSMutableArray array];
+        NSMutableArray *descriptions = [NSMutableArray array];
+        NSString *output = [self fuzzedOptionsOutputWithCount:1 + random() % 20 names:names descriptions:descriptions];
+        
+        // execute
+        NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:nil];
+        
+        // verify
+        XCTAssertEqualObjects([objects valueForKey:@"name"], names, @"Should parse every option name from output: %@", output);
+        XCTAssertEqualObjects([objects valueForKey:@"optionDescription"], descriptions, @"Should parse every option description from output: %@", output);
+    }
+}
+
+- (void)testTruncatedAndCorruptedOptionsOutputIsHandled
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation optionsOperation:[MRBrewFormula formulaWithName:@"test-formula"]];
+    NSArray *corruptions = @[@"", @"\n", @"\t", @"--", @"-", @" ", @"\n\n", @"garbage", @"\r\n"];
+    srandom(20140102);
+    
+    for (NSUInteger iteration = 0; iteration < 500; iteration++) {
+        NSString *output = [self fuzzedOptionsOutputWithCount:1 + random() % 5 names:[NSMutableArray array] descriptions:[NSMutableArray array]];
+        NSUInteger index = random() % ([output length] + 1);
+        NSString *corruption = [corruptions objectAtIndex:random() % [corruptions count]];
+        NSString *corruptedOutput = [[output substringToIndex:index] stringByAppendingString:(random() % 2 ? corruption : [corruption stringByAppendingString:[output substringFromIndex:index]])];
+        
+        // execute
+        NSError *error = nil;
+        NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:corruptedOutput error:&error];
+        
+        // verify
+        XCTAssertTrue((objects && [objects count] > 0 && !error) || (!objects && error), @"Should return either one or more options or an error for output: %@", corruptedOutput);
+        for (MRBrewInstallOption *option in objects) {
+            XCTAssertTrue([[option name] hasPrefix:@"--"], @"Option names should begin with '--'.");
+            XCTAssertEqual([[option optionDescription] rangeOfString:@"\n"].location, (NSUInteger)NSNotFound, @"Descriptions should not contain line breaks.");
+        }
+    }
+}
+
 #pragma mark - Empty List Output Parsing
 
 - (void)testErrorIsInstantiatedForEmptyListOperationOutput
@@ -423,4 +632,57 @@
     XCTAssertNil(objects, @"Nil should be returned for an invalid output string.");
 }
 
+#pragma mark - JSON Output Parsing
+
+- (void)testFormulaeAreDecodedFromJSONInfoOperationOutput
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationInfoIdentifier] name];
+    NSString *output = @"[{\"name\":\"wget\",\"versions\":{\"stable\":\"1.16\",\"bottle\":true},\"installed\":[{\"version\":\"1.15\",\"used_options\":[]}],\"dependencies\":[\"openssl\"]}]";
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:nil];
+    
+    // verify
+    MRBrewFormula *formula = [objects objectAtIndex:0];
+    XCTAssertEqual([objects count], (NSUInteger)1, @"Should decode a formula for each object in the output.");
+    XCTAssertEqualObjects([formula name], @"wget", @"Should decode the formula name.");
+    XCTAssertEqualObjects([formula version], @"1.16", @"Should decode the stable version.");
+    XCTAssertEqualObjects([formula installedVersions], (@[@"1.15"]), @"Should decode the installed versions.");
+    XCTAssertEqualObjects([formula dependencies], (@[@"openssl"]), @"Should decode the dependencies.");
+    XCTAssertTrue([formula isInstalled], @"A formula with an installed version should be installed.");
+}
+
+- (void)testFormulaeAreDecodedFromJSONOutdatedOperationOutput
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationOutdatedIdentifier] name];
+    NSString *output = @"[{\"name\":\"wget\",\"installed_versions\":[\"1.14\",\"1.15\"],\"current_version\":\"1.16\"}]";
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:output error:nil];
+    
+    // verify
+    MRBrewFormula *formula = [objects objectAtIndex:0];
+    XCTAssertEqualObjects([formula version], @"1.16", @"Should decode the current version.");
+    XCTAssertEqualObjects([formula installedVersions], (@[@"1.14", @"1.15"]), @"Should decode the installed versions.");
+}
+
+- (void)testErrorIsInstantiatedForInvalidJSONOutput
+{
+    // setup
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:MRBrewOperationListIdentifier] name];
+    NSError *error = nil;
+    
+    // execute
+    NSArray *objects = [[MRBrewOutputParser outputParser] objectsForOperation:operation output:@"[{\"name\":\"wget\"" error:&error];
+    
+    // verify
+    XCTAssertNil(objects, @"Nil should be returned for incomplete JSON output.");
+    XCTAssertTrue([error code] == MRBrewOutputParserErrorSyntax, @"The error code should match the constant MRBrewOutputParserErrorSyntax.");
+}
+
 @end
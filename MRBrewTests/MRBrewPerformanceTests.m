@@ -0,0 +1,492 @@
+//
+//  MRBrewPerformanceTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import <mach/mach.h>
+#import "MRBrew.h"
+#import "MRBrew+Private.h"
+#import "MRBrewDelegate.h"
+#import "MRBrewFormula.h"
+#import "MRBrewOperation.h"
+#import "MRBrewOutputParser.h"
+#import "MRBrewConstants.h"
+#import "MRBrewInstallOption.h"
+#import "MRBrewLauncher.h"
+#import "MRBrewTask.h"
+
+static NSString * const MRBrewPerformanceTestsDefaultBrewPath = @"/usr/local/bin/brew";
+static const NSUInteger MRBrewPerformanceTestsQueuedOperationCount = 500;
+static const NSTimeInterval MRBrewPerformanceTestsTimeout = 60.0;
+static const NSUInteger MRBrewPerformanceTestsMixedMutatingOperationCount = 20;
+static const NSUInteger MRBrewPerformanceTestsMixedReadOnlyOperationCount = 200;
+static const NSUInteger MRBrewPerformanceTestsInstallOperationCount = 50;
+static const NSUInteger MRBrewPerformanceTestsLaunchCount = 200;
+
+/* Returns synthetic list operation output with the specified number of lines. */
+static NSString *MRBrewPerformanceTestsListOutput(NSUInteger lineCount)
+{
+    NSMutableString *output = [NSMutableString stringWithCapacity:lineCount * 16];
+    
+    for (NSUInteger i = 0; i < lineCount; i++) {
+        [output appendFormat:@"formula-%lu\n", (unsigned long)i];
+    }
+    
+    return output;
+}
+
+/* The list output parser as implemented before it scanned bytes directly, kept
+ * as a baseline for the parser benchmarks.
+ */
+static NSArray *MRBrewPerformanceTestsLegacyParseListOutput(NSString *output)
+{
+    NSMutableArray *objects = [NSMutableArray array];
+    
+    for (NSString *name in [output componentsSeparatedByString:@"\n"]) {
+        if ([name isEqualToString:@""]) {
+            continue;
+        }
+        
+        [objects addObject:[MRBrewFormula formulaWithName:name]];
+    }
+    
+    NSArray *formulae = [NSArray arrayWithArray:objects];
+    for (MRBrewFormula *formula in formulae) {
+        [formula setIsInstalled:YES];
+    }
+    
+    return [NSArray arrayWithArray:formulae];
+}
+
+/* Returns the number of threads currently owned by the test process. */
+static NSUInteger MRBrewPerformanceTestsThreadCount(void)
+{
+    thread_act_array_t threads;
+    mach_msg_type_number_t count = 0;
+    
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    
+    for (mach_msg_type_number_t i = 0; i < count; i++) {
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, sizeof(thread_t) * count);
+    
+    return count;
+}
+
+/* Returns synthetic options operation output with the specified number of
+ * options.
+ */
+static NSString *MRBrewPerformanceTestsOptionsOutput(NSUInteger optionCount)
+{
+    NSMutableString *output = [NSMutableString stringWithCapacity:optionCount * 48];
+    
+    for (NSUInteger i = 0; i < optionCount; i++) {
+        [output appendFormat:@"--with-option-%lu\n\tBuild with support for option %lu\n", (unsigned long)i, (unsigned long)i];
+    }
+    
+    return output;
+}
+
+/* The options output parser as implemented before it was replaced by a
+ * tokenizer, kept as a baseline for the parser benchmarks.
+ */
+static NSArray *MRBrewPerformanceTestsLegacyParseOptionsOutput(NSString *output)
+{
+    NSMutableArray *objects = [NSMutableArray array];
+    
+    NSUInteger optionIndex = 0;
+    NSUInteger descriptionIndex = 1;
+    
+    for (NSString *line in [output componentsSeparatedByString:@"\n--"]) {
+        NSMutableArray *optionWithDescription = [[line componentsSeparatedByString:@"\t"] mutableCopy];
+        
+        if ([optionWithDescription count] != 2) {
+            return nil;
+        }
+        
+        if (![[optionWithDescription objectAtIndex:optionIndex] hasPrefix:@"--"]) {
+            [optionWithDescription setObject:[NSString stringWithFormat:@"--%@", [optionWithDescription objectAtIndex:optionIndex]] atIndexedSubscript:optionIndex];
+        }
+        
+        if ([[optionWithDescription objectAtIndex:optionIndex] rangeOfString:@"\n"].location != NSNotFound) {
+            [optionWithDescription setObject:[[optionWithDescription objectAtIndex:optionIndex] stringByReplacingOccurrencesOfString:@"\n" withString:@""] atIndexedSubscript:optionIndex];
+        }
+        
+        if ([[optionWithDescription objectAtIndex:descriptionIndex] rangeOfString:@"\n"].location != NSNotFound) {
+            [optionWithDescription setObject:[[optionWithDescription objectAtIndex:descriptionIndex] stringByReplacingOccurrencesOfString:@"\n" withString:@""] atIndexedSubscript:descriptionIndex];
+        }
+        
+        [objects addObject:[MRBrewInstallOption installOptionWithName:[optionWithDescription objectAtIndex:optionIndex] description:[optionWithDescription objectAtIndex:descriptionIndex] selected:NO]];
+    }
+    
+    return [NSArray arrayWithArray:objects];
+}
+
+@interface MRBrewPerformanceTests : XCTestCase <MRBrewDelegate> {
+    NSString *_stubBrewPath;
+    NSMutableDictionary *_enqueueTimes;
+    NSTimeInterval _totalLatency;
+    NSTimeInterval _maximumLatency;
+    NSUInteger _finishedOperationCount;
+    NSUInteger _peakThreadCount;
+    NSTimeInterval _totalReadOnlyLatency;
+    NSTimeInterval _maximumReadOnlyLatency;
+    NSUInteger _finishedReadOnlyOperationCount;
+}
+
+@end
+
+@implementation MRBrewPerformanceTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // a stub brew executable that echoes its arguments and exits immediately,
+    // so that measurements reflect the cost of MRBrew rather than Homebrew,
+    // except for operations that modify the installation, which take 50ms
+    _stubBrewPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"MRBrewPerformanceTests-brew"];
+    NSString *script = @"#!/bin/sh\ncase \"$1\" in install|remove|update) sleep 0.05;; esac\necho \"$@\"\nexit 0\n";
+    [script writeToFile:_stubBrewPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] setAttributes:@{NSFilePosixPermissions: @0755} ofItemAtPath:_stubBrewPath error:nil];
+    
+    [[MRBrew sharedBrew] setBrewPath:_stubBrewPath];
+    [[MRBrew sharedBrew] setEnvironment:nil];
+    [[MRBrew sharedBrew] setBackgroundQueue:[[NSOperationQueue alloc] init]];
+    
+    NSOperationQueue *mutatingQueue = [[NSOperationQueue alloc] init];
+    [mutatingQueue setMaxConcurrentOperationCount:1];
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+}
+
+- (void)tearDown
+{
+    [[MRBrew sharedBrew] setBrewPath:MRBrewPerformanceTestsDefaultBrewPath];
+    [[NSFileManager defaultManager] removeItemAtPath:_stubBrewPath error:nil];
+    
+    [super tearDown];
+}
+
+/* Performs the specified number of info operations against the stub brew
+ * executable and spins the run loop until every operation has finished,
+ * sampling the thread count of the process as it goes.
+ */
+- (void)performQueuedOperations:(NSUInteger)count
+{
+    _enqueueTimes = [NSMutableDictionary dictionaryWithCapacity:count];
+    _totalLatency = 0;
+    _maximumLatency = 0;
+    _finishedOperationCount = 0;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        MRBrewFormula *formula = [MRBrewFormula formulaWithName:[NSString stringWithFormat:@"formula-%lu", (unsigned long)i]];
+        MRBrewOperation *operation = [MRBrewOperation infoOperation:formula];
+        [_enqueueTimes setObject:[NSDate date] forKey:[operation description]];
+        [[MRBrew sharedBrew] performOperation:operation delegate:self];
+    }
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewPerformanceTestsTimeout];
+    while (_finishedOperationCount < count && [timeout timeIntervalSinceNow] > 0) {
+        _peakThreadCount = MAX(_peakThreadCount, MRBrewPerformanceTestsThreadCount());
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    XCTAssertEqual(_finishedOperationCount, count, @"Every queued operation should finish before the timeout period is reached.");
+}
+
+- (void)testPerformanceOfQueuedOperationsAgainstStubBrew
+{
+    _peakThreadCount = 0;
+    
+    [self measureBlock:^{
+        [self performQueuedOperations:MRBrewPerformanceTestsQueuedOperationCount];
+        
+        NSLog(@"MRBrewPerformanceTests: %lu operations, mean latency %.1fms, maximum latency %.1fms, peak thread count %lu",
+              (unsigned long)_finishedOperationCount,
+              (_totalLatency / MAX(_finishedOperationCount, 1)) * 1000.0,
+              _maximumLatency * 1000.0,
+              (unsigned long)_peakThreadCount);
+    }];
+}
+
+/* Performs install operations interleaved with read-only info operations
+ * against the stub brew executable, and spins the run loop until every
+ * operation has finished.
+ */
+- (void)performMixedWorkloadWithMutatingOperations:(NSUInteger)mutatingCount readOnlyOperations:(NSUInteger)readOnlyCount
+{
+    NSUInteger count = mutatingCount + readOnlyCount;
+    _enqueueTimes = [NSMutableDictionary dictionaryWithCapacity:count];
+    _totalLatency = 0;
+    _maximumLatency = 0;
+    _finishedOperationCount = 0;
+    _totalReadOnlyLatency = 0;
+    _maximumReadOnlyLatency = 0;
+    _finishedReadOnlyOperationCount = 0;
+    
+    // spread the install operations evenly through the read-only operations
+    NSUInteger interval = (readOnlyCount / MAX(mutatingCount, 1)) + 1;
+    NSUInteger performedMutatingCount = 0;
+    NSUInteger performedReadOnlyCount = 0;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        BOOL mutating = (i % interval == 0 && performedMutatingCount < mutatingCount) || performedReadOnlyCount == readOnlyCount;
+        MRBrewOperation *operation;
+        
+        if (mutating) {
+            MRBrewFormula *formula = [MRBrewFormula formulaWithName:[NSString stringWithFormat:@"installed-formula-%lu", (unsigned long)performedMutatingCount++]];
+            operation = [MRBrewOperation installOperation:formula];
+        }
+        else {
+            MRBrewFormula *formula = [MRBrewFormula formulaWithName:[NSString stringWithFormat:@"formula-%lu", (unsigned long)performedReadOnlyCount++]];
+            operation = [MRBrewOperation infoOperation:formula];
+        }
+        
+        [_enqueueTimes setObject:[NSDate date] forKey:[operation description]];
+        [[MRBrew sharedBrew] performOperation:operation delegate:self];
+    }
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewPerformanceTestsTimeout];
+    while (_finishedOperationCount < count && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    XCTAssertEqual(_finishedOperationCount, count, @"Every queued operation should finish before the timeout period is reached.");
+}
+
+- (void)testPerformanceOfMixedWorkloadAgainstStubBrew
+{
+    [self measureBlock:^{
+        [self performMixedWorkloadWithMutatingOperations:MRBrewPerformanceTestsMixedMutatingOperationCount
+                                      readOnlyOperations:MRBrewPerformanceTestsMixedReadOnlyOperationCount];
+        
+        NSLog(@"MRBrewPerformanceTests: %lu mixed operations, read-only mean latency %.1fms, read-only maximum latency %.1fms, overall maximum latency %.1fms",
+              (unsigned long)_finishedOperationCount,
+              (_totalReadOnlyLatency / MAX(_finishedReadOnlyOperationCount, 1)) * 1000.0,
+              _maximumReadOnlyLatency * 1000.0,
+              _maximumLatency * 1000.0);
+    }];
+}
+
+/* Performs the specified number of install operations against the stub brew
+ * executable, batched or not, and spins the run loop until every operation
+ * has finished.
+ */
+- (void)performInstallOperations:(NSUInteger)count batched:(BOOL)batched
+{
+    _enqueueTimes = [NSMutableDictionary dictionaryWithCapacity:count];
+    _totalLatency = 0;
+    _maximumLatency = 0;
+    _finishedOperationCount = 0;
+    
+    [[MRBrew sharedBrew] setBatchesOperations:batched];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        MRBrewFormula *formula = [MRBrewFormula formulaWithName:[NSString stringWithFormat:@"installed-formula-%lu", (unsigned long)i]];
+        MRBrewOperation *operation = [MRBrewOperation installOperation:formula];
+        [_enqueueTimes setObject:[NSDate date] forKey:[operation description]];
+        [[MRBrew sharedBrew] performOperation:operation delegate:self];
+    }
+    
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:MRBrewPerformanceTestsTimeout];
+    while (_finishedOperationCount < count && [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    [[MRBrew sharedBrew] setBatchesOperations:NO];
+    
+    XCTAssertEqual(_finishedOperationCount, count, @"Every install operation should finish before the timeout period is reached.");
+}
+
+- (void)testPerformanceOfBatchedInstallOperationsAgainstStubBrew
+{
+    [self measureBlock:^{
+        NSDate *start = [NSDate date];
+        [self performInstallOperations:MRBrewPerformanceTestsInstallOperationCount batched:YES];
+        
+        NSLog(@"MRBrewPerformanceTests: %lu batched install operations, wall time %.1fms",
+              (unsigned long)_finishedOperationCount,
+              -[start timeIntervalSinceNow] * 1000.0);
+    }];
+}
+
+- (void)testPerformanceOfUnbatchedInstallOperationsAgainstStubBrew
+{
+    [self measureBlock:^{
+        NSDate *start = [NSDate date];
+        [self performInstallOperations:MRBrewPerformanceTestsInstallOperationCount batched:NO];
+        
+        NSLog(@"MRBrewPerformanceTests: %lu unbatched install operations, wall time %.1fms",
+              (unsigned long)_finishedOperationCount,
+              -[start timeIntervalSinceNow] * 1000.0);
+    }];
+}
+
+#pragma mark - Process Launching
+
+/* Launches the stub brew executable the specified number of times, one at a
+ * time, using either an MRBrewTask or an NSTask configured as MRBrewWorker
+ * configures its task, and returns the mean time from launch to exit.
+ */
+- (NSTimeInterval)meanLatencyOfLaunches:(NSUInteger)count usingLauncher:(BOOL)usesLauncher
+{
+    NSDate *start = [NSDate date];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        @autoreleasepool {
+            NSPipe *outputPipe = [NSPipe pipe];
+            id task = usesLauncher ? [[MRBrewTask alloc] initWithLauncher:[[MRBrew sharedBrew] launcher]] : [[NSTask alloc] init];
+            [task setLaunchPath:[[MRBrew sharedBrew] brewPath]];
+            [task setArguments:@[@"--version"]];
+            [task setEnvironment:[[MRBrew sharedBrew] environment]];
+            [task setStandardOutput:outputPipe];
+            [task launch];
+            
+            [[outputPipe fileHandleForReading] readDataToEndOfFile];
+            while ([task isRunning]) {
+                usleep(100);
+            }
+        }
+    }
+    
+    return -[start timeIntervalSinceNow] / MAX(count, 1);
+}
+
+- (void)measureLaunchesUsingLauncher:(BOOL)usesLauncher
+{
+    NSDictionary *environment = @{@"PATH": @"/usr/bin:/bin:/usr/sbin:/sbin", @"HOME": NSHomeDirectory(), @"LANG": @"en_US.UTF-8"};
+    [[MRBrew sharedBrew] setEnvironment:environment];
+    
+    [self measureBlock:^{
+        NSUInteger flattenCount = [[[MRBrew sharedBrew] launcher] environmentFlattenCount];
+        NSTimeInterval latency = [self meanLatencyOfLaunches:MRBrewPerformanceTestsLaunchCount usingLauncher:usesLauncher];
+        
+        NSLog(@"MRBrewPerformanceTests: %lu launches using %@, mean latency %.2fms, environment flattened %lu times",
+              (unsigned long)MRBrewPerformanceTestsLaunchCount,
+              (usesLauncher ? @"MRBrewLauncher" : @"NSTask"),
+              latency * 1000.0,
+              (unsigned long)([[[MRBrew sharedBrew] launcher] environmentFlattenCount] - flattenCount));
+    }];
+    
+    [[MRBrew sharedBrew] setEnvironment:nil];
+}
+
+- (void)testPerformanceOfLaunchingStubBrewUsingLauncher
+{
+    [self measureLaunchesUsingLauncher:YES];
+}
+
+- (void)testPerformanceOfLaunchingStubBrewUsingNSTask
+{
+    [self measureLaunchesUsingLauncher:NO];
+}
+
+#pragma mark - Output Parsing
+
+- (void)measureListOutputParsingWithLineCount:(NSUInteger)lineCount legacy:(BOOL)legacy
+{
+    NSString *output = MRBrewPerformanceTestsListOutput(lineCount);
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    MRBrewOutputParser *parser = [MRBrewOutputParser outputParser];
+    
+    [self measureBlock:^{
+        @autoreleasepool {
+            NSArray *objects = legacy ? MRBrewPerformanceTestsLegacyParseListOutput(output) : [parser objectsForOperation:operation output:output error:nil];
+            XCTAssertEqual([objects count], lineCount, @"Should parse one formula for each line of output.");
+        }
+    }];
+}
+
+- (void)testPerformanceOfParsingListOutputWith10kLines
+{
+    [self measureListOutputParsingWithLineCount:10000 legacy:NO];
+}
+
+- (void)testPerformanceOfLegacyParsingListOutputWith10kLines
+{
+    [self measureListOutputParsingWithLineCount:10000 legacy:YES];
+}
+
+- (void)testPerformanceOfParsingListOutputWith100kLines
+{
+    [self measureListOutputParsingWithLineCount:100000 legacy:NO];
+}
+
+- (void)testPerformanceOfLegacyParsingListOutputWith100kLines
+{
+    [self measureListOutputParsingWithLineCount:100000 legacy:YES];
+}
+
+- (void)measureOptionsOutputParsingWithOptionCount:(NSUInteger)optionCount legacy:(BOOL)legacy
+{
+    NSString *output = MRBrewPerformanceTestsOptionsOutput(optionCount);
+    MRBrewOperation *operation = [MRBrewOperation optionsOperation:[MRBrewFormula formulaWithName:@"formula"]];
+    MRBrewOutputParser *parser = [MRBrewOutputParser outputParser];
+    
+    [self measureBlock:^{
+        @autoreleasepool {
+            NSArray *objects = legacy ? MRBrewPerformanceTestsLegacyParseOptionsOutput(output) : [parser objectsForOperation:operation output:output error:nil];
+            XCTAssertEqual([objects count], optionCount, @"Should parse one install option for each option in the output.");
+        }
+    }];
+}
+
+- (void)testPerformanceOfParsingOptionsOutputWith10kOptions
+{
+    [self measureOptionsOutputParsingWithOptionCount:10000 legacy:NO];
+}
+
+- (void)testPerformanceOfLegacyParsingOptionsOutputWith10kOptions
+{
+    [self measureOptionsOutputParsingWithOptionCount:10000 legacy:YES];
+}
+
+#pragma mark - MRBrewDelegate methods
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    NSDate *enqueueTime = [_enqueueTimes objectForKey:[operation description]];
+    NSTimeInterval latency = -[enqueueTime timeIntervalSinceNow];
+    
+    _totalLatency += latency;
+    _maximumLatency = MAX(_maximumLatency, latency);
+    _finishedOperationCount++;
+    
+    if ([operation isReadOnly]) {
+        _totalReadOnlyLatency += latency;
+        _maximumReadOnlyLatency = MAX(_maximumReadOnlyLatency, latency);
+        _finishedReadOnlyOperationCount++;
+    }
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didFailWithError:(NSError *)error
+{
+    XCTFail(@"Operation %@ should not fail against the stub brew executable (error code %ld).", operation, (long)[error code]);
+    _finishedOperationCount++;
+}
+
+@end
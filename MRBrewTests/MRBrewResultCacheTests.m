@@ -0,0 +1,222 @@
+//
+//  MRBrewResultCacheTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewResultCache.h"
+#import "MRBrewOperation.h"
+#import "MRBrewConstants.h"
+
+@interface MRBrewResultCacheTests : XCTestCase
+{
+    MRBrewResultCache *_cache;
+}
+
+@end
+
+@implementation MRBrewResultCacheTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _cache = [[MRBrewResultCache alloc] init];
+}
+
+- (void)tearDown
+{
+    _cache = nil;
+    
+    [super tearDown];
+}
+
+#pragma mark - Defaults
+
+- (void)testDefaultByteLimit
+{
+    // execute & verify
+    XCTAssertEqual([_cache byteLimit], (NSUInteger)(4 * 1024 * 1024), @"Default byte limit should be 4 MiB.");
+    XCTAssertEqual([_cache byteCount], (NSUInteger)0, @"A new cache should hold no output.");
+}
+
+#pragma mark - Lookup
+
+- (void)testOutputForUncachedOperationIsNilAndCountsMiss
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    
+    // execute
+    NSString *output = [_cache outputForOperation:operation];
+    
+    // verify
+    XCTAssertNil(output, @"Should return nil for an operation with no cached output.");
+    XCTAssertEqual([_cache missCount], (NSUInteger)1, @"Should count a miss.");
+    XCTAssertEqual([_cache hitCount], (NSUInteger)0, @"Should not count a hit.");
+}
+
+- (void)testOutputForEqualOperationIsReturnedAndCountsHit
+{
+    // setup
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation operationWithName:MRBrewOperationSearchIdentifier formula:nil parameters:@[@"wget"]]];
+    
+    // execute
+    NSString *output = [_cache outputForOperation:[MRBrewOperation operationWithName:MRBrewOperationSearchIdentifier formula:nil parameters:@[@"wget"]]];
+    
+    // verify
+    XCTAssertEqualObjects(output, @"wget\n", @"Should return the output cached for an equal operation.");
+    XCTAssertEqual([_cache hitCount], (NSUInteger)1, @"Should count a hit.");
+}
+
+- (void)testOutputIsNotSharedBetweenOperationsWithDifferentParameters
+{
+    // setup
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation operationWithName:MRBrewOperationSearchIdentifier formula:nil parameters:@[@"wget"]]];
+    
+    // execute
+    NSString *output = [_cache outputForOperation:[MRBrewOperation operationWithName:MRBrewOperationSearchIdentifier formula:nil parameters:@[@"curl"]]];
+    
+    // verify
+    XCTAssertNil(output, @"Should not return output cached for an operation with different parameters.");
+}
+
+- (void)testOutputIsNotSharedBetweenTextAndJSONOperations
+{
+    // setup
+    MRBrewOperation *JSONOperation = [MRBrewOperation listOperation];
+    [JSONOperation setUsesJSONOutput:YES];
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation]];
+    
+    // execute
+    NSString *output = [_cache outputForOperation:JSONOperation];
+    
+    // verify
+    XCTAssertNil(output, @"Should not return text output for an operation with JSON output.");
+}
+
+- (void)testOutputOfOperationThatIsNotReadOnlyIsNotCached
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation updateOperation];
+    
+    // execute
+    [_cache setOutput:@"Already up-to-date.\n" forOperation:operation];
+    
+    // verify
+    XCTAssertNil([_cache outputForOperation:operation], @"Should not cache the output of an operation that is not read-only.");
+    XCTAssertEqual([_cache byteCount], (NSUInteger)0, @"Should hold no output.");
+}
+
+#pragma mark - Eviction
+
+- (void)testOutputLargerThanByteLimitIsNotCached
+{
+    // setup
+    [_cache setByteLimit:8];
+    
+    // execute
+    [_cache setOutput:@"0123456789" forOperation:[MRBrewOperation listOperation]];
+    
+    // verify
+    XCTAssertNil([_cache outputForOperation:[MRBrewOperation listOperation]], @"Should not cache output larger than the byte limit.");
+}
+
+- (void)testLeastRecentlyUsedOutputIsEvictedWhenByteLimitIsExceeded
+{
+    // setup
+    MRBrewOperation *first = [MRBrewOperation operationWithName:MRBrewOperationInfoIdentifier formula:nil parameters:@[@"first"]];
+    MRBrewOperation *second = [MRBrewOperation operationWithName:MRBrewOperationInfoIdentifier formula:nil parameters:@[@"second"]];
+    MRBrewOperation *third = [MRBrewOperation operationWithName:MRBrewOperationInfoIdentifier formula:nil parameters:@[@"third"]];
+    [_cache setByteLimit:2 * 4 * sizeof(unichar)];
+    [_cache setOutput:@"1111" forOperation:first];
+    [_cache setOutput:@"2222" forOperation:second];
+    [_cache outputForOperation:first];
+    
+    // execute
+    [_cache setOutput:@"3333" forOperation:third];
+    
+    // verify
+    XCTAssertNotNil([_cache outputForOperation:first], @"Recently used output should be retained.");
+    XCTAssertNil([_cache outputForOperation:second], @"Least recently used output should be evicted.");
+    XCTAssertNotNil([_cache outputForOperation:third], @"Newly cached output should be retained.");
+    XCTAssertTrue([_cache byteCount] <= [_cache byteLimit], @"Byte count should not exceed the byte limit.");
+}
+
+#pragma mark - Invalidation
+
+- (void)testRemoveAllOutputEmptiesCache
+{
+    // setup
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation]];
+    
+    // execute
+    [_cache removeAllOutput];
+    
+    // verify
+    XCTAssertNil([_cache outputForOperation:[MRBrewOperation listOperation]], @"Should not return output after it has been removed.");
+    XCTAssertEqual([_cache byteCount], (NSUInteger)0, @"Should hold no output.");
+}
+
+- (void)testBrewChangeEmptiesCache
+{
+    // setup
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation]];
+    
+    // execute
+    [_cache brewChangeDidOccur:@[@"/usr/local/Cellar"]];
+    
+    // verify
+    XCTAssertNil([_cache outputForOperation:[MRBrewOperation listOperation]], @"Should discard cached output when Homebrew changes.");
+}
+
+- (void)testOutputOfOperationStartedBeforeBrewChangeIsNotCached
+{
+    // setup
+    NSUInteger generation = [_cache generation];
+    [_cache brewChangeDidOccur:@[@"/usr/local/Cellar"]];
+    
+    // execute
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation] generation:generation];
+    
+    // verify
+    XCTAssertTrue([_cache generation] > generation, @"Should advance the generation when output is discarded.");
+    XCTAssertNil([_cache outputForOperation:[MRBrewOperation listOperation]], @"Should not cache output generated before Homebrew changed.");
+}
+
+- (void)testOutputOfOperationStartedInCurrentGenerationIsCached
+{
+    // setup
+    [_cache removeAllOutput];
+    NSUInteger generation = [_cache generation];
+    
+    // execute
+    [_cache setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation] generation:generation];
+    
+    // verify
+    XCTAssertEqualObjects([_cache outputForOperation:[MRBrewOperation listOperation]], @"wget\n", @"Should cache output generated since the cache was last invalidated.");
+}
+
+@end
@@ -28,9 +28,16 @@
 #import "MRBrew.h"
 #import "MRBrew+Private.h"
 #import "MRBrewWorker.h"
+#import "MRBrewInProcessWorker.h"
 #import "MRBrewFormula.h"
 #import "MRBrewOperation.h"
 #import "MRBrewConstants.h"
+#import "MRBrewDelegate.h"
+#import "MRBrewResultCache.h"
+#import "MRBrewHistogram.h"
+#import "MRBrewOperationMetrics.h"
+#import "MRBrewOperationMetrics+Private.h"
+#import "MRBrewOperationResult.h"
 
 @interface MRBrewTests : XCTestCase
 
@@ -50,7 +57,11 @@ static NSString * const MRBrewTestsDefaultBrewPath = @"/usr/local/bin/brew";
 
 - (void)tearDown
 {
-    // Put teardown code here; it will be run once, after the last test case.
+    [[[MRBrew sharedBrew] inFlightWorkers] removeAllObjects];
+    [[[MRBrew sharedBrew] pendingBatches] removeAllObjects];
+    [[[MRBrew sharedBrew] operationBatches] removeAllObjects];
+    [[MRBrew sharedBrew] resetOperationDurationHistograms];
+    
     [super tearDown];
 }
 
@@ -85,6 +96,36 @@ static NSString * const MRBrewTestsDefaultBrewPath = @"/usr/local/bin/brew";
     XCTAssertNotEqual(brew, sharedBrew, @"Should be a distinct instance not equal to that which is returned by +sharedBrew.");
 }
 
+#pragma mark - Delegate Queue
+
+- (void)testDefaultDelegateQueueIsMainQueue
+{
+    // execute
+    MRBrew *brew = [[MRBrew alloc] init];
+    
+    // verify
+    XCTAssertEqual([brew delegateQueue], [NSOperationQueue mainQueue], @"Should deliver callbacks on the main queue by default.");
+}
+
+- (void)testConfigureWorkerSetsDelegateQueue
+{
+    // setup
+    MRBrew *brew = [[MRBrew alloc] init];
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    MRBrewWorker *inlineWorker = [[MRBrewWorker alloc] init];
+    
+    // execute
+    [brew setDelegateQueue:delegateQueue];
+    [brew configureWorker:worker];
+    [brew setDelegateQueue:nil];
+    [brew configureWorker:inlineWorker];
+    
+    // verify
+    XCTAssertEqual([worker delegateQueue], delegateQueue, @"Worker should deliver callbacks on the delegate queue.");
+    XCTAssertNil([inlineWorker delegateQueue], @"Worker should deliver callbacks inline when there is no delegate queue.");
+}
+
 #pragma mark - Brew Path Tests
 
 - (void)testDefaultBrewPath
@@ -178,6 +219,29 @@ static NSString * const MRBrewTestsDefaultBrewPath = @"/usr/local/bin/brew";
     [worker verify];
 }
 
+- (void)testCancelOperationDelegateWillCancelAssociatedWorkerForDelegate
+{
+    // setup
+    id delegate = [OCMockObject mockForProtocol:@protocol(MRBrewDelegate)];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturnValue:@YES] isEqualToOperation:[OCMArg any]];
+    
+    id worker = [OCMockObject mockForClass:[MRBrewWorker class]];
+    [[[worker stub] andReturn:operation] operation];
+    [[worker expect] cancelForDelegate:delegate];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[queue stub] andReturn:@[worker]] operations];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] cancelOperation:operation delegate:delegate];
+    
+    // verify
+    [worker verify];
+}
+
 - (void)testOperationCountReturnsExpectedCount
 {
     // setup
@@ -242,10 +306,13 @@ static NSString * const MRBrewTestsDefaultBrewPath = @"/usr/local/bin/brew";
     [[[formula stub] andReturn:@"formula-name"] name];
     [[[formula stub] andReturn:formula] copyWithZone:[OCMArg anyPointer]];
     
+    MRBrewOperationPriority priority = MRBrewOperationPriorityNormal;
     id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
     [[[operation stub] andReturn:MRBrewOperationSearchIdentifier] name];
     [[[operation stub] andReturn:@[]] parameters];
     [[[operation stub] andReturn:formula] formula];
+    [[[operation stub] andReturnValue:@NO] isJSONOperation];
+    [[[operation stub] andReturnValue:OCMOCK_VALUE(priority)] priority];
     [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
     
     id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
@@ -259,6 +326,602 @@ static NSString * const MRBrewTestsDefaultBrewPath = @"/usr/local/bin/brew";
     [queue verify];
 }
 
+- (void)testPerformListOperationWithJSONOutputUsesInfoArguments
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [operation setUsesJSONOutput:YES];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    
+    // verify
+    NSArray *arguments = [[[[MRBrew sharedBrew] inFlightWorkers] objectAtIndex:0] arguments];
+    NSArray *expectedArguments = @[MRBrewOperationInfoIdentifier, @"--json=v1", @"--installed"];
+    XCTAssertEqualObjects(arguments, expectedArguments, @"A list operation with JSON output should be performed as an info operation for installed formulae.");
+}
+
+- (void)testPerformInfoOperationWithJSONOutputAddsJSONArgument
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [operation setUsesJSONOutput:YES];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    
+    // verify
+    NSArray *arguments = [[[[MRBrew sharedBrew] inFlightWorkers] objectAtIndex:0] arguments];
+    NSArray *expectedArguments = @[MRBrewOperationInfoIdentifier, @"--json=v1", @"wget"];
+    XCTAssertEqualObjects(arguments, expectedArguments, @"An info operation with JSON output should request JSON for the formula.");
+}
+
+- (void)testPerformOperationWithoutJSONSupportIgnoresJSONOutput
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation searchOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [operation setUsesJSONOutput:YES];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    
+    // verify
+    NSArray *arguments = [[[[MRBrew sharedBrew] inFlightWorkers] objectAtIndex:0] arguments];
+    NSArray *expectedArguments = @[MRBrewOperationSearchIdentifier, @"wget"];
+    XCTAssertEqualObjects(arguments, expectedArguments, @"JSON output should be ignored for operations that do not support it.");
+}
+
+- (void)testPerformEqualReadOnlyOperationAttachesToQueuedWorker
+{
+    // setup
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation listOperation] delegate:nil];
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation listOperation] delegate:nil];
+    
+    // verify
+    [queue verify];
+    XCTAssertEqual([[[MRBrew sharedBrew] inFlightWorkers] count], (NSUInteger)1, @"Equal read-only operations should share a single worker.");
+}
+
+- (void)testPerformOperationWithCachedResultDoesNotAddWorkerToQueue
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [[MRBrew sharedBrew] setCachesResults:YES];
+    [[[MRBrew sharedBrew] resultCache] setOutput:@"wget\n" forOperation:operation];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    
+    // verify
+    [queue verify];
+    XCTAssertEqual([[[MRBrew sharedBrew] resultCache] hitCount], (NSUInteger)1, @"Should answer the operation from the result cache.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setCachesResults:NO];
+}
+
+- (void)testPerformOperationThatIsNotReadOnlyDiscardsCachedResults
+{
+    // setup
+    [[MRBrew sharedBrew] setCachesResults:YES];
+    [[[MRBrew sharedBrew] resultCache] setOutput:@"wget\n" forOperation:[MRBrewOperation listOperation]];
+    
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setMutatingQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation updateOperation] delegate:nil];
+    
+    // verify
+    [queue verify];
+    XCTAssertEqual([[[MRBrew sharedBrew] resultCache] byteCount], (NSUInteger)0, @"Should discard cached output before performing an operation that is not read-only.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setCachesResults:NO];
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+}
+
+#pragma mark - Completion Blocks
+
+- (void)testPerformOperationCompletionReceivesObjectsParsedFromCachedOutput
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [[MRBrew sharedBrew] setCachesResults:YES];
+    [[[MRBrew sharedBrew] resultCache] setOutput:@"wget\ngit\n" forOperation:operation];
+    
+    __block MRBrewOperationResult *completionResult = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation completion:^(MRBrewOperationResult *result) {
+        completionResult = result;
+    }];
+    
+    while (!completionResult && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue([completionResult succeeded], @"Completion should receive a successful result.");
+    XCTAssertEqualObjects([[completionResult objects] valueForKey:@"name"], (@[@"wget", @"git"]), @"Completion should receive the formulae parsed from the output.");
+    XCTAssertNil([completionResult output], @"Completion should not receive output that was parsed.");
+    XCTAssertEqual([[[MRBrew sharedBrew] operationCompletions] count], (NSUInteger)0, @"Should release the completion once it has been called.");
+    
+    // cleanup
+    [[[MRBrew sharedBrew] resultCache] removeAllOutput];
+    [[MRBrew sharedBrew] setCachesResults:NO];
+}
+
+- (void)testPerformOperationsCompletionReceivesResultsInOrderOfOperations
+{
+    // setup
+    MRBrewOperation *listOperation = [MRBrewOperation listOperation];
+    MRBrewOperation *infoOperation = [MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [[MRBrew sharedBrew] setCachesResults:YES];
+    [[[MRBrew sharedBrew] resultCache] setOutput:@"wget\n" forOperation:listOperation];
+    [[[MRBrew sharedBrew] resultCache] setOutput:@"wget: stable 1.15\n" forOperation:infoOperation];
+    
+    __block NSArray *completionResults = nil;
+    __block NSUInteger completionCount = 0;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperations:@[infoOperation, listOperation] completion:^(NSArray *results) {
+        completionResults = results;
+        completionCount++;
+    }];
+    
+    while (!completionResults && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    
+    // verify
+    XCTAssertEqual(completionCount, (NSUInteger)1, @"Completion should be called once, when all of the operations are done.");
+    XCTAssertEqual([completionResults count], (NSUInteger)2, @"Completion should receive a result for each operation.");
+    XCTAssertTrue([[[completionResults objectAtIndex:0] operation] isEqualToOperation:infoOperation], @"Results should be in the order of the operations.");
+    XCTAssertEqualObjects([[completionResults objectAtIndex:0] output], @"wget: stable 1.15\n", @"Result should hold the output of an operation that is not parsed.");
+    XCTAssertEqualObjects([[[completionResults objectAtIndex:1] objects] valueForKey:@"name"], @[@"wget"], @"Result should hold the objects parsed from the output of a list operation.");
+    
+    // cleanup
+    [[[MRBrew sharedBrew] resultCache] removeAllOutput];
+    [[MRBrew sharedBrew] setCachesResults:NO];
+}
+
+- (void)testPerformOperationCompletionReceivesErrorIfBrewCannotBeLaunched
+{
+    // setup
+    NSOperationQueue *backgroundQueue = [[MRBrew sharedBrew] backgroundQueue];
+    [[MRBrew sharedBrew] setBackgroundQueue:[[NSOperationQueue alloc] init]];
+    [[MRBrew sharedBrew] setBrewPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]];
+    
+    __block MRBrewOperationResult *completionResult = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation listOperation] completion:^(MRBrewOperationResult *result) {
+        completionResult = result;
+    }];
+    
+    while (!completionResult && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertNotNil(completionResult, @"Completion should be called for an operation whose brew executable cannot be launched.");
+    XCTAssertFalse([completionResult succeeded], @"Completion should receive an unsuccessful result.");
+    XCTAssertEqualObjects([[completionResult error] domain], MRBrewErrorDomain, @"Completion should receive an MRBrew error.");
+    XCTAssertEqual([[completionResult error] code], (NSInteger)MRBrewErrorUnknown, @"Completion should receive an unknown error.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:nil];
+    [[MRBrew sharedBrew] setBackgroundQueue:backgroundQueue];
+}
+
+- (void)testPerformOperationsCompletionReceivesNoResultsForNoOperations
+{
+    // setup
+    __block NSArray *completionResults = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperations:@[] completion:^(NSArray *results) {
+        completionResults = results;
+    }];
+    
+    while (!completionResults && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqualObjects(completionResults, @[], @"Completion should receive an empty array when there are no operations.");
+}
+
+#pragma mark - In-Process Operations
+
+- (void)testPerformListOperationInProcessReadsCellarWithoutLaunchingBrew
+{
+    // setup
+    NSString *cellarPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"wget/1.15"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[cellarPath stringByAppendingPathComponent:@"git/1.9.0"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[MRBrew sharedBrew] setCellarPath:cellarPath];
+    
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    [operation setPerformsInProcess:YES];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[queue expect] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSOperation *addedOperation = nil;
+        [invocation getArgument:&addedOperation atIndex:2];
+        [addedOperation start];
+    }] addOperation:[OCMArg checkWithBlock:^BOOL(id value) { return [value isKindOfClass:[MRBrewInProcessWorker class]]; }]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    __block MRBrewOperationResult *completionResult = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation completion:^(MRBrewOperationResult *result) {
+        completionResult = result;
+    }];
+    
+    while (!completionResult && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    [queue verify];
+    XCTAssertTrue([completionResult succeeded], @"Completion should receive a successful result.");
+    XCTAssertEqualObjects([[completionResult objects] valueForKey:@"name"], (@[@"git", @"wget"]), @"Completion should receive the formulae in the Cellar.");
+    XCTAssertEqualObjects([[[completionResult objects] lastObject] installedVersions], @[@"1.15"], @"Formulae should include their installed versions.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setCellarPath:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:cellarPath error:NULL];
+}
+
+- (void)testPerformOutdatedOperationInProcessComparesCellarWithFormulaFiles
+{
+    // setup: an installation whose brew executable is never launched
+    NSString *prefix = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[prefix stringByAppendingPathComponent:@"Cellar/wget/1.14"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[prefix stringByAppendingPathComponent:@"Library/Formula"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [@"class Wget < Formula\n  url \"http://ftpmirror.gnu.org/wget/wget-1.15.tar.xz\"\nend\n" writeToFile:[prefix stringByAppendingPathComponent:@"Library/Formula/wget.rb"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    [[MRBrew sharedBrew] setBrewPath:[prefix stringByAppendingPathComponent:@"bin/brew"]];
+    
+    MRBrewOperation *operation = [MRBrewOperation outdatedOperation];
+    [operation setPerformsInProcess:YES];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[queue expect] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSOperation *addedOperation = nil;
+        [invocation getArgument:&addedOperation atIndex:2];
+        [addedOperation start];
+    }] addOperation:[OCMArg checkWithBlock:^BOOL(id value) { return [value isKindOfClass:[MRBrewInProcessWorker class]]; }]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    __block MRBrewOperationResult *completionResult = nil;
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation completion:^(MRBrewOperationResult *result) {
+        completionResult = result;
+    }];
+    
+    while (!completionResult && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    [queue verify];
+    XCTAssertTrue([completionResult succeeded], @"Completion should receive a successful result.");
+    XCTAssertEqualObjects([completionResult output], @"wget\n", @"Completion should receive the output brew would have written.");
+    XCTAssertEqualObjects([[completionResult objects] valueForKey:@"name"], @[@"wget"], @"Completion should receive the outdated formulae.");
+    XCTAssertTrue([[[completionResult objects] lastObject] isUpdated], @"Outdated formulae should be updated.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:prefix error:NULL];
+}
+
+- (void)testCellarPathDefaultsToCellarOfBrewPrefix
+{
+    // setup
+    [[MRBrew sharedBrew] setBrewPath:@"/home/linuxbrew/.linuxbrew/bin/brew"];
+    
+    // execute
+    NSString *cellarPath = [[MRBrew sharedBrew] cellarPath];
+    
+    // verify
+    XCTAssertEqualObjects(cellarPath, @"/home/linuxbrew/.linuxbrew/Cellar", @"Should default to the Cellar of the prefix of the brew executable.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setBrewPath:nil];
+}
+
+#pragma mark - Lanes and Priorities
+
+- (void)testOperationThatIsNotReadOnlyIsAddedToMutatingQueue
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setMutatingQueue:queue];
+    
+    id backgroundQueue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[MRBrew sharedBrew] setBackgroundQueue:backgroundQueue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]] delegate:nil];
+    
+    // verify
+    [queue verify];
+    [backgroundQueue verify];
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+}
+
+- (void)testMutatingQueueExecutesOneOperationAtATime
+{
+    // execute & verify
+    XCTAssertEqual([[[MRBrew sharedBrew] mutatingQueue] maxConcurrentOperationCount], (NSInteger)1, @"Operations that are not read-only should be executed serially.");
+}
+
+- (void)testWorkerQueuePriorityMatchesOperationPriority
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [operation setPriority:MRBrewOperationPriorityHigh];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    
+    // verify
+    MRBrewWorker *worker = [[[MRBrew sharedBrew] inFlightWorkers] objectAtIndex:0];
+    XCTAssertEqual([worker queuePriority], NSOperationQueuePriorityHigh, @"The worker should be queued with the priority of its operation.");
+}
+
+- (void)testAttachingHigherPriorityOperationPromotesQueuedWorker
+{
+    // setup
+    MRBrewOperation *highPriorityOperation = [MRBrewOperation listOperation];
+    [highPriorityOperation setPriority:MRBrewOperationPriorityHigh];
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation listOperation] delegate:nil];
+    [[MRBrew sharedBrew] performOperation:highPriorityOperation delegate:nil];
+    
+    // verify
+    MRBrewWorker *worker = [[[MRBrew sharedBrew] inFlightWorkers] objectAtIndex:0];
+    XCTAssertEqual([worker queuePriority], NSOperationQueuePriorityHigh, @"A queued worker should take the highest priority of its attached operations.");
+}
+
+- (void)testSetMaxConcurrentReadOnlyOperationsSetsBackgroundQueueLimit
+{
+    // setup
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] setMaxConcurrentOperationCount:4];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    // execute
+    [[MRBrew sharedBrew] setMaxConcurrentReadOnlyOperations:4];
+    
+    // verify
+    [queue verify];
+}
+
+- (void)testOperationCountIncludesBothLanes
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    NSUInteger readOnlyCount = 2;
+    NSUInteger mutatingCount = 3;
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[queue stub] andReturnValue:OCMOCK_VALUE(readOnlyCount)] operationCount];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    id otherQueue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[otherQueue stub] andReturnValue:OCMOCK_VALUE(mutatingCount)] operationCount];
+    [[MRBrew sharedBrew] setMutatingQueue:otherQueue];
+    
+    // execute
+    NSUInteger operationCount = [[MRBrew sharedBrew] operationCount];
+    
+    // verify
+    XCTAssertEqual(operationCount, readOnlyCount + mutatingCount, @"Should return the count of operations queued in both lanes.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+}
+
+#pragma mark - Metrics
+
+- (void)testOperationDurationsAreRecordedByOperationName
+{
+    // setup
+    NSDate *enqueueDate = [NSDate date];
+    MRBrewOperationMetrics *installMetrics = [[MRBrewOperationMetrics alloc] init];
+    [installMetrics setOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]]];
+    [installMetrics setEnqueueDate:enqueueDate];
+    [installMetrics setDeliveryDate:[enqueueDate dateByAddingTimeInterval:2.0]];
+    
+    MRBrewOperationMetrics *infoMetrics = [[MRBrewOperationMetrics alloc] init];
+    [infoMetrics setOperation:[MRBrewOperation infoOperation:[MRBrewFormula formulaWithName:@"wget"]]];
+    [infoMetrics setEnqueueDate:enqueueDate];
+    [infoMetrics setDeliveryDate:[enqueueDate dateByAddingTimeInterval:0.5]];
+    
+    // execute
+    [[MRBrew sharedBrew] recordOperationMetrics:installMetrics];
+    [[MRBrew sharedBrew] recordOperationMetrics:installMetrics];
+    [[MRBrew sharedBrew] recordOperationMetrics:infoMetrics];
+    
+    // verify
+    MRBrewHistogram *installHistogram = [[MRBrew sharedBrew] durationHistogramForOperationName:MRBrewOperationInstallIdentifier];
+    XCTAssertEqual([installHistogram count], (NSUInteger)2, @"Durations should be recorded for each operation performed.");
+    XCTAssertEqualWithAccuracy([installHistogram maximum], 2.0, 0.0001, @"Total duration of each operation should be recorded.");
+    XCTAssertEqual([[[MRBrew sharedBrew] operationDurationHistograms] count], (NSUInteger)2, @"Durations should be recorded separately for each operation name.");
+    XCTAssertNil([[MRBrew sharedBrew] durationHistogramForOperationName:MRBrewOperationUpdateIdentifier], @"Operations that have not been performed should have no histogram.");
+}
+
+- (void)testResettingOperationDurationsDiscardsHistograms
+{
+    // setup
+    MRBrewOperationMetrics *metrics = [[MRBrewOperationMetrics alloc] init];
+    [metrics setOperation:[MRBrewOperation updateOperation]];
+    [[MRBrew sharedBrew] recordOperationMetrics:metrics];
+    
+    // execute
+    [[MRBrew sharedBrew] resetOperationDurationHistograms];
+    
+    // verify
+    XCTAssertEqual([[[MRBrew sharedBrew] operationDurationHistograms] count], (NSUInteger)0, @"Resetting should discard recorded durations.");
+}
+
+#pragma mark - Batching Operations
+
+- (void)testBatchingOperationsIsDisabledByDefault
+{
+    // execute & verify
+    XCTAssertFalse([[MRBrew sharedBrew] batchesOperations], @"Operations should not be batched unless requested.");
+}
+
+- (void)testBatchedInstallOperationsArePerformedBySingleWorker
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg checkWithBlock:^BOOL(id worker) {
+        return [[worker arguments] isEqualToArray:@[MRBrewOperationInstallIdentifier, @"wget", @"git"]];
+    }]];
+    [[MRBrew sharedBrew] setMutatingQueue:queue];
+    [[MRBrew sharedBrew] setBatchesOperations:YES];
+    [[MRBrew sharedBrew] setBatchInterval:60.0];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]] delegate:nil];
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"git"]] delegate:nil];
+    [[MRBrew sharedBrew] performPendingBatches];
+    
+    // verify
+    [queue verify];
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+    [[MRBrew sharedBrew] setBatchesOperations:NO];
+    [[MRBrew sharedBrew] setBatchInterval:0.1];
+}
+
+- (void)testOperationsThatCannotBeBatchedAreNotDelayed
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg any]];
+    [[MRBrew sharedBrew] setMutatingQueue:queue];
+    [[MRBrew sharedBrew] setBatchesOperations:YES];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation updateOperation] delegate:nil];
+    
+    // verify
+    [queue verify];
+    XCTAssertEqual([[[MRBrew sharedBrew] pendingBatches] count], (NSUInteger)0, @"Update operations should not be batched.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+    [[MRBrew sharedBrew] setBatchesOperations:NO];
+}
+
+- (void)testCancellingPendingBatchedOperationRemovesItFromBatch
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[queue expect] addOperation:[OCMArg checkWithBlock:^BOOL(id worker) {
+        return [[worker arguments] isEqualToArray:@[MRBrewOperationInstallIdentifier, @"git"]];
+    }]];
+    [[MRBrew sharedBrew] setMutatingQueue:queue];
+    [[MRBrew sharedBrew] setBatchesOperations:YES];
+    [[MRBrew sharedBrew] setBatchInterval:60.0];
+    
+    MRBrewOperation *operation = [MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]];
+    [[MRBrew sharedBrew] performOperation:operation delegate:nil];
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"git"]] delegate:nil];
+    
+    // execute
+    [[MRBrew sharedBrew] cancelOperation:operation];
+    [[MRBrew sharedBrew] performPendingBatches];
+    
+    // verify
+    [queue verify];
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+    [[MRBrew sharedBrew] setBatchesOperations:NO];
+    [[MRBrew sharedBrew] setBatchInterval:0.1];
+}
+
+- (void)testOperationCountIncludesPendingBatchedOperations
+{
+    // setup
+    NSOperationQueue *mutatingQueue = [[MRBrew sharedBrew] mutatingQueue];
+    NSUInteger queuedCount = 0;
+    
+    id queue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[queue stub] andReturnValue:OCMOCK_VALUE(queuedCount)] operationCount];
+    [[MRBrew sharedBrew] setBackgroundQueue:queue];
+    
+    id otherQueue = [OCMockObject mockForClass:[NSOperationQueue class]];
+    [[[otherQueue stub] andReturnValue:OCMOCK_VALUE(queuedCount)] operationCount];
+    [[MRBrew sharedBrew] setMutatingQueue:otherQueue];
+    
+    [[MRBrew sharedBrew] setBatchesOperations:YES];
+    [[MRBrew sharedBrew] setBatchInterval:60.0];
+    
+    // execute
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"wget"]] delegate:nil];
+    [[MRBrew sharedBrew] performOperation:[MRBrewOperation installOperation:[MRBrewFormula formulaWithName:@"git"]] delegate:nil];
+    
+    // verify
+    XCTAssertEqual([[MRBrew sharedBrew] operationCount], (NSUInteger)2, @"Should count operations waiting to be batched.");
+    
+    // cleanup
+    [[MRBrew sharedBrew] setMutatingQueue:mutatingQueue];
+    [[MRBrew sharedBrew] setBatchesOperations:NO];
+    [[MRBrew sharedBrew] setBatchInterval:0.1];
+}
+
 - (void)testEnvironmentVariablesAreRetained
 {
     // setup
@@ -0,0 +1,75 @@
+//
+//  MRBrewVersionTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "MRBrewVersion.h"
+
+@interface MRBrewVersionTests : XCTestCase
+
+@end
+
+@implementation MRBrewVersionTests
+
+#pragma mark - Comparing Versions
+
+- (void)testNumericTokensAreComparedAsNumbers
+{
+    // execute & verify
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.9" toVersion:@"1.15"], NSOrderedAscending, @"Should compare numeric tokens as numbers.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"2.0" toVersion:@"1.99.9"], NSOrderedDescending, @"Should compare tokens from the left.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.0" toVersion:@"1"], NSOrderedSame, @"A missing token should be equal to zero.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"20140101" toVersion:@"20131231"], NSOrderedDescending, @"Should compare long numeric tokens.");
+}
+
+- (void)testLettersFollowingNumbersAreLaterVersions
+{
+    // execute & verify
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.0.1f" toVersion:@"1.0.1g"], NSOrderedAscending, @"Should compare alphabetic tokens.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.0.1g" toVersion:@"1.0.1"], NSOrderedDescending, @"A patch letter should follow the version without it.");
+}
+
+- (void)testPreReleasesPrecedeReleases
+{
+    // execute & verify
+    XCTAssertEqual([MRBrewVersion compareVersion:@"2.0rc1" toVersion:@"2.0"], NSOrderedAscending, @"A release candidate should precede the release.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"2.0-beta2" toVersion:@"2.0rc1"], NSOrderedAscending, @"A beta should precede a release candidate.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"2.0.1" toVersion:@"2.0rc1"], NSOrderedDescending, @"A number should follow a pre-release.");
+}
+
+- (void)testRevisionsAreComparedLast
+{
+    // execute & verify
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.15" toVersion:@"1.15_1"], NSOrderedAscending, @"A revision should follow the version without one.");
+    XCTAssertEqual([MRBrewVersion compareVersion:@"1.15_2" toVersion:@"1.16"], NSOrderedAscending, @"A revision should only be compared when the versions are equal.");
+}
+
+- (void)testGreatestVersion
+{
+    // execute & verify
+    XCTAssertEqualObjects([MRBrewVersion greatestVersionInVersions:(@[@"1.9", @"1.15", @"1.10_1"])], @"1.15", @"Should return the greatest version.");
+    XCTAssertNil([MRBrewVersion greatestVersionInVersions:@[]], @"Should return nil for no versions.");
+}
+
+@end
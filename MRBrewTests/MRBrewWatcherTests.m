@@ -0,0 +1,347 @@
+//
+//  MRBrewWatcherTests.m
+//  MRBrew
+//
+//  Copyright (c) 2014 Marc Ransome <marc.ransome@fidgetbox.co.uk>
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#import <XCTest/XCTest.h>
+#import "MRBrewWatcher.h"
+#import "MRBrewWatcher+Private.h"
+#import "MRBrewFSEventsWatcherBackend.h"
+#import "MRBrewKegChanges.h"
+#import "MRBrewFormula.h"
+
+/* A backend that reports the events it is sent by a test. */
+@interface MRBrewWatcherTestsBackend : NSObject <MRBrewWatcherBackend>
+
+@property (nonatomic, assign, getter=isWatching) BOOL watching;
+@property (assign) NSUInteger maximumDepth;
+
++ (MRBrewWatcherTestsBackend *)lastBackend;
+- (void)reportEvents:(MRBrewWatcherEvent)events atPath:(NSString *)path;
+
+@end
+
+static MRBrewWatcherTestsBackend *MRBrewWatcherTestsLastBackend;
+
+@implementation MRBrewWatcherTestsBackend
+{
+    dispatch_queue_t _queue;
+    MRBrewWatcherBackendHandler _handler;
+}
+
++ (MRBrewWatcherTestsBackend *)lastBackend
+{
+    return MRBrewWatcherTestsLastBackend;
+}
+
+- (instancetype)initWithPaths:(NSArray *)paths queue:(dispatch_queue_t)queue handler:(MRBrewWatcherBackendHandler)handler
+{
+    if (self = [super init]) {
+        _queue = queue;
+        _handler = [handler copy];
+        MRBrewWatcherTestsLastBackend = self;
+    }
+    
+    return self;
+}
+
+- (BOOL)startWatching
+{
+    [self setWatching:YES];
+    return YES;
+}
+
+- (void)stopWatching
+{
+    [self setWatching:NO];
+}
+
+- (void)reportEvents:(MRBrewWatcherEvent)events atPath:(NSString *)path
+{
+    MRBrewWatcherBackendHandler handler = _handler;
+    dispatch_async(_queue, ^{
+        handler(path, events);
+    });
+}
+
+@end
+
+@interface MRBrewWatcherTests : XCTestCase <MRBrewWatcherDelegate>
+{
+    MRBrewWatcher *_watcher;
+    NSMutableArray *_changedDirectories;
+    NSMutableArray *_changes;
+    NSMutableArray *_kegChanges;
+}
+
+@end
+
+@implementation MRBrewWatcherTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+    [super setUp];
+    
+    _changedDirectories = [NSMutableArray array];
+    _changes = [NSMutableArray array];
+    _kegChanges = [NSMutableArray array];
+    _watcher = [MRBrewWatcher watcherWithPath:@"/usr/local/Library" delegate:self];
+    [_watcher setBackendClass:[MRBrewWatcherTestsBackend class]];
+    [_watcher setLatency:0.05];
+}
+
+- (void)tearDown
+{
+    [_watcher stopWatching];
+    _watcher = nil;
+    MRBrewWatcherTestsLastBackend = nil;
+    
+    [super tearDown];
+}
+
+- (void)waitForChanges
+{
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    while ([_changes count] == 0 && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+}
+
+#pragma mark - Defaults
+
+- (void)testDefaultLatencyAndDelegateQueue
+{
+    // setup
+    MRBrewWatcher *watcher = [MRBrewWatcher watcherWithLocation:MRBrewWatcherFormulaLocation delegate:nil];
+    
+    // execute & verify
+    XCTAssertEqual([watcher latency], (NSTimeInterval)3.0, @"Default latency should be 3 seconds.");
+    XCTAssertEqualObjects([watcher delegateQueue], [NSOperationQueue mainQueue], @"Should deliver on the main queue by default.");
+    XCTAssertEqualObjects([watcher pathsToWatch], @[@"/usr/local/Library/Formula"], @"Should watch the path of the location.");
+    XCTAssertEqualObjects([watcher backendClass], [MRBrewWatcher defaultBackendClass], @"Should use the backend of the host.");
+}
+
+- (void)testLibraryLocationWatchesOnlyLibraryPath
+{
+    // setup
+    MRBrewWatcher *watcher = [MRBrewWatcher watcherWithLocation:(MRBrewWatcherLibraryLocation | MRBrewWatcherTapsLocation) delegate:nil];
+    
+    // execute & verify
+    XCTAssertEqualObjects([watcher pathsToWatch], @[@"/usr/local/Library"], @"The library path contains the other locations.");
+}
+
+#pragma mark - Control
+
+- (void)testStartAndStopWatchingControlsBackend
+{
+    // execute
+    [_watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    BOOL watchingAfterStart = [_watcher isWatching];
+    [_watcher stopWatching];
+    
+    // verify
+    XCTAssertTrue(watchingAfterStart, @"Should be watching once the backend has started.");
+    XCTAssertFalse([_watcher isWatching], @"Should not be watching once stopped.");
+    XCTAssertFalse([backend isWatching], @"Should stop the backend.");
+}
+
+#pragma mark - Coalescing
+
+- (void)testCoalescesEventsForEachPath
+{
+    // setup
+    [_watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    
+    // execute
+    [backend reportEvents:MRBrewWatcherCreatedEvent atPath:@"/usr/local/Library/Formula/wget.rb"];
+    [backend reportEvents:MRBrewWatcherModifiedEvent atPath:@"/usr/local/Library/Formula/wget.rb"];
+    [backend reportEvents:MRBrewWatcherModifiedEvent atPath:@"/usr/local/Library/Formula/wget.rb"];
+    [backend reportEvents:MRBrewWatcherRemovedEvent atPath:@"/usr/local/Library/Formula/curl.rb"];
+    [self waitForChanges];
+    
+    // verify
+    NSDictionary *expectedChanges = @{ @"/usr/local/Library/Formula/wget.rb" : @(MRBrewWatcherCreatedEvent | MRBrewWatcherModifiedEvent),
+                                       @"/usr/local/Library/Formula/curl.rb" : @(MRBrewWatcherRemovedEvent) };
+    XCTAssertEqual([_changes count], (NSUInteger)1, @"Should deliver the events that occurred during the latency at once.");
+    XCTAssertEqualObjects([_changes firstObject], expectedChanges, @"Should combine the events for each path.");
+    XCTAssertEqualObjects([_changedDirectories firstObject], @[@"/usr/local/Library/Formula"], @"Should report each directory where changes occurred once.");
+}
+
+- (void)testRescanEventReportsPathAsChangedDirectory
+{
+    // setup
+    [_watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    
+    // execute
+    [backend reportEvents:MRBrewWatcherRescanEvent atPath:@"/usr/local/Library"];
+    [self waitForChanges];
+    
+    // verify
+    XCTAssertEqualObjects([_changedDirectories firstObject], @[@"/usr/local/Library"], @"A path that must be rescanned is itself the changed directory.");
+}
+
+- (void)testWatchedPathAndDirectoriesReportThemselvesAsChangedDirectories
+{
+    // setup
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    NSString *directoryPath = [path stringByAppendingPathComponent:@"Formula"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    MRBrewWatcher *watcher = [MRBrewWatcher watcherWithPath:path delegate:self];
+    [watcher setBackendClass:[MRBrewWatcherTestsBackend class]];
+    [watcher setLatency:0.05];
+    [watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    
+    // execute
+    [backend reportEvents:MRBrewWatcherModifiedEvent atPath:path];
+    [backend reportEvents:MRBrewWatcherCreatedEvent atPath:directoryPath];
+    [backend reportEvents:MRBrewWatcherRemovedEvent atPath:[directoryPath stringByAppendingPathComponent:@"wget.rb"]];
+    [self waitForChanges];
+    
+    // verify
+    NSSet *expectedDirectories = [NSSet setWithObjects:path, directoryPath, nil];
+    XCTAssertEqualObjects([NSSet setWithArray:[_changedDirectories firstObject]], expectedDirectories, @"A watched path or directory should itself be the changed directory, and a file its parent.");
+    
+    // cleanup
+    [watcher stopWatching];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testStopWatchingDiscardsPendingChanges
+{
+    // setup
+    [_watcher setLatency:0.5];
+    [_watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    
+    // execute
+    [backend reportEvents:MRBrewWatcherModifiedEvent atPath:@"/usr/local/Library/Formula/wget.rb"];
+    [_watcher stopWatching];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.0]];
+    
+    // verify
+    XCTAssertEqual([_changes count], (NSUInteger)0, @"Should not deliver changes once stopped.");
+}
+
+#pragma mark - Backends
+
+#ifdef __APPLE__
+- (void)testFSEventsBackendDropsEventsDeeperThanMaximumDepth
+{
+    // setup
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByAppendingPathComponent:@"wget/1.15"] withIntermediateDirectories:YES attributes:nil error:NULL];
+    NSMutableSet *reportedNames = [NSMutableSet set];
+    MRBrewFSEventsWatcherBackend *backend = [[MRBrewFSEventsWatcherBackend alloc] initWithPaths:@[path] queue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) handler:^(NSString *eventPath, MRBrewWatcherEvent events) {
+        @synchronized(reportedNames) {
+            [reportedNames addObject:[eventPath lastPathComponent]];
+        }
+    }];
+    [backend setMaximumDepth:1];
+    [backend startWatching];
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [[NSData data] writeToFile:[path stringByAppendingPathComponent:@"wget/1.16"] atomically:NO];
+    [[NSData data] writeToFile:[path stringByAppendingPathComponent:@"wget/1.15/INSTALL_RECEIPT.json"] atomically:NO];
+    
+    BOOL reported = NO;
+    while (!reported && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        @synchronized(reportedNames) {
+            reported = [reportedNames containsObject:@"1.16"];
+        }
+    }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    [backend stopWatching];
+    
+    // verify
+    @synchronized(reportedNames) {
+        XCTAssertTrue([reportedNames containsObject:@"1.16"], @"Should report an item in a directory at the maximum depth.");
+        XCTAssertFalse([reportedNames containsObject:@"INSTALL_RECEIPT.json"], @"Should not report an item in a directory deeper than the maximum depth.");
+    }
+    
+    // cleanup
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+#endif
+
+#pragma mark - Keg Changes
+
+- (void)testPrefixWatcherReportsKegChanges
+{
+    // setup
+    NSString *prefix = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    NSString *kegPath = [prefix stringByAppendingPathComponent:@"Cellar/wget/1.15"];
+    MRBrewWatcher *watcher = [MRBrewWatcher watcherWithPrefix:prefix delegate:self];
+    [watcher setBackendClass:[MRBrewWatcherTestsBackend class]];
+    [watcher setLatency:0.05];
+    [watcher startWatching];
+    MRBrewWatcherTestsBackend *backend = [MRBrewWatcherTestsBackend lastBackend];
+    
+    // execute
+    [[NSFileManager defaultManager] createDirectoryAtPath:kegPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    [backend reportEvents:MRBrewWatcherCreatedEvent atPath:[kegPath stringByDeletingLastPathComponent]];
+    [self waitForChanges];
+    
+    // verify
+    MRBrewKegChanges *changes = [_kegChanges firstObject];
+    XCTAssertTrue([watcher tracksKegs], @"A watcher created with a prefix should track kegs.");
+    XCTAssertEqual([backend maximumDepth], (NSUInteger)1, @"Should only watch the versions below the Cellar.");
+    XCTAssertEqualObjects([[[changes installedFormulae] firstObject] name], @"wget", @"Should report the installed formula.");
+    XCTAssertEqualObjects([[[changes installedFormulae] firstObject] installedVersions], @[@"1.15"], @"Should report the installed version.");
+    
+    // cleanup
+    [watcher stopWatching];
+    [[NSFileManager defaultManager] removeItemAtPath:prefix error:NULL];
+}
+
+- (void)testPathWatcherDoesNotTrackKegs
+{
+    // execute & verify
+    XCTAssertFalse([_watcher tracksKegs], @"A watcher created with a path should not track kegs.");
+}
+
+#pragma mark - MRBrewWatcherDelegate protocol
+
+- (void)brewChangeDidOccur:(NSArray *)paths
+{
+    [_changedDirectories addObject:paths];
+}
+
+- (void)brewChangesDidOccur:(NSDictionary *)changes
+{
+    [_changes addObject:changes];
+}
+
+- (void)brewKegsDidChange:(MRBrewKegChanges *)changes
+{
+    [_kegChanges addObject:changes];
+}
+
+@end
@@ -29,13 +29,84 @@
 #import "MRBrewWorker+Private.h"
 #import "MRBrew.h"
 #import "MRBrewDelegate.h"
+#import "MRBrewOperation.h"
 #import "MRBrewWorkerTaskConstants.h"
+#import "MRBrewConstants.h"
+#import "MRBrewOperationMetrics.h"
+
+/* A delegate that collects the objects parsed from an operation's output. */
+@interface MRBrewWorkerTestsParsingDelegate : NSObject <MRBrewDelegate>
+
+@property (strong) NSMutableArray *parsedObjects;
+@property (assign) BOOL finished;
+
+@end
+
+@implementation MRBrewWorkerTestsParsingDelegate
+
+- (void)brewOperation:(MRBrewOperation *)operation didParseObjects:(NSArray *)objects
+{
+    [[self parsedObjects] addObjectsFromArray:objects];
+}
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    [self setFinished:YES];
+}
+
+@end
+
+/* A delegate that records the messages it receives and the threads on which
+ * it receives them.
+ */
+@interface MRBrewWorkerTestsRecordingDelegate : NSObject <MRBrewDelegate>
+
+@property (strong) NSMutableArray *messages;
+@property (strong) NSMutableSet *threads;
+@property (assign) BOOL finished;
+
+@end
+
+@implementation MRBrewWorkerTestsRecordingDelegate
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _messages = [NSMutableArray array];
+        _threads = [NSMutableSet set];
+    }
+    
+    return self;
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
+{
+    @synchronized(self) {
+        [[self messages] addObject:output];
+        [[self threads] addObject:[NSThread currentThread]];
+    }
+}
+
+- (void)brewOperationDidFinish:(MRBrewOperation *)operation
+{
+    @synchronized(self) {
+        [[self messages] addObject:@"finished"];
+        [[self threads] addObject:[NSThread currentThread]];
+        [self setFinished:YES];
+    }
+}
+
+@end
 
 @interface MRBrewWorkerTests : XCTestCase <MRBrewDelegate> {
     BOOL _delegateReceivedDidFinishCallback;
     BOOL _delegateReceivedDidFailWithErrorCallback;
     NSInteger _delegateReceivedErrorCode;
     MRBrewOperation *_delegateReceivedOperation;
+    NSString *_delegateReceivedOutput;
+    NSString *_delegateReceivedErrorOutput;
+    NSString *_delegateReceivedErrorOutputInError;
+    MRBrewOperationMetrics *_delegateReceivedMetrics;
 }
 
 @end
@@ -49,6 +120,10 @@
     _delegateReceivedDidFailWithErrorCallback = NO;
     _delegateReceivedErrorCode = MRBrewErrorNone;
     _delegateReceivedOperation = nil;
+    _delegateReceivedOutput = nil;
+    _delegateReceivedErrorOutput = nil;
+    _delegateReceivedErrorOutputInError = nil;
+    _delegateReceivedMetrics = nil;
     
     [[MRBrew sharedBrew] setEnvironment:nil];
 }
@@ -88,6 +163,45 @@
     XCTAssertEqual(_delegateReceivedOperation, operation, @"Delegate should receive reference to operation object held by worker instance.");
 }
 
+- (void)testDelegateReceivesMetricsAfterFinishCallback
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [worker setTask:task];
+    [worker setDelegate:self];
+    
+    __block MRBrewOperationMetrics *handledMetrics = nil;
+    [worker setMetricsHandler:^(MRBrewOperationMetrics *metrics) {
+        handledMetrics = metrics;
+    }];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [NSThread detachNewThreadSelector:@selector(taskExited:) toTarget:worker withObject:nil];
+    
+    while (!_delegateReceivedMetrics && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue(_delegateReceivedDidFinishCallback, @"Delegate should receive brewOperationDidFinish: callback before metrics.");
+    XCTAssertNotNil(_delegateReceivedMetrics, @"Delegate should receive brewOperation:didCollectMetrics: callback.");
+    XCTAssertEqual(handledMetrics, _delegateReceivedMetrics, @"Metrics handler should receive the metrics delivered to the delegate.");
+    XCTAssertEqual([_delegateReceivedMetrics operation], operation, @"Metrics should refer to the operation held by the worker instance.");
+    XCTAssertTrue([_delegateReceivedMetrics succeeded], @"Metrics should record that the operation succeeded.");
+    XCTAssertNotNil([_delegateReceivedMetrics deliveryDate], @"Metrics should record when the outcome was delivered.");
+    XCTAssertTrue([_delegateReceivedMetrics totalDuration] >= 0, @"Metrics should record the duration of the operation.");
+}
+
 - (void)testDelegateReceivesFailedWithErrorCallbackWhenTaskTerminatesAbnormally
 {
     // setup
@@ -149,6 +263,274 @@
     XCTAssertEqual(_delegateReceivedOperation, operation, @"Delegate should receive reference to operation object held by worker instance.");
 }
 
+- (void)testDelegateReceivesFinishCallbackOnlyAfterTaskTerminatesAndOutputIsDrained
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [[[task stub] andReturn:nil] standardError];
+    [worker setTask:task];
+    [worker setDelegate:self];
+    [worker setPendingTaskEvents:3];
+    
+    // execute
+    [worker taskOutputDrained];
+    [worker taskErrorOutputDrained];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    
+    // verify
+    XCTAssertFalse(_delegateReceivedDidFinishCallback, @"Delegate should not receive brewOperationDidFinish: callback before the task terminates.");
+    
+    // execute
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    [worker taskTerminated];
+    
+    while (!_delegateReceivedDidFinishCallback && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue(_delegateReceivedDidFinishCallback, @"Delegate should receive brewOperationDidFinish: callback once the task has terminated and its output has been drained.");
+    XCTAssertTrue([worker isFinished], @"Worker should finish once the task has terminated and its output has been drained.");
+}
+
+- (void)testDelegateReceivesOutputInOrderBeforeFinishCallbackOnConcurrentDelegateQueue
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [[[task stub] andReturn:nil] standardError];
+    [worker setTask:task];
+    [worker setGeneratedOutput:[NSMutableString string]];
+    [worker setErrorOutput:[NSMutableString string]];
+    [worker setPendingTaskEvents:3];
+    
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    [delegateQueue setMaxConcurrentOperationCount:8];
+    [worker setDelegateQueue:delegateQueue];
+    
+    MRBrewWorkerTestsRecordingDelegate *delegate = [[MRBrewWorkerTestsRecordingDelegate alloc] init];
+    [worker setDelegate:delegate];
+    
+    NSMutableArray *expectedMessages = [NSMutableArray array];
+    for (NSUInteger line = 0; line < 200; line++) {
+        [expectedMessages addObject:[NSString stringWithFormat:@"line %lu\n", (unsigned long)line]];
+    }
+    [expectedMessages addObject:@"finished"];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    for (NSUInteger line = 0; line < 200; line++) {
+        [worker notifyDelegateOperationGeneratedOutput:[expectedMessages objectAtIndex:line]];
+    }
+    [worker taskOutputDrained];
+    [worker taskErrorOutputDrained];
+    [worker taskTerminated];
+    
+    while (![delegate finished] && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue([delegate finished], @"Delegate should receive brewOperationDidFinish: callback on the delegate queue.");
+    @synchronized(delegate) {
+        XCTAssertEqualObjects([delegate messages], expectedMessages, @"Delegate should receive output in the order it was generated, before the finish callback, on a concurrent delegate queue.");
+        XCTAssertFalse([[delegate threads] containsObject:[NSThread mainThread]], @"Delegate should not receive callbacks on the main thread when another delegate queue is set.");
+    }
+}
+
+- (void)testDelegateReceivesCallbacksInlineWithoutDelegateQueue
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [[[task stub] andReturn:nil] standardError];
+    [worker setTask:task];
+    [worker setGeneratedOutput:[NSMutableString string]];
+    [worker setErrorOutput:[NSMutableString string]];
+    [worker setPendingTaskEvents:3];
+    [worker setDelegateQueue:nil];
+    
+    MRBrewWorkerTestsRecordingDelegate *delegate = [[MRBrewWorkerTestsRecordingDelegate alloc] init];
+    [worker setDelegate:delegate];
+    
+    // execute
+    [worker notifyDelegateOperationGeneratedOutput:@"wget\n"];
+    [worker taskOutputDrained];
+    [worker taskErrorOutputDrained];
+    [worker taskTerminated];
+    
+    // verify
+    NSArray *expectedMessages = @[@"wget\n", @"finished"];
+    XCTAssertEqualObjects([delegate messages], expectedMessages, @"Delegate should receive callbacks before the worker methods that generate them return when there is no delegate queue.");
+    XCTAssertEqualObjects([delegate threads], [NSSet setWithObject:[NSThread currentThread]], @"Delegate should receive callbacks on the thread that generated them when there is no delegate queue.");
+}
+
+- (void)testDelegateReceivesErrorOutputInFailedWithErrorCallback
+{
+    // setup
+    int unknownExitStatus = 1;
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(unknownExitStatus)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [worker setTask:task];
+    [worker setDelegate:self];
+    [worker setErrorOutput:[NSMutableString string]];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [worker notifyDelegateOperationGeneratedErrorOutput:@"Error: No available formula for test-formula\n"];
+    [NSThread detachNewThreadSelector:@selector(taskExited:) toTarget:worker withObject:nil];
+    
+    while (!_delegateReceivedDidFailWithErrorCallback && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqualObjects(_delegateReceivedErrorOutput, @"Error: No available formula for test-formula\n", @"Delegate should receive brewOperation:didGenerateErrorOutput: callback with the error output.");
+    XCTAssertEqualObjects(_delegateReceivedErrorOutputInError, @"Error: No available formula for test-formula\n", @"Error object should contain the error output under the MRBrewErrorOutputKey key.");
+}
+
+- (void)testAttachedDelegateReceivesOutputGeneratedBeforeAttaching
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:operation];
+    [worker setGeneratedOutput:[NSMutableString string]];
+    [worker setErrorOutput:[NSMutableString string]];
+    [worker notifyDelegateOperationGeneratedOutput:@"wget\n"];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    BOOL attached = [worker attachDelegate:self operation:operation];
+    
+    while (!_delegateReceivedOutput && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertTrue(attached, @"Should accept a delegate while the operation has not finished.");
+    XCTAssertEqualObjects(_delegateReceivedOutput, @"wget\n", @"Attached delegate should receive output generated before it was attached.");
+}
+
+- (void)testDelegateReceivesParsedObjectsBeforeFinishCallback
+{
+    // setup
+    MRBrewWorkerTestsParsingDelegate *delegate = [[MRBrewWorkerTestsParsingDelegate alloc] init];
+    [delegate setParsedObjects:[NSMutableArray array]];
+    
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:[MRBrewOperation listOperation]];
+    [worker setDelegate:delegate];
+    [worker setGeneratedOutput:[NSMutableString string]];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [worker setTask:task];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [worker notifyDelegateOperationGeneratedOutput:@"wget\n"];
+    [worker notifyDelegateOperationGeneratedOutput:@"curl"];
+    [worker taskExited:nil];
+    
+    while (![delegate finished] && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertEqualObjects([[delegate parsedObjects] valueForKey:@"name"], (@[@"wget", @"curl"]), @"Delegate should receive every object parsed from the output before the finish callback.");
+}
+
+- (void)testDelegateCannotAttachOnceTaskHasExited
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    
+    id operation = [OCMockObject mockForClass:[MRBrewOperation class]];
+    [[[operation stub] andReturn:operation] copyWithZone:[OCMArg anyPointer]];
+    [worker setOperation:operation];
+    
+    id task = [OCMockObject mockForClass:[NSTask class]];
+    [[[task stub] andReturnValue:OCMOCK_VALUE(MRBrewWorkerTaskExitedNormally)] terminationStatus];
+    [[[task stub] andReturn:nil] standardOutput];
+    [worker setTask:task];
+    [worker taskExited:nil];
+    
+    // execute & verify
+    XCTAssertFalse([worker attachDelegate:self operation:operation], @"Should not accept a delegate once the outcome of the operation has been delivered.");
+}
+
+- (void)testCancelForDelegateDetachesDelegateWithoutCancellingSharedWorker
+{
+    // setup
+    MRBrewOperation *operation = [MRBrewOperation listOperation];
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:operation];
+    [worker setDelegate:nil];
+    [worker attachDelegate:self operation:operation];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [worker cancelForDelegate:self];
+    
+    while (!_delegateReceivedDidFailWithErrorCallback && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    XCTAssertFalse([worker isCancelled], @"Worker should not be cancelled while another delegate is attached.");
+    XCTAssertEqual(_delegateReceivedErrorCode, (NSInteger)MRBrewErrorOperationCancelled, @"Detached delegate should receive a cancellation error.");
+}
+
+- (void)testCancelForLastAttachedDelegateCancelsWorker
+{
+    // setup
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setOperation:[MRBrewOperation listOperation]];
+    [worker setDelegate:self];
+    
+    // execute
+    [worker cancelForDelegate:self];
+    
+    // verify
+    XCTAssertTrue([worker isCancelled], @"Worker should be cancelled when its last delegate cancels.");
+}
+
 - (void)testWorkerReturnsFastWhenCancelledEarlyLeavingTaskUntouched
 {
     // setup
@@ -167,6 +549,35 @@
     [mockTask verify];
 }
 
+- (void)testWorkerWhoseDependencyDidNotSucceedReportsCancellationWithoutLaunchingTask
+{
+    // setup
+    id mockTask = [OCMockObject mockForClass:[NSTask class]];
+    [[[mockTask stub] andThrow:[NSException exceptionWithName:NSInvalidArgumentException reason:nil userInfo:nil]] launch];
+    
+    MRBrewWorker *dependency = [[MRBrewWorker alloc] init];
+    MRBrewWorker *worker = [[MRBrewWorker alloc] init];
+    [worker setTask:mockTask];
+    [worker setDelegate:self];
+    [worker addDependency:dependency];
+    
+    NSDate *callbackTimeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    
+    // execute
+    [worker start];
+    
+    while (!_delegateReceivedDidFailWithErrorCallback && [callbackTimeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    // verify
+    [mockTask verify];
+    XCTAssertTrue([worker isCancelled], @"Worker should be cancelled when an operation it depends on did not succeed.");
+    XCTAssertTrue([worker isFinished], @"Worker should finish without launching its task.");
+    XCTAssertFalse([worker succeeded], @"Worker should not succeed.");
+    XCTAssertEqual(_delegateReceivedErrorCode, MRBrewErrorOperationCancelled, @"Delegate should receive brewOperation:didFailWithError: callback with the cancelled error code.");
+}
+
 - (void)testTaskEnvironmentIsSetupCorrectly
 {
     // setup
@@ -178,6 +589,7 @@
     [[mockTask expect] setLaunchPath:[[MRBrew sharedBrew] brewPath]];
     [[mockTask expect] setArguments:arguments];
     [[mockTask expect] setStandardOutput:[OCMArg any]];
+    [[mockTask expect] setStandardError:[OCMArg any]];
 
     [worker setTask:mockTask];
     
@@ -256,12 +668,25 @@
 {
     _delegateReceivedDidFailWithErrorCallback = YES;
     _delegateReceivedErrorCode = [error code];
+    _delegateReceivedErrorOutputInError = [[error userInfo] objectForKey:MRBrewErrorOutputKey];
     _delegateReceivedOperation = operation;
 }
 
 - (void)brewOperation:(MRBrewOperation *)operation didGenerateOutput:(NSString *)output
 {
     _delegateReceivedOperation = operation;
+    _delegateReceivedOutput = output;
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didGenerateErrorOutput:(NSString *)output
+{
+    _delegateReceivedOperation = operation;
+    _delegateReceivedErrorOutput = output;
+}
+
+- (void)brewOperation:(MRBrewOperation *)operation didCollectMetrics:(MRBrewOperationMetrics *)metrics
+{
+    _delegateReceivedMetrics = metrics;
 }
 
 @end